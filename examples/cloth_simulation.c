@@ -27,7 +27,8 @@ int main(void) {
   CHECK(owl_plataform_init(window, 600, 600, "model"));
 
   renderer = malloc(sizeof(*renderer));
-  CHECK(owl_renderer_init(renderer, window));
+  CHECK(owl_renderer_init(renderer, window, OWL_NUM_IN_FLIGHT_FRAMES,
+                          OWL_PIPELINE_CACHE_PATH));
 
   simulation = malloc(sizeof(*simulation));
   CHECK(owl_cloth_simulation_init(simulation, renderer, 20, 20,
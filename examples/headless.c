@@ -0,0 +1,66 @@
+#include <owl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WIDTH 600
+#define HEIGHT 600
+#define NUM_FRAMES 64
+
+static struct owl_renderer *renderer;
+static unsigned char *pixels;
+
+#define CHECK(fn)                                                             \
+  do {                                                                        \
+    int code = (fn);                                                          \
+    if (code) {                                                               \
+      printf("something went wrong in call: %s, code %i\n", (#fn), code);     \
+      return 0;                                                               \
+    }                                                                         \
+  } while (0)
+
+int main(void) {
+  int i;
+  FILE *file;
+  owl_v3 position = {-0.8F, -0.8F, 0.0F};
+  owl_v3 color = {1.0F, 1.0F, 1.0F};
+
+  renderer = malloc(sizeof(*renderer));
+  CHECK(owl_renderer_init_headless(renderer, WIDTH, HEIGHT,
+                                   OWL_NUM_IN_FLIGHT_FRAMES,
+                                   OWL_PIPELINE_CACHE_PATH));
+
+  CHECK(owl_renderer_load_font(renderer, 64.0F, "../../res/CascadiaMono.ttf"));
+
+  CHECK(owl_renderer_load_skybox(renderer, "../../res/skybox"));
+
+  for (i = 0; i < NUM_FRAMES; ++i) {
+    CHECK(owl_renderer_begin_frame(renderer));
+    {
+      owl_draw_skybox(renderer);
+      owl_draw_text(renderer, "headless", position, color);
+    }
+    CHECK(owl_renderer_end_frame(renderer));
+  }
+
+  pixels = malloc(renderer->width * renderer->height * 4);
+  CHECK(owl_renderer_read_frame(renderer, pixels));
+
+  file = fopen("headless.ppm", "wb");
+  if (file) {
+    uint32_t j;
+
+    fprintf(file, "P6\n%u %u\n255\n", renderer->width, renderer->height);
+    for (j = 0; j < renderer->width * renderer->height; ++j)
+      fwrite(&pixels[j * 4], 1, 3, file);
+
+    fclose(file);
+  }
+
+  free(pixels);
+
+  owl_renderer_deinit(renderer);
+  free(renderer);
+
+  return 0;
+}
@@ -29,7 +29,8 @@ int main(void)
 	CHECK(owl_plataform_init(window, 600, 600, "model"));
 
 	renderer = malloc(sizeof(*renderer));
-	CHECK(owl_renderer_init(renderer, window));
+	CHECK(owl_renderer_init(renderer, window, OWL_NUM_IN_FLIGHT_FRAMES,
+	                        OWL_PIPELINE_CACHE_PATH));
 
 	model = malloc(sizeof(*model));
 	CHECK(owl_model_init(model, renderer,
@@ -9,6 +9,15 @@ layout(location = 1) in vec2 in_uv;
 layout(location = 0) out vec4 out_color;
 
 void main() {
+#if defined(OWL_SDF)
+  /* the outline sits at 0.5, antialiased over about a pixel at any scale */
+  float dist = texture(sampler2D(texture0, sampler0), in_uv).r;
+  float width = fwidth(dist);
+  float alpha = smoothstep(0.5F - width, 0.5F + width, dist);
+
+  out_color = vec4(in_color, 1.0F) * vec4(alpha);
+#else
   out_color = vec4(in_color, 1.0F) *
               vec4(texture(sampler2D(texture0, sampler0), in_uv).r);
+#endif
 }
@@ -4,6 +4,17 @@
 
 #version 450
 
+// OWL_BINDLESS reads the maps out of a single array of every model texture,
+// indexed through the push constants instead of a descriptor set per material
+// OWL_INDIRECT reads the material out of a buffer, indexed by the draw
+#ifdef OWL_INDIRECT
+#define OWL_BINDLESS
+#endif
+
+#ifdef OWL_BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 layout(location = 0) in vec3 inWorldPos;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV0;
@@ -34,13 +45,33 @@ layout(set = 3, binding = 2) uniform texture2D samplerBRDFLUT;
 // Material bindings
 
 layout(set = 2, binding = 0) uniform sampler sampler0;
+#ifdef OWL_BINDLESS
+layout(set = 2, binding = 1) uniform texture2D textures[];
+
+// a single indirect draw covers many materials
+#ifdef OWL_INDIRECT
+#define OWL_MAP(index) textures[nonuniformEXT(index)]
+#else
+#define OWL_MAP(index) textures[index]
+#endif
+#define colorMap OWL_MAP(material.colorMapIndex)
+#define physicalDescriptorMap OWL_MAP(material.physicalDescriptorMapIndex)
+#define normalMap OWL_MAP(material.normalMapIndex)
+#define aoMap OWL_MAP(material.aoMapIndex)
+#define emissiveMap OWL_MAP(material.emissiveMapIndex)
+#else
 layout(set = 2, binding = 1) uniform texture2D colorMap;
 layout(set = 2, binding = 2) uniform texture2D physicalDescriptorMap;
 layout(set = 2, binding = 3) uniform texture2D normalMap;
 layout(set = 2, binding = 4) uniform texture2D aoMap;
 layout(set = 2, binding = 5) uniform texture2D emissiveMap;
+#endif
 
+#ifdef OWL_INDIRECT
+struct Material {
+#else
 layout(push_constant) uniform Material {
+#endif
   vec4 baseColorFactor;
   vec4 emissiveFactor;
   vec4 diffuseFactor;
@@ -55,8 +86,25 @@ layout(push_constant) uniform Material {
   float roughnessFactor;
   float alphaMask;
   float alphaMaskCutoff;
+  int colorMapIndex;
+  int physicalDescriptorMapIndex;
+  int normalMapIndex;
+  int aoMapIndex;
+  int emissiveMapIndex;
+#ifdef OWL_INDIRECT
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer Materials {
+  Material materials[];
+};
+
+layout(location = 5) flat in uint inMaterial;
+
+#define material materials[inMaterial]
+#else
 }
 material;
+#endif
 
 layout(location = 0) out vec4 outColor;
 
@@ -1,10 +1,11 @@
 #version 450
 
 layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
+// octahedral encoded, see owl_model_encode_normal
+layout(location = 1) in vec2 inNormal;
 layout(location = 2) in vec2 inUV0;
 layout(location = 3) in vec2 inUV1;
-layout(location = 4) in vec4 inJoint0;
+layout(location = 4) in uvec4 inJoint0;
 layout(location = 5) in vec4 inWeight0;
 layout(location = 6) in vec4 inColor0;
 
@@ -25,23 +26,79 @@ ubo;
 
 #define MAX_NUM_JOINTS 128
 
+// OWL_INSTANCED reads a model matrix per instance, applied before ubo.model
+#ifdef OWL_INSTANCED
+layout(location = 7) in mat4 inInstance;
+#endif
+
+// OWL_INDIRECT draws every primitive of a gpu culled model in a single
+// indirect draw, firstInstance is the primitive's draw
+#ifdef OWL_INDIRECT
+struct Draw {
+  vec4 minBounds;
+  vec4 maxBounds;
+  uint node;
+  uint material;
+  uint firstIndex;
+  uint indexCount;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Nodes {
+  mat4 matrices[];
+}
+nodes;
+
+layout(std430, set = 1, binding = 1) readonly buffer Draws {
+  Draw draws[];
+}
+draws;
+#else
 layout(std430, set = 1, binding = 0) readonly buffer SSBONode {
   mat4 matrix;
   mat4 jointMatrix[MAX_NUM_JOINTS];
   int jointCount;
 }
 node;
+#endif
 
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec2 outUV0;
 layout(location = 3) out vec2 outUV1;
 layout(location = 4) out vec4 outColor0;
+#ifdef OWL_INDIRECT
+layout(location = 5) flat out uint outMaterial;
+#endif
+
+vec3 decodeNormal(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
 
 void main() {
+  vec3 normal = decodeNormal(inNormal);
+
   outColor0 = inColor0;
 
   vec4 locPos;
+#ifdef OWL_INSTANCED
+  mat4 model = ubo.model * inInstance;
+#else
+  mat4 model = ubo.model;
+#endif
+
+#ifdef OWL_INDIRECT
+  Draw draw = draws.draws[gl_InstanceIndex];
+  mat4 nodeMatrix = nodes.matrices[draw.node];
+
+  outMaterial = draw.material;
+  locPos = model * nodeMatrix * vec4(inPos, 1.0);
+  outNormal =
+      normalize(transpose(inverse(mat3(model * nodeMatrix))) * normal);
+#else
   if (node.jointCount > 0.0) {
     // Mesh is skinned
     mat4 skinMat = inWeight0.x * node.jointMatrix[int(inJoint0.x)] +
@@ -49,14 +106,15 @@ void main() {
                    inWeight0.z * node.jointMatrix[int(inJoint0.z)] +
                    inWeight0.w * node.jointMatrix[int(inJoint0.w)];
 
-    locPos = ubo.model * node.matrix * skinMat * vec4(inPos, 1.0);
+    locPos = model * node.matrix * skinMat * vec4(inPos, 1.0);
     outNormal = normalize(
-        transpose(inverse(mat3(ubo.model * node.matrix * skinMat))) * inNormal);
+        transpose(inverse(mat3(model * node.matrix * skinMat))) * normal);
   } else {
-    locPos = ubo.model * node.matrix * vec4(inPos, 1.0);
+    locPos = model * node.matrix * vec4(inPos, 1.0);
     outNormal =
-        normalize(transpose(inverse(mat3(ubo.model * node.matrix))) * inNormal);
+        normalize(transpose(inverse(mat3(model * node.matrix))) * normal);
   }
+#endif
   locPos.y = -locPos.y;
   outWorldPos = locPos.xyz / locPos.w;
   outUV0 = inUV0;
@@ -7,6 +7,8 @@
 #include "owl_model.h"
 #include "owl_plataform.h"
 #include "owl_renderer.h"
+#include "owl_text.h"
+#include "owl_thread.h"
 #include "owl_vector_math.h"
 
 #endif
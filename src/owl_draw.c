@@ -6,24 +6,142 @@
 #include "owl_model.h"
 #include "owl_plataform.h"
 #include "owl_renderer.h"
+#include "owl_text.h"
+#include "owl_thread.h"
 #include "owl_vector_math.h"
 
+#include <float.h>
 #include <stdio.h>
 
-/* TODO(samuel): this can be optimized to a single uniforma allcation, even
- * just a push_constant */
-OWLAPI int owl_draw_quad(struct owl_renderer *r, struct owl_quad const *quad) {
+/* fraction of the screen height a node has to cover to be drawn at full
+ * detail, every simplified level takes over at half of the one before */
+#define OWL_DRAW_LOD_SCREEN_SIZE 0.25F
+
+/* draws recorded from a worker thread go through the thread's command buffer
+ * and allocator slices, everything else through the renderer's */
+static VkCommandBuffer owl_draw_command_buffer(struct owl_renderer *r,
+                                               struct owl_thread *t) {
+  if (t)
+    return t->command_buffer;
+
+  return r->frame_command_buffer;
+}
+
+static void *
+owl_draw_vertex_allocate(struct owl_renderer *r, struct owl_thread *t,
+                         uint64_t size,
+                         struct owl_renderer_vertex_allocation *alloc) {
+  if (t)
+    return owl_thread_vertex_allocate(t, size, alloc);
+
+  return owl_renderer_vertex_allocate(r, size, alloc);
+}
+
+static void *
+owl_draw_index_allocate(struct owl_renderer *r, struct owl_thread *t,
+                        uint64_t size,
+                        struct owl_renderer_index_allocation *alloc) {
+  if (t)
+    return owl_thread_index_allocate(t, size, alloc);
+
+  return owl_renderer_index_allocate(r, size, alloc);
+}
+
+static void *
+owl_draw_uniform_allocate(struct owl_renderer *r, struct owl_thread *t,
+                          uint64_t size,
+                          struct owl_renderer_uniform_allocation *alloc) {
+  if (t)
+    return owl_thread_uniform_allocate(t, size, alloc);
+
+  return owl_renderer_uniform_allocate(r, size, alloc);
+}
+
+static struct owl_renderer_quad_batch *
+owl_draw_quad_batch(struct owl_renderer *r, struct owl_thread *t) {
+  if (t)
+    return &t->quad_batch;
+
+  return &r->quad_batch;
+}
+
+/* a single vertex stream and uniform for every quad in the batch, the
+ * indices come from the renderer's static quad index buffer */
+static int owl_draw_flush_quad_batch(struct owl_renderer *r,
+                                     struct owl_thread *t) {
   uint8_t *data;
+  uint64_t size;
   VkDescriptorSet descriptor_sets[2];
   VkCommandBuffer command_buffer;
   struct owl_common_uniform uniform;
-  struct owl_common_vertex vertices[4];
   struct owl_renderer_vertex_allocation vertex_allocation;
-  struct owl_renderer_index_allocation index_allocation;
   struct owl_renderer_uniform_allocation uniform_allocation;
-  static uint32_t const indices[] = {2, 3, 1, 1, 0, 2};
+  struct owl_renderer_quad_batch *batch = owl_draw_quad_batch(r, t);
+
+  if (!batch->num_quads)
+    return OWL_OK;
+
+  command_buffer = owl_draw_command_buffer(r, t);
+
+  size = batch->num_quads * 4 * sizeof(*batch->vertices);
 
-  command_buffer = r->submit_command_buffers[r->frame];
+  data = owl_draw_vertex_allocate(r, t, size, &vertex_allocation);
+  if (!data)
+    return OWL_ERROR_NO_FRAME_MEMORY;
+  OWL_MEMCPY(data, batch->vertices, size);
+
+  OWL_M4_IDENTITY(uniform.projection);
+  OWL_M4_IDENTITY(uniform.view);
+  OWL_M4_IDENTITY(uniform.model);
+
+  data = owl_draw_uniform_allocate(r, t, sizeof(uniform), &uniform_allocation);
+  if (!data)
+    return OWL_ERROR_NO_FRAME_MEMORY;
+  OWL_MEMCPY(data, &uniform, sizeof(uniform));
+
+  descriptor_sets[0] = uniform_allocation.common_descriptor_set;
+  descriptor_sets[1] = batch->texture->descriptor_set;
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    batch->pipeline);
+
+  vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertex_allocation.buffer,
+                         &vertex_allocation.offset);
+
+  vkCmdBindIndexBuffer(command_buffer, r->quad_index_buffer, 0,
+                       VK_INDEX_TYPE_UINT16);
+
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          r->common_pipeline_layout, 0,
+                          OWL_ARRAY_SIZE(descriptor_sets), descriptor_sets, 1,
+                          &uniform_allocation.offset);
+
+  vkCmdDrawIndexed(command_buffer, batch->num_quads * 6, 1, 0, 0, 0);
+
+  batch->num_quads = 0;
+
+  return OWL_OK;
+}
+
+static int owl_draw_quad_common(struct owl_renderer *r, struct owl_thread *t,
+                                VkPipeline pipeline,
+                                struct owl_quad const *quad) {
+  int ret;
+  struct owl_common_vertex *vertices;
+  struct owl_renderer_quad_batch *batch = owl_draw_quad_batch(r, t);
+
+  if (batch->num_quads &&
+      (batch->pipeline != pipeline || batch->texture != quad->texture ||
+       OWL_MAX_BATCH_QUADS == batch->num_quads)) {
+    ret = owl_draw_flush_quad_batch(r, t);
+    if (ret)
+      return ret;
+  }
+
+  batch->pipeline = pipeline;
+  batch->texture = quad->texture;
+
+  vertices = &batch->vertices[batch->num_quads * 4];
 
   vertices[0].position[0] = quad->position0[0];
   vertices[0].position[1] = quad->position0[1];
@@ -61,49 +179,38 @@ OWLAPI int owl_draw_quad(struct owl_renderer *r, struct owl_quad const *quad) {
   vertices[3].uv[0] = quad->uv1[0];
   vertices[3].uv[1] = quad->uv1[1];
 
-  OWL_M4_IDENTITY(uniform.projection);
-  OWL_M4_IDENTITY(uniform.view);
-  OWL_M4_IDENTITY(uniform.model);
-
-  data = owl_renderer_vertex_allocate(r, sizeof(vertices), &vertex_allocation);
-  if (!data)
-    return OWL_ERROR_NO_FRAME_MEMORY;
-  OWL_MEMCPY(data, vertices, sizeof(vertices));
-
-  data = owl_renderer_index_allocate(r, sizeof(indices), &index_allocation);
-  if (!data)
-    return OWL_ERROR_NO_FRAME_MEMORY;
-  OWL_MEMCPY(data, indices, sizeof(indices));
-
-  data = owl_renderer_uniform_allocate(r, sizeof(uniform), &uniform_allocation);
-  if (!data)
-    return OWL_ERROR_NO_FRAME_MEMORY;
-  OWL_MEMCPY(data, &uniform, sizeof(uniform));
+  ++batch->num_quads;
 
-  descriptor_sets[0] = uniform_allocation.common_descriptor_set;
-  descriptor_sets[1] = quad->texture->descriptor_set;
+  return OWL_OK;
+}
 
-  vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertex_allocation.buffer,
-                         &vertex_allocation.offset);
+OWLAPI int owl_draw_quad(struct owl_renderer *r, struct owl_quad const *quad) {
+  return owl_draw_quad_common(r, NULL, r->basic_pipeline, quad);
+}
 
-  vkCmdBindIndexBuffer(command_buffer, index_allocation.buffer,
-                       index_allocation.offset, VK_INDEX_TYPE_UINT32);
+OWLAPI int owl_draw_thread_quad(struct owl_thread *t,
+                                struct owl_quad const *quad) {
+  return owl_draw_quad_common(t->renderer, t, t->renderer->basic_pipeline,
+                              quad);
+}
 
-  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          r->common_pipeline_layout, 0,
-                          OWL_ARRAY_SIZE(descriptor_sets), descriptor_sets, 1,
-                          &uniform_allocation.offset);
+OWLAPI int owl_draw_flush(struct owl_renderer *r) {
+  return owl_draw_flush_quad_batch(r, NULL);
+}
 
-  vkCmdDrawIndexed(command_buffer, OWL_ARRAY_SIZE(indices), 1, 0, 0, 0);
+OWLAPI int owl_draw_thread_flush(struct owl_thread *t) {
+  return owl_draw_flush_quad_batch(t->renderer, t);
+}
 
-  return OWL_OK;
+static VkPipeline owl_draw_text_pipeline(struct owl_renderer *r) {
+  return r->font.sdf ? r->text_sdf_pipeline : r->text_pipeline;
 }
 
-static int owl_draw_glyph(struct owl_renderer *r, struct owl_glyph *glyph,
-                          owl_v3 const color) {
+static int owl_draw_glyph(struct owl_renderer *r, struct owl_thread *t,
+                          struct owl_glyph *glyph, owl_v3 const color) {
   struct owl_quad quad;
 
-  quad.texture = &r->font.atlas;
+  quad.texture = glyph->texture;
 
   quad.position0[0] = glyph->positions[0][0];
   quad.position0[1] = glyph->positions[0][1];
@@ -121,33 +228,47 @@ static int owl_draw_glyph(struct owl_renderer *r, struct owl_glyph *glyph,
   quad.uv1[0] = glyph->uvs[3][0];
   quad.uv1[1] = glyph->uvs[3][1];
 
-  return owl_draw_quad(r, &quad);
+  return owl_draw_quad_common(r, t, owl_draw_text_pipeline(r), &quad);
 }
 
-OWLAPI int owl_draw_text(struct owl_renderer *r, char const *text,
-                         owl_v3 const position, owl_v3 const color) {
-  char const *letter;
+/* threads can't write the font, their glyphs are marked at the end of the
+ * frame */
+static void owl_draw_touch_glyph(struct owl_renderer *r, struct owl_thread *t,
+                                 int32_t cell) {
+  if (t)
+    t->touched_glyphs[cell / 32] |= 1U << (cell % 32);
+  else
+    owl_font_touch_glyph(r, &r->font, cell);
+}
+
+static int owl_draw_text_common(struct owl_renderer *r, struct owl_thread *t,
+                                char const *text, owl_v3 const position,
+                                float scale, owl_v3 const color) {
+  char const *it;
   owl_v2 offset;
   int ret;
-  VkCommandBuffer command_buffer;
-
-  command_buffer = r->submit_command_buffers[r->frame];
 
-  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    r->text_pipeline);
+  /* threads can't upload, their glyphs have to be cached already */
+  if (!t) {
+    ret = owl_font_cache_text(r, &r->font, text);
+    if (ret)
+      return ret;
+  }
 
   offset[0] = position[0] * r->width;
   offset[1] = position[1] * r->height;
 
-  for (letter = &text[0]; '\0' != *letter; ++letter) {
+  for (it = &text[0]; '\0' != *it;) {
     struct owl_glyph glyph;
+    uint32_t const codepoint = owl_font_next_codepoint(&it);
 
-    ret = owl_font_fill_glyph(&r->font, *letter, offset, r->width, r->height,
-                              &glyph);
+    ret = owl_font_fill_glyph(r, &r->font, codepoint, scale, offset, &glyph);
     if (ret)
       return ret;
 
-    ret = owl_draw_glyph(r, &glyph, color);
+    owl_draw_touch_glyph(r, t, glyph.cell);
+
+    ret = owl_draw_glyph(r, t, &glyph, color);
     if (ret)
       return ret;
   }
@@ -155,37 +276,243 @@ OWLAPI int owl_draw_text(struct owl_renderer *r, char const *text,
   return OWL_OK;
 }
 
-static int owl_draw_model_node(struct owl_renderer *r, int32_t id,
-                               struct owl_model const *m, owl_m4 matrix) {
-  int32_t i;
+OWLAPI int owl_draw_text(struct owl_renderer *r, char const *text,
+                         owl_v3 const position, owl_v3 const color) {
+  return owl_draw_text_common(r, NULL, text, position, 1.0F, color);
+}
+
+OWLAPI int owl_draw_thread_text(struct owl_thread *t, char const *text,
+                                owl_v3 const position, owl_v3 const color) {
+  return owl_draw_text_common(t->renderer, t, text, position, 1.0F, color);
+}
+
+OWLAPI int owl_draw_scaled_text(struct owl_renderer *r, char const *text,
+                                owl_v3 const position, float scale,
+                                owl_v3 const color) {
+  return owl_draw_text_common(r, NULL, text, position, scale, color);
+}
+
+OWLAPI int owl_draw_thread_scaled_text(struct owl_thread *t, char const *text,
+                                       owl_v3 const position, float scale,
+                                       owl_v3 const color) {
+  return owl_draw_text_common(t->renderer, t, text, position, scale, color);
+}
+
+static int owl_draw_retained_text_common(struct owl_renderer *r,
+                                         struct owl_thread *t,
+                                         struct owl_text *text) {
   int ret;
+  uint32_t i;
+  uint32_t first;
   uint8_t *data;
-  int32_t p;
-  struct owl_model_node const *node;
-  struct owl_model_mesh const *mesh;
-  struct owl_model_joints_ssbo *ssbo;
-  struct owl_model_uniform uniform;
+  uint64_t offset;
+  VkDescriptorSet descriptor_sets[2];
+  VkCommandBuffer command_buffer;
+  struct owl_common_uniform uniform;
   struct owl_renderer_uniform_allocation uniform_allocation;
-  VkCommandBuffer command_buffer = r->submit_command_buffers[r->frame];
+  uint32_t const frame = r->frame;
 
-  node = &m->nodes[id];
+  /* the frame's copy below is checked and written without a lock */
+  if (text->drawn_frame_count == r->frame_count) {
+    OWL_ASSERT(0 && "retained text drawn twice in a frame");
+    return OWL_ERROR_INVALID_VALUE;
+  }
 
-  for (i = 0; i < node->num_children; ++i) {
-    ret = owl_draw_model_node(r, node->children[i], m, matrix);
+  text->drawn_frame_count = r->frame_count;
+
+  if (!text->num_glyphs)
+    return OWL_OK;
+
+  /* a glyph of the layout was evicted since, its cell might hold another
+   * glyph now. threads can't upload the glyphs again */
+  if (text->font_generation != r->font_generation) {
+    char string[OWL_MAX_TEXT_GLYPHS + 1];
+
+    if (t)
+      return OWL_ERROR_INVALID_VALUE;
+
+    OWL_MEMCPY(string, text->string, sizeof(string));
+
+    ret = owl_text_update(r, text, string, text->position, text->scale,
+                          text->color);
     if (ret)
       return ret;
   }
 
-  if (-1 == node->mesh)
-    return OWL_OK;
+  ret = owl_draw_flush_quad_batch(r, t);
+  if (ret)
+    return ret;
 
-  mesh = &m->meshes[node->mesh];
-  ssbo = mesh->mapped_ssbos[r->frame];
+  command_buffer = owl_draw_command_buffer(r, t);
 
-  OWL_M4_COPY(node->matrix, ssbo->matrix);
+  /* this frame's copy is out of date, the fence of the frame that last read
+   * it was already waited on */
+  offset = frame * sizeof(text->vertices);
 
-  for (p = node->parent; - 1 != p; p = m->nodes[p].parent)
-    owl_m4_multiply(m->nodes[p].matrix, ssbo->matrix, ssbo->matrix);
+  if (text->frame_versions[frame] != text->version) {
+    uint8_t *mapped = text->memory.data;
+    uint64_t const size = text->num_glyphs * 4 * sizeof(*text->vertices);
+
+    OWL_MEMCPY(&mapped[offset], text->vertices, size);
+
+    text->frame_versions[frame] = text->version;
+  }
+
+  OWL_M4_IDENTITY(uniform.projection);
+  OWL_M4_IDENTITY(uniform.view);
+  OWL_M4_IDENTITY(uniform.model);
+
+  data = owl_draw_uniform_allocate(r, t, sizeof(uniform), &uniform_allocation);
+  if (!data)
+    return OWL_ERROR_NO_FRAME_MEMORY;
+  OWL_MEMCPY(data, &uniform, sizeof(uniform));
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    owl_draw_text_pipeline(r));
+
+  vkCmdBindVertexBuffers(command_buffer, 0, 1, &text->buffer, &offset);
+
+  vkCmdBindIndexBuffer(command_buffer, r->quad_index_buffer, 0,
+                       VK_INDEX_TYPE_UINT16);
+
+  descriptor_sets[0] = uniform_allocation.common_descriptor_set;
+
+  /* a draw per run of glyphs that share an atlas page, usually just one */
+  for (first = 0, i = 0; i < text->num_glyphs; ++i) {
+    struct owl_texture const *texture = text->textures[i];
+
+    owl_draw_touch_glyph(r, t, text->cells[i]);
+
+    if (i + 1 < text->num_glyphs && texture == text->textures[i + 1])
+      continue;
+
+    descriptor_sets[1] = texture->descriptor_set;
+
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            r->common_pipeline_layout, 0,
+                            OWL_ARRAY_SIZE(descriptor_sets), descriptor_sets,
+                            1, &uniform_allocation.offset);
+
+    vkCmdDrawIndexed(command_buffer, (i + 1 - first) * 6, 1, first * 6, 0, 0);
+
+    first = i + 1;
+  }
+
+  return OWL_OK;
+}
+
+OWLAPI int owl_draw_retained_text(struct owl_renderer *r,
+                                  struct owl_text *text) {
+  return owl_draw_retained_text_common(r, NULL, text);
+}
+
+OWLAPI int owl_draw_thread_retained_text(struct owl_thread *t,
+                                         struct owl_text *text) {
+  return owl_draw_retained_text_common(t->renderer, t, text);
+}
+
+static VkPipelineLayout
+owl_draw_model_pipeline_layout(struct owl_renderer *r) {
+  if (r->bindless_supported)
+    return r->model_bindless_pipeline_layout;
+
+  return r->model_pipeline_layout;
+}
+
+/* true if the box is entirely outside one of the planes of the clip space
+ * clip maps it to */
+static int owl_draw_is_culled(owl_m4 clip, struct owl_model_bbox const *box) {
+  int32_t i;
+  int32_t outside[6];
+
+  if (!box->valid)
+    return 0;
+
+  /* nothing in it */
+  if (box->min[0] > box->max[0])
+    return 1;
+
+  for (i = 0; i < (int32_t)OWL_ARRAY_SIZE(outside); ++i)
+    outside[i] = 0;
+
+  for (i = 0; i < 8; ++i) {
+    owl_v4 corner;
+    owl_v4 position;
+
+    corner[0] = (i & 1) ? box->max[0] : box->min[0];
+    corner[1] = (i & 2) ? box->max[1] : box->min[1];
+    corner[2] = (i & 4) ? box->max[2] : box->min[2];
+    corner[3] = 1.0F;
+
+    owl_m4_multiply_v4(clip, corner, position);
+
+    outside[0] += position[0] < -position[3];
+    outside[1] += position[0] > position[3];
+    outside[2] += position[1] < -position[3];
+    outside[3] += position[1] > position[3];
+    outside[4] += position[2] < 0.0F;
+    outside[5] += position[2] > position[3];
+  }
+
+  for (i = 0; i < (int32_t)OWL_ARRAY_SIZE(outside); ++i)
+    if (8 == outside[i])
+      return 1;
+
+  return 0;
+}
+
+/* the level of detail of a box from the share of the screen it covers, full
+ * detail when it reaches behind the camera */
+static int32_t owl_draw_model_lod(owl_m4 clip,
+                                  struct owl_model_bbox const *box) {
+  int32_t i;
+  int32_t lod;
+  float size;
+  owl_v2 min;
+  owl_v2 max;
+
+  if (!box->valid)
+    return 0;
+
+  min[0] = min[1] = FLT_MAX;
+  max[0] = max[1] = -FLT_MAX;
+
+  for (i = 0; i < 8; ++i) {
+    owl_v4 corner;
+    owl_v4 position;
+
+    corner[0] = (i & 1) ? box->max[0] : box->min[0];
+    corner[1] = (i & 2) ? box->max[1] : box->min[1];
+    corner[2] = (i & 4) ? box->max[2] : box->min[2];
+    corner[3] = 1.0F;
+
+    owl_m4_multiply_v4(clip, corner, position);
+
+    if (0.0F >= position[3])
+      return 0;
+
+    min[0] = OWL_MIN(min[0], position[0] / position[3]);
+    min[1] = OWL_MIN(min[1], position[1] / position[3]);
+    max[0] = OWL_MAX(max[0], position[0] / position[3]);
+    max[1] = OWL_MAX(max[1], position[1] / position[3]);
+  }
+
+  /* normalized device coordinates span 2 */
+  size = OWL_MAX(max[0] - min[0], max[1] - min[1]) * 0.5F;
+
+  for (lod = 0; lod + 1 < OWL_MODEL_MAX_LODS; ++lod, size *= 2.0F)
+    if (size >= OWL_DRAW_LOD_SCREEN_SIZE)
+      break;
+
+  return lod;
+}
+
+static int
+owl_draw_model_uniform(struct owl_renderer *r, struct owl_thread *t,
+                       owl_m4 matrix,
+                       struct owl_renderer_uniform_allocation *allocation) {
+  uint8_t *data;
+  struct owl_model_uniform uniform;
 
   OWL_M4_COPY(r->projection, uniform.projection);
   OWL_M4_COPY(matrix, uniform.model);
@@ -205,164 +532,436 @@ static int owl_draw_model_node(struct owl_renderer *r, int32_t id,
   uniform.debug_view_inputs = 0.0F;
   uniform.debug_view_equation = 0.0F;
 
-  data = owl_renderer_uniform_allocate(r, sizeof(uniform), &uniform_allocation);
+  data = owl_draw_uniform_allocate(r, t, sizeof(uniform), allocation);
   if (!data)
     return OWL_ERROR_NO_MEMORY;
   OWL_MEMCPY(data, &uniform, sizeof(uniform));
 
+  return OWL_OK;
+}
+
+/* clip is NULL when the caller already culled the instances, every node is
+ * drawn num_instances times at full detail */
+static int owl_draw_model_node(struct owl_renderer *r, struct owl_thread *t,
+                               int32_t id, struct owl_model const *m,
+                               owl_m4 matrix, owl_m4 clip,
+                               uint32_t num_instances) {
+  int32_t i;
+  int ret;
+  int32_t p;
+  int32_t lod = 0;
+  owl_m4 node_clip;
+  struct owl_model_node const *node;
+  struct owl_model_mesh const *mesh;
+  struct owl_model_joints_ssbo *ssbo;
+  struct owl_renderer_uniform_allocation uniform_allocation;
+  VkDescriptorSet node_descriptor_sets[2];
+  VkCommandBuffer command_buffer = owl_draw_command_buffer(r, t);
+  VkPipelineLayout const layout = owl_draw_model_pipeline_layout(r);
+
+  node = &m->nodes[id];
+
+  /* neither the node nor any of its children are on screen */
+  if (clip && owl_draw_is_culled(clip, &node->bvh))
+    return OWL_OK;
+
+  for (i = 0; i < node->num_children; ++i) {
+    ret = owl_draw_model_node(r, t, node->children[i], m, matrix, clip,
+                              num_instances);
+    if (ret)
+      return ret;
+  }
+
+  if (-1 == node->mesh)
+    return OWL_OK;
+
+  if (clip && owl_draw_is_culled(clip, &node->aabb))
+    return OWL_OK;
+
+  if (clip)
+    lod = owl_draw_model_lod(clip, &node->aabb);
+
+  mesh = &m->meshes[node->mesh];
+  ssbo = mesh->mapped_ssbos[r->frame];
+
+  OWL_M4_COPY(node->matrix, ssbo->matrix);
+
+  for (p = node->parent; - 1 != p; p = m->nodes[p].parent)
+    owl_m4_multiply(m->nodes[p].matrix, ssbo->matrix, ssbo->matrix);
+
+  if (clip)
+    owl_m4_multiply(clip, ssbo->matrix, node_clip);
+
+  ret = owl_draw_model_uniform(r, t, matrix, &uniform_allocation);
+  if (ret)
+    return ret;
+
+  node_descriptor_sets[0] = uniform_allocation.model_descriptor_set;
+  node_descriptor_sets[1] = mesh->ssbo_descriptor_sets[r->frame];
+
   vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          r->model_pipeline_layout, 0, 1,
-                          &uniform_allocation.model_descriptor_set, 1,
-                          &uniform_allocation.offset);
+                          layout, 0, OWL_ARRAY_SIZE(node_descriptor_sets),
+                          node_descriptor_sets, 1, &uniform_allocation.offset);
 
   for (i = 0; i < mesh->num_primitives; ++i) {
-    VkDescriptorSet descriptors_sets[3];
     struct owl_model_primitive const *primitive;
     struct owl_model_material const *material;
+    struct owl_model_lod const *level;
     struct owl_model_push_constant push_constant;
 
-    push_constant.workflow = 0.0F;
-    push_constant.base_color_uv_set = -1;
-    push_constant.physical_desc_uv_set = -1;
-    push_constant.normal_uv_set = -1;
-    push_constant.occlusion_uv_set = -1;
-    push_constant.emissive_uv_set = -1;
-
     primitive = &m->primitives[mesh->primitives[i]];
+    level = &primitive->lods[OWL_MIN(lod, primitive->num_lods - 1)];
 
     if (!primitive->num_vertices)
       continue;
 
+    /* skinning moves the vertices out of the primitive bounds, the node
+     * bounds already account for it */
+    if (clip && -1 == node->skin &&
+        owl_draw_is_culled(node_clip, &primitive->bbox))
+      continue;
+
     material = &m->materials[primitive->material];
 
-    descriptors_sets[0] = mesh->ssbo_descriptor_sets[r->frame];
-    descriptors_sets[1] = material->descriptor_set;
-    descriptors_sets[2] = r->environment_descriptor_set;
+    /* with bindless the maps are picked through the push constant */
+    if (!r->bindless_supported)
+      vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              layout, 2, 1, &material->descriptor_set, 0,
+                              NULL);
 
-    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            r->model_pipeline_layout, 1,
-                            OWL_ARRAY_SIZE(descriptors_sets), descriptors_sets,
-                            0, NULL);
+    owl_model_material_push_constant(material, &push_constant);
 
-    push_constant.emissive_factor[0] = material->emissive_factor[0];
-    push_constant.emissive_factor[1] = material->emissive_factor[1];
-    push_constant.emissive_factor[2] = material->emissive_factor[2];
-    push_constant.emissive_factor[3] = material->emissive_factor[3];
+    vkCmdPushConstants(command_buffer, layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                       sizeof(push_constant), &push_constant);
+
+    if (primitive->has_indices)
+      vkCmdDrawIndexed(command_buffer, level->num_indices, num_instances,
+                       level->first, 0, 0);
+    else
+      vkCmdDraw(command_buffer, primitive->num_vertices, num_instances,
+                primitive->first, 0);
+  }
 
-    push_constant.diffuse_factor[0] = material->diffuse_factor[0];
-    push_constant.diffuse_factor[1] = material->diffuse_factor[1];
-    push_constant.diffuse_factor[2] = material->diffuse_factor[2];
-    push_constant.diffuse_factor[3] = material->diffuse_factor[3];
+  return OWL_OK;
+}
 
-    push_constant.specular_factor[0] = material->specular_factor[0];
-    push_constant.specular_factor[1] = material->specular_factor[1];
-    push_constant.specular_factor[2] = material->specular_factor[2];
-    push_constant.specular_factor[3] = material->specular_factor[3];
+/* culls every primitive in the frame's culling dispatch and draws what's
+ * left with a single indirect draw, main thread only */
+static int owl_draw_model_indirect(struct owl_renderer *r,
+                                   struct owl_model const *model,
+                                   owl_m4 matrix, owl_m4 clip) {
+  int32_t i;
+  int ret;
+  VkDescriptorSet descriptor_sets[4];
+  VkDescriptorSet cull_descriptor_sets[2];
+  struct owl_model_cull_push_constant push_constant;
+  struct owl_renderer_uniform_allocation uniform_allocation;
+  VkCommandBuffer cull_command_buffer;
+  uint64_t offset = 0;
+  uint32_t const frame = r->frame;
+  owl_m4 *nodes = model->mapped_nodes[frame];
+  VkCommandBuffer command_buffer = r->frame_command_buffer;
 
-    if (-1 == material->base_color_texture)
-      push_constant.base_color_uv_set = -1;
-    else {
-      push_constant.base_color_uv_set = material->base_color_texcoord;
+  /* the culling pass and the vertex shader read the node world matrices */
+  for (i = 0; i < model->num_nodes; ++i) {
+    int32_t p;
 
-      OWL_ASSERT(0 == push_constant.base_color_uv_set);
-    }
+    OWL_M4_COPY(model->nodes[i].matrix, nodes[i]);
 
-    if (-1 == material->normal_texcoord)
-      push_constant.normal_uv_set = -1;
-    else
-      push_constant.normal_uv_set = material->normal_texcoord;
+    for (p = model->nodes[i].parent; - 1 != p; p = model->nodes[p].parent)
+      owl_m4_multiply(model->nodes[p].matrix, nodes[i], nodes[i]);
+  }
 
-    if (-1 == material->occlusion_texture)
-      push_constant.occlusion_uv_set = -1;
-    else
-      push_constant.occlusion_uv_set = material->occlusion_texcoord;
+  cull_command_buffer = owl_renderer_cull_command_buffer(r);
+  if (!cull_command_buffer)
+    return OWL_ERROR_FATAL;
 
-    if (-1 == material->emissive_texture)
-      push_constant.emissive_uv_set = -1;
-    else
-      push_constant.emissive_uv_set = material->emissive_texcoord;
+  OWL_M4_COPY(clip, push_constant.clip);
 
-    push_constant.physical_desc_uv_set = -1;
+  /* only the previous frame's pyramid matches what's on screen */
+  if (r->depth_pyramid_frame &&
+      r->depth_pyramid_frame + 1 == r->frame_count) {
+    owl_m4_multiply(r->depth_pyramid_clip, matrix,
+                    push_constant.occlusion_clip);
+  } else {
+    OWL_MEMSET(push_constant.occlusion_clip, 0,
+               sizeof(push_constant.occlusion_clip));
+  }
 
-    push_constant.alpha_mask = material->alpha_mode == OWL_ALPHA_MODE_MASK;
-    push_constant.alpha_mask_cutoff = material->alpha_cutoff;
+  vkCmdBindPipeline(cull_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    r->cull_pipeline);
 
-    if (material->specular_glossiness_enable) {
-      push_constant.workflow = 1;
+  cull_descriptor_sets[0] = model->indirect_descriptor_sets[frame];
+  cull_descriptor_sets[1] = r->cull_pyramid_descriptor_set;
 
-      if (-1 == material->specular_glossiness_texture)
-        push_constant.physical_desc_uv_set = -1;
-      else
-        push_constant.physical_desc_uv_set =
-            material->specular_glossiness_texture;
+  vkCmdBindDescriptorSets(cull_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          r->cull_pipeline_layout, 0,
+                          OWL_ARRAY_SIZE(cull_descriptor_sets),
+                          cull_descriptor_sets, 0, NULL);
 
-      if (-1 == material->diffuse_texture)
-        push_constant.base_color_uv_set = -1;
-      else
-        push_constant.base_color_uv_set = material->base_color_texcoord;
-    }
+  vkCmdPushConstants(cull_command_buffer, r->cull_pipeline_layout,
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constant),
+                     &push_constant);
 
-    if (material->metallic_roughness_enable) {
-      push_constant.workflow = 0;
-      push_constant.base_color_factor[0] = material->base_color_factor[0];
-      push_constant.base_color_factor[1] = material->base_color_factor[1];
-      push_constant.base_color_factor[2] = material->base_color_factor[2];
-      push_constant.base_color_factor[3] = material->base_color_factor[3];
-
-      push_constant.metallic_factor = material->metallic_factor;
-      push_constant.roughness_factor = material->roughness_factor;
-
-      if (-1 == material->metallic_roughness_texture)
-        push_constant.physical_desc_uv_set = -1;
-      else
-        push_constant.physical_desc_uv_set =
-            material->metallic_roughness_texcoord;
-    }
+  /* owl_cull.comp runs 64 draws per group */
+  vkCmdDispatch(cull_command_buffer, (model->num_draws + 63) / 64, 1, 1);
 
-    vkCmdPushConstants(command_buffer, r->model_pipeline_layout,
-                       VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_constant),
-                       &push_constant);
+  ret = owl_draw_model_uniform(r, NULL, matrix, &uniform_allocation);
+  if (ret)
+    return ret;
 
-    if (primitive->has_indices)
-      vkCmdDrawIndexed(command_buffer, primitive->num_indices, 1,
-                       primitive->first, 0, 0);
-    else
-      vkCmdDraw(command_buffer, primitive->num_vertices, 1, primitive->first,
-                0);
-  }
+  descriptor_sets[0] = uniform_allocation.model_descriptor_set;
+  descriptor_sets[1] = model->indirect_descriptor_sets[frame];
+  descriptor_sets[2] = r->bindless_descriptor_set;
+  descriptor_sets[3] = r->environment_descriptor_set;
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    r->model_indirect_pipeline);
+
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          r->model_indirect_pipeline_layout, 0,
+                          OWL_ARRAY_SIZE(descriptor_sets), descriptor_sets, 1,
+                          &uniform_allocation.offset);
+
+  vkCmdBindVertexBuffers(command_buffer, 0, 1, &model->vertex_buffer, &offset);
+
+  vkCmdBindIndexBuffer(command_buffer, model->index_buffer, 0,
+                       model->index_type);
+
+  vkCmdDrawIndexedIndirect(command_buffer, model->indirect_buffers[frame], 0,
+                           model->num_draws,
+                           sizeof(VkDrawIndexedIndirectCommand));
 
   return OWL_OK;
 }
 
-OWLAPI int owl_draw_model(struct owl_renderer *r, struct owl_model const *model,
-                          owl_m4 matrix) {
-  int i;
+/* every dispatch runs before the frame's draws, so a model drawn again in the
+ * same frame would reuse the last culling results. only its first draw of
+ * the frame is culled on the gpu */
+static int owl_draw_claim_model_culling(struct owl_renderer *r,
+                                        struct owl_model const *model) {
+  uint32_t i;
 
-  uint64_t offset = 0;
+  for (i = 0; i < r->num_culled_models; ++i)
+    if (model == r->culled_models[i])
+      return 0;
+
+  if (OWL_MAX_CULLED_MODELS <= r->num_culled_models)
+    return 0;
+
+  r->culled_models[r->num_culled_models++] = model;
+
+  return 1;
+}
+
+/* world space to clip space, the vertex shader flips y before the view */
+static void owl_draw_world_clip(struct owl_renderer *r, owl_m4 clip) {
+  owl_m4 flip;
+
+  OWL_M4_IDENTITY(flip);
+  flip[1][1] = -1.0F;
+
+  owl_m4_multiply(r->projection, r->view, clip);
+  owl_m4_multiply(clip, flip, clip);
+}
+
+/* draws the node tree, with instances the model matrices of every instance
+ * are read from it and nothing is culled */
+static int
+owl_draw_model_nodes(struct owl_renderer *r, struct owl_thread *t,
+                     struct owl_model const *model, owl_m4 matrix,
+                     owl_m4 clip, uint32_t num_instances,
+                     struct owl_renderer_vertex_allocation const *instances) {
+  int i;
   int ret = OWL_OK;
-  VkCommandBuffer command_buffer;
+  uint64_t offset = 0;
+  VkCommandBuffer command_buffer = owl_draw_command_buffer(r, t);
+
+  if (instances) {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      r->model_instanced_pipeline);
+
+    vkCmdBindVertexBuffers(command_buffer, 1, 1, &instances->buffer,
+                           &instances->offset);
+  } else if (r->bindless_supported) {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      r->model_bindless_pipeline);
+  } else {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      r->model_pipeline);
+  }
 
-  command_buffer = r->submit_command_buffers[r->frame];
+  if (r->bindless_supported) {
+    VkDescriptorSet descriptor_sets[2];
 
-  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    r->model_pipeline);
+    descriptor_sets[0] = r->bindless_descriptor_set;
+    descriptor_sets[1] = r->environment_descriptor_set;
+
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            r->model_bindless_pipeline_layout, 2,
+                            OWL_ARRAY_SIZE(descriptor_sets), descriptor_sets,
+                            0, NULL);
+  } else {
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            r->model_pipeline_layout, 3, 1,
+                            &r->environment_descriptor_set, 0, NULL);
+  }
 
   vkCmdBindVertexBuffers(command_buffer, 0, 1, &model->vertex_buffer, &offset);
 
   vkCmdBindIndexBuffer(command_buffer, model->index_buffer, 0,
-                       VK_INDEX_TYPE_UINT32);
+                       model->index_type);
 
-  for (i = 0; i < model->num_roots; ++i) {
+  for (i = 0; i < model->num_roots && !ret; ++i) {
     int32_t root = model->roots[i];
-    ret = owl_draw_model_node(r, root, model, matrix);
-    if (ret)
-      return ret;
+    ret = owl_draw_model_node(r, t, root, model, matrix, clip, num_instances);
   }
 
-  return OWL_OK;
+  return ret;
+}
+
+static int owl_draw_model_common(struct owl_renderer *r, struct owl_thread *t,
+                                 struct owl_model const *model, owl_m4 matrix) {
+  owl_m4 clip;
+  int ret = OWL_OK;
+
+  /* still on its way through the transfer queue, skip it this frame */
+  if (!owl_renderer_is_async_upload_done(r, model->upload_ticket))
+    return OWL_OK;
+
+  /* model space to clip space */
+  owl_draw_world_clip(r, clip);
+  owl_m4_multiply(clip, matrix, clip);
+
+  ret = owl_draw_flush_quad_batch(r, t);
+  if (ret)
+    return ret;
+
+  /* the timestamps are shared frame state, only the main thread profiles */
+  if (!t)
+    owl_renderer_begin_scope(r, OWL_RENDERER_SCOPE_MODEL);
+
+  /* the culling dispatches are recorded by the main thread only */
+  if (!t && model->gpu_culled && owl_draw_claim_model_culling(r, model))
+    ret = owl_draw_model_indirect(r, model, matrix, clip);
+  else
+    ret = owl_draw_model_nodes(r, t, model, matrix, clip, 1, NULL);
+
+  if (!t)
+    owl_renderer_end_scope(r, OWL_RENDERER_SCOPE_MODEL);
+
+  return ret;
+}
+
+static int owl_draw_model_instanced_common(struct owl_renderer *r,
+                                           struct owl_thread *t,
+                                           struct owl_model const *model,
+                                           owl_m4 *matrices, uint32_t count) {
+  int ret;
+  int32_t i;
+  uint32_t j;
+  owl_m4 clip;
+  owl_m4 identity;
+  owl_m4 *instances;
+  uint32_t num_instances;
+  struct owl_renderer_vertex_allocation instance_allocation;
+
+  if (!owl_renderer_is_async_upload_done(r, model->upload_ticket))
+    return OWL_OK;
+
+  owl_draw_world_clip(r, clip);
+
+  ret = owl_draw_flush_quad_batch(r, t);
+  if (ret)
+    return ret;
+
+  if (!t)
+    owl_renderer_begin_scope(r, OWL_RENDERER_SCOPE_MODEL);
+
+  /* without the instanced variant every instance walks the tree on its own,
+   * gpu culled models take the same path, their single indirect draw can't
+   * be repeated */
+  if (!r->model_instanced_pipeline) {
+    for (j = 0; j < count && !ret; ++j) {
+      owl_m4 instance_clip;
+
+      owl_m4_multiply(clip, matrices[j], instance_clip);
+
+      ret = owl_draw_model_nodes(r, t, model, matrices[j], instance_clip, 1,
+                                 NULL);
+    }
+
+    goto out;
+  }
+
+  instances = owl_draw_vertex_allocate(r, t, count * sizeof(owl_m4),
+                                       &instance_allocation);
+  if (!instances) {
+    ret = OWL_ERROR_NO_FRAME_MEMORY;
+    goto out;
+  }
+
+  /* instances are culled as a whole by the bounds of the roots, the nodes of
+   * the ones left are all drawn */
+  for (num_instances = 0, j = 0; j < count; ++j) {
+    owl_m4 instance_clip;
+
+    owl_m4_multiply(clip, matrices[j], instance_clip);
+
+    for (i = 0; i < model->num_roots; ++i) {
+      struct owl_model_node const *root = &model->nodes[model->roots[i]];
+
+      if (!owl_draw_is_culled(instance_clip, &root->bvh))
+        break;
+    }
+
+    if (i == model->num_roots)
+      continue;
+
+    OWL_M4_COPY(matrices[j], instances[num_instances]);
+    ++num_instances;
+  }
+
+  if (!num_instances)
+    goto out;
+
+  OWL_M4_IDENTITY(identity);
+
+  ret = owl_draw_model_nodes(r, t, model, identity, NULL, num_instances,
+                             &instance_allocation);
+
+out:
+  if (!t)
+    owl_renderer_end_scope(r, OWL_RENDERER_SCOPE_MODEL);
+
+  return ret;
+}
+
+OWLAPI int owl_draw_model(struct owl_renderer *r, struct owl_model const *model,
+                          owl_m4 matrix) {
+  return owl_draw_model_common(r, NULL, model, matrix);
+}
+
+OWLAPI int owl_draw_thread_model(struct owl_thread *t,
+                                 struct owl_model const *model, owl_m4 matrix) {
+  return owl_draw_model_common(t->renderer, t, model, matrix);
+}
+
+OWLAPI int owl_draw_model_instanced(struct owl_renderer *r,
+                                    struct owl_model const *model,
+                                    owl_m4 *matrices, uint32_t count) {
+  return owl_draw_model_instanced_common(r, NULL, model, matrices, count);
+}
+
+OWLAPI int owl_draw_thread_model_instanced(struct owl_thread *t,
+                                           struct owl_model const *model,
+                                           owl_m4 *matrices, uint32_t count) {
+  return owl_draw_model_instanced_common(t->renderer, t, model, matrices,
+                                         count);
 }
 
 OWLAPI int owl_draw_skybox(struct owl_renderer *r) {
+  int ret;
   uint8_t *data;
   struct owl_renderer_vertex_allocation vertex_allocation;
   struct owl_renderer_index_allocation index_allocation;
@@ -396,10 +995,11 @@ OWLAPI int owl_draw_skybox(struct owl_renderer *r) {
       3, 2, 6, 6, 7, 3,  /* face 4 */
       4, 0, 1, 1, 5, 4}; /* face 5 */
 
-  command_buffer = r->submit_command_buffers[r->frame];
+  ret = owl_draw_flush(r);
+  if (ret)
+    return ret;
 
-  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    r->skybox_pipeline);
+  command_buffer = r->frame_command_buffer;
 
   data = owl_renderer_vertex_allocate(r, sizeof(vertices), &vertex_allocation);
   if (!data)
@@ -424,6 +1024,11 @@ OWLAPI int owl_draw_skybox(struct owl_renderer *r) {
   descriptor_sets[0] = uniform_allocation.common_descriptor_set;
   descriptor_sets[1] = r->skybox.descriptor_set;
 
+  owl_renderer_begin_scope(r, OWL_RENDERER_SCOPE_SKYBOX);
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    r->skybox_pipeline);
+
   vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertex_allocation.buffer,
                          &vertex_allocation.offset);
 
@@ -437,6 +1042,8 @@ OWLAPI int owl_draw_skybox(struct owl_renderer *r) {
 
   vkCmdDrawIndexed(command_buffer, OWL_ARRAY_SIZE(indices), 1, 0, 0, 0);
 
+  owl_renderer_end_scope(r, OWL_RENDERER_SCOPE_SKYBOX);
+
   return OWL_OK;
 }
 
@@ -458,64 +1065,71 @@ OWLAPI int owl_draw_renderer_state(struct owl_renderer *r) {
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "vertex_buffer_size: %llu",
-           r->vertex_buffer_size);
+  snprintf(buffer, sizeof(buffer), "frame_page_size: %llu",
+           r->frame_page_size);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "index_buffer_size: %llu",
-           r->index_buffer_size);
+  snprintf(buffer, sizeof(buffer), "num_frame_pages: %u",
+           r->num_frame_pages[r->frame]);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "uniform_buffer_size: %llu",
-           r->uniform_buffer_size);
+  snprintf(buffer, sizeof(buffer), "upload_buffer_size: %llu",
+           r->upload_buffer_size);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "upload_buffer_size: %llu",
-           r->upload_buffer_size);
+  snprintf(buffer, sizeof(buffer), "frame_last_offset: %llu",
+           r->frame_last_offset);
+
+  owl_draw_text(r, buffer, position, color);
+
+  position[1] += 0.05F;
+
+  snprintf(buffer, sizeof(buffer), "color_memory_size: %llu",
+           r->color_memory_size);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "vertex_buffer_last_offset: %llu",
-           r->vertex_buffer_last_offset);
+  snprintf(buffer, sizeof(buffer), "depth_memory_size: %llu",
+           r->depth_memory_size);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "index_buffer_last_offset: %llu",
-           r->index_buffer_last_offset);
+  snprintf(buffer, sizeof(buffer), "main_pass_ms: %.3f",
+           r->stats.frame_ms[OWL_RENDERER_SCOPE_MAIN_PASS]);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "uniform_buffer_last_offset: %llu",
-           r->uniform_buffer_last_offset);
+  snprintf(buffer, sizeof(buffer), "skybox_ms: %.3f",
+           r->stats.frame_ms[OWL_RENDERER_SCOPE_SKYBOX]);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "color_memory_size: %llu",
-           r->color_memory_size);
+  snprintf(buffer, sizeof(buffer), "model_ms: %.3f",
+           r->stats.frame_ms[OWL_RENDERER_SCOPE_MODEL]);
 
   owl_draw_text(r, buffer, position, color);
 
   position[1] += 0.05F;
 
-  snprintf(buffer, sizeof(buffer), "depth_memory_size: %llu",
-           r->depth_memory_size);
+  snprintf(buffer, sizeof(buffer), "depth_pyramid_ms: %.3f",
+           r->stats.frame_ms[OWL_RENDERER_SCOPE_DEPTH_PYRAMID]);
 
   owl_draw_text(r, buffer, position, color);
 
@@ -524,6 +1138,7 @@ OWLAPI int owl_draw_renderer_state(struct owl_renderer *r) {
 
 OWLAPI int owl_draw_cloth_simulation(struct owl_renderer *r,
                                      struct owl_cloth_simulation *sim) {
+  int ret;
   int32_t i;
   int32_t j;
 
@@ -541,7 +1156,11 @@ OWLAPI int owl_draw_cloth_simulation(struct owl_renderer *r,
 
   VkCommandBuffer command_buffer;
 
-  command_buffer = r->submit_command_buffers[r->frame];
+  ret = owl_draw_flush(r);
+  if (ret)
+    return ret;
+
+  command_buffer = r->frame_command_buffer;
 
   num_indices = (sim->width - 1) * (sim->height - 1) * 6;
   indices = owl_renderer_index_allocate(r, num_indices * sizeof(*indices),
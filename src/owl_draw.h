@@ -6,8 +6,10 @@
 OWL_BEGIN_DECLARATIONS
 
 struct owl_renderer;
+struct owl_thread;
 struct owl_model;
 struct owl_texture;
+struct owl_text;
 struct owl_cloth_simulation;
 struct owl_fluid_simulation;
 
@@ -32,7 +34,8 @@ struct owl_quad {
 };
 
 /**
- * @brief draws a quad to the specifications of the quad struct
+ * @brief draws a quad to the specifications of the quad struct, consecutive
+ * quads with the same texture are batched into a single draw
  *
  * @param vk the renderer instance created with owl_renderer_init(...)
  * @param quad the quad struct describing a quad
@@ -40,6 +43,37 @@ struct owl_quad {
  */
 OWLAPI int owl_draw_quad(struct owl_renderer *r, struct owl_quad const *quad);
 
+/**
+ * @brief draws a quad from a recording thread
+ *
+ * @param t the thread instance, between owl_thread_begin(...) and
+ * owl_thread_end(...)
+ * @param quad the quad struct describing a quad
+ * @return int
+ */
+OWLAPI int owl_draw_thread_quad(struct owl_thread *t,
+                                struct owl_quad const *quad);
+
+/**
+ * @brief records the pending quads, needed before recording commands
+ * directly into the frame command buffer. the other draws and
+ * owl_renderer_end_frame(...) flush on their own
+ *
+ * @param vk the renderer instance created with owl_renderer_init(...)
+ * @return int
+ */
+OWLAPI int owl_draw_flush(struct owl_renderer *r);
+
+/**
+ * @brief records the pending quads of a recording thread, owl_thread_end(...)
+ * flushes on its own
+ *
+ * @param t the thread instance, between owl_thread_begin(...) and
+ * owl_thread_end(...)
+ * @return int
+ */
+OWLAPI int owl_draw_thread_flush(struct owl_thread *t);
+
 /**
  * @brief draw the loaded skybox
  *
@@ -60,9 +94,85 @@ OWLAPI int owl_draw_skybox(struct owl_renderer *r);
 OWLAPI int owl_draw_text(struct owl_renderer *r, char const *text,
                          owl_v3 const position, owl_v3 const color);
 
+/**
+ * @brief draws text from a recording thread, every glyph has to be cached
+ * with owl_font_cache_text(...) on the main thread before the first
+ * owl_thread_begin(...) of the frame or OWL_ERROR_NOT_FOUND is returned
+ *
+ * @param t the thread instance, between owl_thread_begin(...) and
+ * owl_thread_end(...)
+ * @param text the text to draw
+ * @param position the position of the text in normalized coordinates
+ * @param color  the color of the text in normalized values
+ * @return int
+ */
+OWLAPI int owl_draw_thread_text(struct owl_thread *t, char const *text,
+                                owl_v3 const position, owl_v3 const color);
+
+/**
+ * @brief draws text scaled relative to the size the font was loaded with,
+ * only fonts loaded with owl_renderer_load_sdf_font(...) stay sharp
+ *
+ * @param vk the renderer instance created with owl_renderer_init(...)
+ * @param text the text to draw
+ * @param position the position of the text in normalized coordinates
+ * @param scale the scale relative to the loaded font size
+ * @param color  the color of the text in normalized values
+ * @return int
+ */
+OWLAPI int owl_draw_scaled_text(struct owl_renderer *r, char const *text,
+                                owl_v3 const position, float scale,
+                                owl_v3 const color);
+
+/**
+ * @brief draws scaled text from a recording thread, same caching rules as
+ * owl_draw_thread_text(...)
+ *
+ * @param t the thread instance, between owl_thread_begin(...) and
+ * owl_thread_end(...)
+ * @param text the text to draw
+ * @param position the position of the text in normalized coordinates
+ * @param scale the scale relative to the loaded font size
+ * @param color  the color of the text in normalized values
+ * @return int
+ */
+OWLAPI int owl_draw_thread_scaled_text(struct owl_thread *t, char const *text,
+                                       owl_v3 const position, float scale,
+                                       owl_v3 const color);
+
+/**
+ * @brief draws text laid out with owl_text_update(...), a single draw that
+ * doesn't touch the frame allocator unless the layout changed. lays it out
+ * again if a glyph of it was evicted since. a text can only be drawn once a
+ * frame, from the main thread or a single recording thread, drawing it again
+ * fails with OWL_ERROR_INVALID_VALUE
+ *
+ * @param vk the renderer instance created with owl_renderer_init(...)
+ * @param text the text instance created with owl_text_init(...)
+ * @return int
+ */
+OWLAPI int owl_draw_retained_text(struct owl_renderer *r,
+                                  struct owl_text *text);
+
+/**
+ * @brief draws retained text from a recording thread, fails with
+ * OWL_ERROR_INVALID_VALUE if a glyph of the layout was evicted since the last
+ * owl_text_update(...)
+ *
+ * @param t the thread instance, between owl_thread_begin(...) and
+ * owl_thread_end(...)
+ * @param text the text instance created with owl_text_init(...)
+ * @return int
+ */
+OWLAPI int owl_draw_thread_retained_text(struct owl_thread *t,
+                                         struct owl_text *text);
+
 /**
  * @brief draw a model
  *
+ * models with gpu_culled set are culled by a compute pass and drawn with a
+ * single indirect draw, those can only be drawn once per frame
+ *
  * @param vk the renderer instance created with owl_renderer_init(...)
  * @param model the model instance created with owl_model_init(...)
  * @param matrix the model matrix
@@ -71,6 +181,49 @@ OWLAPI int owl_draw_text(struct owl_renderer *r, char const *text,
 OWLAPI int owl_draw_model(struct owl_renderer *r, struct owl_model const *model,
                           owl_m4 matrix);
 
+/**
+ * @brief draw a model from a recording thread
+ *
+ * @param t the thread instance, between owl_thread_begin(...) and
+ * owl_thread_end(...)
+ * @param model the model instance created with owl_model_init(...)
+ * @param matrix the model matrix
+ * @return int
+ */
+OWLAPI int owl_draw_thread_model(struct owl_thread *t,
+                                 struct owl_model const *model, owl_m4 matrix);
+
+/**
+ * @brief draw count copies of a model, every primitive is recorded once
+ *
+ * copies entirely off screen are dropped, the nodes of the rest aren't
+ * culled. without the instanced shader variant every copy is drawn on its
+ * own. gpu culled models are drawn without the culling pass
+ *
+ * @param vk the renderer instance created with owl_renderer_init(...)
+ * @param model the model instance created with owl_model_init(...)
+ * @param matrices the model matrix of every copy
+ * @param count the number of copies
+ * @return int
+ */
+OWLAPI int owl_draw_model_instanced(struct owl_renderer *r,
+                                    struct owl_model const *model,
+                                    owl_m4 *matrices, uint32_t count);
+
+/**
+ * @brief draw count copies of a model from a recording thread
+ *
+ * @param t the thread instance, between owl_thread_begin(...) and
+ * owl_thread_end(...)
+ * @param model the model instance created with owl_model_init(...)
+ * @param matrices the model matrix of every copy
+ * @param count the number of copies
+ * @return int
+ */
+OWLAPI int owl_draw_thread_model_instanced(struct owl_thread *t,
+                                           struct owl_model const *model,
+                                           owl_m4 *matrices, uint32_t count);
+
 /**
  * @brief draws the renderer debug state
  *
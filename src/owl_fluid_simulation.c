@@ -29,23 +29,11 @@ owl_fluid_simulation_buffer_init(struct owl_renderer *r, void const *data,
       goto error;
   }
 
-  {
-    VkDescriptorSetAllocateInfo info;
-    VkResult vk_result;
-
-    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.descriptorPool = r->descriptor_pool;
-    info.descriptorSetCount = 1;
-    info.pSetLayouts = &r->fluid_simulation_source_descriptor_set_layout;
-
-    vk_result = vkAllocateDescriptorSets(device, &info,
-                                         &buffer->storage_descriptor_set);
-    if (vk_result) {
-      ret = OWL_ERROR_FATAL;
-      goto error_deinit_texture;
-    }
-  }
+  ret = owl_renderer_allocate_descriptor_sets(
+      r, 1, &r->fluid_simulation_source_descriptor_set_layout,
+      &buffer->storage_descriptor_set, &buffer->storage_descriptor_pool);
+  if (ret)
+    goto error_deinit_texture;
 
   {
     VkDescriptorImageInfo descriptor;
@@ -85,8 +73,8 @@ owl_fluid_simulation_buffer_deinit(struct owl_renderer *r,
 
   vkDeviceWaitIdle(device);
 
-  vkFreeDescriptorSets(device, r->descriptor_pool, 1,
-                       &buffer->storage_descriptor_set);
+  owl_renderer_free_descriptor_sets(r, buffer->storage_descriptor_pool, 1,
+                                    &buffer->storage_descriptor_set);
   owl_texture_deinit(r, &buffer->texture);
 }
 
@@ -162,21 +150,11 @@ OWLAPI int owl_fluid_simulation_init(struct owl_fluid_simulation *sim,
     sim->uniform = data;
   }
 
-  {
-    VkDescriptorSetAllocateInfo info;
-    VkResult vk_result;
-
-    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.descriptorPool = r->descriptor_pool;
-    info.descriptorSetCount = 1;
-    info.pSetLayouts = &r->fluid_simulation_uniform_descriptor_set_layout;
-
-    vk_result =
-        vkAllocateDescriptorSets(device, &info, &sim->uniform_descriptor_set);
-    if (vk_result)
-      goto error_free_uniform_memory;
-  }
+  ret = owl_renderer_allocate_descriptor_sets(
+      r, 1, &r->fluid_simulation_uniform_descriptor_set_layout,
+      &sim->uniform_descriptor_set, &sim->uniform_descriptor_pool);
+  if (ret)
+    goto error_free_uniform_memory;
 
   {
     VkCommandPoolCreateInfo info;
@@ -335,8 +313,8 @@ error_destroy_command_pool:
   vkDestroyCommandPool(device, sim->command_pool, NULL);
 
 error_free_uniform_descriptor_sets:
-  vkFreeDescriptorSets(device, r->descriptor_pool, 1,
-                       &sim->uniform_descriptor_set);
+  owl_renderer_free_descriptor_sets(r, sim->uniform_descriptor_pool, 1,
+                                    &sim->uniform_descriptor_set);
 
 error_free_uniform_memory:
   vkFreeMemory(device, sim->uniform_memory, NULL);
@@ -368,8 +346,8 @@ OWLAPI void owl_fluid_simulation_deinit(struct owl_fluid_simulation *sim,
 
   vkFreeCommandBuffers(device, sim->command_pool, 1, &sim->command_buffer);
   vkDestroyCommandPool(device, sim->command_pool, NULL);
-  vkFreeDescriptorSets(device, r->descriptor_pool, 1,
-                       &sim->uniform_descriptor_set);
+  owl_renderer_free_descriptor_sets(r, sim->uniform_descriptor_pool, 1,
+                                    &sim->uniform_descriptor_set);
   vkFreeMemory(device, sim->uniform_memory, NULL);
   vkDestroyBuffer(device, sim->uniform_buffer, NULL);
 }
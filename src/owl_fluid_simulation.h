@@ -24,6 +24,7 @@ struct owl_fluid_simulation_push_constant {
 };
 
 struct owl_fluid_simulation_buffer {
+  VkDescriptorPool storage_descriptor_pool;
   VkDescriptorSet storage_descriptor_set;
   struct owl_texture texture;
 };
@@ -36,6 +37,7 @@ struct owl_fluid_simulation {
 
   VkBuffer uniform_buffer;
   VkDeviceMemory uniform_memory;
+  VkDescriptorPool uniform_descriptor_pool;
   VkDescriptorSet uniform_descriptor_set;
   struct owl_fluid_simulation_uniform *uniform;
 
@@ -7,89 +7,440 @@
 
 #include "stb_truetype.h"
 
-#define OWL_FONT_ATLAS_WIDTH 1024
-#define OWL_FONT_ATLAS_HEIGHT 1024
-#define OWL_FONT_ATLAS_SIZE (OWL_FONT_ATLAS_HEIGHT * OWL_FONT_ATLAS_WIDTH)
+#define OWL_FONT_PAGE_SIZE 512
+#define OWL_FONT_SDF_ON_EDGE 128
+#define OWL_FONT_SDF_DISTANCE_SCALE                                            \
+  ((float)OWL_FONT_SDF_ON_EDGE / (float)OWL_FONT_SDF_PADDING)
+
+static int owl_font_init_page(struct owl_renderer *r, struct owl_font *font) {
+  int ret;
+  uint8_t *pixels;
+  struct owl_texture_desc desc;
+
+  pixels = OWL_CALLOC(OWL_FONT_PAGE_SIZE * OWL_FONT_PAGE_SIZE, sizeof(uint8_t));
+  if (!pixels)
+    return OWL_ERROR_NO_MEMORY;
+
+  desc.source = OWL_TEXTURE_SOURCE_DATA;
+  desc.type = OWL_TEXTURE_TYPE_2D;
+  desc.path = NULL;
+  desc.pixels = pixels;
+  desc.width = OWL_FONT_PAGE_SIZE;
+  desc.height = OWL_FONT_PAGE_SIZE;
+  desc.format = OWL_R8_UNORM;
+
+  ret = owl_texture_init(r, &desc, &font->pages[font->num_pages]);
+  if (!ret)
+    ++font->num_pages;
+
+  OWL_FREE(pixels);
+
+  return ret;
+}
 
 OWLAPI int owl_font_init(struct owl_renderer *r, char const *path, int32_t size,
-                         struct owl_font *font) {
+                         int32_t sdf, struct owl_font *font) {
   int ret;
-  uint8_t *bitmap;
-  stbtt_pack_context pack;
-  stbtt_packedchar *packed_chars;
-  struct owl_plataform_file file;
-  struct owl_texture_desc texture_desc;
+  int32_t i;
+  int32_t cell_size;
   int32_t stb_result;
-  int32_t const width = OWL_FONT_ATLAS_WIDTH;
-  int32_t const height = OWL_FONT_ATLAS_HEIGHT;
-  int32_t const first = OWL_FIRST_CHAR;
-  int32_t const num = OWL_NUM_CHARS;
+  stbtt_fontinfo *info;
 
   if (r->font_loaded)
     owl_renderer_unload_font(r);
 
-  ret = owl_plataform_load_file(path, &file);
+  /* a pixel of padding keeps the filtering from bleeding between cells */
+  cell_size = size + 2;
+  if (sdf)
+    cell_size += 2 * OWL_FONT_SDF_PADDING;
+
+  if (0 >= size || OWL_FONT_PAGE_SIZE < cell_size)
+    return OWL_ERROR_INVALID_VALUE;
+
+  ret = owl_plataform_load_file(path, &font->file);
   if (ret)
     return ret;
 
-  bitmap = OWL_CALLOC(OWL_FONT_ATLAS_SIZE, sizeof(uint8_t));
-  if (!bitmap) {
+  info = OWL_MALLOC(sizeof(*info));
+  if (!info) {
     ret = OWL_ERROR_NO_MEMORY;
     goto error_unload_file;
   }
 
-  stb_result = stbtt_PackBegin(&pack, bitmap, width, height, 0, 1, NULL);
+  stb_result = stbtt_InitFont(
+      info, font->file.data, stbtt_GetFontOffsetForIndex(font->file.data, 0));
   if (!stb_result) {
     ret = OWL_ERROR_FATAL;
-    goto error_free_bitmap;
+    goto error_free_info;
   }
 
-  stbtt_PackSetOversampling(&pack, 2, 2);
+  font->info = info;
+  font->sdf = sdf;
+  font->scale = stbtt_ScaleForPixelHeight(info, (float)size);
+  font->cell_size = (uint32_t)cell_size;
+  font->cells_per_row = OWL_FONT_PAGE_SIZE / font->cell_size;
+  font->cells_per_page = font->cells_per_row * font->cells_per_row;
+  font->max_glyphs =
+      OWL_MIN(OWL_FONT_MAX_GLYPHS, OWL_FONT_MAX_PAGES * font->cells_per_page);
+  font->num_pages = 0;
+  font->num_glyphs = 0;
 
-  packed_chars = (stbtt_packedchar *)(&font->chars[0]);
+  for (i = 0; i < OWL_FONT_NUM_BUCKETS; ++i)
+    font->buckets[i] = -1;
 
-  stb_result =
-      stbtt_PackFontRange(&pack, file.data, 0, size, first, num, packed_chars);
-  if (!stb_result) {
-    ret = OWL_ERROR_FATAL;
-    goto error_pack_end;
-  }
-
-  texture_desc.source = OWL_TEXTURE_SOURCE_DATA;
-  texture_desc.type = OWL_TEXTURE_TYPE_2D;
-  texture_desc.path = NULL;
-  texture_desc.pixels = bitmap;
-  texture_desc.width = OWL_FONT_ATLAS_WIDTH;
-  texture_desc.height = OWL_FONT_ATLAS_HEIGHT;
-  texture_desc.format = OWL_R8_UNORM;
+  /* the rest of the pages are created once the first one fills up */
+  ret = owl_font_init_page(r, font);
+  if (ret)
+    goto error_free_info;
 
-  ret = owl_texture_init(r, &texture_desc, &font->atlas);
-  if (!ret)
-    r->font_loaded = 1;
+  r->font_loaded = 1;
 
-error_pack_end:
-  stbtt_PackEnd(&pack);
+  return OWL_OK;
 
-error_free_bitmap:
-  OWL_FREE(bitmap);
+error_free_info:
+  OWL_FREE(info);
 
 error_unload_file:
-  owl_plataform_unload_file(&file);
+  owl_plataform_unload_file(&font->file);
 
   return ret;
 }
 
 OWLAPI void owl_font_deinit(struct owl_renderer *r, struct owl_font *font) {
-  owl_texture_deinit(r, &font->atlas);
+  uint32_t i;
+
+  for (i = 0; i < font->num_pages; ++i)
+    owl_texture_deinit(r, &font->pages[i]);
+
+  OWL_FREE(font->info);
+  owl_plataform_unload_file(&font->file);
+}
+
+OWLAPI uint32_t owl_font_next_codepoint(char const **text) {
+  uint32_t i;
+  uint32_t length;
+  uint32_t codepoint;
+  uint8_t const *it = (uint8_t const *)*text;
+
+  if (0x80 > it[0]) {
+    codepoint = it[0];
+    length = 1;
+  } else if (0xC0 == (it[0] & 0xE0)) {
+    codepoint = it[0] & 0x1F;
+    length = 2;
+  } else if (0xE0 == (it[0] & 0xF0)) {
+    codepoint = it[0] & 0x0F;
+    length = 3;
+  } else if (0xF0 == (it[0] & 0xF8)) {
+    codepoint = it[0] & 0x07;
+    length = 4;
+  } else {
+    *text += 1;
+    return 0xFFFD;
+  }
+
+  for (i = 1; i < length; ++i) {
+    /* a truncated sequence stops at the terminator too */
+    if (0x80 != (it[i] & 0xC0)) {
+      *text += i;
+      return 0xFFFD;
+    }
+
+    codepoint = (codepoint << 6) | (it[i] & 0x3F);
+  }
+
+  *text += length;
+
+  return codepoint;
 }
 
-OWLAPI int owl_font_fill_glyph(struct owl_font *font, char c, owl_v2 offset,
-                               int32_t w, int32_t h, struct owl_glyph *glyph) {
-  stbtt_aligned_quad quad;
-  int const atlas_width = OWL_FONT_ATLAS_WIDTH;
-  int const atlas_height = OWL_FONT_ATLAS_HEIGHT;
-  stbtt_packedchar *packed_chars = (stbtt_packedchar *)(&font->chars[0]);
+static int32_t owl_font_find_glyph(struct owl_font const *font,
+                                   uint32_t codepoint) {
+  int32_t i = font->buckets[codepoint % OWL_FONT_NUM_BUCKETS];
+
+  for (; -1 != i; i = font->glyphs[i].next)
+    if (codepoint == font->glyphs[i].codepoint)
+      return i;
+
+  return -1;
+}
+
+static void owl_font_remove_glyph(struct owl_font *font, int32_t glyph) {
+  uint32_t const codepoint = font->glyphs[glyph].codepoint;
+  int32_t *link = &font->buckets[codepoint % OWL_FONT_NUM_BUCKETS];
+
+  while (glyph != *link)
+    link = &font->glyphs[*link].next;
+
+  *link = font->glyphs[glyph].next;
+}
+
+/* a free cell, or the least recently used one once every page is full */
+static int owl_font_find_cell(struct owl_renderer *r, struct owl_font *font,
+                              int32_t *cell) {
+  int ret;
+  uint32_t i;
+  int32_t lru = -1;
+
+  if (font->num_glyphs < font->max_glyphs) {
+    if (font->num_glyphs == font->num_pages * font->cells_per_page) {
+      ret = owl_font_init_page(r, font);
+      if (ret)
+        return ret;
+    }
+
+    *cell = (int32_t)font->num_glyphs++;
+
+    return OWL_OK;
+  }
+
+  for (i = 0; i < font->num_glyphs; ++i) {
+    uint64_t const last_used = font->glyphs[i].last_used;
+
+    /* still sampled by a frame in flight, or laid out this frame */
+    if (r->frame_count < last_used + r->num_frames)
+      continue;
+
+    if (-1 == lru || last_used < font->glyphs[lru].last_used)
+      lru = (int32_t)i;
+  }
+
+  if (-1 == lru)
+    return OWL_ERROR_NO_SPACE;
+
+  owl_font_remove_glyph(font, lru);
+
+  /* retained text laid out with the evicted glyph has to be laid out again */
+  ++r->font_generation;
+
+  *cell = lru;
+
+  return OWL_OK;
+}
+
+/* writes the glyph into bitmap, which has a row per cell_size bytes */
+static void owl_font_rasterize(struct owl_font const *font, uint32_t codepoint,
+                               uint8_t *bitmap, struct owl_font_glyph *glyph) {
+  int32_t x0;
+  int32_t y0;
+  int32_t x1;
+  int32_t y1;
+  int32_t advance;
+  int32_t bearing;
+  stbtt_fontinfo const *info = font->info;
+  int32_t const max_size = (int32_t)font->cell_size - 1;
+
+  stbtt_GetCodepointHMetrics(info, (int)codepoint, &advance, &bearing);
+  glyph->x_advance = (float)advance * font->scale;
+
+  if (font->sdf) {
+    int32_t i;
+    int32_t width;
+    int32_t height;
+    uint8_t *sdf;
+
+    sdf = stbtt_GetCodepointSDF(info, font->scale, (int)codepoint,
+                                OWL_FONT_SDF_PADDING, OWL_FONT_SDF_ON_EDGE,
+                                OWL_FONT_SDF_DISTANCE_SCALE, &width, &height,
+                                &x0, &y0);
+
+    /* nothing to draw, spaces and the like */
+    if (!sdf) {
+      glyph->x_offset = 0;
+      glyph->y_offset = 0;
+      glyph->width = 0;
+      glyph->height = 0;
+      return;
+    }
+
+    glyph->x_offset = x0;
+    glyph->y_offset = y0;
+    glyph->width = OWL_MIN(width, max_size);
+    glyph->height = OWL_MIN(height, max_size);
+
+    for (i = 0; i < glyph->height; ++i)
+      OWL_MEMCPY(&bitmap[i * font->cell_size], &sdf[i * width],
+                 (uint32_t)glyph->width);
+
+    stbtt_FreeSDF(sdf, NULL);
+
+    return;
+  }
+
+  stbtt_GetCodepointBitmapBox(info, (int)codepoint, font->scale, font->scale,
+                              &x0, &y0, &x1, &y1);
+
+  glyph->x_offset = x0;
+  glyph->y_offset = y0;
+  glyph->width = OWL_MIN(x1 - x0, max_size);
+  glyph->height = OWL_MIN(y1 - y0, max_size);
+
+  if (glyph->width && glyph->height)
+    stbtt_MakeCodepointBitmap(info, bitmap, glyph->width, glyph->height,
+                              (int)font->cell_size, font->scale, font->scale,
+                              (int)codepoint);
+}
+
+OWLAPI int owl_font_cache_text(struct owl_renderer *r, struct owl_font *font,
+                               char const *text) {
   int ret = OWL_OK;
+  uint32_t i;
+  uint32_t num_misses = 0;
+  uint32_t num_copies = 0;
+  uint8_t *data;
+  char const *it;
+  uint32_t *pages;
+  VkBufferImageCopy *copies;
+  struct owl_renderer_upload_allocation upload;
+  uint64_t const cell_size = font->cell_size * font->cell_size;
+
+  for (it = text; '\0' != *it;) {
+    int32_t const glyph =
+        owl_font_find_glyph(font, owl_font_next_codepoint(&it));
+
+    if (-1 == glyph)
+      ++num_misses;
+    else
+      font->glyphs[glyph].last_used = r->frame_count;
+  }
+
+  if (!num_misses)
+    return OWL_OK;
+
+  /* threads walk the buckets without a lock, nothing can be linked in or
+   * evicted while they record */
+  if (r->num_frame_threads) {
+    OWL_ASSERT(0 && "glyphs cached after a thread began");
+    return OWL_ERROR_INVALID_VALUE;
+  }
+
+  /* every miss gets a whole cell, clearing whatever an evicted glyph left */
+  data = owl_renderer_upload_allocate(r, num_misses * cell_size, &upload);
+  if (!data)
+    return OWL_ERROR_NO_UPLOAD_MEMORY;
+
+  OWL_MEMSET(data, 0, num_misses * cell_size);
+
+  copies = OWL_MALLOC(num_misses * 2 * sizeof(*copies));
+  if (!copies) {
+    ret = OWL_ERROR_NO_MEMORY;
+    goto out_free_upload;
+  }
+
+  pages = OWL_MALLOC(num_misses * sizeof(*pages));
+  if (!pages) {
+    ret = OWL_ERROR_NO_MEMORY;
+    goto out_free_copies;
+  }
+
+  for (it = text; '\0' != *it;) {
+    int32_t cell;
+    uint32_t page_cell;
+    struct owl_font_glyph *glyph;
+    VkBufferImageCopy *copy = &copies[num_copies];
+    uint32_t const codepoint = owl_font_next_codepoint(&it);
+
+    /* repeated in the text, already rasterized */
+    if (-1 != owl_font_find_glyph(font, codepoint))
+      continue;
+
+    /* upload the glyphs rasterized so far before failing */
+    ret = owl_font_find_cell(r, font, &cell);
+    if (ret)
+      break;
+
+    glyph = &font->glyphs[cell];
+    glyph->codepoint = codepoint;
+    glyph->last_used = r->frame_count;
+
+    owl_font_rasterize(font, codepoint, &data[num_copies * cell_size], glyph);
+
+    glyph->next = font->buckets[codepoint % OWL_FONT_NUM_BUCKETS];
+    font->buckets[codepoint % OWL_FONT_NUM_BUCKETS] = cell;
+
+    page_cell = (uint32_t)cell % font->cells_per_page;
+
+    copy->bufferOffset = upload.offset + num_copies * cell_size;
+    copy->bufferRowLength = 0;
+    copy->bufferImageHeight = 0;
+    copy->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy->imageSubresource.mipLevel = 0;
+    copy->imageSubresource.baseArrayLayer = 0;
+    copy->imageSubresource.layerCount = 1;
+    copy->imageOffset.x =
+        (int32_t)((page_cell % font->cells_per_row) * font->cell_size);
+    copy->imageOffset.y =
+        (int32_t)((page_cell / font->cells_per_row) * font->cell_size);
+    copy->imageOffset.z = 0;
+    copy->imageExtent.width = font->cell_size;
+    copy->imageExtent.height = font->cell_size;
+    copy->imageExtent.depth = 1;
+
+    pages[num_copies++] = (uint32_t)cell / font->cells_per_page;
+  }
+
+  /* one submit per page that got new glyphs */
+  for (i = 0; i < font->num_pages; ++i) {
+    int update_ret;
+    uint32_t j;
+    uint32_t num_page_copies = 0;
+    VkBufferImageCopy *page_copies = &copies[num_misses];
+
+    for (j = 0; j < num_copies; ++j)
+      if (i == pages[j])
+        page_copies[num_page_copies++] = copies[j];
+
+    if (!num_page_copies)
+      continue;
+
+    update_ret = owl_texture_update(r, &font->pages[i], upload.buffer,
+                                    num_page_copies, page_copies);
+    if (update_ret)
+      ret = update_ret;
+  }
+
+  OWL_FREE(pages);
+
+out_free_copies:
+  OWL_FREE(copies);
+
+out_free_upload:
+  owl_renderer_upload_free(r, data);
+
+  return ret;
+}
+
+OWLAPI void owl_font_touch_glyph(struct owl_renderer *r, struct owl_font *font,
+                                 int32_t cell) {
+  font->glyphs[cell].last_used = r->frame_count;
+}
+
+OWLAPI void owl_font_touch_glyphs(struct owl_renderer *r, struct owl_font *font,
+                                  uint32_t const *cells) {
+  uint32_t i;
+
+  for (i = 0; i < font->num_glyphs; ++i)
+    if (cells[i / 32] & (1U << (i % 32)))
+      font->glyphs[i].last_used = r->frame_count;
+}
+
+OWLAPI int owl_font_fill_glyph(struct owl_renderer *r, struct owl_font *font,
+                               uint32_t codepoint, float scale, owl_v2 offset,
+                               struct owl_glyph *glyph) {
+  float x0;
+  float y0;
+  float x1;
+  float y1;
+  float u0;
+  float v0;
+  float u1;
+  float v1;
+  uint32_t page_cell;
+  struct owl_font_glyph const *cached;
+  float const w = (float)r->width;
+  float const h = (float)r->height;
+  float const page_size = (float)OWL_FONT_PAGE_SIZE;
+  int32_t const cell = owl_font_find_glyph(font, codepoint);
 
   /* -1 ---- +
    *  |      |  h
@@ -97,18 +448,37 @@ OWLAPI int owl_font_fill_glyph(struct owl_font *font, char c, owl_v2 offset,
    *  + ---- 1
    *     w      */
 
-  stbtt_GetPackedQuad(packed_chars, atlas_width, atlas_height,
-                      c - OWL_FIRST_CHAR, &offset[0], &offset[1], &quad, 1);
+  if (-1 == cell)
+    return OWL_ERROR_NOT_FOUND;
 
-  OWL_V3_SET(glyph->positions[0], quad.x0 / (float)w, quad.y0 / (float)h, 0.0F);
-  OWL_V3_SET(glyph->positions[1], quad.x1 / (float)w, quad.y0 / (float)h, 0.0F);
-  OWL_V3_SET(glyph->positions[2], quad.x0 / (float)w, quad.y1 / (float)h, 0.0F);
-  OWL_V3_SET(glyph->positions[3], quad.x1 / (float)w, quad.y1 / (float)h, 0.0F);
+  cached = &font->glyphs[cell];
 
-  OWL_V2_SET(glyph->uvs[0], quad.s0, quad.t0);
-  OWL_V2_SET(glyph->uvs[1], quad.s1, quad.t0);
-  OWL_V2_SET(glyph->uvs[2], quad.s0, quad.t1);
-  OWL_V2_SET(glyph->uvs[3], quad.s1, quad.t1);
+  x0 = offset[0] + scale * (float)cached->x_offset;
+  y0 = offset[1] + scale * (float)cached->y_offset;
+  x1 = x0 + scale * (float)cached->width;
+  y1 = y0 + scale * (float)cached->height;
 
-  return ret;
+  OWL_V3_SET(glyph->positions[0], x0 / w, y0 / h, 0.0F);
+  OWL_V3_SET(glyph->positions[1], x1 / w, y0 / h, 0.0F);
+  OWL_V3_SET(glyph->positions[2], x0 / w, y1 / h, 0.0F);
+  OWL_V3_SET(glyph->positions[3], x1 / w, y1 / h, 0.0F);
+
+  page_cell = (uint32_t)cell % font->cells_per_page;
+
+  u0 = (float)((page_cell % font->cells_per_row) * font->cell_size);
+  v0 = (float)((page_cell / font->cells_per_row) * font->cell_size);
+  u1 = u0 + (float)cached->width;
+  v1 = v0 + (float)cached->height;
+
+  OWL_V2_SET(glyph->uvs[0], u0 / page_size, v0 / page_size);
+  OWL_V2_SET(glyph->uvs[1], u1 / page_size, v0 / page_size);
+  OWL_V2_SET(glyph->uvs[2], u0 / page_size, v1 / page_size);
+  OWL_V2_SET(glyph->uvs[3], u1 / page_size, v1 / page_size);
+
+  glyph->texture = &font->pages[(uint32_t)cell / font->cells_per_page];
+  glyph->cell = cell;
+
+  offset[0] += scale * cached->x_advance;
+
+  return OWL_OK;
 }
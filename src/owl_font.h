@@ -2,44 +2,104 @@
 #define OWL_FONT_H
 
 #include "owl_definitions.h"
+#include "owl_plataform.h"
 #include "owl_texture.h"
 
 OWL_BEGIN_DECLARATIONS
 
 struct owl_renderer;
 
-#define OWL_FIRST_CHAR ((int)(' '))
-#define OWL_NUM_CHARS ((int)('~' - ' '))
+#define OWL_FONT_MAX_PAGES 8
+#define OWL_FONT_MAX_GLYPHS 4096
+#define OWL_FONT_NUM_BUCKETS 1024
+/* distance field texels around every glyph, the farthest distance stored */
+#define OWL_FONT_SDF_PADDING 4
 
-struct owl_packed_char {
-  uint16_t x0;
-  uint16_t y0;
-  uint16_t x1;
-  uint16_t y1;
-  float x_offset;
-  float y_offset;
+/* a rasterized glyph, lives in a fixed size cell of one of the pages. cell i
+ * is cell i % cells_per_page of page i / cells_per_page */
+struct owl_font_glyph {
+  uint32_t codepoint;
+  /* next glyph in the same bucket, -1 at the end */
+  int32_t next;
+  /* renderer frame_count of the last frame that laid it out */
+  uint64_t last_used;
+  /* bitmap box relative to the pen, in pixels */
+  int32_t x_offset;
+  int32_t y_offset;
+  int32_t width;
+  int32_t height;
   float x_advance;
-  float x_offset2;
-  float y_offset2;
 };
 
 struct owl_glyph {
   owl_v3 positions[4];
   owl_v2 uvs[4];
+  struct owl_texture *texture;
+  /* atlas cell it was laid out from */
+  int32_t cell;
 };
 
+/*
+ * glyphs are rasterized the first time they are used and packed into atlas
+ * pages, pages are created as they are needed. once every page is full the
+ * least recently used glyph that no frame in flight is using is evicted.
+ *
+ * recording threads only read the font. every glyph they lay out has to be
+ * cached before the first owl_thread_begin of the frame, nothing is cached
+ * or evicted after that until owl_renderer_end_frame.
+ */
 struct owl_font {
-  struct owl_texture atlas;
-  struct owl_packed_char chars[OWL_NUM_CHARS];
+  struct owl_plataform_file file;
+  /* stbtt_fontinfo, kept out of the header */
+  void *info;
+  /* glyphs are stored as signed distance fields instead of coverage */
+  int32_t sdf;
+  float scale;
+  uint32_t cell_size;
+  uint32_t cells_per_row;
+  uint32_t cells_per_page;
+  uint32_t max_glyphs;
+
+  uint32_t num_pages;
+  struct owl_texture pages[OWL_FONT_MAX_PAGES];
+
+  uint32_t num_glyphs;
+  struct owl_font_glyph glyphs[OWL_FONT_MAX_GLYPHS];
+  int32_t buckets[OWL_FONT_NUM_BUCKETS];
 };
 
 OWLAPI int owl_font_init(struct owl_renderer *r, char const *path, int32_t size,
-                         struct owl_font *font);
+                         int32_t sdf, struct owl_font *font);
 
 OWLAPI void owl_font_deinit(struct owl_renderer *r, struct owl_font *font);
 
-OWLAPI int owl_font_fill_glyph(struct owl_font *font, char c, owl_v2 offset,
-                               int32_t w, int32_t h, struct owl_glyph *glyph);
+/* decodes the utf-8 codepoint text points to and moves text past it, invalid
+ * sequences decode to U+FFFD */
+OWLAPI uint32_t owl_font_next_codepoint(char const **text);
+
+/* main thread only, rasterizes and uploads every glyph of the utf-8 text that
+ * isn't in the atlas yet. OWL_ERROR_INVALID_VALUE if a glyph is missing while
+ * a thread is recording */
+OWLAPI int owl_font_cache_text(struct owl_renderer *r, struct owl_font *font,
+                               char const *text);
+
+/* main thread only, keeps the glyph in cell from being evicted while this
+ * frame is in flight */
+OWLAPI void owl_font_touch_glyph(struct owl_renderer *r, struct owl_font *font,
+                                 int32_t cell);
+
+/* main thread only, touches every cell set in the OWL_FONT_MAX_GLYPHS bit set,
+ * the cells recording threads laid glyphs out from */
+OWLAPI void owl_font_touch_glyphs(struct owl_renderer *r, struct owl_font *font,
+                                  uint32_t const *cells);
+
+/* lays out a cached glyph at offset and advances it, OWL_ERROR_NOT_FOUND if
+ * the glyph isn't in the atlas. scale is relative to the loaded size, only
+ * distance field fonts stay sharp away from 1. doesn't write to the font, the
+ * glyph still has to be touched */
+OWLAPI int owl_font_fill_glyph(struct owl_renderer *r, struct owl_font *font,
+                               uint32_t codepoint, float scale, owl_v2 offset,
+                               struct owl_glyph *glyph);
 
 OWL_END_DECLARATIONS
 
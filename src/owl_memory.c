@@ -0,0 +1,359 @@
+#include "owl_memory.h"
+
+#include "owl_internal.h"
+#include "owl_renderer.h"
+
+#define OWL_MEMORY_NUM_NODES (1UL << (OWL_MEMORY_NUM_LEVELS + 1))
+
+OWLAPI int owl_memory_init(struct owl_renderer *r) {
+  uint32_t i;
+  VkPhysicalDeviceProperties properties;
+  struct owl_memory *memory = &r->memory;
+
+  vkGetPhysicalDeviceProperties(r->physical_device, &properties);
+
+  /* linear and optimal resources can share a block, keeping every range
+   * granularity aligned stops them from aliasing a page */
+  memory->granularity = properties.limits.bufferImageGranularity;
+
+  for (i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+    memory->pools[i].num_blocks = 0;
+    memory->pools[i].num_dedicated = 0;
+    memory->pools[i].dedicated_size = 0;
+  }
+
+  return OWL_OK;
+}
+
+OWLAPI void owl_memory_deinit(struct owl_renderer *r) {
+  uint32_t i;
+  uint32_t j;
+  struct owl_memory *memory = &r->memory;
+
+  for (i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+    struct owl_memory_pool *pool = &memory->pools[i];
+
+    for (j = 0; j < pool->num_blocks; ++j) {
+      struct owl_memory_block *block = &pool->blocks[j];
+
+      OWL_ASSERT(!block->num_allocations);
+
+      vkFreeMemory(r->device, block->memory, NULL);
+      OWL_FREE(block->levels);
+    }
+
+    pool->num_blocks = 0;
+  }
+}
+
+static int owl_memory_is_host_visible(struct owl_renderer *r, uint32_t type) {
+  VkPhysicalDeviceMemoryProperties properties;
+
+  vkGetPhysicalDeviceMemoryProperties(r->physical_device, &properties);
+
+  return !!(properties.memoryTypes[type].propertyFlags &
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+}
+
+static int owl_memory_init_device_memory(struct owl_renderer *r, uint32_t type,
+                                         uint64_t size, VkDeviceMemory *memory,
+                                         uint8_t **data) {
+  VkResult vk_result;
+
+  {
+    VkMemoryAllocateInfo info;
+
+    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.allocationSize = size;
+    info.memoryTypeIndex = type;
+
+    vk_result = vkAllocateMemory(r->device, &info, NULL, memory);
+    if (vk_result)
+      return OWL_ERROR_NO_MEMORY;
+  }
+
+  *data = NULL;
+
+  if (owl_memory_is_host_visible(r, type)) {
+    void *mapped;
+
+    vk_result = vkMapMemory(r->device, *memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+    if (vk_result) {
+      vkFreeMemory(r->device, *memory, NULL);
+      return OWL_ERROR_FATAL;
+    }
+
+    *data = mapped;
+  }
+
+  return OWL_OK;
+}
+
+static int owl_memory_init_block(struct owl_renderer *r, uint32_t type,
+                                 struct owl_memory_block *block) {
+  int ret;
+  uint32_t i;
+  uint32_t level;
+
+  block->levels = OWL_MALLOC(OWL_MEMORY_NUM_NODES);
+  if (!block->levels)
+    return OWL_ERROR_NO_MEMORY;
+
+  ret = owl_memory_init_device_memory(r, type, OWL_MEMORY_BLOCK_SIZE,
+                                      &block->memory, &block->data);
+  if (ret) {
+    OWL_FREE(block->levels);
+    return ret;
+  }
+
+  /* every node starts free, nodes at depth d are OWL_MEMORY_NUM_LEVELS - d */
+  level = OWL_MEMORY_NUM_LEVELS;
+  for (i = 1; i < OWL_MEMORY_NUM_NODES; ++i) {
+    if (!(i & (i - 1)) && 1 != i)
+      --level;
+
+    block->levels[i] = (uint8_t)(level + 1);
+  }
+
+  block->used_size = 0;
+  block->num_allocations = 0;
+
+  return OWL_OK;
+}
+
+/* recomputes the parents of a node after it changed */
+static void owl_memory_update_parents(struct owl_memory_block *block,
+                                      uint32_t node, uint32_t level) {
+  while (1 < node) {
+    uint8_t left;
+    uint8_t right;
+
+    node >>= 1;
+    ++level;
+
+    left = block->levels[node * 2];
+    right = block->levels[node * 2 + 1];
+
+    /* both halves free merge back into the whole range */
+    if (level == left && level == right)
+      block->levels[node] = (uint8_t)(level + 1);
+    else
+      block->levels[node] = OWL_MAX(left, right);
+  }
+}
+
+static int owl_memory_block_allocate(struct owl_memory_block *block,
+                                     uint32_t level, uint64_t *offset) {
+  uint32_t node = 1;
+  uint32_t node_level = OWL_MEMORY_NUM_LEVELS;
+
+  if (block->levels[1] < level + 1)
+    return OWL_ERROR_NO_SPACE;
+
+  while (node_level != level) {
+    node *= 2;
+    --node_level;
+
+    /* prefer the left half to keep the free space packed at the end */
+    if (block->levels[node] < level + 1)
+      ++node;
+  }
+
+  block->levels[node] = 0;
+  owl_memory_update_parents(block, node, level);
+
+  *offset = (uint64_t)(node - (1UL << (OWL_MEMORY_NUM_LEVELS - level)))
+            << (level + OWL_MEMORY_MIN_ORDER);
+
+  return OWL_OK;
+}
+
+static void owl_memory_block_free(struct owl_memory_block *block,
+                                  uint32_t level, uint64_t offset) {
+  uint32_t node;
+
+  node = (uint32_t)(offset >> (level + OWL_MEMORY_MIN_ORDER));
+  node += 1UL << (OWL_MEMORY_NUM_LEVELS - level);
+
+  OWL_ASSERT(!block->levels[node]);
+
+  block->levels[node] = (uint8_t)(level + 1);
+  owl_memory_update_parents(block, node, level);
+}
+
+OWLAPI int owl_memory_allocate(struct owl_renderer *r,
+                               VkMemoryRequirements const *requirements,
+                               uint32_t properties,
+                               struct owl_memory_allocation *alloc) {
+  int ret;
+  uint32_t i;
+  uint32_t order;
+  uint64_t size;
+  struct owl_memory_pool *pool;
+  struct owl_memory *memory = &r->memory;
+
+  alloc->type = owl_renderer_find_memory_type(
+      r, requirements->memoryTypeBits, properties);
+  pool = &memory->pools[alloc->type];
+
+  /* ranges are aligned to their own size, a big enough range satisfies the
+   * alignment and the granularity */
+  size = requirements->size;
+  size = OWL_MAX(size, requirements->alignment);
+  size = OWL_MAX(size, memory->granularity);
+
+  order = OWL_MEMORY_MIN_ORDER;
+  while (((uint64_t)1 << order) < size && order <= OWL_MEMORY_MAX_ORDER)
+    ++order;
+
+  if (OWL_MEMORY_MAX_ORDER < order) {
+    uint8_t *data;
+
+    ret = owl_memory_init_device_memory(r, alloc->type, requirements->size,
+                                        &alloc->memory, &data);
+    if (ret)
+      return ret;
+
+    alloc->offset = 0;
+    alloc->size = requirements->size;
+    alloc->data = data;
+    alloc->block = -1;
+
+    ++pool->num_dedicated;
+    pool->dedicated_size += alloc->size;
+
+    return OWL_OK;
+  }
+
+  alloc->size = (uint64_t)1 << order;
+
+  for (i = 0; i < pool->num_blocks; ++i) {
+    struct owl_memory_block *block = &pool->blocks[i];
+
+    ret = owl_memory_block_allocate(block, order - OWL_MEMORY_MIN_ORDER,
+                                    &alloc->offset);
+    if (!ret)
+      goto out;
+  }
+
+  if (OWL_MAX_MEMORY_BLOCKS <= pool->num_blocks)
+    return OWL_ERROR_NO_MEMORY;
+
+  ret = owl_memory_init_block(r, alloc->type, &pool->blocks[i]);
+  if (ret)
+    return ret;
+
+  ++pool->num_blocks;
+
+  ret = owl_memory_block_allocate(&pool->blocks[i],
+                                  order - OWL_MEMORY_MIN_ORDER, &alloc->offset);
+  OWL_ASSERT(!ret);
+
+out:
+  pool->blocks[i].used_size += alloc->size;
+  ++pool->blocks[i].num_allocations;
+
+  alloc->memory = pool->blocks[i].memory;
+  alloc->block = (int32_t)i;
+
+  if (pool->blocks[i].data)
+    alloc->data = &pool->blocks[i].data[alloc->offset];
+  else
+    alloc->data = NULL;
+
+  return OWL_OK;
+}
+
+OWLAPI void owl_memory_free(struct owl_renderer *r,
+                            struct owl_memory_allocation *alloc) {
+  uint32_t order;
+  struct owl_memory_block *block;
+  struct owl_memory_pool *pool = &r->memory.pools[alloc->type];
+
+  if (!alloc->memory)
+    return;
+
+  if (-1 == alloc->block) {
+    vkFreeMemory(r->device, alloc->memory, NULL);
+
+    --pool->num_dedicated;
+    pool->dedicated_size -= alloc->size;
+
+    alloc->memory = VK_NULL_HANDLE;
+
+    return;
+  }
+
+  block = &pool->blocks[alloc->block];
+
+  order = OWL_MEMORY_MIN_ORDER;
+  while (((uint64_t)1 << order) < alloc->size)
+    ++order;
+
+  owl_memory_block_free(block, order - OWL_MEMORY_MIN_ORDER, alloc->offset);
+
+  block->used_size -= alloc->size;
+  --block->num_allocations;
+
+  /* blocks are kept around once created, loading the next level is likely
+   * to need them again */
+  alloc->memory = VK_NULL_HANDLE;
+}
+
+OWLAPI int owl_memory_bind_buffer(struct owl_renderer *r, VkBuffer buffer,
+                                  struct owl_memory_allocation *alloc) {
+  VkResult vk_result;
+
+  vk_result =
+      vkBindBufferMemory(r->device, buffer, alloc->memory, alloc->offset);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
+
+  return OWL_OK;
+}
+
+OWLAPI int owl_memory_bind_image(struct owl_renderer *r, VkImage image,
+                                 struct owl_memory_allocation *alloc) {
+  VkResult vk_result;
+
+  vk_result = vkBindImageMemory(r->device, image, alloc->memory, alloc->offset);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
+
+  return OWL_OK;
+}
+
+OWLAPI void owl_memory_get_stats(struct owl_renderer *r, uint32_t type,
+                                 struct owl_memory_stats *stats) {
+  uint32_t i;
+  uint64_t free_size;
+  struct owl_memory_pool *pool = &r->memory.pools[type];
+
+  stats->num_blocks = pool->num_blocks;
+  stats->num_allocations = 0;
+  stats->num_dedicated = pool->num_dedicated;
+  stats->reserved_size = pool->num_blocks * OWL_MEMORY_BLOCK_SIZE;
+  stats->used_size = 0;
+  stats->dedicated_size = pool->dedicated_size;
+  stats->largest_free_size = 0;
+  stats->fragmentation = 0.0F;
+
+  for (i = 0; i < pool->num_blocks; ++i) {
+    uint64_t largest = 0;
+    struct owl_memory_block *block = &pool->blocks[i];
+
+    if (block->levels[1])
+      largest = (uint64_t)1 << (block->levels[1] - 1 + OWL_MEMORY_MIN_ORDER);
+
+    stats->num_allocations += block->num_allocations;
+    stats->used_size += block->used_size;
+    stats->largest_free_size = OWL_MAX(stats->largest_free_size, largest);
+  }
+
+  free_size = stats->reserved_size - stats->used_size;
+
+  if (free_size)
+    stats->fragmentation =
+        1.0F - (float)stats->largest_free_size / (float)free_size;
+}
@@ -0,0 +1,92 @@
+#ifndef OWL_MEMORY_H
+#define OWL_MEMORY_H
+
+#include "owl_definitions.h"
+
+#include <vulkan/vulkan.h>
+
+OWL_BEGIN_DECLARATIONS
+
+struct owl_renderer;
+
+#define OWL_MEMORY_MIN_ORDER 10
+#define OWL_MEMORY_MAX_ORDER 26
+#define OWL_MEMORY_NUM_LEVELS (OWL_MEMORY_MAX_ORDER - OWL_MEMORY_MIN_ORDER)
+#define OWL_MEMORY_BLOCK_SIZE (1UL << OWL_MEMORY_MAX_ORDER)
+#define OWL_MAX_MEMORY_BLOCKS 16
+
+/*
+ * a VkDeviceMemory split into power of two ranges. levels is a buddy tree
+ * with the root at index 1, every node stores the level of the largest free
+ * range under it plus one, 0 meaning everything under it is taken.
+ */
+struct owl_memory_block {
+  VkDeviceMemory memory;
+  /* mapped once at creation when the memory type is host visible */
+  uint8_t *data;
+  uint8_t *levels;
+  uint64_t used_size;
+  uint32_t num_allocations;
+};
+
+struct owl_memory_pool {
+  uint32_t num_blocks;
+  struct owl_memory_block blocks[OWL_MAX_MEMORY_BLOCKS];
+  /* requests bigger than a block get their own VkDeviceMemory */
+  uint32_t num_dedicated;
+  uint64_t dedicated_size;
+};
+
+struct owl_memory {
+  uint64_t granularity;
+  struct owl_memory_pool pools[VK_MAX_MEMORY_TYPES];
+};
+
+struct owl_memory_allocation {
+  VkDeviceMemory memory;
+  uint64_t offset;
+  uint64_t size;
+  /* NULL unless the memory type is host visible */
+  void *data;
+  uint32_t type;
+  /* index of the block in the pool, -1 for dedicated allocations */
+  int32_t block;
+};
+
+struct owl_memory_stats {
+  uint32_t num_blocks;
+  uint32_t num_allocations;
+  uint32_t num_dedicated;
+  uint64_t reserved_size;
+  uint64_t used_size;
+  uint64_t dedicated_size;
+  uint64_t largest_free_size;
+  /* 0 when all the free space is a single range, close to 1 when it's
+   * scattered in small ones */
+  float fragmentation;
+};
+
+OWLAPI int owl_memory_init(struct owl_renderer *r);
+
+OWLAPI void owl_memory_deinit(struct owl_renderer *r);
+
+OWLAPI int owl_memory_allocate(struct owl_renderer *r,
+                               VkMemoryRequirements const *requirements,
+                               uint32_t properties,
+                               struct owl_memory_allocation *alloc);
+
+OWLAPI void owl_memory_free(struct owl_renderer *r,
+                            struct owl_memory_allocation *alloc);
+
+OWLAPI int owl_memory_bind_buffer(struct owl_renderer *r, VkBuffer buffer,
+                                  struct owl_memory_allocation *alloc);
+
+OWLAPI int owl_memory_bind_image(struct owl_renderer *r, VkImage image,
+                                 struct owl_memory_allocation *alloc);
+
+OWLAPI void owl_memory_get_stats(struct owl_renderer *r, uint32_t type,
+                                 struct owl_memory_stats *stats);
+
+OWL_END_DECLARATIONS
+
+#endif
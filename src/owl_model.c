@@ -2,12 +2,16 @@
 
 #include "cgltf.h"
 #include "owl_internal.h"
+#include "owl_plataform.h"
 #include "owl_renderer.h"
 #include "owl_texture.h"
 #include "owl_vector_math.h"
+#include "stb_image.h"
 
 #include <float.h>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #if !defined(NDEBUG)
 
@@ -79,6 +83,11 @@ static int owl_model_load_images(struct owl_renderer *r,
 
     ret = owl_texture_init(r, &desc, &out_image->texture);
     OWL_ASSERT(!ret);
+
+    if (r->bindless_supported) {
+      ret = owl_renderer_add_bindless_texture(r, &out_image->texture);
+      OWL_ASSERT(!ret);
+    }
   }
 
   return ret;
@@ -118,6 +127,131 @@ static void owl_model_unload_textures(struct owl_renderer *r,
   OWL_UNUSED(m);
 }
 
+/* points the material at its maps, through the bindless slots or a
+ * descriptor set of its own */
+static int owl_model_init_material_maps(struct owl_renderer *r,
+                                        struct owl_model *m,
+                                        struct owl_model_material *material) {
+  int32_t j;
+  struct owl_texture const *maps[OWL_MODEL_MATERIAL_NUM_MAPS];
+  int ret = OWL_OK;
+
+  OWL_ASSERT(m->empty_texture.image_view);
+
+  for (j = 0; j < OWL_MODEL_MATERIAL_NUM_MAPS; ++j)
+    maps[j] = &m->empty_texture;
+
+  if (material->specular_glossiness_enable) {
+    if (-1 != material->diffuse_texture) {
+      struct owl_model_texture *texture;
+      struct owl_model_image *image;
+      texture = &m->textures[material->diffuse_texture];
+      image = &m->images[m->textures[texture->image].image];
+      maps[0] = &image->texture;
+    }
+
+    if (-1 != material->specular_glossiness_texture) {
+      struct owl_model_texture *texture;
+      struct owl_model_image *image;
+      texture = &m->textures[material->specular_glossiness_texture];
+      image = &m->images[m->textures[texture->image].image];
+      maps[1] = &image->texture;
+    }
+  }
+
+  if (material->metallic_roughness_enable) {
+    if (-1 != material->base_color_texture) {
+      struct owl_model_texture *texture;
+      struct owl_model_image *image;
+      texture = &m->textures[material->base_color_texture];
+      image = &m->images[texture->image];
+      maps[0] = &image->texture;
+    }
+
+    if (-1 != material->metallic_roughness_texture) {
+      struct owl_model_texture *texture;
+      struct owl_model_image *image;
+      texture = &m->textures[material->metallic_roughness_texture];
+      image = &m->images[texture->image];
+      maps[1] = &image->texture;
+    }
+  }
+
+  if (-1 != material->normal_texture) {
+    struct owl_model_texture *texture;
+    struct owl_model_image *image;
+    texture = &m->textures[material->normal_texture];
+    image = &m->images[texture->image];
+    maps[2] = &image->texture;
+  }
+
+  if (-1 != material->occlusion_texture) {
+    struct owl_model_texture *texture;
+    struct owl_model_image *image;
+    texture = &m->textures[material->occlusion_texture];
+    image = &m->images[texture->image];
+    maps[3] = &image->texture;
+  }
+
+  if (-1 != material->emissive_texture) {
+    struct owl_model_texture *texture;
+    struct owl_model_image *image;
+    texture = &m->textures[material->emissive_texture];
+    image = &m->images[texture->image];
+    maps[4] = &image->texture;
+  }
+
+  for (j = 0; j < OWL_MODEL_MATERIAL_NUM_MAPS; ++j)
+    material->bindless_maps[j] = (int32_t)maps[j]->bindless_index;
+
+  /* bindless materials only need the slots */
+  material->descriptor_set = VK_NULL_HANDLE;
+
+  if (!r->bindless_supported) {
+    VkDescriptorImageInfo descriptors[OWL_MODEL_MATERIAL_NUM_MAPS + 1];
+    VkWriteDescriptorSet writes[OWL_MODEL_MATERIAL_NUM_MAPS + 1];
+
+    ret = owl_renderer_allocate_descriptor_sets(
+        r, 1, &r->model_maps_descriptor_set_layout, &material->descriptor_set,
+        &material->descriptor_pool);
+    if (ret) {
+      material->descriptor_set = VK_NULL_HANDLE;
+      return ret;
+    }
+
+    descriptors[0].sampler = r->linear_sampler;
+    descriptors[0].imageView = VK_NULL_HANDLE;
+    descriptors[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    for (j = 0; j < OWL_MODEL_MATERIAL_NUM_MAPS; ++j) {
+      descriptors[j + 1].sampler = VK_NULL_HANDLE;
+      descriptors[j + 1].imageView = maps[j]->image_view;
+      descriptors[j + 1].imageLayout =
+          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(writes); ++j) {
+      writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[j].pNext = NULL;
+      writes[j].dstSet = material->descriptor_set;
+      writes[j].dstBinding = (uint32_t)j;
+      writes[j].dstArrayElement = 0;
+      writes[j].descriptorCount = 1;
+      if (0 == j)
+        writes[j].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+      else
+        writes[j].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+      writes[j].pImageInfo = &descriptors[j];
+      writes[j].pBufferInfo = NULL;
+      writes[j].pTexelBufferView = NULL;
+    }
+
+    vkUpdateDescriptorSets(r->device, OWL_ARRAY_SIZE(writes), writes, 0, NULL);
+  }
+
+  return ret;
+}
+
 static int owl_model_load_materials(struct owl_renderer *r,
                                     struct cgltf_data *gltf,
                                     struct owl_model *m) {
@@ -294,145 +428,118 @@ static int owl_model_load_materials(struct owl_renderer *r,
       out_material->specular_factor[3] = 1.0F;
     }
 
-    {
-      VkDescriptorSetAllocateInfo info;
-      VkResult vk_result;
-      OWL_UNUSED(vk_result);
+    ret = owl_model_init_material_maps(r, m, out_material);
+    OWL_ASSERT(!ret);
+  }
 
-      info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-      info.pNext = NULL;
-      info.descriptorPool = r->descriptor_pool;
-      info.descriptorSetCount = 1;
-      info.pSetLayouts = &r->model_maps_descriptor_set_layout;
+  return ret;
+}
 
-      vk_result = vkAllocateDescriptorSets(r->device, &info,
-                                           &out_material->descriptor_set);
-      OWL_ASSERT(!vk_result);
-    }
+static void owl_model_unload_materials(struct owl_renderer *r,
+                                       struct owl_model *m) {
+  int32_t i;
+  for (i = 0; i < m->num_materials; ++i) {
+    struct owl_model_material *material = &m->materials[i];
 
-    {
-      uint32_t j;
-      VkDescriptorImageInfo descriptors[6];
-      VkWriteDescriptorSet writes[6];
-
-      OWL_ASSERT(m->empty_texture.image_view);
-
-      descriptors[0].sampler = r->linear_sampler;
-      descriptors[0].imageView = VK_NULL_HANDLE;
-      descriptors[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-      descriptors[1].sampler = VK_NULL_HANDLE;
-      descriptors[1].imageView = m->empty_texture.image_view;
-      descriptors[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-      descriptors[2].sampler = VK_NULL_HANDLE;
-      descriptors[2].imageView = m->empty_texture.image_view;
-      descriptors[2].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-      if (out_material->specular_glossiness_enable) {
-        if (-1 != out_material->diffuse_texture) {
-          struct owl_model_texture *texture;
-          struct owl_model_image *image;
-          texture = &m->textures[out_material->diffuse_texture];
-          image = &m->images[m->textures[texture->image].image];
-          descriptors[1].imageView = image->texture.image_view;
-        }
+    if (!material->descriptor_set)
+      continue;
 
-        if (-1 != out_material->specular_glossiness_texture) {
-          struct owl_model_texture *texture;
-          struct owl_model_image *image;
-          texture = &m->textures[out_material->specular_glossiness_texture];
-          image = &m->images[m->textures[texture->image].image];
-          descriptors[2].imageView = image->texture.image_view;
-        }
-      }
+    owl_renderer_free_descriptor_sets(r, material->descriptor_pool, 1,
+                                      &material->descriptor_set);
+  }
+}
 
-      if (out_material->metallic_roughness_enable) {
-        if (-1 != out_material->base_color_texture) {
-          struct owl_model_texture *texture;
-          struct owl_model_image *image;
-          texture = &m->textures[out_material->base_color_texture];
-          image = &m->images[texture->image];
-          descriptors[1].imageView = image->texture.image_view;
-        }
+OWLAPI void owl_model_material_push_constant(
+    struct owl_model_material const *material,
+    struct owl_model_push_constant *push_constant) {
+  OWL_MEMSET(push_constant, 0, sizeof(*push_constant));
+
+  push_constant->workflow = 0.0F;
+  push_constant->base_color_uv_set = -1;
+  push_constant->physical_desc_uv_set = -1;
+  push_constant->normal_uv_set = -1;
+  push_constant->occlusion_uv_set = -1;
+  push_constant->emissive_uv_set = -1;
+
+  push_constant->emissive_factor[0] = material->emissive_factor[0];
+  push_constant->emissive_factor[1] = material->emissive_factor[1];
+  push_constant->emissive_factor[2] = material->emissive_factor[2];
+  push_constant->emissive_factor[3] = material->emissive_factor[3];
+
+  push_constant->diffuse_factor[0] = material->diffuse_factor[0];
+  push_constant->diffuse_factor[1] = material->diffuse_factor[1];
+  push_constant->diffuse_factor[2] = material->diffuse_factor[2];
+  push_constant->diffuse_factor[3] = material->diffuse_factor[3];
+
+  push_constant->specular_factor[0] = material->specular_factor[0];
+  push_constant->specular_factor[1] = material->specular_factor[1];
+  push_constant->specular_factor[2] = material->specular_factor[2];
+  push_constant->specular_factor[3] = material->specular_factor[3];
+
+  if (-1 == material->base_color_texture)
+    push_constant->base_color_uv_set = -1;
+  else {
+    push_constant->base_color_uv_set = material->base_color_texcoord;
+
+    OWL_ASSERT(0 == push_constant->base_color_uv_set);
+  }
 
-        if (-1 != out_material->metallic_roughness_texture) {
-          struct owl_model_texture *texture;
-          struct owl_model_image *image;
-          texture = &m->textures[out_material->metallic_roughness_texture];
-          image = &m->images[texture->image];
-          descriptors[2].imageView = image->texture.image_view;
-        }
-      }
+  if (-1 == material->normal_texcoord)
+    push_constant->normal_uv_set = -1;
+  else
+    push_constant->normal_uv_set = material->normal_texcoord;
 
-      descriptors[3].sampler = VK_NULL_HANDLE;
-      if (-1 != out_material->normal_texture) {
-        struct owl_model_texture *texture;
-        struct owl_model_image *image;
-        texture = &m->textures[out_material->normal_texture];
-        image = &m->images[texture->image];
-        descriptors[3].imageView = image->texture.image_view;
-      } else {
-        descriptors[3].imageView = m->empty_texture.image_view;
-      }
-      descriptors[3].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-      descriptors[4].sampler = VK_NULL_HANDLE;
-      if (-1 != out_material->occlusion_texture) {
-        struct owl_model_texture *texture;
-        struct owl_model_image *image;
-        texture = &m->textures[out_material->occlusion_texture];
-        image = &m->images[texture->image];
-        descriptors[4].imageView = image->texture.image_view;
-      } else {
-        descriptors[4].imageView = m->empty_texture.image_view;
-      }
-      descriptors[4].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-      descriptors[5].sampler = VK_NULL_HANDLE;
-      if (-1 != out_material->emissive_texture) {
-        struct owl_model_texture *texture;
-        struct owl_model_image *image;
-        texture = &m->textures[out_material->emissive_texture];
-        image = &m->images[texture->image];
-        descriptors[5].imageView = image->texture.image_view;
-      } else {
-        descriptors[5].imageView = m->empty_texture.image_view;
-      }
-      descriptors[5].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-      for (j = 0; j < OWL_ARRAY_SIZE(writes); ++j) {
-        writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writes[j].pNext = NULL;
-        writes[j].dstSet = out_material->descriptor_set;
-        writes[j].dstBinding = j;
-        writes[j].dstArrayElement = 0;
-        writes[j].descriptorCount = 1;
-        if (0 == j)
-          writes[j].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-        else
-          writes[j].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        writes[j].pImageInfo = &descriptors[j];
-        writes[j].pBufferInfo = NULL;
-        writes[j].pTexelBufferView = NULL;
-      }
+  if (-1 == material->occlusion_texture)
+    push_constant->occlusion_uv_set = -1;
+  else
+    push_constant->occlusion_uv_set = material->occlusion_texcoord;
 
-      vkUpdateDescriptorSets(r->device, OWL_ARRAY_SIZE(writes), writes, 0,
-                             NULL);
-    }
+  if (-1 == material->emissive_texture)
+    push_constant->emissive_uv_set = -1;
+  else
+    push_constant->emissive_uv_set = material->emissive_texcoord;
+
+  push_constant->physical_desc_uv_set = -1;
+
+  push_constant->alpha_mask = material->alpha_mode == OWL_ALPHA_MODE_MASK;
+  push_constant->alpha_mask_cutoff = material->alpha_cutoff;
+
+  push_constant->color_map_index = material->bindless_maps[0];
+  push_constant->physical_desc_map_index = material->bindless_maps[1];
+  push_constant->normal_map_index = material->bindless_maps[2];
+  push_constant->occlusion_map_index = material->bindless_maps[3];
+  push_constant->emissive_map_index = material->bindless_maps[4];
+
+  if (material->specular_glossiness_enable) {
+    push_constant->workflow = 1;
+
+    if (-1 == material->specular_glossiness_texture)
+      push_constant->physical_desc_uv_set = -1;
+    else
+      push_constant->physical_desc_uv_set =
+          material->specular_glossiness_texture;
+
+    if (-1 == material->diffuse_texture)
+      push_constant->base_color_uv_set = -1;
+    else
+      push_constant->base_color_uv_set = material->base_color_texcoord;
   }
 
-  return ret;
-}
+  if (material->metallic_roughness_enable) {
+    push_constant->workflow = 0;
+    push_constant->base_color_factor[0] = material->base_color_factor[0];
+    push_constant->base_color_factor[1] = material->base_color_factor[1];
+    push_constant->base_color_factor[2] = material->base_color_factor[2];
+    push_constant->base_color_factor[3] = material->base_color_factor[3];
 
-static void owl_model_unload_materials(struct owl_renderer *r,
-                                       struct owl_model *m) {
-  int32_t i;
-  VkDevice const device = r->device;
-  for (i = 0; i < m->num_materials; ++i) {
-    struct owl_model_material *material = &m->materials[i];
-    vkFreeDescriptorSets(device, r->descriptor_pool, 1,
-                         &material->descriptor_set);
+    push_constant->metallic_factor = material->metallic_factor;
+    push_constant->roughness_factor = material->roughness_factor;
+
+    if (-1 == material->metallic_roughness_texture)
+      push_constant->physical_desc_uv_set = -1;
+    else
+      push_constant->physical_desc_uv_set =
+          material->metallic_roughness_texcoord;
   }
 }
 
@@ -455,6 +562,8 @@ struct owl_model_all_primitives {
   struct owl_model_vertex *vertices;
 
   int32_t num_indices;
+  /* room for the full detail indices and every simplified level of them */
+  int32_t max_indices;
   uint32_t *indices;
 };
 
@@ -465,6 +574,7 @@ static int owl_model_init_all_primitives(struct owl_model_all_primitives *p,
 
   p->num_vertices = 0;
   p->num_indices = 0;
+  p->max_indices = 0;
 
   for (i = 0; i < gltf->nodes_count; ++i) {
     uint32_t j;
@@ -481,15 +591,16 @@ static int owl_model_init_all_primitives(struct owl_model_all_primitives *p,
       attr = owl_find_gltf_attribute(primitive, "POSITION");
 
       p->num_vertices += attr->data->count;
-      p->num_indices += primitive->indices->count;
+      /* no level has more indices than the full detail one */
+      p->max_indices += primitive->indices->count * OWL_MODEL_MAX_LODS;
     }
   }
 
   p->vertices = OWL_MALLOC(p->num_vertices * sizeof(*p->vertices));
   OWL_ASSERT(p->vertices);
 
-  if (p->num_indices) {
-    p->indices = OWL_MALLOC(p->num_indices * sizeof(*p->indices));
+  if (p->max_indices) {
+    p->indices = OWL_MALLOC(p->max_indices * sizeof(*p->indices));
     OWL_ASSERT(p->indices);
   } else {
     p->indices = NULL;
@@ -531,6 +642,109 @@ static int32_t owl_model_gltf_stride(cgltf_type type) {
   }
 }
 
+static uint16_t owl_model_float_to_half(float value) {
+  uint32_t bits;
+  uint32_t sign;
+  uint32_t half;
+  uint32_t mantissa;
+  int32_t exponent;
+
+  OWL_MEMCPY(&bits, &value, sizeof(bits));
+
+  sign = (bits >> 16) & 0x8000;
+  exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+  mantissa = bits & 0x7FFFFF;
+
+  /* nan stays nan, infinity and whatever is too large end up infinity */
+  if (0xFF == ((bits >> 23) & 0xFF))
+    return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+  if (31 <= exponent)
+    return (uint16_t)(sign | 0x7C00);
+
+  /* too small even for a denormal */
+  if (-10 > exponent)
+    return (uint16_t)sign;
+
+  if (0 >= exponent) {
+    uint32_t const shift = (uint32_t)(14 - exponent);
+
+    /* denormals keep the implicit bit in the mantissa */
+    mantissa |= 0x800000;
+    half = mantissa >> shift;
+
+    if ((mantissa >> (shift - 1)) & 1)
+      ++half;
+
+    return (uint16_t)(sign | half);
+  }
+
+  half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+
+  /* rounding up can carry into the exponent, which is still right */
+  if (mantissa & 0x1000)
+    ++half;
+
+  return (uint16_t)(sign | half);
+}
+
+static uint8_t owl_model_float_to_unorm8(float value) {
+  return (uint8_t)(OWL_CLAMP(value, 0.0F, 1.0F) * 255.0F + 0.5F);
+}
+
+static int16_t owl_model_float_to_snorm16(float value) {
+  return (int16_t)floor(OWL_CLAMP(value, -1.0F, 1.0F) * 32767.0F + 0.5F);
+}
+
+/* octahedral encoding, the normal is projected on the octahedron and the
+ * lower half is folded over the upper one, owl_pbr.vert unfolds it */
+static void owl_model_encode_normal(float const *normal, int16_t *out) {
+  float x;
+  float y;
+  float length;
+
+  length = (float)(fabs(normal[0]) + fabs(normal[1]) + fabs(normal[2]));
+
+  /* a missing normal, decodes to +z */
+  if (0.0F >= length) {
+    out[0] = 0;
+    out[1] = 0;
+    return;
+  }
+
+  x = normal[0] / length;
+  y = normal[1] / length;
+
+  if (0.0F > normal[2]) {
+    float const folded_x = (1.0F - (float)fabs(y)) * (0.0F <= x ? 1.0F : -1.0F);
+    float const folded_y = (1.0F - (float)fabs(x)) * (0.0F <= y ? 1.0F : -1.0F);
+
+    x = folded_x;
+    y = folded_y;
+  }
+
+  out[0] = owl_model_float_to_snorm16(x);
+  out[1] = owl_model_float_to_snorm16(y);
+}
+
+/* the rounding error goes to the largest weight so they still add up to 1 */
+static void owl_model_encode_weights(float const *weights, uint8_t *out) {
+  int32_t i;
+  int32_t sum = 0;
+  int32_t largest = 0;
+
+  for (i = 0; i < 4; ++i) {
+    out[i] = owl_model_float_to_unorm8(weights[i]);
+    sum += out[i];
+
+    if (out[i] > out[largest])
+      largest = i;
+  }
+
+  if (sum)
+    out[largest] = (uint8_t)(out[largest] + 255 - sum);
+}
+
 #if 0
 static int owl_model_load_mesh(struct owl_renderer *r, cgltf_mesh const *mesh,
                                struct owl_model_node *n,
@@ -667,991 +881,2733 @@ static int owl_model_load_mesh(struct owl_renderer *r, cgltf_mesh const *mesh,
 }
 #endif
 
-static int owl_model_load_nodes(struct owl_renderer *r,
-                                struct cgltf_data const *gltf,
-                                struct owl_model_all_primitives *p,
-                                struct owl_model *m) {
-  int32_t i;
-  int32_t num_vertices = 0;
-  int32_t num_indices = 0;
-  int ret = OWL_OK;
-  VkDevice const device = r->device;
+/* empty but valid, anything merged into it replaces it */
+static void owl_model_bbox_reset(struct owl_model_bbox *box) {
+  box->min[0] = FLT_MAX;
+  box->min[1] = FLT_MAX;
+  box->min[2] = FLT_MAX;
+  box->max[0] = -FLT_MAX;
+  box->max[1] = -FLT_MAX;
+  box->max[2] = -FLT_MAX;
+  box->valid = 1;
+}
 
-  OWL_UNUSED(r);
+static int owl_model_bbox_is_empty(struct owl_model_bbox const *box) {
+  return box->min[0] > box->max[0];
+}
 
-  OWL_ASSERT(gltf->nodes_count < OWL_ARRAY_SIZE(m->nodes));
-  OWL_ASSERT(gltf->meshes_count < OWL_ARRAY_SIZE(m->meshes));
+/* a box without bounds can't be culled, neither can anything holding it */
+static void owl_model_bbox_merge(struct owl_model_bbox const *other,
+                                 struct owl_model_bbox *box) {
+  int32_t i;
 
-  m->num_primitives = 0;
-  m->num_meshes = 0;
-  m->num_nodes = (int32_t)gltf->nodes_count;
+  if (!other->valid) {
+    box->valid = 0;
+    return;
+  }
 
-  for (i = 0; i < m->num_nodes; ++i) {
-    int32_t j;
-    struct cgltf_node const *in_node;
-    struct owl_model_node *out_node;
+  for (i = 0; i < 3; ++i) {
+    box->min[i] = OWL_MIN(box->min[i], other->min[i]);
+    box->max[i] = OWL_MAX(box->max[i], other->max[i]);
+  }
+}
 
-    in_node = &gltf->nodes[i];
-    out_node = &m->nodes[(int32_t)(in_node - gltf->nodes)];
+/* the axis aligned box holding box transformed by matrix */
+static void owl_model_bbox_transform(owl_m4 const matrix,
+                                     struct owl_model_bbox const *box,
+                                     struct owl_model_bbox *out) {
+  int32_t i;
+  int32_t j;
 
-    if (in_node->parent)
-      out_node->parent = (int32_t)(in_node->parent - gltf->nodes);
-    else
-      out_node->parent = -1;
+  if (!box->valid || owl_model_bbox_is_empty(box)) {
+    *out = *box;
+    return;
+  }
 
-    OWL_ASSERT(in_node->children_count < OWL_ARRAY_SIZE(out_node->children));
+  /* each column adds its smallest and largest contribution */
+  for (i = 0; i < 3; ++i) {
+    float min = matrix[3][i];
+    float max = matrix[3][i];
 
-    out_node->num_children = (int32_t)in_node->children_count;
-    for (j = 0; j < out_node->num_children; ++j)
-      out_node->children[j] = (int32_t)(in_node->children[j] - gltf->nodes);
+    for (j = 0; j < 3; ++j) {
+      float const a = matrix[j][i] * box->min[j];
+      float const b = matrix[j][i] * box->max[j];
 
-    if (in_node->name) {
-      uint32_t max_length = OWL_ARRAY_SIZE(out_node->name);
-      OWL_STRNCPY(out_node->name, in_node->name, max_length);
-    } else {
-      uint32_t max_length = OWL_ARRAY_SIZE(out_node->name);
-      OWL_STRNCPY(out_node->name, "NO NAME", max_length);
+      min += OWL_MIN(a, b);
+      max += OWL_MAX(a, b);
     }
 
-    if (in_node->has_translation) {
-      out_node->translation[0] = in_node->translation[0];
-      out_node->translation[1] = in_node->translation[1];
-      out_node->translation[2] = in_node->translation[2];
-    } else {
-      out_node->translation[0] = 0.0F;
-      out_node->translation[1] = 0.0F;
-      out_node->translation[2] = 0.0F;
-    }
+    out->min[i] = min;
+    out->max[i] = max;
+  }
 
-    if (in_node->has_rotation) {
-      out_node->rotation[0] = in_node->rotation[0];
-      out_node->rotation[1] = in_node->rotation[1];
-      out_node->rotation[2] = in_node->rotation[2];
-      out_node->rotation[3] = in_node->rotation[3];
-    } else {
-      out_node->rotation[0] = 0.0F;
-      out_node->rotation[1] = 0.0F;
-      out_node->rotation[2] = 0.0F;
-      out_node->rotation[3] = 0.0F;
-    }
+  out->valid = 1;
+}
 
-    if (in_node->has_scale) {
-      out_node->scale[0] = in_node->scale[0];
-      out_node->scale[1] = in_node->scale[1];
-      out_node->scale[2] = in_node->scale[2];
-    } else {
-      out_node->scale[0] = 1.0F;
-      out_node->scale[1] = 1.0F;
-      out_node->scale[2] = 1.0F;
-    }
+/* allowed quadric error of the first simplified level as a fraction of the
+ * primitive's extent, doubled every level after it */
+#define OWL_MODEL_LOD_ERROR 0.01F
 
-    if (in_node->has_matrix)
-      OWL_M4_COPY_V16(in_node->matrix, out_node->matrix);
-    else
-      OWL_M4_IDENTITY(out_node->matrix);
+/* upper triangle of a symmetric 4x4 matrix, evaluated at a point it's the
+ * sum of the squared distances to the planes added to it */
+struct owl_model_quadric {
+  float m[10];
+};
 
-    if (in_node->skin)
-      out_node->skin = (int32_t)(in_node->skin - gltf->skins);
-    else
-      out_node->skin = -1;
+static void owl_model_quadric_add_plane(struct owl_model_quadric *q,
+                                        owl_v3 const n, float d) {
+  q->m[0] += n[0] * n[0];
+  q->m[1] += n[0] * n[1];
+  q->m[2] += n[0] * n[2];
+  q->m[3] += n[0] * d;
+  q->m[4] += n[1] * n[1];
+  q->m[5] += n[1] * n[2];
+  q->m[6] += n[1] * d;
+  q->m[7] += n[2] * n[2];
+  q->m[8] += n[2] * d;
+  q->m[9] += d * d;
+}
 
-    /* FIXME(samuel): not sure if each node has it's own mesh, however as I
-     * allocate resources per mesh, it's easier to give each one it's own
-     * instead of checking if it exists */
-    if (in_node->mesh) {
-      struct cgltf_mesh const *in_mesh;
-      struct owl_model_mesh *out_mesh;
+static void owl_model_quadric_add(struct owl_model_quadric const *q,
+                                  struct owl_model_quadric *out) {
+  int32_t i;
 
-      in_mesh = in_node->mesh;
+  for (i = 0; i < (int32_t)OWL_ARRAY_SIZE(out->m); ++i)
+    out->m[i] += q->m[i];
+}
 
-#if 0
-			out_node->mesh = (int32_t)(in_mesh - gltf->meshes);
-#else
-      out_node->mesh = m->num_meshes++;
-#endif
-      out_mesh = &m->meshes[out_node->mesh];
+static float owl_model_quadric_error(struct owl_model_quadric const *q,
+                                     owl_v3 const v) {
+  float error;
 
-      OWL_ASSERT(in_mesh->primitives_count <
-                 OWL_ARRAY_SIZE(out_mesh->primitives));
+  error = q->m[0] * v[0] * v[0] + q->m[4] * v[1] * v[1] +
+          q->m[7] * v[2] * v[2] + q->m[9];
 
-      out_mesh->num_primitives = (int32_t)in_mesh->primitives_count;
-      for (j = 0; j < out_mesh->num_primitives; ++j) {
-        int32_t k;
-        int32_t has_skin;
-        int32_t num_local_vertices = 0;
-        int32_t num_local_indices = 0;
+  error += 2.0F * (q->m[1] * v[0] * v[1] + q->m[2] * v[0] * v[2] +
+                   q->m[3] * v[0] + q->m[5] * v[1] * v[2] + q->m[6] * v[1] +
+                   q->m[8] * v[2]);
 
-        int32_t position_stride = 0;
-        float const *position = NULL;
+  /* rounding can take it just under 0 */
+  return OWL_MAX(error, 0.0F);
+}
 
-        owl_v3 min_pos;
-        owl_v3 max_pos;
+struct owl_model_collapse {
+  float error;
+  uint32_t from;
+  uint32_t to;
+};
 
-        int32_t normal_stride = 0;
-        float const *normal = NULL;
+static int owl_model_collapse_compare(void const *lhs, void const *rhs) {
+  struct owl_model_collapse const *l = lhs;
+  struct owl_model_collapse const *r = rhs;
 
-        int32_t uv0_stride = 0;
-        float const *uv0 = NULL;
+  return (l->error > r->error) - (l->error < r->error);
+}
 
-        int32_t uv1_stride = 0;
-        float const *uv1 = NULL;
+/* triangles around every vertex, the ones around v are triangles[offsets[v]]
+ * up to triangles[offsets[v + 1]] */
+static void owl_model_build_adjacency(uint32_t num_vertices,
+                                      uint32_t const *indices,
+                                      uint32_t num_indices, uint32_t *offsets,
+                                      uint32_t *triangles) {
+  uint32_t i;
+  uint32_t total;
 
-        int32_t joints0_component_is_u8;
-        int32_t joints0_stride = 0;
-        uint8_t const *joints0 = NULL;
+  OWL_MEMSET(offsets, 0, (num_vertices + 1) * sizeof(*offsets));
 
-        int32_t weights0_stride = 0;
-        float const *weights0 = NULL;
+  for (i = 0; i < num_indices; ++i)
+    ++offsets[indices[i]];
 
-        int32_t color0_stride = 0;
+  for (total = 0, i = 0; i < num_vertices; ++i) {
+    uint32_t const count = offsets[i];
+    offsets[i] = total;
+    total += count;
+  }
+
+  for (i = 0; i < num_indices; ++i)
+    triangles[offsets[indices[i]]++] = i / 3;
+
+  /* filling moved every offset to the start of the next vertex */
+  for (i = num_vertices; i > 0; --i)
+    offsets[i] = offsets[i - 1];
+
+  offsets[0] = 0;
+}
+
+static int owl_model_triangle_has(uint32_t const *triangle, uint32_t v) {
+  return triangle[0] == v || triangle[1] == v || triangle[2] == v;
+}
+
+static void owl_model_triangle_normal(struct owl_model_vertex const *vertices,
+                                      uint32_t const *triangle, uint32_t from,
+                                      uint32_t to, owl_v3 normal) {
+  owl_v3 e0;
+  owl_v3 e1;
+  float const *p0;
+  float const *p1;
+  float const *p2;
+
+  p0 = vertices[from == triangle[0] ? to : triangle[0]].position;
+  p1 = vertices[from == triangle[1] ? to : triangle[1]].position;
+  p2 = vertices[from == triangle[2] ? to : triangle[2]].position;
+
+  OWL_V3_SUB(p1, p0, e0);
+  OWL_V3_SUB(p2, p0, e1);
+  owl_v3_cross(e0, e1, normal);
+}
+
+/* the number of triangles collapsing from onto to removes, -1 if any of the
+ * ones left would flip */
+static int32_t owl_model_check_collapse(
+    struct owl_model_vertex const *vertices, uint32_t const *indices,
+    uint32_t const *offsets, uint32_t const *triangles, uint32_t from,
+    uint32_t to) {
+  uint32_t i;
+  int32_t removed = 0;
+
+  for (i = offsets[from]; i < offsets[from + 1]; ++i) {
+    owl_v3 before;
+    owl_v3 after;
+    uint32_t const *triangle = &indices[triangles[i] * 3];
+
+    if (owl_model_triangle_has(triangle, to)) {
+      ++removed;
+      continue;
+    }
+
+    owl_model_triangle_normal(vertices, triangle, from, from, before);
+    owl_model_triangle_normal(vertices, triangle, from, to, after);
+
+    if (OWL_V3_DOT(before, after) <= 0.0F)
+      return -1;
+  }
+
+  return removed;
+}
+
+/* collapses edges of the triangle list into one of their vertices, cheapest
+ * first by quadric error, until target indices are left or every collapse
+ * left costs more than max_error. border vertices and the vertices
+ * themselves never move, the result indexes the same vertices. indices are
+ * offset by base, vertices aren't. out needs room for num_indices, returns
+ * the number written or 0 if there was no memory to simplify */
+static uint32_t owl_model_simplify(struct owl_model_vertex const *vertices,
+                                   uint32_t base, uint32_t num_vertices,
+                                   uint32_t const *indices,
+                                   uint32_t num_indices, uint32_t target,
+                                   float max_error, uint32_t *out) {
+  uint32_t i;
+  uint32_t count = 0;
+  uint32_t *offsets;
+  uint32_t *triangles;
+  uint32_t *remap;
+  uint8_t *locked;
+  uint8_t *touched;
+  struct owl_model_quadric *quadrics;
+  struct owl_model_collapse *collapses;
+
+  offsets = OWL_MALLOC((num_vertices + 1) * sizeof(*offsets));
+  triangles = OWL_MALLOC(num_indices * sizeof(*triangles));
+  remap = OWL_MALLOC(num_vertices * sizeof(*remap));
+  locked = OWL_CALLOC(num_vertices, sizeof(*locked));
+  touched = OWL_MALLOC(num_vertices * sizeof(*touched));
+  quadrics = OWL_CALLOC(num_vertices, sizeof(*quadrics));
+  /* both directions of the three edges of every triangle */
+  collapses = OWL_MALLOC(num_indices * 2 * sizeof(*collapses));
+
+  if (!offsets || !triangles || !remap || !locked || !touched || !quadrics ||
+      !collapses)
+    goto out;
+
+  for (i = 0; i < num_indices; ++i)
+    out[i] = indices[i] - base;
+
+  count = num_indices;
+
+  /* every triangle adds its plane to its three vertices */
+  for (i = 0; i < count; i += 3) {
+    owl_v3 normal;
+    float length;
+    float distance;
+
+    owl_model_triangle_normal(vertices, &out[i], 0, 0, normal);
+
+    length = owl_v3_magnitude(normal);
+    if (0.0F >= length)
+      continue;
+
+    OWL_V3_INVERSE_SCALE(normal, length, normal);
+    distance = -OWL_V3_DOT(normal, vertices[out[i]].position);
+
+    owl_model_quadric_add_plane(&quadrics[out[i + 0]], normal, distance);
+    owl_model_quadric_add_plane(&quadrics[out[i + 1]], normal, distance);
+    owl_model_quadric_add_plane(&quadrics[out[i + 2]], normal, distance);
+  }
+
+  owl_model_build_adjacency(num_vertices, out, count, offsets, triangles);
+
+  /* edges with a single triangle are on the border of the mesh or on a uv or
+   * normal seam, their vertices stay so there are no holes */
+  for (i = 0; i < count; ++i) {
+    uint32_t j;
+    uint32_t shared = 0;
+    uint32_t const a = out[i];
+    uint32_t const b = out[i - i % 3 + (i + 1) % 3];
+
+    for (j = offsets[a]; j < offsets[a + 1]; ++j)
+      shared += owl_model_triangle_has(&out[triangles[j] * 3], b);
+
+    if (1 == shared) {
+      locked[a] = 1;
+      locked[b] = 1;
+    }
+  }
+
+  while (count > target) {
+    uint32_t j;
+    uint32_t num_collapses = 0;
+    uint32_t num_applied = 0;
+    uint32_t num_triangles = count / 3;
+
+    owl_model_build_adjacency(num_vertices, out, count, offsets, triangles);
+
+    for (i = 0; i < count; ++i) {
+      struct owl_model_quadric q;
+      uint32_t const a = out[i];
+      uint32_t const b = out[i - i % 3 + (i + 1) % 3];
+
+      q = quadrics[a];
+      owl_model_quadric_add(&quadrics[b], &q);
+
+      if (!locked[a]) {
+        struct owl_model_collapse *collapse = &collapses[num_collapses++];
+        collapse->error = owl_model_quadric_error(&q, vertices[b].position);
+        collapse->from = a;
+        collapse->to = b;
+      }
+
+      if (!locked[b]) {
+        struct owl_model_collapse *collapse = &collapses[num_collapses++];
+        collapse->error = owl_model_quadric_error(&q, vertices[a].position);
+        collapse->from = b;
+        collapse->to = a;
+      }
+    }
+
+    OWL_QSORT(collapses, num_collapses, sizeof(*collapses),
+              owl_model_collapse_compare);
+
+    for (i = 0; i < num_vertices; ++i) {
+      remap[i] = i;
+      touched[i] = 0;
+    }
+
+    for (j = 0; j < num_collapses && num_triangles * 3 > target; ++j) {
+      int32_t removed;
+      uint32_t const from = collapses[j].from;
+      uint32_t const to = collapses[j].to;
+
+      if (collapses[j].error > max_error)
+        break;
+
+      if (touched[from] || touched[to])
+        continue;
+
+      removed = owl_model_check_collapse(vertices, out, offsets, triangles,
+                                         from, to);
+      if (0 > removed)
+        continue;
+
+      remap[from] = to;
+      owl_model_quadric_add(&quadrics[from], &quadrics[to]);
+
+      /* the triangles around from change, nothing else sharing a vertex
+       * with them collapses until the list is rebuilt */
+      for (i = offsets[from]; i < offsets[from + 1]; ++i) {
+        uint32_t const *triangle = &out[triangles[i] * 3];
+        touched[triangle[0]] = 1;
+        touched[triangle[1]] = 1;
+        touched[triangle[2]] = 1;
+      }
+
+      num_triangles -= (uint32_t)removed;
+      ++num_applied;
+    }
+
+    if (!num_applied)
+      break;
+
+    for (j = 0, i = 0; i < count; i += 3) {
+      uint32_t const a = remap[out[i + 0]];
+      uint32_t const b = remap[out[i + 1]];
+      uint32_t const c = remap[out[i + 2]];
+
+      if (a == b || b == c || c == a)
+        continue;
+
+      out[j++] = a;
+      out[j++] = b;
+      out[j++] = c;
+    }
+
+    count = j;
+  }
+
+  for (i = 0; i < count; ++i)
+    out[i] += base;
+
+out:
+  OWL_FREE(collapses);
+  OWL_FREE(quadrics);
+  OWL_FREE(touched);
+  OWL_FREE(locked);
+  OWL_FREE(remap);
+  OWL_FREE(triangles);
+  OWL_FREE(offsets);
+
+  return count;
+}
+
+/* entries of the fifo post transform cache the reorder targets and the miss
+ * ratio is measured with */
+#define OWL_MODEL_VERTEX_CACHE_SIZE 16
+/* a dead end only closes an overdraw cluster once it has this many
+ * triangles, every cluster boundary costs a few cache misses */
+#define OWL_MODEL_MIN_CLUSTER_SIZE 64
+
+static uint32_t owl_model_count_cache_misses(uint32_t const *indices,
+                                             uint32_t num_indices) {
+  uint32_t i;
+  uint32_t head = 0;
+  uint32_t misses = 0;
+  uint32_t cache[OWL_MODEL_VERTEX_CACHE_SIZE];
+
+  for (i = 0; i < OWL_MODEL_VERTEX_CACHE_SIZE; ++i)
+    cache[i] = 0xFFFFFFFF;
+
+  for (i = 0; i < num_indices; ++i) {
+    uint32_t j;
+
+    for (j = 0; j < OWL_MODEL_VERTEX_CACHE_SIZE; ++j)
+      if (cache[j] == indices[i])
+        break;
+
+    if (OWL_MODEL_VERTEX_CACHE_SIZE != j)
+      continue;
+
+    cache[head] = indices[i];
+    head = (head + 1) % OWL_MODEL_VERTEX_CACHE_SIZE;
+    ++misses;
+  }
+
+  return misses;
+}
+
+/* a run of the reordered triangles */
+struct owl_model_cluster {
+  float key;
+  owl_v3 normal;
+  uint32_t first;
+  uint32_t count;
+};
+
+static int owl_model_cluster_compare(void const *lhs, void const *rhs) {
+  struct owl_model_cluster const *l = lhs;
+  struct owl_model_cluster const *r = rhs;
+
+  /* descending */
+  return (l->key < r->key) - (l->key > r->key);
+}
+
+/* sorts the clusters so the ones furthest out along their own normal are
+ * drawn first, they are the likeliest to occlude the rest from any point of
+ * view */
+static void owl_model_sort_clusters(struct owl_model_vertex const *vertices,
+                                    uint32_t const *indices,
+                                    uint32_t const *order,
+                                    struct owl_model_cluster *clusters,
+                                    uint32_t num_clusters) {
+  uint32_t i;
+  float area = 0.0F;
+  owl_v3 center;
+
+  OWL_V3_ZERO(center);
+
+  for (i = 0; i < num_clusters; ++i) {
+    uint32_t j;
+    float length;
+    owl_v3 centroid;
+    float cluster_area = 0.0F;
+    struct owl_model_cluster *cluster = &clusters[i];
+
+    OWL_V3_ZERO(cluster->normal);
+    OWL_V3_ZERO(centroid);
+
+    for (j = cluster->first; j < cluster->first + cluster->count; ++j) {
+      owl_v3 cross;
+      owl_v3 sum;
+      float triangle_area;
+      uint32_t const *triangle = &indices[order[j] * 3];
+
+      owl_model_triangle_normal(vertices, triangle, 0, 0, cross);
+      triangle_area = owl_v3_magnitude(cross);
+
+      OWL_V3_ADD(cluster->normal, cross, cluster->normal);
+
+      OWL_V3_ADD(vertices[triangle[0]].position,
+                 vertices[triangle[1]].position, sum);
+      OWL_V3_ADD(sum, vertices[triangle[2]].position, sum);
+      OWL_V3_SCALE(sum, triangle_area / 3.0F, sum);
+      OWL_V3_ADD(centroid, sum, centroid);
+
+      cluster_area += triangle_area;
+    }
+
+    /* the mesh center is the area weighted centroid of every triangle */
+    OWL_V3_ADD(center, centroid, center);
+    area += cluster_area;
+
+    if (0.0F < cluster_area)
+      OWL_V3_INVERSE_SCALE(centroid, cluster_area, centroid);
+
+    length = owl_v3_magnitude(cluster->normal);
+    if (0.0F < length)
+      OWL_V3_INVERSE_SCALE(cluster->normal, length, cluster->normal);
+
+    cluster->key = OWL_V3_DOT(centroid, cluster->normal);
+  }
+
+  if (0.0F < area)
+    OWL_V3_INVERSE_SCALE(center, area, center);
+
+  /* dot(centroid - center, normal) */
+  for (i = 0; i < num_clusters; ++i)
+    clusters[i].key -= OWL_V3_DOT(center, clusters[i].normal);
+
+  OWL_QSORT(clusters, num_clusters, sizeof(*clusters),
+            owl_model_cluster_compare);
+}
+
+/* reorders the triangles for the post transform cache with tipsify. the
+ * fans restart at dead ends, which split the order into clusters that are
+ * then sorted against overdraw. indices are offset by base, vertices aren't.
+ * returns 0 if there was no memory to reorder them, they are left as is */
+static int
+owl_model_optimize_vertex_cache(struct owl_model_vertex const *vertices,
+                                uint32_t base, uint32_t num_vertices,
+                                uint32_t *indices, uint32_t num_indices) {
+  uint32_t i;
+  int32_t fan;
+  uint32_t time;
+  uint32_t cursor = 0;
+  uint32_t num_dead_ends = 0;
+  uint32_t num_emitted = 0;
+  uint32_t num_clusters = 0;
+  uint32_t const num_triangles = num_indices / 3;
+  int ret = 0;
+  uint32_t *local;
+  uint32_t *offsets;
+  uint32_t *triangles;
+  uint32_t *live;
+  uint32_t *timestamps;
+  uint32_t *dead_ends;
+  uint32_t *order;
+  uint8_t *emitted;
+  struct owl_model_cluster *clusters;
+
+  local = OWL_MALLOC(num_indices * sizeof(*local));
+  offsets = OWL_MALLOC((num_vertices + 1) * sizeof(*offsets));
+  triangles = OWL_MALLOC(num_indices * sizeof(*triangles));
+  live = OWL_MALLOC(num_vertices * sizeof(*live));
+  timestamps = OWL_CALLOC(num_vertices, sizeof(*timestamps));
+  dead_ends = OWL_MALLOC(num_indices * sizeof(*dead_ends));
+  order = OWL_MALLOC(num_triangles * sizeof(*order));
+  emitted = OWL_CALLOC(num_triangles, sizeof(*emitted));
+  clusters = OWL_MALLOC(num_triangles * sizeof(*clusters));
+
+  if (!local || !offsets || !triangles || !live || !timestamps ||
+      !dead_ends || !order || !emitted || !clusters)
+    goto out;
+
+  for (i = 0; i < num_indices; ++i)
+    local[i] = indices[i] - base;
+
+  owl_model_build_adjacency(num_vertices, local, num_indices, offsets,
+                            triangles);
+
+  for (i = 0; i < num_vertices; ++i)
+    live[i] = offsets[i + 1] - offsets[i];
+
+  clusters[0].first = 0;
+
+  /* every vertex starts out of the cache */
+  time = OWL_MODEL_VERTEX_CACHE_SIZE + 1;
+
+  for (fan = 0; 0 <= fan;) {
+    int32_t best_priority = -1;
+    uint32_t const round = num_dead_ends;
+
+    /* emit every triangle around the fan vertex that's left */
+    for (i = offsets[fan]; i < offsets[fan + 1]; ++i) {
+      uint32_t j;
+      uint32_t const triangle = triangles[i];
+
+      if (emitted[triangle])
+        continue;
+
+      for (j = 0; j < 3; ++j) {
+        uint32_t const v = local[triangle * 3 + j];
+
+        dead_ends[num_dead_ends++] = v;
+        --live[v];
+
+        if (time - timestamps[v] > OWL_MODEL_VERTEX_CACHE_SIZE)
+          timestamps[v] = time++;
+      }
+
+      emitted[triangle] = 1;
+      order[num_emitted++] = triangle;
+    }
+
+    /* the next fan is a vertex of those triangles that is still in the
+     * cache, preferably the oldest one that stays in it while its fan is
+     * emitted */
+    for (fan = -1, i = round; i < num_dead_ends; ++i) {
+      int32_t priority = 0;
+      uint32_t const v = dead_ends[i];
+
+      if (!live[v])
+        continue;
+
+      if (time - timestamps[v] + 2 * live[v] <= OWL_MODEL_VERTEX_CACHE_SIZE)
+        priority = (int32_t)(time - timestamps[v]);
+
+      if (priority > best_priority) {
+        best_priority = priority;
+        fan = (int32_t)v;
+      }
+    }
+
+    if (0 <= fan)
+      continue;
+
+    /* dead end, restart from the most recent vertex with triangles left or
+     * from the next one in order */
+    while (num_dead_ends && 0 > fan) {
+      uint32_t const v = dead_ends[--num_dead_ends];
+
+      if (live[v])
+        fan = (int32_t)v;
+    }
+
+    for (; cursor < num_vertices && 0 > fan; ++cursor)
+      if (live[cursor])
+        fan = (int32_t)cursor;
+
+    if (num_emitted - clusters[num_clusters].first >=
+        OWL_MODEL_MIN_CLUSTER_SIZE) {
+      clusters[num_clusters].count =
+          num_emitted - clusters[num_clusters].first;
+      clusters[++num_clusters].first = num_emitted;
+    }
+  }
+
+  OWL_ASSERT(num_emitted == num_triangles);
+
+  /* the remaining triangles close the last cluster */
+  if (num_emitted > clusters[num_clusters].first) {
+    clusters[num_clusters].count = num_emitted - clusters[num_clusters].first;
+    ++num_clusters;
+  }
+
+  owl_model_sort_clusters(vertices, local, order, clusters, num_clusters);
+
+  for (num_emitted = 0, i = 0; i < num_clusters; ++i) {
+    uint32_t j;
+    struct owl_model_cluster const *cluster = &clusters[i];
+
+    for (j = cluster->first; j < cluster->first + cluster->count; ++j) {
+      uint32_t const *triangle = &local[order[j] * 3];
+
+      indices[num_emitted++] = triangle[0] + base;
+      indices[num_emitted++] = triangle[1] + base;
+      indices[num_emitted++] = triangle[2] + base;
+    }
+  }
+
+  ret = 1;
+
+out:
+  OWL_FREE(clusters);
+  OWL_FREE(emitted);
+  OWL_FREE(order);
+  OWL_FREE(dead_ends);
+  OWL_FREE(timestamps);
+  OWL_FREE(live);
+  OWL_FREE(triangles);
+  OWL_FREE(offsets);
+  OWL_FREE(local);
+
+  return ret;
+}
+
+/* moves the vertices to the order the indices first use them in, unused
+ * ones go last. indices are offset by base, vertices aren't */
+static void owl_model_optimize_vertex_fetch(struct owl_model_vertex *vertices,
+                                            uint32_t base,
+                                            uint32_t num_vertices,
+                                            uint32_t *indices,
+                                            uint32_t num_indices) {
+  uint32_t i;
+  uint32_t next = 0;
+  uint32_t *remap;
+  struct owl_model_vertex *copy;
+
+  remap = OWL_MALLOC(num_vertices * sizeof(*remap));
+  copy = OWL_MALLOC(num_vertices * sizeof(*copy));
+
+  if (!remap || !copy)
+    goto out;
+
+  for (i = 0; i < num_vertices; ++i)
+    remap[i] = 0xFFFFFFFF;
+
+  for (i = 0; i < num_indices; ++i) {
+    uint32_t const v = indices[i] - base;
+
+    if (0xFFFFFFFF == remap[v])
+      remap[v] = next++;
+
+    indices[i] = remap[v] + base;
+  }
+
+  for (i = 0; i < num_vertices; ++i)
+    if (0xFFFFFFFF == remap[i])
+      remap[i] = next++;
+
+  OWL_MEMCPY(copy, vertices, num_vertices * sizeof(*copy));
+
+  for (i = 0; i < num_vertices; ++i)
+    vertices[remap[i]] = copy[i];
+
+out:
+  OWL_FREE(copy);
+  OWL_FREE(remap);
+}
+
+/* misses[0] and misses[1] count the cache misses of the primitive's indices
+ * before and after reordering them */
+static void
+owl_model_optimize_primitive(struct owl_model_all_primitives *p,
+                             int32_t first_vertex,
+                             struct owl_model_primitive const *primitive,
+                             uint64_t *misses) {
+  uint32_t *indices = &p->indices[primitive->first];
+  struct owl_model_vertex *vertices = &p->vertices[first_vertex];
+
+  misses[0] += owl_model_count_cache_misses(indices, primitive->num_indices);
+
+  owl_model_optimize_vertex_cache(vertices, (uint32_t)first_vertex,
+                                  primitive->num_vertices, indices,
+                                  primitive->num_indices);
+
+  owl_model_optimize_vertex_fetch(vertices, (uint32_t)first_vertex,
+                                  primitive->num_vertices, indices,
+                                  primitive->num_indices);
+
+  misses[1] += owl_model_count_cache_misses(indices, primitive->num_indices);
+}
+
+/* appends the simplified levels of the primitive after its own indices,
+ * returns the number of indices used */
+static int32_t
+owl_model_generate_lods(struct owl_model_all_primitives *p,
+                        int32_t first_vertex, int32_t num_indices,
+                        struct owl_model_primitive *primitive) {
+  int32_t i;
+  float extent;
+  owl_v3 size;
+
+  /* glTF requires the bounds of positions, they size the allowed error */
+  if (!primitive->bbox.valid)
+    return num_indices;
+
+  OWL_V3_SUB(primitive->bbox.max, primitive->bbox.min, size);
+  extent = owl_v3_magnitude(size);
+
+  for (i = 1; i < OWL_MODEL_MAX_LODS; ++i) {
+    uint32_t count;
+    uint32_t target;
+    float max_error;
+    struct owl_model_lod const *previous = &primitive->lods[i - 1];
+    struct owl_model_lod *lod = &primitive->lods[i];
+
+    /* half of the triangles, rounded to whole ones */
+    target = previous->num_indices / 6 * 3;
+    if (!target)
+      break;
+
+    max_error = extent * OWL_MODEL_LOD_ERROR * (float)(1 << (i - 1));
+
+    OWL_ASSERT(num_indices + (int32_t)previous->num_indices <=
+               p->max_indices);
+
+    count = owl_model_simplify(
+        &p->vertices[first_vertex], (uint32_t)first_vertex,
+        primitive->num_vertices, &p->indices[previous->first],
+        previous->num_indices, target, max_error * max_error,
+        &p->indices[num_indices]);
+
+    /* the error bound stopped it early, not worth a level */
+    if (!count || count * 4 > previous->num_indices * 3)
+      break;
+
+    owl_model_optimize_vertex_cache(&p->vertices[first_vertex],
+                                    (uint32_t)first_vertex,
+                                    primitive->num_vertices,
+                                    &p->indices[num_indices], count);
+
+    lod->first = (uint32_t)num_indices;
+    lod->num_indices = count;
+    ++primitive->num_lods;
+
+    num_indices += (int32_t)count;
+  }
+
+  return num_indices;
+}
+
+/* the node and joint matrices of the node's mesh, a storage buffer per frame
+ * in flight */
+static int owl_model_init_mesh_storage(struct owl_renderer *r,
+                                       struct owl_model *m,
+                                       struct owl_model_node const *node) {
+  int32_t j;
+  int ret = OWL_OK;
+  VkDevice const device = r->device;
+  struct owl_model_mesh *mesh = &m->meshes[node->mesh];
+
+  for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(mesh->ssbos); ++j) {
+    VkBufferCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.size = sizeof(struct owl_model_joints_ssbo);
+    info.usage = 0;
+    info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
+
+    vk_result = vkCreateBuffer(device, &info, NULL, &mesh->ssbos[j]);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error_destroy_ssbos;
+    }
+  }
+
+  {
+    uint64_t aligned_size;
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
+    struct owl_memory_allocation *memory = &mesh->ssbo_memory;
+    VkResult vk_result;
+
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    vkGetBufferMemoryRequirements(device, mesh->ssbos[0], &requirements);
+
+    aligned_size = OWL_ALIGN_UP_2(requirements.size, requirements.alignment);
+
+    /* one range for every frame's ssbo */
+    requirements.size = aligned_size * OWL_ARRAY_SIZE(mesh->ssbos);
+
+    ret = owl_memory_allocate(r, &requirements, properties, memory);
+    if (ret)
+      goto error_destroy_ssbos;
+
+    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(mesh->ssbos); ++j) {
+      uint64_t const offset = j * aligned_size;
+
+      vk_result = vkBindBufferMemory(device, mesh->ssbos[j], memory->memory,
+                                     memory->offset + offset);
+      if (vk_result) {
+        ret = OWL_ERROR_FATAL;
+        goto error_free_memory;
+      }
+
+      mesh->mapped_ssbos[j] = (void *)&((uint8_t *)(memory->data))[offset];
+    }
+
+    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(mesh->ssbos); ++j) {
+      int32_t l;
+      struct owl_model_joints_ssbo *ssbo = mesh->mapped_ssbos[j];
+
+      if (-1 != node->skin)
+        ssbo->num_joints = m->skins[node->skin].num_joints;
+      else
+        ssbo->num_joints = 0;
+
+      OWL_M4_IDENTITY(ssbo->matrix);
+
+      for (l = 0; l < (int32_t)OWL_ARRAY_SIZE(ssbo->joints); ++l)
+        OWL_M4_IDENTITY(ssbo->joints[l]);
+    }
+  }
+
+  {
+    VkDescriptorSetLayout layouts[OWL_ARRAY_SIZE(mesh->ssbos)];
+
+    OWL_ASSERT(OWL_ARRAY_SIZE(mesh->ssbo_descriptor_sets) ==
+               OWL_ARRAY_SIZE(mesh->ssbos));
+
+    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(layouts); ++j)
+      layouts[j] = r->model_storage_descriptor_set_layout;
+
+    ret = owl_renderer_allocate_descriptor_sets(
+        r, OWL_ARRAY_SIZE(layouts), layouts, mesh->ssbo_descriptor_sets,
+        &mesh->ssbo_descriptor_pool);
+    if (ret)
+      goto error_free_memory;
+  }
+  {
+    VkDescriptorBufferInfo descriptors[OWL_ARRAY_SIZE(mesh->ssbos)];
+    VkWriteDescriptorSet writes[OWL_ARRAY_SIZE(mesh->ssbos)];
+
+    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(descriptors); ++j) {
+      descriptors[j].buffer = mesh->ssbos[j];
+      descriptors[j].offset = 0;
+      descriptors[j].range = sizeof(struct owl_model_joints_ssbo);
+
+      writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[j].pNext = NULL;
+      writes[j].dstSet = mesh->ssbo_descriptor_sets[j];
+      writes[j].dstBinding = 0;
+      writes[j].dstArrayElement = 0;
+      writes[j].descriptorCount = 1;
+      writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[j].pImageInfo = NULL;
+      writes[j].pBufferInfo = &descriptors[j];
+      writes[j].pTexelBufferView = NULL;
+    }
+
+    vkUpdateDescriptorSets(device, OWL_ARRAY_SIZE(writes), writes, 0, NULL);
+  }
+
+  return OWL_OK;
+
+error_free_memory:
+  owl_memory_free(r, &mesh->ssbo_memory);
+  j = (int32_t)OWL_ARRAY_SIZE(mesh->ssbos);
+
+error_destroy_ssbos:
+  for (j = j - 1; j >= 0; --j)
+    vkDestroyBuffer(device, mesh->ssbos[j], NULL);
+
+  return ret;
+}
+
+static int owl_model_load_nodes(struct owl_renderer *r,
+                                struct cgltf_data const *gltf,
+                                struct owl_model_all_primitives *p,
+                                struct owl_model *m) {
+  int32_t i;
+  int32_t num_vertices = 0;
+  int32_t num_indices = 0;
+  uint64_t num_triangles = 0;
+  uint64_t misses[2];
+  int ret = OWL_OK;
+
+  misses[0] = 0;
+  misses[1] = 0;
+
+  OWL_ASSERT(gltf->nodes_count < OWL_ARRAY_SIZE(m->nodes));
+  OWL_ASSERT(gltf->meshes_count < OWL_ARRAY_SIZE(m->meshes));
+
+  m->num_primitives = 0;
+  m->num_meshes = 0;
+  m->num_nodes = (int32_t)gltf->nodes_count;
+
+  for (i = 0; i < m->num_nodes; ++i) {
+    int32_t j;
+    struct cgltf_node const *in_node;
+    struct owl_model_node *out_node;
+
+    in_node = &gltf->nodes[i];
+    out_node = &m->nodes[(int32_t)(in_node - gltf->nodes)];
+
+    if (in_node->parent)
+      out_node->parent = (int32_t)(in_node->parent - gltf->nodes);
+    else
+      out_node->parent = -1;
+
+    OWL_ASSERT(in_node->children_count < OWL_ARRAY_SIZE(out_node->children));
+
+    out_node->num_children = (int32_t)in_node->children_count;
+    for (j = 0; j < out_node->num_children; ++j)
+      out_node->children[j] = (int32_t)(in_node->children[j] - gltf->nodes);
+
+    if (in_node->name) {
+      uint32_t max_length = OWL_ARRAY_SIZE(out_node->name);
+      OWL_STRNCPY(out_node->name, in_node->name, max_length);
+    } else {
+      uint32_t max_length = OWL_ARRAY_SIZE(out_node->name);
+      OWL_STRNCPY(out_node->name, "NO NAME", max_length);
+    }
+
+    if (in_node->has_translation) {
+      out_node->translation[0] = in_node->translation[0];
+      out_node->translation[1] = in_node->translation[1];
+      out_node->translation[2] = in_node->translation[2];
+    } else {
+      out_node->translation[0] = 0.0F;
+      out_node->translation[1] = 0.0F;
+      out_node->translation[2] = 0.0F;
+    }
+
+    if (in_node->has_rotation) {
+      out_node->rotation[0] = in_node->rotation[0];
+      out_node->rotation[1] = in_node->rotation[1];
+      out_node->rotation[2] = in_node->rotation[2];
+      out_node->rotation[3] = in_node->rotation[3];
+    } else {
+      out_node->rotation[0] = 0.0F;
+      out_node->rotation[1] = 0.0F;
+      out_node->rotation[2] = 0.0F;
+      out_node->rotation[3] = 0.0F;
+    }
+
+    if (in_node->has_scale) {
+      out_node->scale[0] = in_node->scale[0];
+      out_node->scale[1] = in_node->scale[1];
+      out_node->scale[2] = in_node->scale[2];
+    } else {
+      out_node->scale[0] = 1.0F;
+      out_node->scale[1] = 1.0F;
+      out_node->scale[2] = 1.0F;
+    }
+
+    if (in_node->has_matrix)
+      OWL_M4_COPY_V16(in_node->matrix, out_node->matrix);
+    else
+      OWL_M4_IDENTITY(out_node->matrix);
+
+    if (in_node->skin)
+      out_node->skin = (int32_t)(in_node->skin - gltf->skins);
+    else
+      out_node->skin = -1;
+
+    /* FIXME(samuel): not sure if each node has it's own mesh, however as I
+     * allocate resources per mesh, it's easier to give each one it's own
+     * instead of checking if it exists */
+    if (in_node->mesh) {
+      struct cgltf_mesh const *in_mesh;
+      struct owl_model_mesh *out_mesh;
+
+      in_mesh = in_node->mesh;
+
+#if 0
+			out_node->mesh = (int32_t)(in_mesh - gltf->meshes);
+#else
+      out_node->mesh = m->num_meshes++;
+#endif
+      out_mesh = &m->meshes[out_node->mesh];
+
+      OWL_ASSERT(in_mesh->primitives_count <
+                 OWL_ARRAY_SIZE(out_mesh->primitives));
+
+      out_mesh->num_primitives = (int32_t)in_mesh->primitives_count;
+      for (j = 0; j < out_mesh->num_primitives; ++j) {
+        int32_t k;
+        int32_t has_skin;
+        int32_t num_local_vertices = 0;
+        int32_t num_local_indices = 0;
+
+        int32_t position_stride = 0;
+        float const *position = NULL;
+
+        int32_t has_bounds = 0;
+        owl_v3 min_pos;
+        owl_v3 max_pos;
+
+        int32_t normal_stride = 0;
+        float const *normal = NULL;
+
+        int32_t uv0_stride = 0;
+        float const *uv0 = NULL;
+
+        int32_t uv1_stride = 0;
+        float const *uv1 = NULL;
+
+        int32_t joints0_component_is_u8;
+        int32_t joints0_stride = 0;
+        uint8_t const *joints0 = NULL;
+
+        int32_t weights0_stride = 0;
+        float const *weights0 = NULL;
+
+        int32_t color0_stride = 0;
         float const *color0 = NULL;
 
-        struct cgltf_attribute const *attr = NULL;
-        struct owl_model_primitive *out_primitive = NULL;
-        struct cgltf_primitive const *in_primitive = NULL;
+        struct cgltf_attribute const *attr = NULL;
+        struct owl_model_primitive *out_primitive = NULL;
+        struct cgltf_primitive const *in_primitive = NULL;
+
+        in_primitive = &in_mesh->primitives[j];
+        out_mesh->primitives[j] = m->num_primitives;
+        out_primitive = &m->primitives[m->num_primitives++];
+
+        attr = owl_find_gltf_attribute(in_primitive, "POSITION");
+        if (attr) {
+          position = owl_resolve_gltf_accessor(attr->data);
+          position_stride = owl_model_gltf_stride(attr->data->type);
+          num_local_vertices = (int32_t)attr->data->count;
+          has_bounds = attr->data->has_min && attr->data->has_max;
+          if (attr->data->has_min) {
+            min_pos[0] = attr->data->min[0];
+            min_pos[1] = attr->data->min[1];
+            min_pos[2] = attr->data->min[2];
+          }
+
+          if (attr->data->has_max) {
+            max_pos[0] = attr->data->max[0];
+            max_pos[1] = attr->data->max[1];
+            max_pos[2] = attr->data->max[2];
+          }
+        }
+
+        attr = owl_find_gltf_attribute(in_primitive, "NORMAL");
+        if (attr) {
+          normal = owl_resolve_gltf_accessor(attr->data);
+          normal_stride = owl_model_gltf_stride(attr->data->type);
+        }
+
+        attr = owl_find_gltf_attribute(in_primitive, "TEXCOORD_0");
+        if (attr) {
+          uv0 = owl_resolve_gltf_accessor(attr->data);
+          uv0_stride = owl_model_gltf_stride(attr->data->type);
+        }
+
+        attr = owl_find_gltf_attribute(in_primitive, "TEXCOORD_1");
+        if (attr) {
+          uv1 = owl_resolve_gltf_accessor(attr->data);
+          uv1_stride = owl_model_gltf_stride(attr->data->type);
+        }
+
+        attr = owl_find_gltf_attribute(in_primitive, "JOINTS_0");
+        if (attr) {
+          joints0 = owl_resolve_gltf_accessor(attr->data);
+          joints0_stride = owl_model_gltf_stride(attr->data->type);
+          if (attr->data->component_type == cgltf_component_type_r_8u)
+            joints0_component_is_u8 = 1;
+          else
+            joints0_component_is_u8 = 0;
+        }
+
+        attr = owl_find_gltf_attribute(in_primitive, "weights_0");
+        if (attr) {
+          weights0 = owl_resolve_gltf_accessor(attr->data);
+          weights0_stride = owl_model_gltf_stride(attr->data->type);
+        }
+
+        attr = owl_find_gltf_attribute(in_primitive, "COLOR_0");
+        if (attr) {
+          color0 = owl_resolve_gltf_accessor(attr->data);
+          color0_stride = owl_model_gltf_stride(attr->data->type);
+        }
+
+        has_skin = joints0 && weights0;
+
+        for (k = 0; k < num_local_vertices; ++k) {
+          struct owl_model_vertex *vertex = &p->vertices[num_vertices + k];
+
+          OWL_ASSERT(position);
+          OWL_ASSERT(3 <= position_stride);
+          vertex->position[0] = (&position[k * position_stride])[0];
+          vertex->position[1] = (&position[k * position_stride])[1];
+          vertex->position[2] = (&position[k * position_stride])[2];
+
+          if (normal) {
+            OWL_ASSERT(3 <= normal_stride);
+            owl_model_encode_normal(&normal[k * normal_stride],
+                                    vertex->normal);
+          } else {
+            vertex->normal[0] = 0;
+            vertex->normal[1] = 0;
+          }
+
+          if (uv0) {
+            OWL_ASSERT(2 <= uv0_stride);
+            vertex->uv0[0] = owl_model_float_to_half(uv0[k * uv0_stride]);
+            vertex->uv0[1] = owl_model_float_to_half(uv0[k * uv0_stride + 1]);
+          } else {
+            vertex->uv0[0] = 0;
+            vertex->uv0[1] = 0;
+          }
+
+          if (uv1) {
+            OWL_ASSERT(2 <= uv1_stride);
+            vertex->uv1[0] = owl_model_float_to_half(uv1[k * uv1_stride]);
+            vertex->uv1[1] = owl_model_float_to_half(uv1[k * uv1_stride + 1]);
+          } else {
+            vertex->uv1[0] = 0;
+            vertex->uv1[1] = 0;
+          }
+
+          if (has_skin) {
+            int32_t l;
+
+            OWL_ASSERT(4 == joints0_stride);
+            for (l = 0; l < 4; ++l) {
+              uint32_t joint;
+
+              if (joints0_component_is_u8) {
+                joint = (&joints0[k * joints0_stride])[l];
+              } else {
+                uint16_t const *joints0_u16 = (uint16_t const *)joints0;
+                joint = (&joints0_u16[k * joints0_stride])[l];
+              }
+
+              /* owl_model_joints_ssbo holds fewer joints than that anyway */
+              OWL_ASSERT(256 > joint);
+              vertex->joints0[l] = (uint8_t)joint;
+            }
+          } else {
+            vertex->joints0[0] = 0;
+            vertex->joints0[1] = 0;
+            vertex->joints0[2] = 0;
+            vertex->joints0[3] = 0;
+          }
+
+          if (has_skin) {
+            OWL_ASSERT(4 == weights0_stride);
+            owl_model_encode_weights(&weights0[k * weights0_stride],
+                                     vertex->weights0);
+          } else {
+            vertex->weights0[0] = 255;
+            vertex->weights0[1] = 0;
+            vertex->weights0[2] = 0;
+            vertex->weights0[3] = 0;
+          }
+
+          if (color0) {
+            int32_t l;
+
+            OWL_ASSERT(4 == color0_stride);
+            for (l = 0; l < 4; ++l)
+              vertex->color0[l] =
+                  owl_model_float_to_unorm8(color0[k * color0_stride + l]);
+          } else {
+            vertex->color0[0] = 255;
+            vertex->color0[1] = 255;
+            vertex->color0[2] = 255;
+            vertex->color0[3] = 255;
+          }
+        }
+
+        if (in_primitive->indices) {
+          struct cgltf_accessor *accessor = in_primitive->indices;
+
+          num_local_indices = (int32_t)accessor->count;
+
+          OWL_ASSERT(num_indices + num_local_indices <= p->max_indices);
+
+          switch (accessor->component_type) {
+          case cgltf_component_type_r_32u: {
+            int32_t l;
+            uint32_t const *data = owl_resolve_gltf_accessor(accessor);
+            for (l = 0; l < num_local_indices; ++l)
+              p->indices[num_indices + l] = data[l] + num_vertices;
+          } break;
+          case cgltf_component_type_r_16u: {
+            int32_t l;
+            uint16_t const *data = owl_resolve_gltf_accessor(accessor);
+            for (l = 0; l < num_local_indices; ++l)
+              p->indices[num_indices + l] = data[l] + num_vertices;
+          } break;
+          case cgltf_component_type_r_8u: {
+            int32_t l;
+            uint8_t const *data = owl_resolve_gltf_accessor(accessor);
+            for (l = 0; l < num_local_indices; ++l)
+              p->indices[num_indices + l] = data[l] + num_vertices;
+          } break;
+          case cgltf_component_type_invalid:
+          case cgltf_component_type_r_8:
+          case cgltf_component_type_r_16:
+          case cgltf_component_type_r_32f:
+            OWL_ASSERT(0);
+          }
+        }
+
+        {
+          int32_t material;
+
+          out_primitive->first = num_indices;
+          out_primitive->num_indices = num_local_indices;
+          out_primitive->num_vertices = num_local_vertices;
+          out_primitive->has_indices = !!num_local_indices;
+          out_primitive->bbox.valid = has_bounds;
+
+          if (has_bounds) {
+            out_primitive->bbox.min[0] = min_pos[0];
+            out_primitive->bbox.min[1] = min_pos[1];
+            out_primitive->bbox.min[2] = min_pos[2];
+
+            out_primitive->bbox.max[0] = max_pos[0];
+            out_primitive->bbox.max[1] = max_pos[1];
+            out_primitive->bbox.max[2] = max_pos[2];
+          }
+
+          material = (int32_t)(in_primitive->material - gltf->materials);
+          out_primitive->material = material;
+
+          out_primitive->num_lods = 1;
+          out_primitive->lods[0].first = (uint32_t)num_indices;
+          out_primitive->lods[0].num_indices = (uint32_t)num_local_indices;
+
+          num_indices += num_local_indices;
+
+          /* the lods are simplified from the reordered vertices and
+           * indices, they only need their own triangles reordered */
+          if (num_local_indices &&
+              cgltf_primitive_type_triangles == in_primitive->type) {
+            owl_model_optimize_primitive(p, num_vertices, out_primitive,
+                                         misses);
+            num_triangles += (uint64_t)num_local_indices / 3;
+
+            num_indices = owl_model_generate_lods(p, num_vertices,
+                                                  num_indices, out_primitive);
+          }
+
+          num_vertices += num_local_vertices;
+        }
+      }
+
+      /* skinned meshes grow aabb with the joints as they animate */
+      owl_model_bbox_reset(&out_mesh->bb);
+
+      for (j = 0; j < out_mesh->num_primitives; ++j) {
+        int32_t const primitive = out_mesh->primitives[j];
+        owl_model_bbox_merge(&m->primitives[primitive].bbox, &out_mesh->bb);
+      }
+
+      out_mesh->aabb = out_mesh->bb;
+
+      ret = owl_model_init_mesh_storage(r, m, out_node);
+      OWL_ASSERT(!ret);
+    } else {
+      out_node->mesh = -1;
+    }
+  }
+
+  OWL_ASSERT(num_indices <= p->max_indices);
+  OWL_ASSERT(num_vertices == p->num_vertices);
+
+  p->num_indices = num_indices;
+
+  if (num_triangles) {
+    OWL_DEBUG_LOG("vertex cache acmr %.3f as loaded, %.3f reordered\n",
+                  (double)misses[0] / (double)num_triangles,
+                  (double)misses[1] / (double)num_triangles);
+  }
+
+  return ret;
+}
+
+static void owl_model_unload_nodes(struct owl_renderer *r,
+                                   struct owl_model *m) {
+  int32_t i;
+  VkDevice const device = r->device;
+  /* could just iterate each mesh instead of going trough each node,
+  however it's easier to cleanup future resource allocations this way */
+  for (i = 0; i < m->num_nodes; ++i) {
+    int32_t j;
+    struct owl_model_node *node;
+    struct owl_model_mesh *mesh;
+
+    node = &m->nodes[i];
+
+    /* if no mesh, continue */
+    if (-1 == node->mesh)
+      continue;
+
+    mesh = &m->meshes[node->mesh];
+
+    owl_renderer_free_descriptor_sets(r, mesh->ssbo_descriptor_pool,
+                                      OWL_ARRAY_SIZE(mesh->ssbos),
+                                      mesh->ssbo_descriptor_sets);
+
+    owl_memory_free(r, &mesh->ssbo_memory);
+
+    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(mesh->ssbos); ++j)
+      vkDestroyBuffer(device, mesh->ssbos[j], NULL);
+  }
+}
+
+/* indices point into the vertex buffer shared by every primitive, it's the
+ * whole buffer that has to fit. narrows the indices in place when it does */
+static VkIndexType
+owl_model_narrow_indices(struct owl_model_all_primitives *p) {
+  int32_t i;
+  uint16_t *indices = (uint16_t *)p->indices;
+
+  if (0xFFFF + 1 < p->num_vertices)
+    return VK_INDEX_TYPE_UINT32;
+
+  /* each index is read before the narrowed ones reach it */
+  for (i = 0; i < p->num_indices; ++i)
+    indices[i] = (uint16_t)p->indices[i];
+
+  return VK_INDEX_TYPE_UINT16;
+}
+
+/* vertices and indices are already in the layout the gpu reads them in */
+static int owl_model_init_buffers(struct owl_renderer *r, void const *vertices,
+                                  int32_t num_vertices, void const *indices,
+                                  int32_t num_indices, VkIndexType index_type,
+                                  struct owl_model *m) {
+  int ret = OWL_OK;
+  uint64_t index_stride;
+  VkDevice const device = r->device;
+
+  m->index_type = index_type;
+
+  if (VK_INDEX_TYPE_UINT16 == index_type)
+    index_stride = sizeof(uint16_t);
+  else
+    index_stride = sizeof(uint32_t);
+
+  {
+    VkBufferCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.size = num_vertices * sizeof(struct owl_model_vertex);
+    info.usage = 0;
+    info.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = 0;
+
+    vk_result = vkCreateBuffer(device, &info, NULL, &m->vertex_buffer);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
+  }
+
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
+
+    properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    vkGetBufferMemoryRequirements(device, m->vertex_buffer, &requirements);
+
+    ret = owl_memory_allocate(r, &requirements, properties, &m->vertex_memory);
+    if (ret)
+      goto error_destroy_vertex_buffer;
+
+    ret = owl_memory_bind_buffer(r, m->vertex_buffer, &m->vertex_memory);
+    if (ret)
+      goto error_free_vertex_memory;
+  }
+
+  if (num_indices) {
+    {
+      VkBufferCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.size = num_indices * index_stride;
+      info.usage = 0;
+      info.usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+      info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+      info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      info.queueFamilyIndexCount = 0;
+      info.pQueueFamilyIndices = 0;
+
+      vk_result = vkCreateBuffer(device, &info, NULL, &m->index_buffer);
+      if (vk_result) {
+        ret = OWL_ERROR_FATAL;
+        goto error_free_vertex_memory;
+      }
+    }
+
+    {
+      VkMemoryPropertyFlagBits properties;
+      VkMemoryRequirements requirements;
+
+      properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+      vkGetBufferMemoryRequirements(device, m->index_buffer, &requirements);
+
+      ret =
+          owl_memory_allocate(r, &requirements, properties, &m->index_memory);
+      if (ret)
+        goto error_destroy_index_buffer;
+
+      ret = owl_memory_bind_buffer(r, m->index_buffer, &m->index_memory);
+      if (ret)
+        goto error_free_index_memory;
+    }
+
+    m->has_indices = 1;
+  } else {
+    m->index_buffer = VK_NULL_HANDLE;
+    m->index_memory.memory = VK_NULL_HANDLE;
+    m->has_indices = 0;
+  }
+
+  /* a single upload for both buffers, the model isn't drawn until the
+   * transfer queue is done with it */
+  {
+    int release_ret;
+    VkBufferCopy copy;
+    uint64_t vertex_size;
+    uint64_t index_size;
+    uint8_t *data;
+    struct owl_renderer_upload_allocation allocation;
+
+    vertex_size = num_vertices * sizeof(struct owl_model_vertex);
+    index_size = num_indices * index_stride;
+
+    data = owl_renderer_begin_async_upload(r, vertex_size + index_size,
+                                           &allocation);
+    if (!data) {
+      ret = OWL_ERROR_NO_UPLOAD_MEMORY;
+      goto error_free_index_memory;
+    }
+
+    OWL_MEMCPY(data, vertices, vertex_size);
+
+#if 0
+    {
+      int32_t i;
+      OWL_DEBUG_LOG("splating vertices...\n");
+      for (i = 0; i < num_vertices; ++i) {
+        struct owl_model_vertex const *vertex = &vertices[i];
+        OWL_DEBUG_LOG("  p->vertices[%i]:\n", i);
+        OWL_DEBUG_LOG("    position: " OWL_V3_FORMAT "\n",
+                      OWL_V3_FORMAT_ARGS(vertex->position));
+      }
+    }
+#endif
+
+    copy.srcOffset = allocation.offset;
+    copy.dstOffset = 0;
+    copy.size = vertex_size;
+
+    vkCmdCopyBuffer(r->async_command_buffer, allocation.buffer,
+                    m->vertex_buffer, 1, &copy);
+
+    release_ret = owl_renderer_async_release_buffer(
+        r, m->vertex_buffer, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+    if (!release_ret && m->has_indices) {
+      OWL_MEMCPY(&data[vertex_size], indices, index_size);
+
+#if 0
+      {
+        int32_t i;
+        OWL_DEBUG_LOG("splating indices...\n");
+        for (i = 0; i < num_indices; ++i) {
+          OWL_DEBUG_LOG("  indices[%i]: = %u\n", i, indices[i]);
+          OWL_ASSERT(indices[i] <= (uint32_t)num_vertices);
+        }
+      }
+#endif
+
+      copy.srcOffset = allocation.offset + vertex_size;
+      copy.dstOffset = 0;
+      copy.size = index_size;
+
+      vkCmdCopyBuffer(r->async_command_buffer, allocation.buffer,
+                      m->index_buffer, 1, &copy);
+
+      release_ret = owl_renderer_async_release_buffer(
+          r, m->index_buffer, VK_ACCESS_INDEX_READ_BIT);
+    }
+
+    /* the upload is already recording, submit it either way so the slot
+     * and the staging memory come back */
+    ret = owl_renderer_end_async_upload(r, &m->upload_ticket);
+    if (ret)
+      goto error_free_index_memory;
+
+    if (release_ret) {
+      ret = owl_renderer_wait_async_upload(r, m->upload_ticket);
+      OWL_ASSERT(!ret);
+      ret = release_ret;
+      goto error_free_index_memory;
+    }
+  }
+
+  return OWL_OK;
+
+error_free_index_memory:
+  if (num_indices)
+    owl_memory_free(r, &m->index_memory);
+
+error_destroy_index_buffer:
+  if (num_indices)
+    vkDestroyBuffer(device, m->index_buffer, NULL);
+
+error_free_vertex_memory:
+  owl_memory_free(r, &m->vertex_memory);
+
+error_destroy_vertex_buffer:
+  vkDestroyBuffer(device, m->vertex_buffer, NULL);
+
+  m->has_indices = 0;
+
+  return ret;
+}
+
+static void owl_model_deinit_buffers(struct owl_renderer *r,
+                                     struct owl_model *m) {
+  VkDevice const device = r->device;
+
+  if (m->has_indices) {
+    owl_memory_free(r, &m->index_memory);
+    vkDestroyBuffer(device, m->index_buffer, NULL);
+  }
+
+  owl_memory_free(r, &m->vertex_memory);
+  vkDestroyBuffer(device, m->vertex_buffer, NULL);
+}
+
+/* TODO(samuel): do a simplify pass */
+static int owl_model_load_skins(struct owl_renderer *r,
+                                struct cgltf_data const *gltf,
+                                struct owl_model *m) {
+  int32_t i;
+  int ret = OWL_OK;
+
+  OWL_UNUSED(r);
+
+  OWL_ASSERT(gltf->skins_count < OWL_ARRAY_SIZE(m->skins));
+
+  m->num_skins = (int32_t)gltf->skins_count;
+  for (i = 0; i < m->num_skins; ++i) {
+    int32_t j;
+    struct owl_model_skin *out_skin = &m->skins[i];
+    struct cgltf_skin const *in_skin = &gltf->skins[i];
+
+    if (in_skin->name) {
+      uint32_t max_length = OWL_ARRAY_SIZE(out_skin->name);
+      OWL_STRNCPY(out_skin->name, in_skin->name, max_length);
+    } else {
+      uint32_t max_length = OWL_ARRAY_SIZE(out_skin->name);
+      OWL_STRNCPY(out_skin->name, "NO NAME", max_length);
+    }
+
+    if (in_skin->skeleton)
+      out_skin->root = (int32_t)(in_skin->skeleton - gltf->nodes);
+    else
+      out_skin->root = -1;
+
+    OWL_ASSERT(in_skin->joints_count < OWL_ARRAY_SIZE(out_skin->joints));
+
+    out_skin->num_joints = (int32_t)in_skin->joints_count;
+    for (j = 0; j < out_skin->num_joints; ++j)
+      out_skin->joints[j] = (int32_t)(in_skin->joints[j] - gltf->nodes);
+
+    if (in_skin->inverse_bind_matrices) {
+      struct cgltf_accessor *accessor;
+      owl_m4 const *matrices;
+
+      accessor = in_skin->inverse_bind_matrices;
+      matrices = owl_resolve_gltf_accessor(accessor);
+
+      OWL_ASSERT(accessor->count < OWL_ARRAY_SIZE(out_skin->joints));
 
-        in_primitive = &in_mesh->primitives[j];
-        out_mesh->primitives[j] = m->num_primitives;
-        out_primitive = &m->primitives[m->num_primitives++];
+      out_skin->num_inverse_bind_matrices = accessor->count;
+      for (j = 0; j < out_skin->num_inverse_bind_matrices; ++j)
+        OWL_M4_COPY(matrices[j], out_skin->inverse_bind_matrices[j]);
+    }
 
-        attr = owl_find_gltf_attribute(in_primitive, "POSITION");
-        if (attr) {
-          position = owl_resolve_gltf_accessor(attr->data);
-          position_stride = owl_model_gltf_stride(attr->data->type);
-          num_local_vertices = (int32_t)attr->data->count;
-          if (attr->data->has_min) {
-            min_pos[0] = attr->data->min[0];
-            min_pos[1] = attr->data->min[1];
-            min_pos[2] = attr->data->min[2];
-          }
+    /* allocate and write the descriptor sets */
+  }
 
-          if (attr->data->has_max) {
-            max_pos[0] = attr->data->max[0];
-            max_pos[1] = attr->data->max[1];
-            max_pos[2] = attr->data->max[2];
-          }
-        }
+  return ret;
+}
 
-        attr = owl_find_gltf_attribute(in_primitive, "NORMAL");
-        if (attr) {
-          normal = owl_resolve_gltf_accessor(attr->data);
-          normal_stride = owl_model_gltf_stride(attr->data->type);
-        }
+static void owl_model_unload_skins(struct owl_renderer *r,
+                                   struct owl_model *m) {
+  OWL_UNUSED(r);
+  OWL_UNUSED(m);
+}
 
-        attr = owl_find_gltf_attribute(in_primitive, "TEXCOORD_0");
-        if (attr) {
-          uv0 = owl_resolve_gltf_accessor(attr->data);
-          uv0_stride = owl_model_gltf_stride(attr->data->type);
-        }
+static int owl_model_load_animations(struct owl_renderer *r,
+                                     struct cgltf_data const *gltf,
+                                     struct owl_model *m) {
+  int32_t i;
+  int ret = OWL_OK;
 
-        attr = owl_find_gltf_attribute(in_primitive, "TEXCOORD_1");
-        if (attr) {
-          uv1 = owl_resolve_gltf_accessor(attr->data);
-          uv1_stride = owl_model_gltf_stride(attr->data->type);
-        }
+  OWL_UNUSED(r);
 
-        attr = owl_find_gltf_attribute(in_primitive, "JOINTS_0");
-        if (attr) {
-          joints0 = owl_resolve_gltf_accessor(attr->data);
-          joints0_stride = owl_model_gltf_stride(attr->data->type);
-          if (attr->data->component_type == cgltf_component_type_r_8u)
-            joints0_component_is_u8 = 1;
-          else
-            joints0_component_is_u8 = 0;
-        }
+  OWL_ASSERT(OWL_ANIMATION_INTERPOLATION_LINEAR ==
+             cgltf_interpolation_type_linear);
+  OWL_ASSERT(OWL_ANIMATION_INTERPOLATION_STEP == cgltf_interpolation_type_step);
+  OWL_ASSERT(OWL_ANIMATION_INTERPOLATION_CUBICSPLINE ==
+             cgltf_interpolation_type_cubic_spline);
 
-        attr = owl_find_gltf_attribute(in_primitive, "weights_0");
-        if (attr) {
-          weights0 = owl_resolve_gltf_accessor(attr->data);
-          weights0_stride = owl_model_gltf_stride(attr->data->type);
-        }
+  OWL_ASSERT(OWL_ANIMATION_PATH_TRANSLATION ==
+             cgltf_animation_path_type_translation);
+  OWL_ASSERT(OWL_ANIMATION_PATH_ROTATION == cgltf_animation_path_type_rotation);
+  OWL_ASSERT(OWL_ANIMATION_PATH_SCALE == /*   */
+             cgltf_animation_path_type_scale);
+  OWL_ASSERT(OWL_ANIMATION_PATH_WEIGHTS == /*  */
+             cgltf_animation_path_type_weights);
 
-        attr = owl_find_gltf_attribute(in_primitive, "COLOR_0");
-        if (attr) {
-          color0 = owl_resolve_gltf_accessor(attr->data);
-          color0_stride = owl_model_gltf_stride(attr->data->type);
-        }
+  OWL_ASSERT(gltf->animations_count < OWL_ARRAY_SIZE(m->animations));
 
-        has_skin = joints0 && weights0;
+  m->num_samplers = 0;
+  m->num_channels = 0;
 
-        for (k = 0; k < num_local_vertices; ++k) {
-          struct owl_model_vertex *vertex = &p->vertices[num_vertices + k];
+  m->num_animations = (int32_t)gltf->animations_count;
+  for (i = 0; i < m->num_animations; ++i) {
+    int32_t j;
+    struct owl_model_animation *out_animation = &m->animations[i];
+    struct cgltf_animation const *in_animation = &gltf->animations[i];
 
-          OWL_ASSERT(position);
-          OWL_ASSERT(3 <= position_stride);
-          vertex->position[0] = (&position[k * position_stride])[0];
-          vertex->position[1] = (&position[k * position_stride])[1];
-          vertex->position[2] = (&position[k * position_stride])[2];
+    out_animation->time = 0.0F;
+    out_animation->start = FLT_MAX;
+    out_animation->end = FLT_MIN;
 
-          if (normal) {
-            OWL_ASSERT(3 <= normal_stride);
-            vertex->normal[0] = (&normal[k * normal_stride])[0];
-            vertex->normal[1] = (&normal[k * normal_stride])[1];
-            vertex->normal[2] = (&normal[k * normal_stride])[2];
-          } else {
-            vertex->normal[0] = 0.0F;
-            vertex->normal[1] = 0.0F;
-            vertex->normal[2] = 0.0F;
-          }
+    if (in_animation->name) {
+      int32_t max_length = OWL_ARRAY_SIZE(out_animation->name);
+      OWL_STRNCPY(out_animation->name, in_animation->name, max_length);
+    } else {
+      int32_t max_length = OWL_ARRAY_SIZE(out_animation->name);
+      OWL_STRNCPY(out_animation->name, "NO NAME", max_length);
+    }
 
-          if (uv0) {
-            OWL_ASSERT(2 <= uv0_stride);
-            vertex->uv0[0] = (&uv0[k * uv0_stride])[0];
-            vertex->uv0[1] = (&uv0[k * uv0_stride])[1];
-#if 0
-            OWL_DEBUG_LOG("  uv0: " OWL_V2_FORMAT "\n", OWL_V2_FORMAT_ARGS(vertex->uv0));
-            OWL_ASSERT(vertex->uv0[0] < 1.0F && vertex->uv0[0] > 0.0F);
-            OWL_ASSERT(vertex->uv0[1] < 1.0F && vertex->uv0[1] > 0.0F);
-#endif
-          } else {
-            vertex->uv0[0] = 0.0F;
-            vertex->uv0[1] = 0.0F;
-          }
+    OWL_ASSERT(in_animation->samplers_count <
+               OWL_ARRAY_SIZE(out_animation->samplers));
 
-          if (uv1) {
-            OWL_ASSERT(2 <= uv1_stride);
-            vertex->uv1[0] = (&uv1[k * uv1_stride])[0];
-            vertex->uv1[1] = (&uv1[k * uv1_stride])[1];
-          } else {
-            vertex->uv1[0] = 0.0F;
-            vertex->uv1[1] = 0.0F;
-          }
+    out_animation->num_samplers = (int32_t)in_animation->samplers_count;
+    for (j = 0; j < out_animation->num_samplers; ++j) {
+      int32_t k;
+      float const *inputs;
+      struct owl_model_animation_sampler *out_sampler;
+      struct cgltf_animation_sampler *in_sampler;
 
-          if (has_skin) {
-            OWL_ASSERT(4 == joints0_stride);
-            if (joints0_component_is_u8) {
-              vertex->joints0[0] = (&joints0[k * joints0_stride])[0];
-              vertex->joints0[1] = (&joints0[k * joints0_stride])[1];
-              vertex->joints0[2] = (&joints0[k * joints0_stride])[2];
-              vertex->joints0[3] = (&joints0[k * joints0_stride])[3];
-            } else {
-              uint16_t *joints0_u16 = (uint16_t *)joints0;
-              vertex->joints0[0] = (&joints0_u16[k * joints0_stride])[0];
-              vertex->joints0[1] = (&joints0_u16[k * joints0_stride])[1];
-              vertex->joints0[2] = (&joints0_u16[k * joints0_stride])[2];
-              vertex->joints0[3] = (&joints0_u16[k * joints0_stride])[3];
-            }
-          } else {
-            vertex->joints0[0] = 0.0F;
-            vertex->joints0[1] = 0.0F;
-            vertex->joints0[2] = 0.0F;
-            vertex->joints0[3] = 0.0F;
-          }
+      out_animation->samplers[j] = m->num_samplers + j;
 
-          if (has_skin) {
-            OWL_ASSERT(4 == weights0_stride);
-            vertex->weights0[0] = (&weights0[k * weights0_stride])[0];
-            vertex->weights0[1] = (&weights0[k * weights0_stride])[1];
-            vertex->weights0[2] = (&weights0[k * weights0_stride])[2];
-            vertex->weights0[3] = (&weights0[k * weights0_stride])[3];
-          } else {
-            vertex->weights0[0] = 1.0F;
-            vertex->weights0[1] = 0.0F;
-            vertex->weights0[2] = 0.0F;
-            vertex->weights0[3] = 0.0F;
-          }
+      in_sampler = &in_animation->samplers[j];
+      out_sampler = &m->samplers[out_animation->samplers[j]];
 
-          if (color0) {
-            OWL_ASSERT(4 == color0_stride);
-            vertex->color0[0] = (&color0[k * color0_stride])[0];
-            vertex->color0[1] = (&color0[k * color0_stride])[1];
-            vertex->color0[2] = (&color0[k * color0_stride])[2];
-            vertex->color0[3] = (&color0[k * color0_stride])[3];
-          } else {
-            vertex->color0[0] = 1.0F;
-            vertex->color0[1] = 1.0F;
-            vertex->color0[2] = 1.0F;
-            vertex->color0[3] = 1.0F;
-          }
-        }
+      out_sampler->interpolation = in_sampler->interpolation;
 
-        if (in_primitive->indices) {
-          struct cgltf_accessor *accessor = in_primitive->indices;
+      /* FIXME(samuel): validate this component type */
+      OWL_ASSERT(in_sampler->input);
+      inputs = owl_resolve_gltf_accessor(in_sampler->input);
 
-          num_local_indices = (int32_t)accessor->count;
+      OWL_ASSERT(in_sampler->input->count <
+                 OWL_ARRAY_SIZE(out_sampler->inputs));
 
-          OWL_ASSERT(num_indices + num_local_indices <= p->num_indices);
+      out_sampler->num_inputs = (int32_t)in_sampler->input->count;
+      for (k = 0; k < out_sampler->num_inputs; ++k) {
+        float const input = inputs[k];
 
-          switch (accessor->component_type) {
-          case cgltf_component_type_r_32u: {
-            int32_t l;
-            uint32_t const *data = owl_resolve_gltf_accessor(accessor);
-            for (l = 0; l < num_local_indices; ++l)
-              p->indices[num_indices + l] = data[l] + num_vertices;
-          } break;
-          case cgltf_component_type_r_16u: {
-            int32_t l;
-            uint16_t const *data = owl_resolve_gltf_accessor(accessor);
-            for (l = 0; l < num_local_indices; ++l)
-              p->indices[num_indices + l] = data[l] + num_vertices;
-          } break;
-          case cgltf_component_type_r_8u: {
-            int32_t l;
-            uint8_t const *data = owl_resolve_gltf_accessor(accessor);
-            for (l = 0; l < num_local_indices; ++l)
-              p->indices[num_indices + l] = data[l] + num_vertices;
-          } break;
-          case cgltf_component_type_invalid:
-          case cgltf_component_type_r_8:
-          case cgltf_component_type_r_16:
-          case cgltf_component_type_r_32f:
-            OWL_ASSERT(0);
-          }
-        }
+        if (input < out_animation->start)
+          out_animation->start = input;
 
-        {
-          int32_t material;
+        if (input > out_animation->end)
+          out_animation->end = input;
 
-          out_primitive->first = num_indices;
-          out_primitive->num_indices = num_local_indices;
-          out_primitive->num_vertices = num_local_vertices;
-          out_primitive->has_indices = !!num_local_indices;
-          out_primitive->bbox.valid = 0;
+        out_sampler->inputs[k] = input;
+      }
 
-          out_primitive->bbox.min[0] = min_pos[0];
-          out_primitive->bbox.min[1] = min_pos[1];
-          out_primitive->bbox.min[2] = min_pos[2];
+      OWL_ASSERT(in_sampler->output->count <
+                 OWL_ARRAY_SIZE(out_sampler->outputs));
 
-          out_primitive->bbox.max[0] = max_pos[0];
-          out_primitive->bbox.max[1] = max_pos[1];
-          out_primitive->bbox.max[2] = max_pos[2];
+      out_sampler->num_outputs = (int32_t)in_sampler->output->count;
+      switch (in_sampler->output->type) {
+      case cgltf_type_vec3: {
+        owl_v3 const *outputs;
+        outputs = owl_resolve_gltf_accessor(in_sampler->output);
 
-          material = (int32_t)(in_primitive->material - gltf->materials);
-          out_primitive->material = material;
+        for (k = 0; k < out_sampler->num_outputs; ++k) {
+          OWL_V4_ZERO(out_sampler->outputs[k]);
+          OWL_V3_COPY(outputs[k], out_sampler->outputs[k]);
+        }
+      } break;
 
-          num_indices += num_local_indices;
-          num_vertices += num_local_vertices;
+      case cgltf_type_vec4: {
+        owl_v4 const *outputs;
+        outputs = owl_resolve_gltf_accessor(in_sampler->output);
+        for (k = 0; k < out_sampler->num_outputs; ++k) {
+          OWL_V4_COPY(outputs[k], out_sampler->outputs[k]);
         }
-      }
+      } break;
 
-      for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(out_mesh->ssbos); ++j) {
-        VkBufferCreateInfo info;
-        VkResult vk_result;
-        OWL_UNUSED(vk_result);
-
-        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        info.pNext = NULL;
-        info.flags = 0;
-        info.size = sizeof(struct owl_model_joints_ssbo);
-        info.usage = 0;
-        info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        info.queueFamilyIndexCount = 0;
-        info.pQueueFamilyIndices = NULL;
-
-        vk_result = vkCreateBuffer(device, &info, NULL, &out_mesh->ssbos[j]);
-        OWL_ASSERT(!vk_result);
+      case cgltf_type_invalid:
+      case cgltf_type_scalar:
+      case cgltf_type_vec2:
+      case cgltf_type_mat2:
+      case cgltf_type_mat3:
+      case cgltf_type_mat4:
+        OWL_ASSERT(0);
       }
+    }
 
-      {
-        uint64_t aligned_size;
-        VkMemoryPropertyFlagBits properties;
-        VkMemoryRequirements requirements;
-        VkMemoryAllocateInfo info;
-        VkResult vk_result;
-        OWL_UNUSED(vk_result);
-
-        properties = 0;
-        properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-        properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-        vkGetBufferMemoryRequirements(device, out_mesh->ssbos[0],
-                                      &requirements);
-
-        aligned_size =
-            OWL_ALIGN_UP_2(requirements.size, requirements.alignment);
-
-        info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        info.pNext = NULL;
-        info.allocationSize = aligned_size * OWL_ARRAY_SIZE(out_mesh->ssbos);
-        info.memoryTypeIndex = owl_renderer_find_memory_type(
-            r, requirements.memoryTypeBits, properties);
-
-        vk_result =
-            vkAllocateMemory(device, &info, NULL, &out_mesh->ssbo_memory);
-        OWL_ASSERT(!vk_result);
-
-        for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(out_mesh->ssbos); ++j) {
-          vk_result =
-              vkBindBufferMemory(device, out_mesh->ssbos[j],
-                                 out_mesh->ssbo_memory, j * aligned_size);
-          OWL_ASSERT(!vk_result);
-        }
+    m->num_samplers += out_animation->num_samplers;
 
-        {
-          void *data;
-          vk_result = vkMapMemory(device, out_mesh->ssbo_memory, 0,
-                                  VK_WHOLE_SIZE, 0, &data);
-          OWL_ASSERT(!vk_result);
-          for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(out_mesh->ssbos); ++j) {
-            uint64_t const offset = j * aligned_size;
-            out_mesh->mapped_ssbos[j] = (void *)&((uint8_t *)(data))[offset];
-          }
-        }
+    OWL_ASSERT(in_animation->channels_count <
+               OWL_ARRAY_SIZE(out_animation->channels));
+
+    out_animation->num_channels = in_animation->channels_count;
+    for (j = 0; j < out_animation->num_channels; ++j) {
+      int32_t id;
+      struct owl_model_animation_channel *out_channel;
+      struct cgltf_animation_channel *in_channel;
+
+      out_animation->channels[j] = m->num_channels + j;
+
+      in_channel = &in_animation->channels[j];
+      out_channel = &m->channels[out_animation->channels[j]];
+
+      out_channel->path = in_channel->target_path;
+      out_channel->node = (int32_t)(in_channel->target_node - gltf->nodes);
 
-        for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(out_mesh->ssbos); ++j) {
-          int32_t l;
-          struct owl_model_joints_ssbo *ssbo = out_mesh->mapped_ssbos[j];
+      id = (int32_t)(in_channel->sampler - in_animation->samplers);
+      out_channel->sampler = out_animation->samplers[id];
+    }
 
-          if (-1 != out_node->skin)
-            ssbo->num_joints = m->skins[out_node->skin].num_joints;
-          else
-            ssbo->num_joints = 0;
+    m->num_channels += out_animation->num_channels;
+  }
 
-          OWL_M4_IDENTITY(ssbo->matrix);
+  return ret;
+}
 
-          for (l = 0; l < (int32_t)OWL_ARRAY_SIZE(ssbo->joints); ++l)
-            OWL_M4_IDENTITY(ssbo->joints[l]);
-        }
-      }
+static void owl_model_unload_animations(struct owl_renderer *r,
+                                        struct owl_model *m) {
+  OWL_UNUSED(r);
+  OWL_UNUSED(m);
+}
 
-      {
-        VkDescriptorSetLayout layouts[OWL_ARRAY_SIZE(out_mesh->ssbos)];
-        VkDescriptorSetAllocateInfo info;
-        VkResult vk_result;
-        OWL_UNUSED(vk_result);
-
-        OWL_ASSERT(OWL_ARRAY_SIZE(out_mesh->ssbo_descriptor_sets) ==
-                   OWL_ARRAY_SIZE(out_mesh->ssbos));
-
-        for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(layouts); ++j)
-          layouts[j] = r->model_storage_descriptor_set_layout;
-
-        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        info.pNext = NULL;
-        info.descriptorPool = r->descriptor_pool;
-        info.descriptorSetCount = OWL_ARRAY_SIZE(layouts);
-        info.pSetLayouts = layouts;
-
-        vk_result = vkAllocateDescriptorSets(device, &info,
-                                             out_mesh->ssbo_descriptor_sets);
-        OWL_ASSERT(!vk_result);
-      }
-      {
-        VkDescriptorBufferInfo descriptors[OWL_ARRAY_SIZE(out_mesh->ssbos)];
-        VkWriteDescriptorSet writes[OWL_ARRAY_SIZE(out_mesh->ssbos)];
-
-        for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(descriptors); ++j) {
-          descriptors[j].buffer = out_mesh->ssbos[j];
-          descriptors[j].offset = 0;
-          descriptors[j].range = sizeof(struct owl_model_joints_ssbo);
-
-          writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-          writes[j].pNext = NULL;
-          writes[j].dstSet = out_mesh->ssbo_descriptor_sets[j];
-          writes[j].dstBinding = 0;
-          writes[j].dstArrayElement = 0;
-          writes[j].descriptorCount = 1;
-          writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-          writes[j].pImageInfo = NULL;
-          writes[j].pBufferInfo = &descriptors[j];
-          writes[j].pTexelBufferView = NULL;
-        }
+static int owl_model_load_roots(struct owl_renderer *r,
+                                struct cgltf_data const *gltf,
+                                struct owl_model *m) {
+  int32_t i;
+  int ret = OWL_OK;
+  struct cgltf_scene const *in_scene = gltf->scene;
 
-        vkUpdateDescriptorSets(device, OWL_ARRAY_SIZE(writes), writes, 0, NULL);
-      }
-    } else {
-      out_node->mesh = -1;
-    }
-  }
+  OWL_UNUSED(r);
 
-  OWL_ASSERT(num_indices == p->num_indices);
-  OWL_ASSERT(num_vertices == p->num_vertices);
+  OWL_ASSERT(in_scene->nodes_count < OWL_ARRAY_SIZE(m->roots));
+
+  m->num_roots = in_scene->nodes_count;
+  for (i = 0; i < m->num_roots; ++i)
+    m->roots[i] = (int32_t)(in_scene->nodes[i] - gltf->nodes);
 
   return ret;
 }
 
-static void owl_model_unload_nodes(struct owl_renderer *r,
+static void owl_model_unload_roots(struct owl_renderer *r,
                                    struct owl_model *m) {
-  int32_t i;
-  VkDevice const device = r->device;
-  /* could just iterate each mesh instead of going trough each node,
-  however it's easier to cleanup future resource allocations this way */
-  for (i = 0; i < m->num_nodes; ++i) {
-    int32_t j;
-    struct owl_model_node *node;
-    struct owl_model_mesh *mesh;
+  OWL_UNUSED(r);
+  OWL_UNUSED(m);
+}
 
-    node = &m->nodes[i];
+#define OWL_PATH_SEPARATOR '/'
 
-    /* if no mesh, continue */
-    if (-1 == node->mesh)
-      continue;
+/* TODO(samuel): cleanup on error */
+/* the node's aabb in model space, same matrices owl_draw_model uses */
+static void owl_model_update_node_bounds(struct owl_model *m, int32_t id,
+                                         owl_m4 parent) {
+  int32_t i;
+  owl_m4 matrix;
+  struct owl_model_node *node = &m->nodes[id];
 
-    mesh = &m->meshes[node->mesh];
+  owl_m4_multiply(parent, node->matrix, matrix);
+
+  if (-1 == node->mesh)
+    owl_model_bbox_reset(&node->aabb);
+  else
+    owl_model_bbox_transform(matrix, &m->meshes[node->mesh].aabb, &node->aabb);
 
-    vkFreeDescriptorSets(device, r->descriptor_pool,
-                         OWL_ARRAY_SIZE(mesh->ssbos),
-                         mesh->ssbo_descriptor_sets);
+  node->bvh = node->aabb;
 
-    vkFreeMemory(device, mesh->ssbo_memory, NULL);
+  for (i = 0; i < node->num_children; ++i) {
+    int32_t const child = node->children[i];
 
-    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(mesh->ssbos); ++j)
-      vkDestroyBuffer(device, mesh->ssbos[j], NULL);
+    owl_model_update_node_bounds(m, child, matrix);
+    owl_model_bbox_merge(&m->nodes[child].bvh, &node->bvh);
   }
 }
 
-static int owl_model_init_buffers(struct owl_renderer *r,
-                                  struct owl_model_all_primitives *p,
-                                  struct owl_model *m) {
+static void owl_model_update_bounds(struct owl_model *m) {
+  int32_t i;
+  owl_m4 identity;
+
+  OWL_M4_IDENTITY(identity);
+
+  for (i = 0; i < m->num_roots; ++i)
+    owl_model_update_node_bounds(m, m->roots[i], identity);
+}
+
+/* count buffers of the same size sharing a single allocation, buffer i
+ * starts i aligned sizes into it */
+static int owl_model_init_shared_buffers(struct owl_renderer *r, uint64_t size,
+                                         uint32_t usage, uint32_t properties,
+                                         int32_t count, VkBuffer *buffers,
+                                         struct owl_memory_allocation *memory,
+                                         uint64_t *aligned_size) {
+  int32_t i;
+  VkMemoryRequirements requirements;
   int ret = OWL_OK;
   VkDevice const device = r->device;
 
-  {
+  for (i = 0; i < count; ++i) {
     VkBufferCreateInfo info;
-    VkResult vk_result;
-    OWL_UNUSED(vk_result);
+    VkResult vk_result = VK_SUCCESS;
 
     info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     info.pNext = NULL;
     info.flags = 0;
-    info.size = p->num_vertices * sizeof(*p->vertices);
-    info.usage = 0;
-    info.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    info.size = size;
+    info.usage = usage;
     info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     info.queueFamilyIndexCount = 0;
-    info.pQueueFamilyIndices = 0;
+    info.pQueueFamilyIndices = NULL;
 
-    vk_result = vkCreateBuffer(device, &info, NULL, &m->vertex_buffer);
-    OWL_ASSERT(!vk_result);
+    vk_result = vkCreateBuffer(device, &info, NULL, &buffers[i]);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error_destroy_buffers;
+    }
   }
 
-  {
-    VkMemoryPropertyFlagBits properties;
-    VkMemoryRequirements requirements;
-    VkMemoryAllocateInfo info;
-    VkResult vk_result;
-    OWL_UNUSED(vk_result);
-
-    properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  vkGetBufferMemoryRequirements(device, buffers[0], &requirements);
 
-    vkGetBufferMemoryRequirements(device, m->vertex_buffer, &requirements);
+  *aligned_size = OWL_ALIGN_UP_2(requirements.size, requirements.alignment);
+  requirements.size = *aligned_size * count;
 
-    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.allocationSize = requirements.size;
-    info.memoryTypeIndex = owl_renderer_find_memory_type(
-        r, requirements.memoryTypeBits, properties);
+  ret = owl_memory_allocate(r, &requirements, properties, memory);
+  if (ret)
+    goto error_destroy_buffers;
 
-    vk_result = vkAllocateMemory(device, &info, NULL, &m->vertex_memory);
-    OWL_ASSERT(!vk_result);
+  for (i = 0; i < count; ++i) {
+    VkResult vk_result = VK_SUCCESS;
+    uint64_t const offset = memory->offset + i * *aligned_size;
 
-    vk_result =
-        vkBindBufferMemory(device, m->vertex_buffer, m->vertex_memory, 0);
-    OWL_ASSERT(!vk_result);
+    vk_result = vkBindBufferMemory(device, buffers[i], memory->memory, offset);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error_free_memory;
+    }
   }
 
-  {
-    VkBufferCopy copy;
-    uint64_t size;
-    void *data;
-    struct owl_renderer_upload_allocation allocation;
+  return OWL_OK;
 
-    ret = owl_renderer_begin_im_command_buffer(r);
-    OWL_ASSERT(!ret);
+error_free_memory:
+  owl_memory_free(r, memory);
 
-    size = p->num_vertices * sizeof(*p->vertices);
-    data = owl_renderer_upload_allocate(r, size, &allocation);
-    OWL_ASSERT(data);
+  i = count;
 
-    OWL_MEMCPY(data, p->vertices, size);
+error_destroy_buffers:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyBuffer(device, buffers[i], NULL);
 
-#if 0
-    {
-      int32_t i;
-      OWL_DEBUG_LOG("splating vertices...\n");
-      for (i = 0; i < p->num_vertices; ++i) {
-        struct owl_model_vertex *vertex = &p->vertices[i];
-        OWL_DEBUG_LOG("  p->vertices[%i]:\n", i);
-        OWL_DEBUG_LOG("    position: " OWL_V3_FORMAT "\n",
-                      OWL_V3_FORMAT_ARGS(vertex->position));
-        OWL_DEBUG_LOG("    normal: " OWL_V3_FORMAT "\n",
-                      OWL_V3_FORMAT_ARGS(vertex->normal));
-        OWL_DEBUG_LOG("    uv0: " OWL_V2_FORMAT "\n",
-                      OWL_V2_FORMAT_ARGS(vertex->uv0));
-        OWL_DEBUG_LOG("    uv1: " OWL_V2_FORMAT "\n",
-                      OWL_V2_FORMAT_ARGS(vertex->uv1));
-        OWL_DEBUG_LOG("    joints0: " OWL_V4_FORMAT "\n",
-                      OWL_V4_FORMAT_ARGS(vertex->joints0));
-        OWL_DEBUG_LOG("    weights0: " OWL_V4_FORMAT "\n",
-                      OWL_V4_FORMAT_ARGS(vertex->weights0));
-        OWL_DEBUG_LOG("    color0: " OWL_V4_FORMAT "\n",
-                      OWL_V4_FORMAT_ARGS(vertex->color0));
-      }
-    }
-#endif
+  return ret;
+}
 
-    copy.srcOffset = 0;
-    copy.dstOffset = 0;
-    copy.size = size;
+static void owl_model_deinit_shared_buffers(
+    struct owl_renderer *r, int32_t count, VkBuffer *buffers,
+    struct owl_memory_allocation *memory) {
+  int32_t i;
 
-    vkCmdCopyBuffer(r->im_command_buffer, allocation.buffer, m->vertex_buffer,
-                    1, &copy);
+  owl_memory_free(r, memory);
 
-    ret = owl_renderer_end_im_command_buffer(r);
-    OWL_ASSERT(!ret);
+  for (i = 0; i < count; ++i)
+    vkDestroyBuffer(r->device, buffers[i], NULL);
+}
 
-    owl_renderer_upload_free(r, data);
-  }
+static int owl_model_init_gpu_culling(struct owl_renderer *r,
+                                      struct owl_model *m) {
+  int32_t i;
+  int32_t j;
+  uint32_t usage;
+  uint32_t properties;
+  uint64_t aligned_size;
+  uint32_t num_draws = 0;
+  struct owl_model_draw *draws;
+  struct owl_model_material_data *materials;
+  int ret = OWL_OK;
+  int32_t const num_frames = OWL_MAX_IN_FLIGHT_FRAMES;
 
-  if (p->num_indices) {
-    {
-      VkBufferCreateInfo info;
-      VkResult vk_result;
-      OWL_UNUSED(vk_result);
+  m->gpu_culled = 0;
+  m->num_draws = 0;
 
-      info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.size = p->num_indices * sizeof(*p->indices);
-      info.usage = 0;
-      info.usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-      info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-      info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      info.queueFamilyIndexCount = 0;
-      info.pQueueFamilyIndices = 0;
+  /* skinned vertices leave the primitive bounds and non indexed primitives
+   * don't fit an indexed draw, those models keep the cpu path */
+  if (!r->gpu_culling_supported || m->num_skins || !m->has_indices ||
+      !m->num_materials)
+    return OWL_OK;
 
-      vk_result = vkCreateBuffer(device, &info, NULL, &m->index_buffer);
-      OWL_ASSERT(!vk_result);
-    }
+  for (i = 0; i < m->num_nodes; ++i) {
+    struct owl_model_mesh const *mesh;
 
-    {
-      VkMemoryPropertyFlagBits properties;
-      VkMemoryRequirements requirements;
-      VkMemoryAllocateInfo info;
-      VkResult vk_result;
-      OWL_UNUSED(vk_result);
+    if (-1 == m->nodes[i].mesh)
+      continue;
 
-      properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    mesh = &m->meshes[m->nodes[i].mesh];
 
-      vkGetBufferMemoryRequirements(device, m->index_buffer, &requirements);
+    for (j = 0; j < mesh->num_primitives; ++j) {
+      struct owl_model_primitive const *primitive;
 
-      info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-      info.pNext = NULL;
-      info.allocationSize = requirements.size;
-      info.memoryTypeIndex = owl_renderer_find_memory_type(
-          r, requirements.memoryTypeBits, properties);
+      primitive = &m->primitives[mesh->primitives[j]];
 
-      vk_result = vkAllocateMemory(device, &info, NULL, &m->index_memory);
-      OWL_ASSERT(!vk_result);
+      if (!primitive->num_vertices)
+        continue;
+
+      if (!primitive->has_indices)
+        return OWL_OK;
 
-      vk_result =
-          vkBindBufferMemory(device, m->index_buffer, m->index_memory, 0);
-      OWL_ASSERT(!vk_result);
+      ++num_draws;
     }
+  }
 
-    {
-      VkBufferCopy copy;
-      uint64_t size;
-      void *data;
-      struct owl_renderer_upload_allocation allocation;
+  if (!num_draws)
+    return OWL_OK;
+
+  properties = 0;
+  properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+  properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+  ret = owl_model_init_shared_buffers(
+      r, num_draws * sizeof(struct owl_model_draw),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, properties, 1, &m->draw_buffer,
+      &m->draw_memory, &aligned_size);
+  if (ret)
+    goto error;
+
+  ret = owl_model_init_shared_buffers(
+      r, m->num_materials * sizeof(struct owl_model_material_data),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, properties, 1, &m->material_buffer,
+      &m->material_memory, &aligned_size);
+  if (ret)
+    goto error_deinit_draw_buffer;
+
+  ret = owl_model_init_shared_buffers(
+      r, m->num_nodes * sizeof(owl_m4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      properties, num_frames, m->node_buffers, &m->node_memory, &aligned_size);
+  if (ret)
+    goto error_deinit_material_buffer;
+
+  for (i = 0; i < num_frames; ++i) {
+    uint8_t *data = m->node_memory.data;
+    m->mapped_nodes[i] = (void *)&data[i * aligned_size];
+  }
 
-      ret = owl_renderer_begin_im_command_buffer(r);
-      OWL_ASSERT(!ret);
+  usage = 0;
+  usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 
-      size = p->num_indices * sizeof(*p->indices);
-      data = owl_renderer_upload_allocate(r, size, &allocation);
-      OWL_ASSERT(data);
+  ret = owl_model_init_shared_buffers(
+      r, num_draws * sizeof(VkDrawIndexedIndirectCommand), usage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, num_frames, m->indirect_buffers,
+      &m->indirect_memory, &aligned_size);
+  if (ret)
+    goto error_deinit_node_buffers;
 
-      OWL_MEMCPY(data, p->indices, size);
+  draws = m->draw_memory.data;
 
-#if 0
-      {
-        int32_t i;
-        OWL_DEBUG_LOG("splating indices...\n");
-        for (i = 0; i < p->num_indices; ++i) {
-          OWL_DEBUG_LOG("  p->indices[%i]: = %u\n", i, p->indices[i]);
-          OWL_ASSERT(p->indices[i] <= (uint32_t)p->num_vertices);
-        }
-      }
-#endif
+  for (i = 0; i < m->num_nodes; ++i) {
+    struct owl_model_mesh const *mesh;
 
-      copy.srcOffset = 0;
-      copy.dstOffset = 0;
-      copy.size = size;
+    if (-1 == m->nodes[i].mesh)
+      continue;
 
-      vkCmdCopyBuffer(r->im_command_buffer, allocation.buffer, m->index_buffer,
-                      1, &copy);
+    mesh = &m->meshes[m->nodes[i].mesh];
 
-      ret = owl_renderer_end_im_command_buffer(r);
-      OWL_ASSERT(!ret);
+    for (j = 0; j < mesh->num_primitives; ++j) {
+      struct owl_model_primitive const *primitive;
+      struct owl_model_draw *draw;
+
+      primitive = &m->primitives[mesh->primitives[j]];
+
+      if (!primitive->num_vertices)
+        continue;
 
-      owl_renderer_upload_free(r, data);
+      draw = &draws[m->num_draws++];
+
+      draw->min[0] = primitive->bbox.min[0];
+      draw->min[1] = primitive->bbox.min[1];
+      draw->min[2] = primitive->bbox.min[2];
+      draw->min[3] = primitive->bbox.valid ? 1.0F : 0.0F;
+      draw->max[0] = primitive->bbox.max[0];
+      draw->max[1] = primitive->bbox.max[1];
+      draw->max[2] = primitive->bbox.max[2];
+      draw->max[3] = 0.0F;
+      draw->node = (uint32_t)i;
+      draw->material = (uint32_t)primitive->material;
+      draw->first_index = primitive->first;
+      draw->num_indices = primitive->num_indices;
     }
+  }
 
-    m->has_indices = 1;
-  } else {
-    m->index_buffer = VK_NULL_HANDLE;
-    m->index_memory = VK_NULL_HANDLE;
-    m->has_indices = 0;
+  materials = m->material_memory.data;
+
+  for (i = 0; i < m->num_materials; ++i) {
+    owl_model_material_push_constant(&m->materials[i],
+                                     &materials[i].push_constant);
+    materials[i].padding = 0;
+  }
+
+  {
+    VkDescriptorSetLayout layouts[OWL_MAX_IN_FLIGHT_FRAMES];
+
+    for (i = 0; i < num_frames; ++i)
+      layouts[i] = r->model_indirect_descriptor_set_layout;
+
+    ret = owl_renderer_allocate_descriptor_sets(r, num_frames, layouts,
+                                                m->indirect_descriptor_sets,
+                                                &m->indirect_descriptor_pool);
+    if (ret)
+      goto error_deinit_indirect_buffers;
   }
 
+  for (i = 0; i < num_frames; ++i) {
+    VkDescriptorBufferInfo descriptors[4];
+    VkWriteDescriptorSet writes[4];
+
+    descriptors[0].buffer = m->node_buffers[i];
+    descriptors[0].offset = 0;
+    descriptors[0].range = VK_WHOLE_SIZE;
+
+    descriptors[1].buffer = m->draw_buffer;
+    descriptors[1].offset = 0;
+    descriptors[1].range = VK_WHOLE_SIZE;
+
+    descriptors[2].buffer = m->material_buffer;
+    descriptors[2].offset = 0;
+    descriptors[2].range = VK_WHOLE_SIZE;
+
+    descriptors[3].buffer = m->indirect_buffers[i];
+    descriptors[3].offset = 0;
+    descriptors[3].range = VK_WHOLE_SIZE;
+
+    for (j = 0; j < (int32_t)OWL_ARRAY_SIZE(writes); ++j) {
+      writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[j].pNext = NULL;
+      writes[j].dstSet = m->indirect_descriptor_sets[i];
+      writes[j].dstBinding = (uint32_t)j;
+      writes[j].dstArrayElement = 0;
+      writes[j].descriptorCount = 1;
+      writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[j].pImageInfo = NULL;
+      writes[j].pBufferInfo = &descriptors[j];
+      writes[j].pTexelBufferView = NULL;
+    }
+
+    vkUpdateDescriptorSets(r->device, OWL_ARRAY_SIZE(writes), writes, 0, NULL);
+  }
+
+  m->gpu_culled = 1;
+
+  return OWL_OK;
+
+error_deinit_indirect_buffers:
+  owl_model_deinit_shared_buffers(r, num_frames, m->indirect_buffers,
+                                  &m->indirect_memory);
+
+error_deinit_node_buffers:
+  owl_model_deinit_shared_buffers(r, num_frames, m->node_buffers,
+                                  &m->node_memory);
+
+error_deinit_material_buffer:
+  owl_model_deinit_shared_buffers(r, 1, &m->material_buffer,
+                                  &m->material_memory);
+
+error_deinit_draw_buffer:
+  owl_model_deinit_shared_buffers(r, 1, &m->draw_buffer, &m->draw_memory);
+
+error:
+  m->num_draws = 0;
+
   return ret;
 }
 
-static void owl_model_deinit_buffers(struct owl_renderer *r,
-                                     struct owl_model *m) {
-  VkDevice const device = r->device;
+static void owl_model_deinit_gpu_culling(struct owl_renderer *r,
+                                         struct owl_model *m) {
+  int32_t const num_frames = OWL_MAX_IN_FLIGHT_FRAMES;
 
-  if (m->has_indices) {
-    vkFreeMemory(device, m->index_memory, NULL);
-    vkDestroyBuffer(device, m->index_buffer, NULL);
+  if (!m->gpu_culled)
+    return;
+
+  owl_renderer_free_descriptor_sets(r, m->indirect_descriptor_pool,
+                                    num_frames, m->indirect_descriptor_sets);
+
+  owl_model_deinit_shared_buffers(r, num_frames, m->indirect_buffers,
+                                  &m->indirect_memory);
+  owl_model_deinit_shared_buffers(r, num_frames, m->node_buffers,
+                                  &m->node_memory);
+  owl_model_deinit_shared_buffers(r, 1, &m->material_buffer,
+                                  &m->material_memory);
+  owl_model_deinit_shared_buffers(r, 1, &m->draw_buffer, &m->draw_memory);
+}
+
+/*
+ * baked models are the model tables as they are laid out in memory followed
+ * by the vertices and indices as they are uploaded, the loader maps the file
+ * and reads everything straight from the mapping. the layout is tied to the
+ * build that baked it, the header and the size of every table are checked
+ * before anything is read. every image is baked into a file of its own next
+ * to the model, already decoded into rgba8 srgb pixels
+ */
+#define OWL_MODEL_BAKED_MAGIC 0x4D4C574FU
+#define OWL_MODEL_BAKED_IMAGE_MAGIC 0x544C574FU
+#define OWL_MODEL_BAKED_VERSION 1
+#define OWL_MODEL_BAKED_ALIGNMENT 16
+#define OWL_MODEL_BAKED_EXTENSION ".owlm"
+
+#define OWL_MODEL_BAKED_VERTICES 0
+#define OWL_MODEL_BAKED_INDICES 1
+#define OWL_MODEL_BAKED_IMAGES 2
+#define OWL_MODEL_BAKED_ROOTS 3
+#define OWL_MODEL_BAKED_NODES 4
+#define OWL_MODEL_BAKED_TEXTURES 5
+#define OWL_MODEL_BAKED_MATERIALS 6
+#define OWL_MODEL_BAKED_MESHES 7
+#define OWL_MODEL_BAKED_PRIMITIVES 8
+#define OWL_MODEL_BAKED_SKINS 9
+#define OWL_MODEL_BAKED_SAMPLERS 10
+#define OWL_MODEL_BAKED_CHANNELS 11
+#define OWL_MODEL_BAKED_ANIMATIONS 12
+#define OWL_MODEL_BAKED_NUM_TABLES 13
+
+/* count elements of size bytes, offset bytes from the start of the file */
+struct owl_model_baked_table {
+  uint64_t offset;
+  uint32_t count;
+  uint32_t size;
+};
+
+/* the size of the indices is the index type */
+struct owl_model_baked_header {
+  uint32_t magic;
+  uint32_t version;
+  struct owl_model_baked_table tables[OWL_MODEL_BAKED_NUM_TABLES];
+};
+
+/* relative to the directory of the model */
+struct owl_model_baked_image {
+  char path[256];
+};
+
+/* followed by width * height rgba8 srgb pixels */
+struct owl_model_baked_image_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+};
+
+/* the model array a table is copied from and into, NULL for the tables that
+ * have none */
+static void *owl_model_baked_array(struct owl_model *m, int32_t table,
+                                   uint32_t *size, uint32_t *capacity) {
+  switch (table) {
+  case OWL_MODEL_BAKED_VERTICES:
+    *size = sizeof(struct owl_model_vertex);
+    *capacity = 0x7FFFFFFF;
+    return NULL;
+  case OWL_MODEL_BAKED_INDICES:
+    *size = 0;
+    *capacity = 0x7FFFFFFF;
+    return NULL;
+  case OWL_MODEL_BAKED_IMAGES:
+    *size = sizeof(struct owl_model_baked_image);
+    *capacity = OWL_ARRAY_SIZE(m->images);
+    return NULL;
+  case OWL_MODEL_BAKED_ROOTS:
+    *size = sizeof(m->roots[0]);
+    *capacity = OWL_ARRAY_SIZE(m->roots);
+    return m->roots;
+  case OWL_MODEL_BAKED_NODES:
+    *size = sizeof(m->nodes[0]);
+    *capacity = OWL_ARRAY_SIZE(m->nodes);
+    return m->nodes;
+  case OWL_MODEL_BAKED_TEXTURES:
+    *size = sizeof(m->textures[0]);
+    *capacity = OWL_ARRAY_SIZE(m->textures);
+    return m->textures;
+  case OWL_MODEL_BAKED_MATERIALS:
+    *size = sizeof(m->materials[0]);
+    *capacity = OWL_ARRAY_SIZE(m->materials);
+    return m->materials;
+  case OWL_MODEL_BAKED_MESHES:
+    *size = sizeof(m->meshes[0]);
+    *capacity = OWL_ARRAY_SIZE(m->meshes);
+    return m->meshes;
+  case OWL_MODEL_BAKED_PRIMITIVES:
+    *size = sizeof(m->primitives[0]);
+    *capacity = OWL_ARRAY_SIZE(m->primitives);
+    return m->primitives;
+  case OWL_MODEL_BAKED_SKINS:
+    *size = sizeof(m->skins[0]);
+    *capacity = OWL_ARRAY_SIZE(m->skins);
+    return m->skins;
+  case OWL_MODEL_BAKED_SAMPLERS:
+    *size = sizeof(m->samplers[0]);
+    *capacity = OWL_ARRAY_SIZE(m->samplers);
+    return m->samplers;
+  case OWL_MODEL_BAKED_CHANNELS:
+    *size = sizeof(m->channels[0]);
+    *capacity = OWL_ARRAY_SIZE(m->channels);
+    return m->channels;
+  case OWL_MODEL_BAKED_ANIMATIONS:
+    *size = sizeof(m->animations[0]);
+    *capacity = OWL_ARRAY_SIZE(m->animations);
+    return m->animations;
   }
 
-  vkFreeMemory(device, m->vertex_memory, NULL);
-  vkDestroyBuffer(device, m->vertex_buffer, NULL);
+  OWL_ASSERT(0);
+
+  return NULL;
 }
 
-/* TODO(samuel): do a simplify pass */
-static int owl_model_load_skins(struct owl_renderer *r,
-                                struct cgltf_data const *gltf,
-                                struct owl_model *m) {
+static int owl_model_is_baked(char const *path) {
+  uint64_t const length = OWL_STRLEN(path);
+  uint64_t const extension = sizeof(OWL_MODEL_BAKED_EXTENSION) - 1;
+
+  if (length < extension)
+    return 0;
+
+  return !OWL_STRNCMP(&path[length - extension], OWL_MODEL_BAKED_EXTENSION,
+                      extension);
+}
+
+static int owl_model_write_baked_image(char const *src, char const *path) {
+  int width;
+  int height;
+  int channels;
+  uint8_t *data;
+  uint8_t *pixels;
+  uint64_t size;
+  struct owl_model_baked_image_header header;
+  int ret = OWL_OK;
+
+  pixels = stbi_load(src, &width, &height, &channels, STBI_rgb_alpha);
+  if (!pixels)
+    return OWL_ERROR_NOT_FOUND;
+
+  size = (uint64_t)width * (uint64_t)height * 4;
+
+  data = OWL_MALLOC(sizeof(header) + size);
+  if (!data) {
+    ret = OWL_ERROR_NO_MEMORY;
+    goto out_free_pixels;
+  }
+
+  header.magic = OWL_MODEL_BAKED_IMAGE_MAGIC;
+  header.version = OWL_MODEL_BAKED_VERSION;
+  header.width = (uint32_t)width;
+  header.height = (uint32_t)height;
+
+  OWL_MEMCPY(data, &header, sizeof(header));
+  OWL_MEMCPY(&data[sizeof(header)], pixels, size);
+
+  ret = owl_plataform_save_file(path, data, sizeof(header) + size);
+
+  OWL_FREE(data);
+
+out_free_pixels:
+  stbi_image_free(pixels);
+
+  return ret;
+}
+
+/* the gpu objects the tables point to are left zeroed, the loader creates
+ * them again */
+static int owl_model_write_baked(struct owl_model *m,
+                                 struct cgltf_data const *gltf,
+                                 struct owl_model_all_primitives const *p,
+                                 char const *path) {
   int32_t i;
+  uint8_t *data;
+  uint64_t offset;
+  char const *name;
+  struct owl_model_baked_header header;
+  struct owl_model_baked_table *tables = header.tables;
   int ret = OWL_OK;
 
-  OWL_UNUSED(r);
+  OWL_MEMSET(&header, 0, sizeof(header));
 
-  OWL_ASSERT(gltf->skins_count < OWL_ARRAY_SIZE(m->skins));
+  header.magic = OWL_MODEL_BAKED_MAGIC;
+  header.version = OWL_MODEL_BAKED_VERSION;
 
-  m->num_skins = (int32_t)gltf->skins_count;
-  for (i = 0; i < m->num_skins; ++i) {
-    int32_t j;
-    struct owl_model_skin *out_skin = &m->skins[i];
-    struct cgltf_skin const *in_skin = &gltf->skins[i];
+  tables[OWL_MODEL_BAKED_VERTICES].count = (uint32_t)p->num_vertices;
+  tables[OWL_MODEL_BAKED_INDICES].count = (uint32_t)p->num_indices;
+  tables[OWL_MODEL_BAKED_IMAGES].count = (uint32_t)m->num_images;
+  tables[OWL_MODEL_BAKED_ROOTS].count = (uint32_t)m->num_roots;
+  tables[OWL_MODEL_BAKED_NODES].count = (uint32_t)m->num_nodes;
+  tables[OWL_MODEL_BAKED_TEXTURES].count = (uint32_t)m->num_textures;
+  tables[OWL_MODEL_BAKED_MATERIALS].count = (uint32_t)m->num_materials;
+  tables[OWL_MODEL_BAKED_MESHES].count = (uint32_t)m->num_meshes;
+  tables[OWL_MODEL_BAKED_PRIMITIVES].count = (uint32_t)m->num_primitives;
+  tables[OWL_MODEL_BAKED_SKINS].count = (uint32_t)m->num_skins;
+  tables[OWL_MODEL_BAKED_SAMPLERS].count = (uint32_t)m->num_samplers;
+  tables[OWL_MODEL_BAKED_CHANNELS].count = (uint32_t)m->num_channels;
+  tables[OWL_MODEL_BAKED_ANIMATIONS].count = (uint32_t)m->num_animations;
 
-    if (in_skin->name) {
-      uint32_t max_length = OWL_ARRAY_SIZE(out_skin->name);
-      OWL_STRNCPY(out_skin->name, in_skin->name, max_length);
-    } else {
-      uint32_t max_length = OWL_ARRAY_SIZE(out_skin->name);
-      OWL_STRNCPY(out_skin->name, "NO NAME", max_length);
+  offset = OWL_ALIGN_UP_2(sizeof(header), OWL_MODEL_BAKED_ALIGNMENT);
+
+  for (i = 0; i < OWL_MODEL_BAKED_NUM_TABLES; ++i) {
+    uint32_t capacity;
+    struct owl_model_baked_table *table = &tables[i];
+
+    owl_model_baked_array(m, i, &table->size, &capacity);
+
+    if (OWL_MODEL_BAKED_INDICES == i) {
+      if (VK_INDEX_TYPE_UINT16 == m->index_type)
+        table->size = sizeof(uint16_t);
+      else
+        table->size = sizeof(uint32_t);
     }
 
-    if (in_skin->skeleton)
-      out_skin->root = (int32_t)(in_skin->skeleton - gltf->nodes);
-    else
-      out_skin->root = -1;
+    table->offset = offset;
+    offset += (uint64_t)table->count * table->size;
+    offset = OWL_ALIGN_UP_2(offset, OWL_MODEL_BAKED_ALIGNMENT);
+  }
+
+  data = OWL_CALLOC(1, offset);
+  if (!data)
+    return OWL_ERROR_NO_MEMORY;
+
+  OWL_MEMCPY(data, &header, sizeof(header));
+
+  OWL_MEMCPY(&data[tables[OWL_MODEL_BAKED_VERTICES].offset], p->vertices,
+             (uint64_t)p->num_vertices * sizeof(*p->vertices));
+
+  OWL_MEMCPY(&data[tables[OWL_MODEL_BAKED_INDICES].offset], p->indices,
+             (uint64_t)p->num_indices * tables[OWL_MODEL_BAKED_INDICES].size);
+
+  for (i = OWL_MODEL_BAKED_ROOTS; i < OWL_MODEL_BAKED_NUM_TABLES; ++i) {
+    uint32_t size;
+    uint32_t capacity;
+    struct owl_model_baked_table const *table = &tables[i];
+    void const *array = owl_model_baked_array(m, i, &size, &capacity);
+
+    OWL_MEMCPY(&data[table->offset], array, (uint64_t)table->count * size);
+  }
+
+  {
+    struct owl_model_material *materials;
+    uint64_t const materials_offset = tables[OWL_MODEL_BAKED_MATERIALS].offset;
 
-    OWL_ASSERT(in_skin->joints_count < OWL_ARRAY_SIZE(out_skin->joints));
+    materials = (struct owl_model_material *)&data[materials_offset];
 
-    out_skin->num_joints = (int32_t)in_skin->joints_count;
-    for (j = 0; j < out_skin->num_joints; ++j)
-      out_skin->joints[j] = (int32_t)(in_skin->joints[j] - gltf->nodes);
+    for (i = 0; i < m->num_materials; ++i) {
+      struct owl_model_material *material = &materials[i];
 
-    if (in_skin->inverse_bind_matrices) {
-      struct cgltf_accessor *accessor;
-      owl_m4 const *matrices;
+      OWL_MEMSET(material->bindless_maps, 0, sizeof(material->bindless_maps));
+      material->descriptor_pool = VK_NULL_HANDLE;
+      material->descriptor_set = VK_NULL_HANDLE;
+    }
+  }
 
-      accessor = in_skin->inverse_bind_matrices;
-      matrices = owl_resolve_gltf_accessor(accessor);
+  {
+    struct owl_model_mesh *meshes;
+    uint64_t const meshes_offset = tables[OWL_MODEL_BAKED_MESHES].offset;
 
-      OWL_ASSERT(accessor->count < OWL_ARRAY_SIZE(out_skin->joints));
+    meshes = (struct owl_model_mesh *)&data[meshes_offset];
 
-      out_skin->num_inverse_bind_matrices = accessor->count;
-      for (j = 0; j < out_skin->num_inverse_bind_matrices; ++j)
-        OWL_M4_COPY(matrices[j], out_skin->inverse_bind_matrices[j]);
+    for (i = 0; i < m->num_meshes; ++i) {
+      struct owl_model_mesh *mesh = &meshes[i];
+
+      OWL_MEMSET(mesh->ssbos, 0, sizeof(mesh->ssbos));
+      OWL_MEMSET(&mesh->ssbo_memory, 0, sizeof(mesh->ssbo_memory));
+      mesh->ssbo_descriptor_pool = VK_NULL_HANDLE;
+      OWL_MEMSET(mesh->ssbo_descriptor_sets, 0,
+                 sizeof(mesh->ssbo_descriptor_sets));
+      OWL_MEMSET(mesh->mapped_ssbos, 0, sizeof(mesh->mapped_ssbos));
     }
+  }
 
-    /* allocate and write the descriptor sets */
+  /* the images are named after the model, next to it */
+  name = path;
+  for (i = 0; '\0' != path[i]; ++i)
+    if (OWL_PATH_SEPARATOR == path[i])
+      name = &path[i + 1];
+
+  for (i = 0; i < m->num_images; ++i) {
+    struct owl_model_uri src;
+    struct owl_model_uri dst;
+    struct owl_model_baked_image *image;
+    uint64_t const images_offset = tables[OWL_MODEL_BAKED_IMAGES].offset;
+
+    image = &((struct owl_model_baked_image *)&data[images_offset])[i];
+
+    OWL_SNPRINTF(image->path, sizeof(image->path), "%s.%i.owlt", name, i);
+    OWL_SNPRINTF(dst.path, sizeof(dst.path), "%s.%i.owlt", path, i);
+
+    ret = owl_model_get_real_uri(m, gltf->images[i].uri, &src);
+    if (ret)
+      goto out_free_data;
+
+    ret = owl_model_write_baked_image(src.path, dst.path);
+    if (ret)
+      goto out_free_data;
   }
 
-  return ret;
-}
+  ret = owl_plataform_save_file(path, data, offset);
 
-static void owl_model_unload_skins(struct owl_renderer *r,
-                                   struct owl_model *m) {
-  OWL_UNUSED(r);
-  OWL_UNUSED(m);
+out_free_data:
+  OWL_FREE(data);
+
+  return ret;
 }
 
-static int owl_model_load_animations(struct owl_renderer *r,
-                                     struct cgltf_data const *gltf,
-                                     struct owl_model *m) {
+/* the layout of the file has to match the build's, the contents are trusted
+ * to be what owl_model_bake wrote */
+static int owl_model_check_baked(struct owl_model *m,
+                                 struct owl_plataform_file const *file) {
   int32_t i;
-  int ret = OWL_OK;
-
-  OWL_UNUSED(r);
+  struct owl_model_baked_header const *header;
 
-  OWL_ASSERT(OWL_ANIMATION_INTERPOLATION_LINEAR ==
-             cgltf_interpolation_type_linear);
-  OWL_ASSERT(OWL_ANIMATION_INTERPOLATION_STEP == cgltf_interpolation_type_step);
-  OWL_ASSERT(OWL_ANIMATION_INTERPOLATION_CUBICSPLINE ==
-             cgltf_interpolation_type_cubic_spline);
+  if (file->size < sizeof(*header))
+    return OWL_ERROR_INVALID_VALUE;
 
-  OWL_ASSERT(OWL_ANIMATION_PATH_TRANSLATION ==
-             cgltf_animation_path_type_translation);
-  OWL_ASSERT(OWL_ANIMATION_PATH_ROTATION == cgltf_animation_path_type_rotation);
-  OWL_ASSERT(OWL_ANIMATION_PATH_SCALE == /*   */
-             cgltf_animation_path_type_scale);
-  OWL_ASSERT(OWL_ANIMATION_PATH_WEIGHTS == /*  */
-             cgltf_animation_path_type_weights);
+  header = (struct owl_model_baked_header const *)file->data;
 
-  OWL_ASSERT(gltf->animations_count < OWL_ARRAY_SIZE(m->animations));
+  if (OWL_MODEL_BAKED_MAGIC != header->magic)
+    return OWL_ERROR_INVALID_VALUE;
 
-  m->num_samplers = 0;
-  m->num_channels = 0;
+  if (OWL_MODEL_BAKED_VERSION != header->version)
+    return OWL_ERROR_INVALID_VALUE;
 
-  m->num_animations = (int32_t)gltf->animations_count;
-  for (i = 0; i < m->num_animations; ++i) {
-    int32_t j;
-    struct owl_model_animation *out_animation = &m->animations[i];
-    struct cgltf_animation const *in_animation = &gltf->animations[i];
+  for (i = 0; i < OWL_MODEL_BAKED_NUM_TABLES; ++i) {
+    uint32_t size;
+    uint32_t capacity;
+    struct owl_model_baked_table const *table = &header->tables[i];
 
-    out_animation->time = 0.0F;
-    out_animation->start = FLT_MAX;
-    out_animation->end = FLT_MIN;
+    owl_model_baked_array(m, i, &size, &capacity);
 
-    if (in_animation->name) {
-      int32_t max_length = OWL_ARRAY_SIZE(out_animation->name);
-      OWL_STRNCPY(out_animation->name, in_animation->name, max_length);
-    } else {
-      int32_t max_length = OWL_ARRAY_SIZE(out_animation->name);
-      OWL_STRNCPY(out_animation->name, "NO NAME", max_length);
+    if (OWL_MODEL_BAKED_INDICES == i) {
+      if (sizeof(uint16_t) != table->size && sizeof(uint32_t) != table->size)
+        return OWL_ERROR_INVALID_VALUE;
+    } else if (size != table->size) {
+      return OWL_ERROR_INVALID_VALUE;
     }
 
-    OWL_ASSERT(in_animation->samplers_count <
-               OWL_ARRAY_SIZE(out_animation->samplers));
+    if (capacity < table->count)
+      return OWL_ERROR_INVALID_VALUE;
 
-    out_animation->num_samplers = (int32_t)in_animation->samplers_count;
-    for (j = 0; j < out_animation->num_samplers; ++j) {
-      int32_t k;
-      float const *inputs;
-      struct owl_model_animation_sampler *out_sampler;
-      struct cgltf_animation_sampler *in_sampler;
+    if (file->size < table->offset)
+      return OWL_ERROR_INVALID_VALUE;
 
-      out_animation->samplers[j] = m->num_samplers + j;
+    if (file->size - table->offset < (uint64_t)table->count * table->size)
+      return OWL_ERROR_INVALID_VALUE;
+  }
 
-      in_sampler = &in_animation->samplers[j];
-      out_sampler = &m->samplers[out_animation->samplers[j]];
+  return OWL_OK;
+}
 
-      out_sampler->interpolation = in_sampler->interpolation;
+static int owl_model_load_baked_image(struct owl_renderer *r,
+                                      struct owl_model *m,
+                                      struct owl_model_baked_image const *image,
+                                      struct owl_texture *texture) {
+  uint64_t size;
+  struct owl_model_uri uri;
+  struct owl_texture_desc desc;
+  struct owl_plataform_file file;
+  struct owl_model_baked_image_header const *header;
+  int ret = OWL_OK;
 
-      /* FIXME(samuel): validate this component type */
-      OWL_ASSERT(in_sampler->input);
-      inputs = owl_resolve_gltf_accessor(in_sampler->input);
+  if ('\0' != image->path[sizeof(image->path) - 1])
+    return OWL_ERROR_INVALID_VALUE;
 
-      OWL_ASSERT(in_sampler->input->count <
-                 OWL_ARRAY_SIZE(out_sampler->inputs));
+  ret = owl_model_get_real_uri(m, image->path, &uri);
+  if (ret)
+    return ret;
 
-      out_sampler->num_inputs = (int32_t)in_sampler->input->count;
-      for (k = 0; k < out_sampler->num_inputs; ++k) {
-        float const input = inputs[k];
+  ret = owl_plataform_map_file(uri.path, &file);
+  if (ret)
+    return ret;
 
-        if (input < out_animation->start)
-          out_animation->start = input;
+  header = (struct owl_model_baked_image_header const *)file.data;
 
-        if (input > out_animation->end)
-          out_animation->end = input;
+  if (file.size < sizeof(*header) ||
+      OWL_MODEL_BAKED_IMAGE_MAGIC != header->magic ||
+      OWL_MODEL_BAKED_VERSION != header->version) {
+    ret = OWL_ERROR_INVALID_VALUE;
+    goto out_unmap_file;
+  }
 
-        out_sampler->inputs[k] = input;
-      }
+  size = (uint64_t)header->width * (uint64_t)header->height * 4;
+  if (!size || file.size - sizeof(*header) < size) {
+    ret = OWL_ERROR_INVALID_VALUE;
+    goto out_unmap_file;
+  }
 
-      OWL_ASSERT(in_sampler->output->count <
-                 OWL_ARRAY_SIZE(out_sampler->outputs));
+  desc.source = OWL_TEXTURE_SOURCE_DATA;
+  desc.type = OWL_TEXTURE_TYPE_2D;
+  desc.path = NULL;
+  desc.pixels = &file.data[sizeof(*header)];
+  desc.width = header->width;
+  desc.height = header->height;
+  desc.format = OWL_RGBA8_SRGB;
 
-      out_sampler->num_outputs = (int32_t)in_sampler->output->count;
-      switch (in_sampler->output->type) {
-      case cgltf_type_vec3: {
-        owl_v3 const *outputs;
-        outputs = owl_resolve_gltf_accessor(in_sampler->output);
+  ret = owl_texture_init(r, &desc, texture);
+  if (ret)
+    goto out_unmap_file;
 
-        for (k = 0; k < out_sampler->num_outputs; ++k) {
-          OWL_V4_ZERO(out_sampler->outputs[k]);
-          OWL_V3_COPY(outputs[k], out_sampler->outputs[k]);
-        }
-      } break;
+  if (r->bindless_supported) {
+    ret = owl_renderer_add_bindless_texture(r, texture);
+    OWL_ASSERT(!ret);
+  }
 
-      case cgltf_type_vec4: {
-        owl_v4 const *outputs;
-        outputs = owl_resolve_gltf_accessor(in_sampler->output);
-        for (k = 0; k < out_sampler->num_outputs; ++k) {
-          OWL_V4_COPY(outputs[k], out_sampler->outputs[k]);
-        }
-      } break;
+out_unmap_file:
+  owl_plataform_unmap_file(&file);
 
-      case cgltf_type_invalid:
-      case cgltf_type_scalar:
-      case cgltf_type_vec2:
-      case cgltf_type_mat2:
-      case cgltf_type_mat3:
-      case cgltf_type_mat4:
-        OWL_ASSERT(0);
-      }
-    }
+  return ret;
+}
 
-    m->num_samplers += out_animation->num_samplers;
+static int owl_model_init_baked(struct owl_model *m, struct owl_renderer *r,
+                                char const *path) {
+  int32_t i;
+  VkIndexType index_type;
+  struct owl_plataform_file file;
+  struct owl_model_baked_table const *tables;
+  struct owl_model_baked_image const *images;
+  int ret = OWL_OK;
 
-    OWL_ASSERT(in_animation->channels_count <
-               OWL_ARRAY_SIZE(out_animation->channels));
+  ret = owl_plataform_map_file(path, &file);
+  if (ret)
+    return ret;
 
-    out_animation->num_channels = in_animation->channels_count;
-    for (j = 0; j < out_animation->num_channels; ++j) {
-      int32_t id;
-      struct owl_model_animation_channel *out_channel;
-      struct cgltf_animation_channel *in_channel;
+  ret = owl_model_check_baked(m, &file);
+  if (ret)
+    goto out_unmap_file;
 
-      out_animation->channels[j] = m->num_channels + j;
+  tables = ((struct owl_model_baked_header const *)file.data)->tables;
 
-      in_channel = &in_animation->channels[j];
-      out_channel = &m->channels[out_animation->channels[j]];
+  for (i = OWL_MODEL_BAKED_ROOTS; i < OWL_MODEL_BAKED_NUM_TABLES; ++i) {
+    uint32_t size;
+    uint32_t capacity;
+    void *array = owl_model_baked_array(m, i, &size, &capacity);
 
-      out_channel->path = in_channel->target_path;
-      out_channel->node = (int32_t)(in_channel->target_node - gltf->nodes);
+    OWL_MEMCPY(array, &file.data[tables[i].offset],
+               (uint64_t)tables[i].count * size);
+  }
 
-      id = (int32_t)(in_channel->sampler - in_animation->samplers);
-      out_channel->sampler = out_animation->samplers[id];
+  m->num_roots = (int32_t)tables[OWL_MODEL_BAKED_ROOTS].count;
+  m->num_nodes = (int)tables[OWL_MODEL_BAKED_NODES].count;
+  m->num_textures = (int)tables[OWL_MODEL_BAKED_TEXTURES].count;
+  m->num_materials = (int)tables[OWL_MODEL_BAKED_MATERIALS].count;
+  m->num_meshes = (int)tables[OWL_MODEL_BAKED_MESHES].count;
+  m->num_primitives = (int)tables[OWL_MODEL_BAKED_PRIMITIVES].count;
+  m->num_skins = (int)tables[OWL_MODEL_BAKED_SKINS].count;
+  m->num_samplers = (int)tables[OWL_MODEL_BAKED_SAMPLERS].count;
+  m->num_channels = (int)tables[OWL_MODEL_BAKED_CHANNELS].count;
+  m->num_animations = (int)tables[OWL_MODEL_BAKED_ANIMATIONS].count;
+
+  images = (struct owl_model_baked_image const *)&file
+               .data[tables[OWL_MODEL_BAKED_IMAGES].offset];
+
+  for (i = 0; i < (int32_t)tables[OWL_MODEL_BAKED_IMAGES].count; ++i) {
+    ret = owl_model_load_baked_image(r, m, &images[i], &m->images[i].texture);
+    if (ret)
+      goto error_unload_images;
+
+    m->num_images = i + 1;
+  }
+
+  for (i = 0; i < m->num_materials; ++i) {
+    ret = owl_model_init_material_maps(r, m, &m->materials[i]);
+    if (ret) {
+      m->num_materials = i;
+      goto error_unload_materials;
     }
+  }
 
-    m->num_channels += out_animation->num_channels;
+  for (i = 0; i < m->num_nodes; ++i) {
+    if (-1 == m->nodes[i].mesh)
+      continue;
+
+    ret = owl_model_init_mesh_storage(r, m, &m->nodes[i]);
+    if (ret) {
+      m->num_nodes = i;
+      goto error_unload_nodes;
+    }
   }
 
-  return ret;
-}
+  if (sizeof(uint16_t) == tables[OWL_MODEL_BAKED_INDICES].size)
+    index_type = VK_INDEX_TYPE_UINT16;
+  else
+    index_type = VK_INDEX_TYPE_UINT32;
 
-static void owl_model_unload_animations(struct owl_renderer *r,
-                                        struct owl_model *m) {
-  OWL_UNUSED(r);
-  OWL_UNUSED(m);
-}
+  ret = owl_model_init_buffers(
+      r, &file.data[tables[OWL_MODEL_BAKED_VERTICES].offset],
+      (int32_t)tables[OWL_MODEL_BAKED_VERTICES].count,
+      &file.data[tables[OWL_MODEL_BAKED_INDICES].offset],
+      (int32_t)tables[OWL_MODEL_BAKED_INDICES].count, index_type, m);
+  if (ret)
+    goto error_unload_nodes;
 
-static int owl_model_load_roots(struct owl_renderer *r,
-                                struct cgltf_data const *gltf,
-                                struct owl_model *m) {
-  int32_t i;
-  int ret = OWL_OK;
-  struct cgltf_scene const *in_scene = gltf->scene;
+  owl_model_update_bounds(m);
 
-  OWL_UNUSED(r);
+  ret = owl_model_init_gpu_culling(r, m);
+  if (ret)
+    goto error_deinit_buffers;
 
-  OWL_ASSERT(in_scene->nodes_count < OWL_ARRAY_SIZE(m->roots));
+  owl_plataform_unmap_file(&file);
 
-  m->num_roots = in_scene->nodes_count;
-  for (i = 0; i < m->num_roots; ++i)
-    m->roots[i] = (int32_t)(in_scene->nodes[i] - gltf->nodes);
+  return OWL_OK;
+
+error_deinit_buffers:
+  owl_renderer_wait_async_upload(r, m->upload_ticket);
+  owl_model_deinit_buffers(r, m);
+
+error_unload_nodes:
+  owl_model_unload_nodes(r, m);
+
+error_unload_materials:
+  owl_model_unload_materials(r, m);
+
+error_unload_images:
+  owl_model_unload_images(r, m);
+
+out_unmap_file:
+  owl_plataform_unmap_file(&file);
 
   return ret;
 }
 
-static void owl_model_unload_roots(struct owl_renderer *r,
-                                   struct owl_model *m) {
-  OWL_UNUSED(r);
-  OWL_UNUSED(m);
+/* everything but the empty texture */
+static void owl_model_unload(struct owl_model *model, struct owl_renderer *r) {
+  /* the acquire barriers can't be left pending on destroyed buffers */
+  owl_renderer_wait_async_upload(r, model->upload_ticket);
+  vkDeviceWaitIdle(r->device);
+  owl_model_deinit_gpu_culling(r, model);
+  owl_model_unload_roots(r, model);
+  owl_model_unload_animations(r, model);
+  owl_model_unload_skins(r, model);
+  owl_model_deinit_buffers(r, model);
+  owl_model_unload_nodes(r, model);
+  owl_model_unload_materials(r, model);
+  owl_model_unload_textures(r, model);
+  owl_model_unload_images(r, model);
 }
 
-#define OWL_PATH_SEPARATOR '/'
-
-/* TODO(samuel): cleanup on error */
-OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
-                          char const *path) {
+static int owl_model_init_common(struct owl_model *model,
+                                 struct owl_renderer *r, char const *path) {
   struct owl_texture_desc empty_desc;
-  struct cgltf_options options;
-  struct cgltf_data *data = NULL;
-  struct owl_model_all_primitives all_primitives;
-
   int ret = OWL_OK;
 
-  OWL_MEMSET(&options, 0, sizeof(options));
   OWL_MEMSET(model, 0, sizeof(*model));
   OWL_MEMSET(&empty_desc, 0, sizeof(empty_desc));
 
@@ -1660,6 +3616,11 @@ OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
   ret = owl_texture_init(r, &empty_desc, &model->empty_texture);
   OWL_ASSERT(!ret);
 
+  if (r->bindless_supported) {
+    ret = owl_renderer_add_bindless_texture(r, &model->empty_texture);
+    OWL_ASSERT(!ret);
+  }
+
   OWL_STRNCPY(model->path, path, sizeof(model->path));
 
   {
@@ -1677,6 +3638,20 @@ OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
     model->directory[end] = '\0';
   }
 
+  return ret;
+}
+
+/* writes the baked model to baked_path as well when it isn't NULL */
+static int owl_model_init_gltf(struct owl_model *model, struct owl_renderer *r,
+                               char const *path, char const *baked_path) {
+  struct cgltf_options options;
+  struct cgltf_data *data = NULL;
+  struct owl_model_all_primitives all_primitives;
+
+  int ret = OWL_OK;
+
+  OWL_MEMSET(&options, 0, sizeof(options));
+
   if (cgltf_result_success != cgltf_parse_file(&options, path, &data)) {
     OWL_DEBUG_LOG("Filed to parse gltf file!");
     ret = OWL_ERROR_FATAL;
@@ -1706,7 +3681,12 @@ OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
   ret = owl_model_load_nodes(r, data, &all_primitives, model);
   OWL_ASSERT(!ret);
 
-  ret = owl_model_init_buffers(r, &all_primitives, model);
+  ret = owl_model_init_buffers(r, all_primitives.vertices,
+                               all_primitives.num_vertices,
+                               all_primitives.indices,
+                               all_primitives.num_indices,
+                               owl_model_narrow_indices(&all_primitives),
+                               model);
   OWL_ASSERT(!ret);
 
   ret = owl_model_load_animations(r, data, model);
@@ -1715,6 +3695,17 @@ OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
   ret = owl_model_load_roots(r, data, model);
   OWL_ASSERT(!ret);
 
+  owl_model_update_bounds(model);
+
+  ret = owl_model_init_gpu_culling(r, model);
+  OWL_ASSERT(!ret);
+
+  if (baked_path) {
+    ret = owl_model_write_baked(model, data, &all_primitives, baked_path);
+    if (ret)
+      owl_model_unload(model, r);
+  }
+
   owl_model_deinit_all_primitives(&all_primitives);
 
   cgltf_free(data);
@@ -1723,16 +3714,55 @@ out:
   return ret;
 }
 
+OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
+                          char const *path) {
+  int ret;
+
+  ret = owl_model_init_common(model, r, path);
+  if (ret)
+    return ret;
+
+  if (owl_model_is_baked(path))
+    ret = owl_model_init_baked(model, r, path);
+  else
+    ret = owl_model_init_gltf(model, r, path, NULL);
+
+  if (ret)
+    owl_texture_deinit(r, &model->empty_texture);
+
+  return ret;
+}
+
+OWLAPI int owl_model_bake(struct owl_renderer *r, char const *path,
+                          char const *baked_path) {
+  int ret;
+  struct owl_model *model;
+
+  /* far too big for the stack */
+  model = OWL_MALLOC(sizeof(*model));
+  if (!model)
+    return OWL_ERROR_NO_MEMORY;
+
+  ret = owl_model_init_common(model, r, path);
+  if (ret)
+    goto out_free_model;
+
+  ret = owl_model_init_gltf(model, r, path, baked_path);
+  if (ret) {
+    owl_texture_deinit(r, &model->empty_texture);
+    goto out_free_model;
+  }
+
+  owl_model_deinit(model, r);
+
+out_free_model:
+  OWL_FREE(model);
+
+  return ret;
+}
+
 OWLAPI void owl_model_deinit(struct owl_model *model, struct owl_renderer *r) {
-  vkDeviceWaitIdle(r->device);
-  owl_model_unload_roots(r, model);
-  owl_model_unload_animations(r, model);
-  owl_model_unload_skins(r, model);
-  owl_model_deinit_buffers(r, model);
-  owl_model_unload_nodes(r, model);
-  owl_model_unload_materials(r, model);
-  owl_model_unload_textures(r, model);
-  owl_model_unload_images(r, model);
+  owl_model_unload(model, r);
   owl_texture_deinit(r, &model->empty_texture);
 }
 
@@ -1773,7 +3803,7 @@ static void owl_model_update_node_joints(struct owl_renderer *r,
   int32_t i;
   owl_m4 tmp;
   owl_m4 inverse;
-  struct owl_model_mesh const *mesh;
+  struct owl_model_mesh *mesh;
   struct owl_model_skin const *skin;
   struct owl_model_node const *node;
   uint32_t const frame = r->frame;
@@ -1796,12 +3826,20 @@ static void owl_model_update_node_joints(struct owl_renderer *r,
   owl_m4_inverse(tmp, inverse);
 
 #if 1
+  /* skinned vertices are blends of the joint transforms, so they stay inside
+   * the union of the bounds moved by every joint */
+  owl_model_bbox_reset(&mesh->aabb);
+
   for (i = 0; i < skin->num_joints; ++i) {
+    struct owl_model_bbox joint_bbox;
     struct owl_model_joints_ssbo *ssbo = mesh->mapped_ssbos[frame];
 
     owl_model_resolve_node_matrix(m, skin->joints[i], tmp);
     owl_m4_multiply(tmp, skin->inverse_bind_matrices[i], tmp);
     owl_m4_multiply(inverse, tmp, ssbo->joints[i]);
+
+    owl_model_bbox_transform(ssbo->joints[i], &mesh->bb, &joint_bbox);
+    owl_model_bbox_merge(&joint_bbox, &mesh->aabb);
   }
 #else
   OWL_UNUSED(frame);
@@ -1872,5 +3910,7 @@ OWLAPI int owl_model_update_animation(struct owl_renderer *r,
   for (i = 0; i < m->num_roots; ++i)
     owl_model_update_node_joints(r, m, m->roots[i]);
 
+  owl_model_update_bounds(m);
+
   return OWL_OK;
 }
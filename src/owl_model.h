@@ -15,14 +15,20 @@ OWL_BEGIN_DECLARATIONS
 #define OWL_ALPHA_MODE_MASK 1
 #define OWL_ALPHA_MODE_BLEND 2
 
+#define OWL_MODEL_MATERIAL_NUM_MAPS 5
+/* full detail plus the simplified levels generated on import */
+#define OWL_MODEL_MAX_LODS 4
+
+/* quantized on import, the normal is octahedral encoded into two snorm16,
+ * uvs are half floats, weights and color unorm8 */
 struct owl_model_vertex {
   owl_v3 position;
-  owl_v3 normal;
-  owl_v2 uv0;
-  owl_v2 uv1;
-  owl_v4 joints0;
-  owl_v4 weights0;
-  owl_v4 color0;
+  int16_t normal[2];
+  uint16_t uv0[2];
+  uint16_t uv1[2];
+  uint8_t joints0[4];
+  uint8_t weights0[4];
+  uint8_t color0[4];
 };
 
 struct owl_model_uniform {
@@ -39,6 +45,7 @@ struct owl_model_uniform {
   float debug_view_equation;
 };
 
+/* valid is 0 when the bounds are unknown, those are never culled */
 struct owl_model_bbox {
   owl_v3 min;
   owl_v3 max;
@@ -70,9 +77,20 @@ struct owl_model_material {
   owl_v4 specular_factor;
   int32_t metallic_roughness_enable;
   int32_t specular_glossiness_enable;
+  /* slots of the color, physical descriptor, normal, occlusion and emissive
+   * maps in the renderer's bindless array */
+  int32_t bindless_maps[OWL_MODEL_MATERIAL_NUM_MAPS];
+  /* VK_NULL_HANDLE when drawing bindless */
+  VkDescriptorPool descriptor_pool;
   VkDescriptorSet descriptor_set;
 };
 
+/* a range of the model's index buffer */
+struct owl_model_lod {
+  uint32_t first;
+  uint32_t num_indices;
+};
+
 struct owl_model_primitive {
   uint32_t first;
   uint32_t num_indices;
@@ -80,6 +98,10 @@ struct owl_model_primitive {
   int32_t material;
   int32_t has_indices;
   struct owl_model_bbox bbox;
+  /* lods[0] is first and num_indices, every other level indexes the same
+   * vertices with about half the triangles of the one before */
+  int32_t num_lods;
+  struct owl_model_lod lods[OWL_MODEL_MAX_LODS];
 };
 
 struct owl_model_joints_ssbo {
@@ -91,13 +113,16 @@ struct owl_model_joints_ssbo {
 struct owl_model_mesh {
   int32_t num_primitives;
   int32_t primitives[128];
+  /* bounds of the primitives, and of the skinned primitives as last
+   * animated, both relative to the node */
   struct owl_model_bbox bb;
   struct owl_model_bbox aabb;
 
-  VkBuffer ssbos[OWL_NUM_IN_FLIGHT_FRAMES];
-  VkDeviceMemory ssbo_memory;
-  VkDescriptorSet ssbo_descriptor_sets[OWL_NUM_IN_FLIGHT_FRAMES];
-  struct owl_model_joints_ssbo *mapped_ssbos[OWL_NUM_IN_FLIGHT_FRAMES];
+  VkBuffer ssbos[OWL_MAX_IN_FLIGHT_FRAMES];
+  struct owl_memory_allocation ssbo_memory;
+  VkDescriptorPool ssbo_descriptor_pool;
+  VkDescriptorSet ssbo_descriptor_sets[OWL_MAX_IN_FLIGHT_FRAMES];
+  struct owl_model_joints_ssbo *mapped_ssbos[OWL_MAX_IN_FLIGHT_FRAMES];
 };
 
 struct owl_model_skin {
@@ -122,6 +147,7 @@ struct owl_model_node {
   owl_v3 translation;
   owl_v3 scale;
   owl_v4 rotation;
+  /* model space bounds of the node and of the node and its children */
   struct owl_model_bbox bvh;
   struct owl_model_bbox aabb;
 };
@@ -180,6 +206,36 @@ struct owl_model_push_constant {
   float roughness_factor;
   float alpha_mask;
   float alpha_mask_cutoff;
+  int32_t color_map_index;
+  int32_t physical_desc_map_index;
+  int32_t normal_map_index;
+  int32_t occlusion_map_index;
+  int32_t emissive_map_index;
+};
+
+/* a material as the indirect pipeline reads it, std430 pads the array
+ * stride to the vec4 alignment */
+struct owl_model_material_data {
+  struct owl_model_push_constant push_constant;
+  int32_t padding;
+};
+
+/* a primitive as owl_cull.comp sees it, the bounds are relative to the node,
+ * min[3] is 1 when they are known */
+struct owl_model_draw {
+  owl_v4 min;
+  owl_v4 max;
+  uint32_t node;
+  uint32_t material;
+  uint32_t first_index;
+  uint32_t num_indices;
+};
+
+/* the draw count comes from the size of the draw buffer */
+struct owl_model_cull_push_constant {
+  owl_m4 clip;
+  /* zero when there's no depth pyramid to test against */
+  owl_m4 occlusion_clip;
 };
 
 struct owl_model_image {
@@ -195,11 +251,16 @@ struct owl_model {
   char directory[256];
 
   VkBuffer vertex_buffer;
-  VkDeviceMemory vertex_memory;
+  struct owl_memory_allocation vertex_memory;
 
   int32_t has_indices;
+  /* VK_INDEX_TYPE_UINT16 whenever every vertex can be indexed with it */
+  VkIndexType index_type;
   VkBuffer index_buffer;
-  VkDeviceMemory index_memory;
+  struct owl_memory_allocation index_memory;
+
+  /* the vertex and index buffers can't be drawn before it's done */
+  uint64_t upload_ticket;
 
   int32_t active_animation;
 
@@ -237,6 +298,24 @@ struct owl_model {
 
   int num_animations;
   struct owl_model_animation animations[128];
+
+  /* culled on the gpu and drawn with a single indirect draw, only for
+   * unskinned models with indices when the renderer supports it. the draws
+   * and materials never change, the node matrices are written and the
+   * indirect commands generated every frame */
+  int32_t gpu_culled;
+  uint32_t num_draws;
+  VkBuffer draw_buffer;
+  struct owl_memory_allocation draw_memory;
+  VkBuffer material_buffer;
+  struct owl_memory_allocation material_memory;
+  VkBuffer node_buffers[OWL_MAX_IN_FLIGHT_FRAMES];
+  struct owl_memory_allocation node_memory;
+  owl_m4 *mapped_nodes[OWL_MAX_IN_FLIGHT_FRAMES];
+  VkBuffer indirect_buffers[OWL_MAX_IN_FLIGHT_FRAMES];
+  struct owl_memory_allocation indirect_memory;
+  VkDescriptorPool indirect_descriptor_pool;
+  VkDescriptorSet indirect_descriptor_sets[OWL_MAX_IN_FLIGHT_FRAMES];
 };
 
 OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
@@ -244,6 +323,18 @@ OWLAPI int owl_model_init(struct owl_model *model, struct owl_renderer *r,
 
 OWLAPI void owl_model_deinit(struct owl_model *model, struct owl_renderer *r);
 
+/* loads the gltf model at path and writes it to baked_path, with its images
+ * decoded into files of their own next to it. owl_model_init loads paths
+ * ending in .owlm as baked models, those only work with the build that baked
+ * them */
+OWLAPI int owl_model_bake(struct owl_renderer *r, char const *path,
+                          char const *baked_path);
+
+/* the material as the pbr shaders read it */
+OWLAPI void
+owl_model_material_push_constant(struct owl_model_material const *material,
+                                 struct owl_model_push_constant *push_constant);
+
 OWLAPI int owl_model_update_animation(struct owl_renderer *r,
                                       struct owl_model *m, float dt,
                                       int32_t animation);
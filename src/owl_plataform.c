@@ -1,3 +1,8 @@
+/* mmap and friends, the rest of the tree is strict c90 */
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "owl_plataform.h"
 
 #include "owl_internal.h"
@@ -13,6 +18,13 @@
 
 #include <stdio.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 OWLAPI int owl_plataform_init(struct owl_plataform *plataform, int w, int h,
                               char const *title) {
   int res;
@@ -167,3 +179,111 @@ OWLAPI int owl_plataform_load_file(char const *path,
 OWLAPI void owl_plataform_unload_file(struct owl_plataform_file *file) {
   OWL_FREE(file->data);
 }
+
+/* room for the process id and the suffix of the temporary file */
+#define OWL_PLATAFORM_TMP_SUFFIX_LENGTH 32
+
+OWLAPI int owl_plataform_save_file(char const *path, void const *data,
+                                   uint64_t size) {
+  FILE *fp = NULL;
+  char *tmp_path;
+  int ret = OWL_OK;
+  uint64_t const length = OWL_STRLEN(path) + OWL_PLATAFORM_TMP_SUFFIX_LENGTH;
+
+  tmp_path = OWL_MALLOC(length);
+  if (!tmp_path)
+    return OWL_ERROR_NO_MEMORY;
+
+  /* a file per process, two of them saving at once don't mix their writes */
+#if defined(_WIN32)
+  OWL_SNPRINTF(tmp_path, length, "%s.tmp", path);
+#else
+  OWL_SNPRINTF(tmp_path, length, "%s.%ld.tmp", path, (long)getpid());
+#endif
+
+  fp = fopen(tmp_path, "wb");
+  if (!fp) {
+    ret = OWL_ERROR_NOT_FOUND;
+    goto out_free_tmp_path;
+  }
+
+  if (1 != fwrite(data, size, 1, fp))
+    ret = OWL_ERROR_FATAL;
+
+  if (fclose(fp))
+    ret = OWL_ERROR_FATAL;
+
+#if defined(_WIN32)
+  /* rename doesn't replace an existing file here */
+  if (!ret)
+    remove(path);
+#endif
+
+  /* readers see either the old file or the whole new one */
+  if (!ret && rename(tmp_path, path))
+    ret = OWL_ERROR_FATAL;
+
+  if (ret)
+    remove(tmp_path);
+
+out_free_tmp_path:
+  OWL_FREE(tmp_path);
+
+  return ret;
+}
+
+#if defined(_WIN32)
+
+OWLAPI int owl_plataform_map_file(char const *path,
+                                  struct owl_plataform_file *file) {
+  return owl_plataform_load_file(path, file);
+}
+
+OWLAPI void owl_plataform_unmap_file(struct owl_plataform_file *file) {
+  owl_plataform_unload_file(file);
+}
+
+#else
+
+OWLAPI int owl_plataform_map_file(char const *path,
+                                  struct owl_plataform_file *file) {
+  int fd;
+  void *data;
+  struct stat info;
+  int ret = OWL_OK;
+
+  file->path = path;
+  file->size = 0;
+  file->data = NULL;
+
+  fd = open(path, O_RDONLY);
+  if (-1 == fd)
+    return OWL_ERROR_NOT_FOUND;
+
+  if (fstat(fd, &info) || !info.st_size) {
+    ret = OWL_ERROR_FATAL;
+    goto out_close;
+  }
+
+  data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (MAP_FAILED == data) {
+    ret = OWL_ERROR_FATAL;
+    goto out_close;
+  }
+
+  file->size = (uint64_t)info.st_size;
+  file->data = data;
+
+  /* the mapping outlives the descriptor */
+out_close:
+  close(fd);
+
+  return ret;
+}
+
+OWLAPI void owl_plataform_unmap_file(struct owl_plataform_file *file) {
+  if (file->data)
+    munmap(file->data, (size_t)file->size);
+}
+
+#endif
@@ -53,6 +53,17 @@ OWLAPI int owl_plataform_load_file(char const *path,
 
 OWLAPI void owl_plataform_unload_file(struct owl_plataform_file *file);
 
+/* writes a temporary file next to path and renames it over path */
+OWLAPI int owl_plataform_save_file(char const *path, void const *data,
+                                   uint64_t size);
+
+/* read only view of the whole file, the pages are read in as they are
+ * touched. falls back to loading it where there's no mmap */
+OWLAPI int owl_plataform_map_file(char const *path,
+                                  struct owl_plataform_file *file);
+
+OWLAPI void owl_plataform_unmap_file(struct owl_plataform_file *file);
+
 OWL_END_DECLARATIONS
 
 #endif
@@ -1,10 +1,12 @@
 #include "owl_renderer.h"
 
 #include "owl_definitions.h"
+#include "owl_draw.h"
 #include "owl_internal.h"
 #include "owl_model.h"
 #include "owl_plataform.h"
 #include "owl_texture.h"
+#include "owl_thread.h"
 #include "owl_vector_math.h"
 
 #ifndef OWL_POW
@@ -14,7 +16,10 @@
 
 #include <stdio.h>
 
-#define OWL_DEFAULT_BUFFER_SIZE (1 << 16)
+/* the indirect shaders read the maps out of the bindless array */
+#if defined(OWL_ENABLE_GPU_CULLING) && !defined(OWL_ENABLE_BINDLESS)
+#error "OWL_ENABLE_GPU_CULLING requires OWL_ENABLE_BINDLESS"
+#endif
 
 #if defined(OWL_ENABLE_VALIDATION)
 
@@ -49,6 +54,9 @@ static VKAPI_ATTR VKAPI_CALL VkBool32 owl_renderer_debug_callback(
 static char const *const debug_validation_layers[] = {
     "VK_LAYER_KHRONOS_validation"};
 
+static char const *const headless_instance_extensions[] = {
+    VK_EXT_DEBUG_UTILS_EXTENSION_NAME};
+
 #endif
 
 static int owl_renderer_init_instance(struct owl_renderer *r) {
@@ -63,12 +71,25 @@ static int owl_renderer_init_instance(struct owl_renderer *r) {
     VkApplicationInfo app_info;
     VkInstanceCreateInfo info;
 
-    char const *name = owl_plataform_get_title(r->plataform);
+    char const *name;
 
-    ret = owl_plataform_get_required_instance_extensions(
-        r->plataform, &num_extensions, &extensions);
-    if (ret)
-      return ret;
+    if (r->headless) {
+      name = "owl";
+#if defined(OWL_ENABLE_VALIDATION)
+      num_extensions = OWL_ARRAY_SIZE(headless_instance_extensions);
+      extensions = headless_instance_extensions;
+#else  /* OWL_ENABLE_VALIDATION */
+      num_extensions = 0;
+      extensions = NULL;
+#endif /* OWL_ENABLE_VALIDATION */
+    } else {
+      name = owl_plataform_get_title(r->plataform);
+
+      ret = owl_plataform_get_required_instance_extensions(
+          r->plataform, &num_extensions, &extensions);
+      if (ret)
+        return ret;
+    }
 
     app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     app_info.pNext = NULL;
@@ -76,7 +97,9 @@ static int owl_renderer_init_instance(struct owl_renderer *r) {
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName = "No Engine";
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_MAKE_VERSION(1, 0, 0);
+    /* 1.2 for descriptor indexing, devices without it still get the per
+     * material descriptor sets */
+    app_info.apiVersion = VK_MAKE_VERSION(1, 2, 0);
 
     info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     info.pNext = NULL;
@@ -186,10 +209,18 @@ static void owl_renderer_set_vk_object_name(struct owl_renderer *r,
 #endif
 
 static int owl_renderer_init_surface(struct owl_renderer *r) {
+  if (r->headless) {
+    r->surface = VK_NULL_HANDLE;
+    return OWL_OK;
+  }
+
   return owl_plataform_create_vulkan_surface(r->plataform, r);
 }
 
 static void owl_renderer_deinit_surface(struct owl_renderer *r) {
+  if (r->headless)
+    return;
+
   vkDestroySurfaceKHR(r->instance, r->surface, NULL);
 }
 
@@ -225,14 +256,37 @@ static int owl_renderer_find_queue_families(struct owl_renderer *r) {
     if (properties->queueFlags & VK_QUEUE_GRAPHICS_BIT)
       r->graphics_family = i;
 
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &supports_surface);
-    if (supports_surface)
-      r->present_family = i;
+    /* nothing is presented in headless mode, reuse the graphics family */
+    if (r->headless) {
+      r->present_family = r->graphics_family;
+    } else {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface,
+                                           &supports_surface);
+      if (supports_surface)
+        r->present_family = i;
+    }
 
     if ((uint32_t)-1 != r->graphics_family && (uint32_t)-1 != r->present_family)
       found_families = 1;
   }
 
+  /* a family without graphics or compute is usually backed by the copy
+   * engines, uploads there run alongside the frames */
+  r->transfer_family = r->graphics_family;
+
+  for (i = 0; i < num_family_properties; ++i) {
+    VkQueueFlags const flags = family_properties[i].queueFlags;
+
+    if (!(flags & VK_QUEUE_TRANSFER_BIT))
+      continue;
+
+    if (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))
+      continue;
+
+    r->transfer_family = i;
+    break;
+  }
+
   OWL_FREE(family_properties);
 
   return found_families;
@@ -247,6 +301,9 @@ static int owl_renderer_validate_extensions(struct owl_renderer *r) {
   VkExtensionProperties *supported_extensions = NULL;
   VkPhysicalDevice const device = r->physical_device;
 
+  if (r->headless)
+    return 1;
+
   device_extension_markers = OWL_MALLOC(OWL_ARRAY_SIZE(device_extensions) *
                                         sizeof(*device_extension_markers));
   if (!device_extension_markers)
@@ -458,6 +515,19 @@ static int owl_renderer_select_physical_device(struct owl_renderer *r) {
     if (!ok)
       continue;
 
+    if (r->headless) {
+      r->surface_format.format = VK_FORMAT_R8G8B8A8_SRGB;
+      r->surface_format.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+      r->present_mode = VK_PRESENT_MODE_FIFO_KHR;
+
+      ok = owl_renderer_request_msaa(r, VK_SAMPLE_COUNT_2_BIT);
+      if (!ok)
+        continue;
+
+      found_device = 1;
+      continue;
+    }
+
     ok = owl_renderer_request_surface_format(r, VK_FORMAT_B8G8R8A8_SRGB,
                                              VK_COLOR_SPACE_SRGB_NONLINEAR_KHR);
     if (!ok)
@@ -491,50 +561,125 @@ cleanup:
 }
 
 static int owl_renderer_init_device(struct owl_renderer *r) {
+  VkPhysicalDeviceProperties properties;
   VkPhysicalDeviceFeatures features;
+#if defined(OWL_ENABLE_BINDLESS)
+  VkPhysicalDeviceFeatures2 features2;
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing_features;
+#endif
   VkDeviceCreateInfo info;
-  VkDeviceQueueCreateInfo queue_infos[2];
+  VkDeviceQueueCreateInfo queue_infos[3];
+  uint32_t num_queue_infos = 0;
   float const priority = 1.0F;
   VkResult vk_result = VK_SUCCESS;
   int ret = OWL_OK;
 
-  queue_infos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  queue_infos[0].pNext = NULL;
-  queue_infos[0].flags = 0;
-  queue_infos[0].queueFamilyIndex = r->graphics_family;
-  queue_infos[0].queueCount = 1;
-  queue_infos[0].pQueuePriorities = &priority;
-
-  queue_infos[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  queue_infos[1].pNext = NULL;
-  queue_infos[1].flags = 0;
-  queue_infos[1].queueFamilyIndex = r->present_family;
-  queue_infos[1].queueCount = 1;
-  queue_infos[1].pQueuePriorities = &priority;
+  queue_infos[num_queue_infos].sType =
+      VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queue_infos[num_queue_infos].pNext = NULL;
+  queue_infos[num_queue_infos].flags = 0;
+  queue_infos[num_queue_infos].queueFamilyIndex = r->graphics_family;
+  queue_infos[num_queue_infos].queueCount = 1;
+  queue_infos[num_queue_infos].pQueuePriorities = &priority;
+  ++num_queue_infos;
+
+  if (r->graphics_family != r->present_family) {
+    queue_infos[num_queue_infos].sType =
+        VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_infos[num_queue_infos].pNext = NULL;
+    queue_infos[num_queue_infos].flags = 0;
+    queue_infos[num_queue_infos].queueFamilyIndex = r->present_family;
+    queue_infos[num_queue_infos].queueCount = 1;
+    queue_infos[num_queue_infos].pQueuePriorities = &priority;
+    ++num_queue_infos;
+  }
+
+  if (r->graphics_family != r->transfer_family &&
+      r->present_family != r->transfer_family) {
+    queue_infos[num_queue_infos].sType =
+        VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_infos[num_queue_infos].pNext = NULL;
+    queue_infos[num_queue_infos].flags = 0;
+    queue_infos[num_queue_infos].queueFamilyIndex = r->transfer_family;
+    queue_infos[num_queue_infos].queueCount = 1;
+    queue_infos[num_queue_infos].pQueuePriorities = &priority;
+    ++num_queue_infos;
+  }
 
   vkGetPhysicalDeviceFeatures(r->physical_device, &features);
+  vkGetPhysicalDeviceProperties(r->physical_device, &properties);
+
+  r->bindless_supported = 0;
+  r->gpu_culling_supported = 0;
+
+#if defined(OWL_ENABLE_BINDLESS)
+  if (VK_API_VERSION_1_2 <= properties.apiVersion) {
+    indexing_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    indexing_features.pNext = NULL;
+
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &indexing_features;
+
+    vkGetPhysicalDeviceFeatures2(r->physical_device, &features2);
+
+    r->bindless_supported =
+        indexing_features.runtimeDescriptorArray &&
+        indexing_features.descriptorBindingPartiallyBound &&
+        indexing_features.descriptorBindingSampledImageUpdateAfterBind;
+
+#if defined(OWL_ENABLE_GPU_CULLING)
+    {
+      VkFormatProperties depth_properties;
+
+      /* the depth pyramid is reduced from the depth attachment */
+      vkGetPhysicalDeviceFormatProperties(r->physical_device, r->depth_format,
+                                          &depth_properties);
+
+      /* every primitive is a draw of a single indirect call, they pick their
+       * maps with a non uniform index */
+      r->gpu_culling_supported =
+          r->bindless_supported && features.multiDrawIndirect &&
+          features.drawIndirectFirstInstance &&
+          indexing_features.shaderSampledImageArrayNonUniformIndexing &&
+          (VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT &
+           depth_properties.optimalTilingFeatures);
+    }
+#endif
+  }
+#endif
 
   info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
   info.pNext = NULL;
   info.flags = 0;
-  if (r->graphics_family == r->present_family) {
-    info.queueCreateInfoCount = 1;
-  } else {
-    info.queueCreateInfoCount = 2;
-  }
+  info.queueCreateInfoCount = num_queue_infos;
   info.pQueueCreateInfos = queue_infos;
   info.enabledLayerCount = 0;      /* deprecated */
   info.ppEnabledLayerNames = NULL; /* deprecated */
-  info.enabledExtensionCount = OWL_ARRAY_SIZE(device_extensions);
-  info.ppEnabledExtensionNames = device_extensions;
+  if (r->headless) {
+    info.enabledExtensionCount = 0;
+    info.ppEnabledExtensionNames = NULL;
+  } else {
+    info.enabledExtensionCount = OWL_ARRAY_SIZE(device_extensions);
+    info.ppEnabledExtensionNames = device_extensions;
+  }
   info.pEnabledFeatures = &features;
 
+#if defined(OWL_ENABLE_BINDLESS)
+  /* features2 already holds the core features, enable everything supported */
+  if (r->bindless_supported) {
+    info.pNext = &features2;
+    info.pEnabledFeatures = NULL;
+  }
+#endif
+
   vk_result = vkCreateDevice(r->physical_device, &info, NULL, &r->device);
   if (vk_result)
     return OWL_ERROR_FATAL;
 
   vkGetDeviceQueue(r->device, r->graphics_family, 0, &r->graphics_queue);
   vkGetDeviceQueue(r->device, r->present_family, 0, &r->present_queue);
+  vkGetDeviceQueue(r->device, r->transfer_family, 0, &r->transfer_queue);
 
   return ret;
 }
@@ -543,10 +688,133 @@ static void owl_renderer_deinit_device(struct owl_renderer *r) {
   vkDestroyDevice(r->device, NULL);
 }
 
+static uint32_t owl_renderer_read_u32_le(uint8_t const *data) {
+  uint32_t value = 0;
+
+  value |= (uint32_t)data[0];
+  value |= (uint32_t)data[1] << 8;
+  value |= (uint32_t)data[2] << 16;
+  value |= (uint32_t)data[3] << 24;
+
+  return value;
+}
+
+/* the header is always least significant byte first, see
+ * VkPipelineCacheHeaderVersionOne */
+static int
+owl_renderer_validate_pipeline_cache(struct owl_renderer *r,
+                                     struct owl_plataform_file const *file) {
+  uint32_t header_size;
+  uint32_t header_version;
+  uint32_t vendor_id;
+  uint32_t device_id;
+  VkPhysicalDeviceProperties properties;
+  uint64_t const min_header_size = 16 + VK_UUID_SIZE;
+
+  if (file->size < min_header_size)
+    return 0;
+
+  header_size = owl_renderer_read_u32_le(&file->data[0]);
+  header_version = owl_renderer_read_u32_le(&file->data[4]);
+  vendor_id = owl_renderer_read_u32_le(&file->data[8]);
+  device_id = owl_renderer_read_u32_le(&file->data[12]);
+
+  if (header_size < min_header_size || file->size < header_size)
+    return 0;
+
+  if (VK_PIPELINE_CACHE_HEADER_VERSION_ONE != header_version)
+    return 0;
+
+  vkGetPhysicalDeviceProperties(r->physical_device, &properties);
+
+  if (properties.vendorID != vendor_id)
+    return 0;
+
+  if (properties.deviceID != device_id)
+    return 0;
+
+  /* the uuid changes with the driver version */
+  if (OWL_MEMCMP(properties.pipelineCacheUUID, &file->data[16], VK_UUID_SIZE))
+    return 0;
+
+  return 1;
+}
+
+static int owl_renderer_init_pipeline_cache(struct owl_renderer *r) {
+  int ret;
+  struct owl_plataform_file file;
+  VkPipelineCacheCreateInfo info;
+  VkResult vk_result = VK_SUCCESS;
+
+  info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  info.pNext = NULL;
+  info.flags = 0;
+  info.initialDataSize = 0;
+  info.pInitialData = NULL;
+
+  /* a missing or stale cache is not an error, it just starts empty */
+  if (r->pipeline_cache_path[0])
+    ret = owl_plataform_load_file(r->pipeline_cache_path, &file);
+  else
+    ret = OWL_ERROR_NOT_FOUND;
+
+  if (!ret) {
+    if (owl_renderer_validate_pipeline_cache(r, &file)) {
+      info.initialDataSize = file.size;
+      info.pInitialData = file.data;
+    } else {
+      OWL_DEBUG_LOG("Discarding incompatible pipeline cache\n");
+    }
+  }
+
+  vk_result = vkCreatePipelineCache(r->device, &info, NULL, &r->pipeline_cache);
+
+  if (!ret)
+    owl_plataform_unload_file(&file);
+
+  if (vk_result)
+    return OWL_ERROR_FATAL;
+
+  return OWL_OK;
+}
+
+static void owl_renderer_deinit_pipeline_cache(struct owl_renderer *r) {
+  size_t size;
+  void *data;
+  VkResult vk_result;
+  VkDevice const device = r->device;
+
+  if (!r->pipeline_cache_path[0])
+    goto out;
+
+  vk_result = vkGetPipelineCacheData(device, r->pipeline_cache, &size, NULL);
+  if (vk_result || !size)
+    goto out;
+
+  data = OWL_MALLOC(size);
+  if (!data)
+    goto out;
+
+  vk_result = vkGetPipelineCacheData(device, r->pipeline_cache, &size, data);
+  if (!vk_result) {
+    if (owl_plataform_save_file(r->pipeline_cache_path, data, size)) {
+      OWL_DEBUG_LOG("Failed to save pipeline cache\n");
+    }
+  }
+
+  OWL_FREE(data);
+
+out:
+  vkDestroyPipelineCache(device, r->pipeline_cache, NULL);
+}
+
 static int owl_renderer_clamp_dimensions(struct owl_renderer *r) {
   VkSurfaceCapabilitiesKHR capabilities;
   VkResult vk_result;
 
+  if (r->headless)
+    return OWL_OK;
+
   vk_result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
       r->physical_device, r->surface, &capabilities);
   if (vk_result)
@@ -665,6 +933,9 @@ static int owl_renderer_init_attachments(struct owl_renderer *r) {
     info.samples = r->msaa;
     info.tiling = VK_IMAGE_TILING_OPTIMAL;
     info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    /* the depth pyramid is built from it */
+    if (r->gpu_culling_supported)
+      info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
     info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     info.queueFamilyIndexCount = 0;
     info.pQueueFamilyIndices = NULL;
@@ -796,7 +1067,11 @@ static int owl_renderer_init_render_passes(struct owl_renderer *r) {
   attachments[1].format = r->depth_format;
   attachments[1].samples = r->msaa;
   attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  /* read after the pass to build the depth pyramid */
+  if (r->gpu_culling_supported)
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  else
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -811,7 +1086,10 @@ static int owl_renderer_init_render_passes(struct owl_renderer *r) {
   attachments[2].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   attachments[2].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   attachments[2].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  attachments[2].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  if (r->headless)
+    attachments[2].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  else
+    attachments[2].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
   subpass.flags = 0;
   subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
@@ -863,79 +1141,73 @@ static void owl_renderer_deinit_render_passes(struct owl_renderer *r) {
   vkDestroyRenderPass(device, r->main_render_pass, NULL);
 }
 
-static int owl_renderer_init_swapchain(struct owl_renderer *r) {
-  int32_t i;
-
-  VkResult vk_result = VK_SUCCESS;
-  int ret = OWL_OK;
+static int owl_renderer_init_offscreen_targets(struct owl_renderer *r) {
   VkDevice const device = r->device;
-  VkPhysicalDevice const physical_device = r->physical_device;
 
   {
-    uint32_t families[2];
-    VkSwapchainCreateInfoKHR info;
-    VkSurfaceCapabilitiesKHR capabilities;
-
-    r->swapchain_image = 0;
-
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, r->surface,
-                                              &capabilities);
+    VkImageCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-    info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     info.pNext = NULL;
     info.flags = 0;
-    info.surface = r->surface;
-    info.minImageCount = r->num_frames;
-    info.imageFormat = r->surface_format.format;
-    info.imageColorSpace = r->surface_format.colorSpace;
-    info.imageExtent.width = r->width;
-    info.imageExtent.height = r->height;
-    info.imageArrayLayers = 1;
-    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    info.preTransform = capabilities.currentTransform;
-    info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    info.presentMode = r->present_mode;
-    info.clipped = VK_TRUE;
-    info.oldSwapchain = VK_NULL_HANDLE;
-
-    families[0] = r->graphics_family;
-    families[1] = r->present_family;
-
-    if (r->graphics_family == r->present_family) {
-      info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      info.queueFamilyIndexCount = 0;
-      info.pQueueFamilyIndices = NULL;
-    } else {
-      info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-      info.queueFamilyIndexCount = 2;
-      info.pQueueFamilyIndices = families;
-    }
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = r->surface_format.format;
+    info.extent.width = r->width;
+    info.extent.height = r->height;
+    info.extent.depth = 1;
+    info.mipLevels = 1;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = 0;
+    info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-    vk_result = vkCreateSwapchainKHR(device, &info, NULL, &r->swapchain);
+    vk_result = vkCreateImage(device, &info, NULL, &r->offscreen_image);
     if (vk_result)
       goto error;
+  }
 
-    vk_result = vkGetSwapchainImagesKHR(device, r->swapchain,
-                                        &r->num_swapchain_images, NULL);
-    if (vk_result)
-      goto error_destroy_swapchain;
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
+    VkMemoryAllocateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-    if (OWL_MAX_SWAPCHAIN_IMAGES <= r->num_swapchain_images)
-      goto error_destroy_swapchain;
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    vk_result = vkGetSwapchainImagesKHR(
-        device, r->swapchain, &r->num_swapchain_images, r->swapchain_images);
+    vkGetImageMemoryRequirements(device, r->offscreen_image, &requirements);
+
+    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.allocationSize = requirements.size;
+    info.memoryTypeIndex = owl_renderer_find_memory_type(
+        r, requirements.memoryTypeBits, properties);
+
+    vk_result = vkAllocateMemory(device, &info, NULL, &r->offscreen_memory);
     if (vk_result)
-      goto error_destroy_swapchain;
+      goto error_destroy_image;
+
+    vk_result =
+        vkBindImageMemory(device, r->offscreen_image, r->offscreen_memory, 0);
+    if (vk_result)
+      goto error_free_memory;
   }
 
-  for (i = 0; i < (int32_t)r->num_swapchain_images; ++i) {
+  {
     VkImageViewCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
     info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     info.pNext = NULL;
     info.flags = 0;
-    info.image = r->swapchain_images[i];
+    info.image = r->offscreen_image;
     info.viewType = VK_IMAGE_VIEW_TYPE_2D;
     info.format = r->surface_format.format;
     info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -949,18 +1221,19 @@ static int owl_renderer_init_swapchain(struct owl_renderer *r) {
     info.subresourceRange.layerCount = 1;
 
     vk_result =
-        vkCreateImageView(device, &info, NULL, &r->swapchain_image_views[i]);
+        vkCreateImageView(device, &info, NULL, &r->offscreen_image_view);
     if (vk_result)
-      goto error_destroy_image_views;
+      goto error_free_memory;
   }
 
-  for (i = 0; i < (int32_t)r->num_swapchain_images; ++i) {
+  {
     VkImageView attachments[3];
     VkFramebufferCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
     attachments[0] = r->color_image_view;
     attachments[1] = r->depth_image_view;
-    attachments[2] = r->swapchain_image_views[i];
+    attachments[2] = r->offscreen_image_view;
 
     info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
     info.pNext = NULL;
@@ -973,44 +1246,312 @@ static int owl_renderer_init_swapchain(struct owl_renderer *r) {
     info.layers = 1;
 
     vk_result =
-        vkCreateFramebuffer(device, &info, NULL, &r->swapchain_framebuffers[i]);
+        vkCreateFramebuffer(device, &info, NULL, &r->offscreen_framebuffer);
     if (vk_result)
-      goto error_destroy_framebuffers;
+      goto error_destroy_image_view;
   }
 
-  return OWL_OK;
+  {
+    VkBufferCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-error_destroy_framebuffers:
-  for (i = i - 1; i >= 0; --i)
-    vkDestroyFramebuffer(device, r->swapchain_framebuffers[i], NULL);
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.size = r->width * r->height * 4;
+    info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
 
-  i = r->num_swapchain_images;
+    vk_result =
+        vkCreateBuffer(device, &info, NULL, &r->offscreen_readback_buffer);
+    if (vk_result)
+      goto error_destroy_framebuffer;
+  }
 
-error_destroy_image_views:
-  for (i = i - 1; i >= 0; --i)
-    vkDestroyImageView(device, r->swapchain_image_views[i], NULL);
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
+    VkMemoryAllocateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-error_destroy_swapchain:
-  vkDestroySwapchainKHR(device, r->swapchain, NULL);
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-error:
-  return ret;
-}
+    vkGetBufferMemoryRequirements(device, r->offscreen_readback_buffer,
+                                  &requirements);
 
-static void owl_renderer_deinit_swapchain(struct owl_renderer *r) {
-  uint32_t i;
-  VkDevice const device = r->device;
+    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.allocationSize = requirements.size;
+    info.memoryTypeIndex = owl_renderer_find_memory_type(
+        r, requirements.memoryTypeBits, properties);
 
-  for (i = 0; i < r->num_swapchain_images; ++i)
-    vkDestroyFramebuffer(device, r->swapchain_framebuffers[i], NULL);
+    vk_result = vkAllocateMemory(device, &info, NULL,
+                                 &r->offscreen_readback_memory);
+    if (vk_result)
+      goto error_destroy_readback_buffer;
 
-  for (i = 0; i < r->num_swapchain_images; ++i)
+    vk_result = vkBindBufferMemory(device, r->offscreen_readback_buffer,
+                                   r->offscreen_readback_memory, 0);
+    if (vk_result)
+      goto error_free_readback_memory;
+
+    vk_result = vkMapMemory(device, r->offscreen_readback_memory, 0,
+                            VK_WHOLE_SIZE, 0, &r->offscreen_readback_data);
+    if (vk_result)
+      goto error_free_readback_memory;
+  }
+
+  r->offscreen_rendered = 0;
+
+  return OWL_OK;
+
+error_free_readback_memory:
+  vkFreeMemory(device, r->offscreen_readback_memory, NULL);
+
+error_destroy_readback_buffer:
+  vkDestroyBuffer(device, r->offscreen_readback_buffer, NULL);
+
+error_destroy_framebuffer:
+  vkDestroyFramebuffer(device, r->offscreen_framebuffer, NULL);
+
+error_destroy_image_view:
+  vkDestroyImageView(device, r->offscreen_image_view, NULL);
+
+error_free_memory:
+  vkFreeMemory(device, r->offscreen_memory, NULL);
+
+error_destroy_image:
+  vkDestroyImage(device, r->offscreen_image, NULL);
+
+error:
+  return OWL_ERROR_FATAL;
+}
+
+static void owl_renderer_deinit_offscreen_targets(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+
+  vkFreeMemory(device, r->offscreen_readback_memory, NULL);
+  vkDestroyBuffer(device, r->offscreen_readback_buffer, NULL);
+  vkDestroyFramebuffer(device, r->offscreen_framebuffer, NULL);
+  vkDestroyImageView(device, r->offscreen_image_view, NULL);
+  vkFreeMemory(device, r->offscreen_memory, NULL);
+  vkDestroyImage(device, r->offscreen_image, NULL);
+}
+
+static int owl_renderer_init_swapchain(struct owl_renderer *r) {
+  int32_t i;
+
+  VkResult vk_result = VK_SUCCESS;
+  int ret = OWL_OK;
+  VkDevice const device = r->device;
+  VkPhysicalDevice const physical_device = r->physical_device;
+
+  if (r->headless)
+    return owl_renderer_init_offscreen_targets(r);
+
+  {
+    uint32_t families[2];
+    VkSwapchainCreateInfoKHR info;
+    VkSurfaceCapabilitiesKHR capabilities;
+
+    r->swapchain_image = 0;
+
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, r->surface,
+                                              &capabilities);
+
+    info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.surface = r->surface;
+    info.minImageCount = OWL_MAX(r->num_frames, capabilities.minImageCount);
+    if (capabilities.maxImageCount)
+      info.minImageCount = OWL_MIN(info.minImageCount,
+                                   capabilities.maxImageCount);
+    info.imageFormat = r->surface_format.format;
+    info.imageColorSpace = r->surface_format.colorSpace;
+    info.imageExtent.width = r->width;
+    info.imageExtent.height = r->height;
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.preTransform = capabilities.currentTransform;
+    info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    info.presentMode = r->present_mode;
+    info.clipped = VK_TRUE;
+    /* on a resize the old swapchain is still alive in the garbage, passing
+     * it lets the presentation engine hand over its resources */
+    info.oldSwapchain = r->swapchain;
+
+    families[0] = r->graphics_family;
+    families[1] = r->present_family;
+
+    if (r->graphics_family == r->present_family) {
+      info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      info.queueFamilyIndexCount = 0;
+      info.pQueueFamilyIndices = NULL;
+    } else {
+      info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+      info.queueFamilyIndexCount = 2;
+      info.pQueueFamilyIndices = families;
+    }
+
+    vk_result = vkCreateSwapchainKHR(device, &info, NULL, &r->swapchain);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error;
+    }
+
+    vk_result = vkGetSwapchainImagesKHR(device, r->swapchain,
+                                        &r->num_swapchain_images, NULL);
+    if (vk_result)
+      goto error_destroy_swapchain;
+
+    if (OWL_MAX_SWAPCHAIN_IMAGES <= r->num_swapchain_images)
+      goto error_destroy_swapchain;
+
+    vk_result = vkGetSwapchainImagesKHR(
+        device, r->swapchain, &r->num_swapchain_images, r->swapchain_images);
+    if (vk_result)
+      goto error_destroy_swapchain;
+  }
+
+  for (i = 0; i < (int32_t)r->num_swapchain_images; ++i) {
+    VkImageViewCreateInfo info;
+
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.image = r->swapchain_images[i];
+    info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    info.format = r->surface_format.format;
+    info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    info.subresourceRange.baseMipLevel = 0;
+    info.subresourceRange.levelCount = 1;
+    info.subresourceRange.baseArrayLayer = 0;
+    info.subresourceRange.layerCount = 1;
+
+    vk_result =
+        vkCreateImageView(device, &info, NULL, &r->swapchain_image_views[i]);
+    if (vk_result)
+      goto error_destroy_image_views;
+  }
+
+  for (i = 0; i < (int32_t)r->num_swapchain_images; ++i) {
+    VkImageView attachments[3];
+    VkFramebufferCreateInfo info;
+
+    attachments[0] = r->color_image_view;
+    attachments[1] = r->depth_image_view;
+    attachments[2] = r->swapchain_image_views[i];
+
+    info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.renderPass = r->main_render_pass;
+    info.attachmentCount = OWL_ARRAY_SIZE(attachments);
+    info.pAttachments = attachments;
+    info.width = r->width;
+    info.height = r->height;
+    info.layers = 1;
+
+    vk_result =
+        vkCreateFramebuffer(device, &info, NULL, &r->swapchain_framebuffers[i]);
+    if (vk_result)
+      goto error_destroy_framebuffers;
+  }
+
+  return OWL_OK;
+
+error_destroy_framebuffers:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyFramebuffer(device, r->swapchain_framebuffers[i], NULL);
+
+  i = r->num_swapchain_images;
+
+error_destroy_image_views:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyImageView(device, r->swapchain_image_views[i], NULL);
+
+error_destroy_swapchain:
+  vkDestroySwapchainKHR(device, r->swapchain, NULL);
+  r->swapchain = VK_NULL_HANDLE;
+
+  ret = OWL_ERROR_FATAL;
+
+error:
+  return ret;
+}
+
+static void owl_renderer_deinit_swapchain(struct owl_renderer *r) {
+  uint32_t i;
+  VkDevice const device = r->device;
+
+  if (r->headless) {
+    owl_renderer_deinit_offscreen_targets(r);
+    return;
+  }
+
+  for (i = 0; i < r->num_swapchain_images; ++i)
+    vkDestroyFramebuffer(device, r->swapchain_framebuffers[i], NULL);
+
+  for (i = 0; i < r->num_swapchain_images; ++i)
     vkDestroyImageView(device, r->swapchain_image_views[i], NULL);
 
   vkDestroySwapchainKHR(device, r->swapchain, NULL);
+  r->swapchain = VK_NULL_HANDLE;
+}
+
+static int owl_renderer_init_descriptor_pool(struct owl_renderer *r,
+                                             uint32_t size, uint32_t flags,
+                                             VkDescriptorPool *pool) {
+  VkDescriptorPoolSize sizes[7];
+  VkDescriptorPoolCreateInfo info;
+  VkResult vk_result = VK_SUCCESS;
+
+  sizes[0].descriptorCount = size;
+  sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
+  sizes[1].descriptorCount = size;
+  sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+
+  sizes[2].descriptorCount = size;
+  sizes[2].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+
+  sizes[3].descriptorCount = size;
+  sizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+  sizes[4].descriptorCount = size;
+  sizes[4].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+  sizes[5].descriptorCount = size;
+  sizes[5].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+  sizes[6].descriptorCount = size;
+  sizes[6].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+  info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  info.pNext = NULL;
+  info.flags = flags;
+  info.maxSets = size * OWL_ARRAY_SIZE(sizes);
+  info.poolSizeCount = OWL_ARRAY_SIZE(sizes);
+  info.pPoolSizes = sizes;
+
+  vk_result = vkCreateDescriptorPool(r->device, &info, NULL, pool);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
+
+  return OWL_OK;
 }
 
 static int owl_renderer_init_pools(struct owl_renderer *r) {
+  int32_t i;
   VkDevice const device = r->device;
 
   {
@@ -1028,46 +1569,48 @@ static int owl_renderer_init_pools(struct owl_renderer *r) {
   }
 
   {
-    VkDescriptorPoolSize sizes[7];
-    VkDescriptorPoolCreateInfo info;
-    VkResult vk_result = VK_SUCCESS;
-
-    sizes[0].descriptorCount = 256;
-    sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-
-    sizes[1].descriptorCount = 256;
-    sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+    int ret;
 
-    sizes[2].descriptorCount = 256;
-    sizes[2].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    ret = owl_renderer_init_descriptor_pool(
+        r, OWL_DESCRIPTOR_POOL_SIZE,
+        VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+        &r->descriptor_pools[0]);
+    if (ret)
+      goto error_destroy_command_pool;
 
-    sizes[3].descriptorCount = 256;
-    sizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    r->num_descriptor_pools = 1;
+  }
 
-    sizes[4].descriptorCount = 256;
-    sizes[4].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i) {
+    int ret;
 
-    sizes[5].descriptorCount = 256;
-    sizes[5].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    ret = owl_renderer_init_descriptor_pool(r, OWL_FRAME_DESCRIPTOR_POOL_SIZE,
+                                            0, &r->frame_descriptor_pools[i]);
+    if (ret)
+      goto error_destroy_frame_descriptor_pools;
+  }
 
-    sizes[6].descriptorCount = 256;
-    sizes[6].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  {
+    VkFenceCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     info.pNext = NULL;
-    info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    info.maxSets = 256 * OWL_ARRAY_SIZE(sizes);
-    info.poolSizeCount = OWL_ARRAY_SIZE(sizes);
-    info.pPoolSizes = sizes;
+    info.flags = 0;
 
-    vk_result =
-        vkCreateDescriptorPool(device, &info, NULL, &r->descriptor_pool);
+    vk_result = vkCreateFence(device, &info, NULL, &r->im_fence);
     if (vk_result)
-      goto error_destroy_command_pool;
+      goto error_destroy_frame_descriptor_pools;
   }
 
   return OWL_OK;
 
+error_destroy_frame_descriptor_pools:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyDescriptorPool(device, r->frame_descriptor_pools[i], NULL);
+
+  vkDestroyDescriptorPool(device, r->descriptor_pools[0], NULL);
+
 error_destroy_command_pool:
   vkDestroyCommandPool(device, r->command_pool, NULL);
 
@@ -1076,11 +1619,37 @@ error:
 }
 
 static void owl_renderer_deinit_pools(struct owl_renderer *r) {
+  uint32_t i;
   VkDevice const device = r->device;
-  vkDestroyDescriptorPool(device, r->descriptor_pool, NULL);
+  vkDestroyFence(device, r->im_fence, NULL);
+
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i)
+    vkDestroyDescriptorPool(device, r->frame_descriptor_pools[i], NULL);
+
+  for (i = 0; i < r->num_descriptor_pools; ++i)
+    vkDestroyDescriptorPool(device, r->descriptor_pools[i], NULL);
+
   vkDestroyCommandPool(device, r->command_pool, NULL);
 }
 
+static void owl_renderer_deinit_shaders(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+  vkDestroyShaderModule(device, r->model_instanced_vertex_shader, NULL);
+  vkDestroyShaderModule(device, r->depth_pyramid_compute_shader, NULL);
+  vkDestroyShaderModule(device, r->cull_compute_shader, NULL);
+  vkDestroyShaderModule(device, r->model_indirect_fragment_shader, NULL);
+  vkDestroyShaderModule(device, r->model_indirect_vertex_shader, NULL);
+  vkDestroyShaderModule(device, r->text_sdf_fragment_shader, NULL);
+  vkDestroyShaderModule(device, r->model_bindless_fragment_shader, NULL);
+  vkDestroyShaderModule(device, r->skybox_fragment_shader, NULL);
+  vkDestroyShaderModule(device, r->skybox_vertex_shader, NULL);
+  vkDestroyShaderModule(device, r->model_fragment_shader, NULL);
+  vkDestroyShaderModule(device, r->model_vertex_shader, NULL);
+  vkDestroyShaderModule(device, r->text_fragment_shader, NULL);
+  vkDestroyShaderModule(device, r->basic_fragment_shader, NULL);
+  vkDestroyShaderModule(device, r->basic_vertex_shader, NULL);
+}
+
 static int owl_renderer_init_shaders(struct owl_renderer *r) {
   VkDevice const device = r->device;
 
@@ -1146,6 +1715,30 @@ static int owl_renderer_init_shaders(struct owl_renderer *r) {
       goto error_destroy_basic_fragment_shader;
   }
 
+  r->text_sdf_fragment_shader = VK_NULL_HANDLE;
+
+#if defined(OWL_ENABLE_SDF_FONT)
+  {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    static uint32_t const spv[] = {
+#include "owl_font_sdf.frag.spv.u32"
+    };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(spv);
+    info.pCode = spv;
+
+    vk_result =
+        vkCreateShaderModule(device, &info, NULL, &r->text_sdf_fragment_shader);
+    if (vk_result)
+      goto error_destroy_text_fragment_shader;
+  }
+#endif
+
   {
     VkShaderModuleCreateInfo info;
     VkResult vk_result = VK_SUCCESS;
@@ -1164,7 +1757,7 @@ static int owl_renderer_init_shaders(struct owl_renderer *r) {
         vkCreateShaderModule(device, &info, NULL, &r->model_vertex_shader);
 
     if (VK_SUCCESS != vk_result)
-      goto error_destroy_text_fragment_shader;
+      goto error_destroy_text_sdf_fragment_shader;
   }
 
   {
@@ -1230,18 +1823,179 @@ static int owl_renderer_init_shaders(struct owl_renderer *r) {
       goto error_destroy_skybox_vertex_shader;
   }
 
-  return OWL_OK;
+  r->model_bindless_fragment_shader = VK_NULL_HANDLE;
 
-error_destroy_skybox_vertex_shader:
-  vkDestroyShaderModule(device, r->skybox_vertex_shader, NULL);
+#if defined(OWL_ENABLE_BINDLESS)
+  if (r->bindless_supported) {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-error_destroy_model_fragment_shader:
-  vkDestroyShaderModule(device, r->model_fragment_shader, NULL);
+    static uint32_t const spv[] = {
+#include "owl_pbr_bindless.frag.spv.u32"
+    };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(spv);
+    info.pCode = spv;
+
+    vk_result = vkCreateShaderModule(device, &info, NULL,
+                                     &r->model_bindless_fragment_shader);
+    if (vk_result)
+      goto error_destroy_skybox_fragment_shader;
+  }
+#endif
+
+  r->model_indirect_vertex_shader = VK_NULL_HANDLE;
+  r->model_indirect_fragment_shader = VK_NULL_HANDLE;
+  r->cull_compute_shader = VK_NULL_HANDLE;
+  r->depth_pyramid_compute_shader = VK_NULL_HANDLE;
+  r->model_instanced_vertex_shader = VK_NULL_HANDLE;
+
+#if defined(OWL_ENABLE_GPU_CULLING)
+  if (r->gpu_culling_supported) {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    static uint32_t const spv[] = {
+#include "owl_pbr_indirect.vert.spv.u32"
+    };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(spv);
+    info.pCode = spv;
+
+    vk_result = vkCreateShaderModule(device, &info, NULL,
+                                     &r->model_indirect_vertex_shader);
+    if (vk_result)
+      goto error_destroy_model_bindless_fragment_shader;
+  }
+
+  if (r->gpu_culling_supported) {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    static uint32_t const spv[] = {
+#include "owl_pbr_indirect.frag.spv.u32"
+    };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(spv);
+    info.pCode = spv;
+
+    vk_result = vkCreateShaderModule(device, &info, NULL,
+                                     &r->model_indirect_fragment_shader);
+    if (vk_result)
+      goto error_destroy_model_indirect_vertex_shader;
+  }
+
+  if (r->gpu_culling_supported) {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    static uint32_t const spv[] = {
+#include "owl_cull.comp.spv.u32"
+    };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(spv);
+    info.pCode = spv;
+
+    vk_result =
+        vkCreateShaderModule(device, &info, NULL, &r->cull_compute_shader);
+    if (vk_result)
+      goto error_destroy_model_indirect_fragment_shader;
+  }
+
+  if (r->gpu_culling_supported) {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    static uint32_t const spv[] = {
+#include "owl_depth_pyramid.comp.spv.u32"
+    };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(spv);
+    info.pCode = spv;
+
+    vk_result = vkCreateShaderModule(device, &info, NULL,
+                                     &r->depth_pyramid_compute_shader);
+    if (vk_result)
+      goto error_destroy_cull_compute_shader;
+  }
+#endif
+
+#if defined(OWL_ENABLE_INSTANCING)
+  {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    static uint32_t const spv[] = {
+#include "owl_pbr_instanced.vert.spv.u32"
+    };
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(spv);
+    info.pCode = spv;
+
+    vk_result = vkCreateShaderModule(device, &info, NULL,
+                                     &r->model_instanced_vertex_shader);
+    /* every other module is either created or VK_NULL_HANDLE by now */
+    if (vk_result) {
+      owl_renderer_deinit_shaders(r);
+      return OWL_ERROR_FATAL;
+    }
+  }
+#endif
+
+  return OWL_OK;
+
+#if defined(OWL_ENABLE_GPU_CULLING)
+error_destroy_cull_compute_shader:
+  vkDestroyShaderModule(device, r->cull_compute_shader, NULL);
+
+error_destroy_model_indirect_fragment_shader:
+  vkDestroyShaderModule(device, r->model_indirect_fragment_shader, NULL);
+
+error_destroy_model_indirect_vertex_shader:
+  vkDestroyShaderModule(device, r->model_indirect_vertex_shader, NULL);
+
+error_destroy_model_bindless_fragment_shader:
+  vkDestroyShaderModule(device, r->model_bindless_fragment_shader, NULL);
+#endif
+
+#if defined(OWL_ENABLE_BINDLESS)
+error_destroy_skybox_fragment_shader:
+  vkDestroyShaderModule(device, r->skybox_fragment_shader, NULL);
+#endif
+
+error_destroy_skybox_vertex_shader:
+  vkDestroyShaderModule(device, r->skybox_vertex_shader, NULL);
+
+error_destroy_model_fragment_shader:
+  vkDestroyShaderModule(device, r->model_fragment_shader, NULL);
 
 error_destroy_model_vertex_shader:
   vkDestroyShaderModule(device, r->model_vertex_shader, NULL);
 
+error_destroy_text_sdf_fragment_shader:
+  vkDestroyShaderModule(device, r->text_sdf_fragment_shader, NULL);
+
+#if defined(OWL_ENABLE_SDF_FONT)
 error_destroy_text_fragment_shader:
+#endif
   vkDestroyShaderModule(device, r->text_fragment_shader, NULL);
 
 error_destroy_basic_fragment_shader:
@@ -1254,17 +2008,6 @@ error:
   return OWL_ERROR_FATAL;
 }
 
-static void owl_renderer_deinit_shaders(struct owl_renderer *r) {
-  VkDevice const device = r->device;
-  vkDestroyShaderModule(device, r->skybox_fragment_shader, NULL);
-  vkDestroyShaderModule(device, r->skybox_vertex_shader, NULL);
-  vkDestroyShaderModule(device, r->model_fragment_shader, NULL);
-  vkDestroyShaderModule(device, r->model_vertex_shader, NULL);
-  vkDestroyShaderModule(device, r->text_fragment_shader, NULL);
-  vkDestroyShaderModule(device, r->basic_fragment_shader, NULL);
-  vkDestroyShaderModule(device, r->basic_vertex_shader, NULL);
-}
-
 static int owl_renderer_init_layouts(struct owl_renderer *r) {
   VkDevice const device = r->device;
 
@@ -1507,134 +2250,448 @@ static int owl_renderer_init_layouts(struct owl_renderer *r) {
       goto error_destroy_model_environment_descriptor_set_layout;
   }
 
-  return OWL_OK;
+  r->model_bindless_descriptor_set_layout = VK_NULL_HANDLE;
+  r->model_bindless_pipeline_layout = VK_NULL_HANDLE;
+  r->model_indirect_descriptor_set_layout = VK_NULL_HANDLE;
+  r->model_indirect_pipeline_layout = VK_NULL_HANDLE;
+  r->cull_pipeline_layout = VK_NULL_HANDLE;
+  r->cull_pyramid_descriptor_set_layout = VK_NULL_HANDLE;
+  r->depth_pyramid_descriptor_set_layout = VK_NULL_HANDLE;
+  r->depth_pyramid_pipeline_layout = VK_NULL_HANDLE;
 
-error_destroy_model_environment_descriptor_set_layout:
-  vkDestroyDescriptorSetLayout(
-      device, r->model_environment_descriptor_set_layout, NULL);
+  if (!r->bindless_supported)
+    return OWL_OK;
 
-error_destroy_model_maps_descriptor_set_layout:
-  vkDestroyDescriptorSetLayout(device, r->model_maps_descriptor_set_layout,
-                               NULL);
+  {
+    VkDescriptorBindingFlags binding_flags[2];
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info;
+    VkDescriptorSetLayoutBinding bindings[2];
+    VkDescriptorSetLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-error_destroy_model_storage_descriptor_set_layout:
-  vkDestroyDescriptorSetLayout(device, r->model_storage_descriptor_set_layout,
-                               NULL);
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[0].pImmutableSamplers = NULL;
 
-error_destroy_model_uniform_descriptor_set_layout:
-  vkDestroyDescriptorSetLayout(device, r->model_uniform_descriptor_set_layout,
-                               NULL);
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[1].descriptorCount = OWL_MAX_BINDLESS_TEXTURES;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[1].pImmutableSamplers = NULL;
 
-error_destroy_common_pipeline_layout:
-  vkDestroyPipelineLayout(device, r->common_pipeline_layout, NULL);
+    /* textures are added while previous frames are still using the set */
+    binding_flags[0] = 0;
+    binding_flags[1] = 0;
+    binding_flags[1] |= VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    binding_flags[1] |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
 
-error_destroy_common_texture_descriptor_set_layout:
-  vkDestroyDescriptorSetLayout(device, r->common_texture_descriptor_set_layout,
-                               NULL);
+    flags_info.sType =
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flags_info.pNext = NULL;
+    flags_info.bindingCount = OWL_ARRAY_SIZE(binding_flags);
+    flags_info.pBindingFlags = binding_flags;
 
-error_destroy_common_uniform_descriptor_set_layout:
-  vkDestroyDescriptorSetLayout(device, r->common_uniform_descriptor_set_layout,
-                               NULL);
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.pNext = &flags_info;
+    info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    info.bindingCount = OWL_ARRAY_SIZE(bindings);
+    info.pBindings = bindings;
 
-error:
-  return OWL_ERROR_FATAL;
-}
+    vk_result = vkCreateDescriptorSetLayout(
+        device, &info, NULL, &r->model_bindless_descriptor_set_layout);
+    if (vk_result)
+      goto error_destroy_model_pipeline_layout;
+  }
 
-static void owl_renderer_deinit_layouts(struct owl_renderer *r) {
-  VkDevice const device = r->device;
-  vkDestroyPipelineLayout(device, r->model_pipeline_layout, NULL);
-  vkDestroyDescriptorSetLayout(
-      device, r->model_environment_descriptor_set_layout, NULL);
-  vkDestroyDescriptorSetLayout(device, r->model_maps_descriptor_set_layout,
-                               NULL);
-  vkDestroyDescriptorSetLayout(device, r->model_storage_descriptor_set_layout,
-                               NULL);
-  vkDestroyDescriptorSetLayout(device, r->model_uniform_descriptor_set_layout,
-                               NULL);
-  vkDestroyPipelineLayout(device, r->common_pipeline_layout, NULL);
-  vkDestroyDescriptorSetLayout(device, r->common_texture_descriptor_set_layout,
-                               NULL);
-  vkDestroyDescriptorSetLayout(device, r->common_uniform_descriptor_set_layout,
-                               NULL);
-}
+  {
+    VkDescriptorSetLayout layouts[4];
+    VkPushConstantRange push_constant;
+    VkPipelineLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-static int owl_renderer_init_graphics_pipelines(struct owl_renderer *r) {
-  VkVertexInputBindingDescription vertex_bindings;
-  VkVertexInputAttributeDescription vertex_attributes[7];
-  VkPipelineVertexInputStateCreateInfo vertex_input;
-  VkPipelineInputAssemblyStateCreateInfo input_assembly;
-  VkViewport viewport;
-  VkRect2D scissor;
-  VkPipelineViewportStateCreateInfo viewport_state;
-  VkPipelineRasterizationStateCreateInfo rasterization;
-  VkPipelineMultisampleStateCreateInfo multisample;
-  VkPipelineColorBlendAttachmentState color_attachment;
-  VkPipelineColorBlendStateCreateInfo color;
-  VkPipelineDepthStencilStateCreateInfo depth;
-  VkPipelineShaderStageCreateInfo stages[2];
-  VkGraphicsPipelineCreateInfo info;
-  int ret;
-  VkResult vk_result;
-  VkDevice const device = r->device;
+    push_constant.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_constant.offset = 0;
+    push_constant.size = sizeof(struct owl_model_push_constant);
 
-  ret = owl_renderer_init_shaders(r);
-  if (ret)
-    return ret;
+    layouts[0] = r->model_uniform_descriptor_set_layout;
+    layouts[1] = r->model_storage_descriptor_set_layout;
+    layouts[2] = r->model_bindless_descriptor_set_layout;
+    layouts[3] = r->model_environment_descriptor_set_layout;
 
-  vertex_bindings.binding = 0;
-  vertex_bindings.stride = sizeof(struct owl_common_vertex);
-  vertex_bindings.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.setLayoutCount = OWL_ARRAY_SIZE(layouts);
+    info.pSetLayouts = layouts;
+    info.pushConstantRangeCount = 1;
+    info.pPushConstantRanges = &push_constant;
 
-  vertex_attributes[0].binding = 0;
-  vertex_attributes[0].location = 0;
-  vertex_attributes[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-  vertex_attributes[0].offset = offsetof(struct owl_common_vertex, position);
+    vk_result = vkCreatePipelineLayout(device, &info, NULL,
+                                       &r->model_bindless_pipeline_layout);
+    if (vk_result)
+      goto error_destroy_model_bindless_descriptor_set_layout;
+  }
 
-  vertex_attributes[1].binding = 0;
-  vertex_attributes[1].location = 1;
-  vertex_attributes[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-  vertex_attributes[1].offset = offsetof(struct owl_common_vertex, color);
+  if (!r->gpu_culling_supported)
+    return OWL_OK;
 
-  vertex_attributes[2].binding = 0;
-  vertex_attributes[2].location = 2;
-  vertex_attributes[2].format = VK_FORMAT_R32G32_SFLOAT;
-  vertex_attributes[2].offset = offsetof(struct owl_common_vertex, uv);
+  {
+    VkDescriptorSetLayoutBinding bindings[4];
+    VkDescriptorSetLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-  vertex_input.sType =
-      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertex_input.pNext = NULL;
-  vertex_input.flags = 0;
-  vertex_input.vertexBindingDescriptionCount = 1;
-  vertex_input.pVertexBindingDescriptions = &vertex_bindings;
-  vertex_input.vertexAttributeDescriptionCount = 3;
-  vertex_input.pVertexAttributeDescriptions = vertex_attributes;
+    /* node matrices */
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = 0;
+    bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[0].stageFlags |= VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[0].pImmutableSamplers = NULL;
 
-  input_assembly.sType =
-      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-  input_assembly.pNext = NULL;
-  input_assembly.flags = 0;
-  input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-  input_assembly.primitiveRestartEnable = VK_FALSE;
+    /* draws */
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = 0;
+    bindings[1].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[1].stageFlags |= VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].pImmutableSamplers = NULL;
 
-  viewport.x = 0.0F;
-  viewport.y = 0.0F;
-  viewport.width = r->width;
-  viewport.height = r->height;
-  viewport.minDepth = 0.0F;
-  viewport.maxDepth = 1.0F;
+    /* materials */
+    bindings[2].binding = 2;
+    bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[2].descriptorCount = 1;
+    bindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[2].pImmutableSamplers = NULL;
 
-  scissor.offset.x = 0;
-  scissor.offset.y = 0;
-  scissor.extent.width = r->width;
-  scissor.extent.height = r->height;
+    /* indirect commands */
+    bindings[3].binding = 3;
+    bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[3].descriptorCount = 1;
+    bindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[3].pImmutableSamplers = NULL;
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.bindingCount = OWL_ARRAY_SIZE(bindings);
+    info.pBindings = bindings;
+
+    vk_result = vkCreateDescriptorSetLayout(
+        device, &info, NULL, &r->model_indirect_descriptor_set_layout);
+    if (vk_result)
+      goto error_destroy_model_bindless_pipeline_layout;
+  }
+
+  {
+    VkDescriptorSetLayoutBinding binding;
+    VkDescriptorSetLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    /* every level of the depth pyramid */
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    binding.pImmutableSamplers = NULL;
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.bindingCount = 1;
+    info.pBindings = &binding;
+
+    vk_result = vkCreateDescriptorSetLayout(
+        device, &info, NULL, &r->cull_pyramid_descriptor_set_layout);
+    if (vk_result)
+      goto error_destroy_model_indirect_descriptor_set_layout;
+  }
+
+  {
+    VkDescriptorSetLayoutBinding bindings[3];
+    VkDescriptorSetLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    /* multisampled depth attachment */
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[0].pImmutableSamplers = NULL;
+
+    /* previous level */
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].pImmutableSamplers = NULL;
+
+    /* level written */
+    bindings[2].binding = 2;
+    bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[2].descriptorCount = 1;
+    bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[2].pImmutableSamplers = NULL;
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.bindingCount = OWL_ARRAY_SIZE(bindings);
+    info.pBindings = bindings;
+
+    vk_result = vkCreateDescriptorSetLayout(
+        device, &info, NULL, &r->depth_pyramid_descriptor_set_layout);
+    if (vk_result)
+      goto error_destroy_cull_pyramid_descriptor_set_layout;
+  }
+
+  {
+    VkPushConstantRange push_constant;
+    VkPipelineLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant.offset = 0;
+    push_constant.size =
+        sizeof(struct owl_renderer_depth_pyramid_push_constant);
+
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.setLayoutCount = 1;
+    info.pSetLayouts = &r->depth_pyramid_descriptor_set_layout;
+    info.pushConstantRangeCount = 1;
+    info.pPushConstantRanges = &push_constant;
+
+    vk_result = vkCreatePipelineLayout(device, &info, NULL,
+                                       &r->depth_pyramid_pipeline_layout);
+    if (vk_result)
+      goto error_destroy_depth_pyramid_descriptor_set_layout;
+  }
+
+  {
+    VkDescriptorSetLayout layouts[4];
+    VkPipelineLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    layouts[0] = r->model_uniform_descriptor_set_layout;
+    layouts[1] = r->model_indirect_descriptor_set_layout;
+    layouts[2] = r->model_bindless_descriptor_set_layout;
+    layouts[3] = r->model_environment_descriptor_set_layout;
+
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.setLayoutCount = OWL_ARRAY_SIZE(layouts);
+    info.pSetLayouts = layouts;
+    /* the materials are read out of the indirect set */
+    info.pushConstantRangeCount = 0;
+    info.pPushConstantRanges = NULL;
+
+    vk_result = vkCreatePipelineLayout(device, &info, NULL,
+                                       &r->model_indirect_pipeline_layout);
+    if (vk_result)
+      goto error_destroy_depth_pyramid_pipeline_layout;
+  }
+
+  {
+    VkDescriptorSetLayout layouts[2];
+    VkPushConstantRange push_constant;
+    VkPipelineLayoutCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant.offset = 0;
+    push_constant.size = sizeof(struct owl_model_cull_push_constant);
+
+    layouts[0] = r->model_indirect_descriptor_set_layout;
+    layouts[1] = r->cull_pyramid_descriptor_set_layout;
+
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.setLayoutCount = OWL_ARRAY_SIZE(layouts);
+    info.pSetLayouts = layouts;
+    info.pushConstantRangeCount = 1;
+    info.pPushConstantRanges = &push_constant;
+
+    vk_result =
+        vkCreatePipelineLayout(device, &info, NULL, &r->cull_pipeline_layout);
+    if (vk_result)
+      goto error_destroy_model_indirect_pipeline_layout;
+  }
+
+  return OWL_OK;
+
+error_destroy_model_indirect_pipeline_layout:
+  vkDestroyPipelineLayout(device, r->model_indirect_pipeline_layout, NULL);
+
+error_destroy_depth_pyramid_pipeline_layout:
+  vkDestroyPipelineLayout(device, r->depth_pyramid_pipeline_layout, NULL);
+
+error_destroy_depth_pyramid_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->depth_pyramid_descriptor_set_layout,
+                               NULL);
+
+error_destroy_cull_pyramid_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->cull_pyramid_descriptor_set_layout,
+                               NULL);
+
+error_destroy_model_indirect_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->model_indirect_descriptor_set_layout,
+                               NULL);
+
+error_destroy_model_bindless_pipeline_layout:
+  vkDestroyPipelineLayout(device, r->model_bindless_pipeline_layout, NULL);
+
+error_destroy_model_bindless_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->model_bindless_descriptor_set_layout,
+                               NULL);
+
+error_destroy_model_pipeline_layout:
+  vkDestroyPipelineLayout(device, r->model_pipeline_layout, NULL);
+
+error_destroy_model_environment_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(
+      device, r->model_environment_descriptor_set_layout, NULL);
+
+error_destroy_model_maps_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->model_maps_descriptor_set_layout,
+                               NULL);
+
+error_destroy_model_storage_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->model_storage_descriptor_set_layout,
+                               NULL);
+
+error_destroy_model_uniform_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->model_uniform_descriptor_set_layout,
+                               NULL);
+
+error_destroy_common_pipeline_layout:
+  vkDestroyPipelineLayout(device, r->common_pipeline_layout, NULL);
+
+error_destroy_common_texture_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->common_texture_descriptor_set_layout,
+                               NULL);
+
+error_destroy_common_uniform_descriptor_set_layout:
+  vkDestroyDescriptorSetLayout(device, r->common_uniform_descriptor_set_layout,
+                               NULL);
+
+error:
+  return OWL_ERROR_FATAL;
+}
+
+static void owl_renderer_deinit_layouts(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+  vkDestroyPipelineLayout(device, r->cull_pipeline_layout, NULL);
+  vkDestroyPipelineLayout(device, r->model_indirect_pipeline_layout, NULL);
+  vkDestroyPipelineLayout(device, r->depth_pyramid_pipeline_layout, NULL);
+  vkDestroyDescriptorSetLayout(device, r->depth_pyramid_descriptor_set_layout,
+                               NULL);
+  vkDestroyDescriptorSetLayout(device, r->cull_pyramid_descriptor_set_layout,
+                               NULL);
+  vkDestroyDescriptorSetLayout(device, r->model_indirect_descriptor_set_layout,
+                               NULL);
+  vkDestroyPipelineLayout(device, r->model_bindless_pipeline_layout, NULL);
+  vkDestroyDescriptorSetLayout(device, r->model_bindless_descriptor_set_layout,
+                               NULL);
+  vkDestroyPipelineLayout(device, r->model_pipeline_layout, NULL);
+  vkDestroyDescriptorSetLayout(
+      device, r->model_environment_descriptor_set_layout, NULL);
+  vkDestroyDescriptorSetLayout(device, r->model_maps_descriptor_set_layout,
+                               NULL);
+  vkDestroyDescriptorSetLayout(device, r->model_storage_descriptor_set_layout,
+                               NULL);
+  vkDestroyDescriptorSetLayout(device, r->model_uniform_descriptor_set_layout,
+                               NULL);
+  vkDestroyPipelineLayout(device, r->common_pipeline_layout, NULL);
+  vkDestroyDescriptorSetLayout(device, r->common_texture_descriptor_set_layout,
+                               NULL);
+  vkDestroyDescriptorSetLayout(device, r->common_uniform_descriptor_set_layout,
+                               NULL);
+}
+
+static int owl_renderer_init_graphics_pipelines(struct owl_renderer *r) {
+  int32_t i;
+  VkVertexInputBindingDescription vertex_bindings[2];
+  VkVertexInputAttributeDescription vertex_attributes[11];
+  VkPipelineVertexInputStateCreateInfo vertex_input;
+  VkPipelineInputAssemblyStateCreateInfo input_assembly;
+  VkPipelineViewportStateCreateInfo viewport_state;
+  VkPipelineRasterizationStateCreateInfo rasterization;
+  VkPipelineMultisampleStateCreateInfo multisample;
+  VkPipelineColorBlendAttachmentState color_attachment;
+  VkPipelineColorBlendStateCreateInfo color;
+  VkPipelineDepthStencilStateCreateInfo depth;
+  VkDynamicState dynamic[2];
+  VkPipelineDynamicStateCreateInfo dynamic_state;
+  VkPipelineShaderStageCreateInfo stages[2];
+  VkGraphicsPipelineCreateInfo info;
+  int ret;
+  VkResult vk_result;
+  VkDevice const device = r->device;
+
+  ret = owl_renderer_init_shaders(r);
+  if (ret)
+    return ret;
+
+  vertex_bindings[0].binding = 0;
+  vertex_bindings[0].stride = sizeof(struct owl_common_vertex);
+  vertex_bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+  vertex_attributes[0].binding = 0;
+  vertex_attributes[0].location = 0;
+  vertex_attributes[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+  vertex_attributes[0].offset = offsetof(struct owl_common_vertex, position);
+
+  vertex_attributes[1].binding = 0;
+  vertex_attributes[1].location = 1;
+  vertex_attributes[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+  vertex_attributes[1].offset = offsetof(struct owl_common_vertex, color);
+
+  vertex_attributes[2].binding = 0;
+  vertex_attributes[2].location = 2;
+  vertex_attributes[2].format = VK_FORMAT_R32G32_SFLOAT;
+  vertex_attributes[2].offset = offsetof(struct owl_common_vertex, uv);
+
+  vertex_input.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertex_input.pNext = NULL;
+  vertex_input.flags = 0;
+  vertex_input.vertexBindingDescriptionCount = 1;
+  vertex_input.pVertexBindingDescriptions = vertex_bindings;
+  vertex_input.vertexAttributeDescriptionCount = 3;
+  vertex_input.pVertexAttributeDescriptions = vertex_attributes;
+
+  input_assembly.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  input_assembly.pNext = NULL;
+  input_assembly.flags = 0;
+  input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  input_assembly.primitiveRestartEnable = VK_FALSE;
 
+  /* the viewport and scissor are dynamic so resizing doesn't need new
+   * pipelines, see owl_renderer_set_viewport */
   viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
   viewport_state.pNext = NULL;
   viewport_state.flags = 0;
   viewport_state.viewportCount = 1;
-  viewport_state.pViewports = &viewport;
+  viewport_state.pViewports = NULL;
   viewport_state.scissorCount = 1;
-  viewport_state.pScissors = &scissor;
+  viewport_state.pScissors = NULL;
+
+  dynamic[0] = VK_DYNAMIC_STATE_VIEWPORT;
+  dynamic[1] = VK_DYNAMIC_STATE_SCISSOR;
+
+  dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamic_state.pNext = NULL;
+  dynamic_state.flags = 0;
+  dynamic_state.dynamicStateCount = OWL_ARRAY_SIZE(dynamic);
+  dynamic_state.pDynamicStates = dynamic;
 
   rasterization.sType =
       VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -1740,22 +2797,22 @@ static int owl_renderer_init_graphics_pipelines(struct owl_renderer *r) {
   info.pMultisampleState = &multisample;
   info.pDepthStencilState = &depth;
   info.pColorBlendState = &color;
-  info.pDynamicState = NULL;
+  info.pDynamicState = &dynamic_state;
   info.layout = r->common_pipeline_layout;
   info.renderPass = r->main_render_pass;
   info.subpass = 0;
   info.basePipelineHandle = VK_NULL_HANDLE;
   info.basePipelineIndex = -1;
 
-  vk_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, NULL,
-                                        &r->basic_pipeline);
+  vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                        NULL, &r->basic_pipeline);
   if (vk_result)
     goto error_denit_shaders;
 
   rasterization.polygonMode = VK_POLYGON_MODE_LINE;
 
-  vk_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, NULL,
-                                        &r->wires_pipeline);
+  vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                        NULL, &r->wires_pipeline);
   if (vk_result)
     goto error_destroy_basic_pipeline;
 
@@ -1769,12 +2826,23 @@ static int owl_renderer_init_graphics_pipelines(struct owl_renderer *r) {
 
   stages[1].module = r->text_fragment_shader;
 
-  vk_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, NULL,
-                                        &r->text_pipeline);
+  vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                        NULL, &r->text_pipeline);
   if (vk_result)
     goto error_destroy_wires_pipeline;
 
-  vertex_bindings.stride = sizeof(struct owl_model_vertex);
+  r->text_sdf_pipeline = VK_NULL_HANDLE;
+
+  if (r->text_sdf_fragment_shader) {
+    stages[1].module = r->text_sdf_fragment_shader;
+
+    vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                          NULL, &r->text_sdf_pipeline);
+    if (vk_result)
+      goto error_destroy_text_pipeline;
+  }
+
+  vertex_bindings[0].stride = sizeof(struct owl_model_vertex);
 
   vertex_attributes[0].binding = 0;
   vertex_attributes[0].location = 0;
@@ -1783,32 +2851,32 @@ static int owl_renderer_init_graphics_pipelines(struct owl_renderer *r) {
 
   vertex_attributes[1].binding = 0;
   vertex_attributes[1].location = 1;
-  vertex_attributes[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+  vertex_attributes[1].format = VK_FORMAT_R16G16_SNORM;
   vertex_attributes[1].offset = offsetof(struct owl_model_vertex, normal);
 
   vertex_attributes[2].binding = 0;
   vertex_attributes[2].location = 2;
-  vertex_attributes[2].format = VK_FORMAT_R32G32_SFLOAT;
+  vertex_attributes[2].format = VK_FORMAT_R16G16_SFLOAT;
   vertex_attributes[2].offset = offsetof(struct owl_model_vertex, uv0);
 
   vertex_attributes[3].binding = 0;
   vertex_attributes[3].location = 3;
-  vertex_attributes[3].format = VK_FORMAT_R32G32_SFLOAT;
+  vertex_attributes[3].format = VK_FORMAT_R16G16_SFLOAT;
   vertex_attributes[3].offset = offsetof(struct owl_model_vertex, uv1);
 
   vertex_attributes[4].binding = 0;
   vertex_attributes[4].location = 4;
-  vertex_attributes[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+  vertex_attributes[4].format = VK_FORMAT_R8G8B8A8_UINT;
   vertex_attributes[4].offset = offsetof(struct owl_model_vertex, joints0);
 
   vertex_attributes[5].binding = 0;
   vertex_attributes[5].location = 5;
-  vertex_attributes[5].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+  vertex_attributes[5].format = VK_FORMAT_R8G8B8A8_UNORM;
   vertex_attributes[5].offset = offsetof(struct owl_model_vertex, weights0);
 
   vertex_attributes[6].binding = 0;
   vertex_attributes[6].location = 6;
-  vertex_attributes[6].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+  vertex_attributes[6].format = VK_FORMAT_R8G8B8A8_UNORM;
   vertex_attributes[6].offset = offsetof(struct owl_model_vertex, color0);
 
   vertex_input.vertexAttributeDescriptionCount = 7;
@@ -1824,12 +2892,128 @@ static int owl_renderer_init_graphics_pipelines(struct owl_renderer *r) {
 
   info.layout = r->model_pipeline_layout;
 
-  vk_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, NULL,
-                                        &r->model_pipeline);
+  vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                        NULL, &r->model_pipeline);
   if (vk_result)
-    goto error_destroy_text_pipeline;
+    goto error_destroy_text_sdf_pipeline;
+
+  r->model_bindless_pipeline = VK_NULL_HANDLE;
+
+  if (r->bindless_supported) {
+    stages[1].module = r->model_bindless_fragment_shader;
+
+    info.layout = r->model_bindless_pipeline_layout;
+
+    vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                          NULL, &r->model_bindless_pipeline);
+    if (vk_result)
+      goto error_destroy_model_pipeline;
+  }
+
+  r->model_instanced_pipeline = VK_NULL_HANDLE;
+
+  if (r->model_instanced_vertex_shader) {
+    /* a model matrix per instance, one vec4 column per location */
+    vertex_bindings[1].binding = 1;
+    vertex_bindings[1].stride = sizeof(owl_m4);
+    vertex_bindings[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    for (i = 0; i < 4; ++i) {
+      vertex_attributes[7 + i].binding = 1;
+      vertex_attributes[7 + i].location = 7 + i;
+      vertex_attributes[7 + i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+      vertex_attributes[7 + i].offset = i * sizeof(owl_v4);
+    }
+
+    vertex_input.vertexBindingDescriptionCount = 2;
+    vertex_input.vertexAttributeDescriptionCount = 11;
+
+    stages[0].module = r->model_instanced_vertex_shader;
+
+    if (r->bindless_supported) {
+      stages[1].module = r->model_bindless_fragment_shader;
+      info.layout = r->model_bindless_pipeline_layout;
+    } else {
+      stages[1].module = r->model_fragment_shader;
+      info.layout = r->model_pipeline_layout;
+    }
 
-  vertex_bindings.stride = sizeof(struct owl_skybox_vertex);
+    vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                          NULL, &r->model_instanced_pipeline);
+    if (vk_result)
+      goto error_destroy_model_bindless_pipeline;
+
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.vertexAttributeDescriptionCount = 7;
+  }
+
+  r->model_indirect_pipeline = VK_NULL_HANDLE;
+  r->cull_pipeline = VK_NULL_HANDLE;
+  r->depth_pyramid_pipeline = VK_NULL_HANDLE;
+
+  if (r->gpu_culling_supported) {
+    stages[0].module = r->model_indirect_vertex_shader;
+    stages[1].module = r->model_indirect_fragment_shader;
+
+    info.layout = r->model_indirect_pipeline_layout;
+
+    vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                          NULL, &r->model_indirect_pipeline);
+    if (vk_result)
+      goto error_destroy_model_instanced_pipeline;
+  }
+
+  if (r->gpu_culling_supported) {
+    VkComputePipelineCreateInfo compute_info;
+
+    compute_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    compute_info.pNext = NULL;
+    compute_info.flags = 0;
+    compute_info.stage.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    compute_info.stage.pNext = NULL;
+    compute_info.stage.flags = 0;
+    compute_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    compute_info.stage.module = r->cull_compute_shader;
+    compute_info.stage.pName = "main";
+    compute_info.stage.pSpecializationInfo = NULL;
+    compute_info.layout = r->cull_pipeline_layout;
+    compute_info.basePipelineHandle = VK_NULL_HANDLE;
+    compute_info.basePipelineIndex = -1;
+
+    vk_result = vkCreateComputePipelines(device, r->pipeline_cache, 1,
+                                         &compute_info, NULL,
+                                         &r->cull_pipeline);
+    if (vk_result)
+      goto error_destroy_model_indirect_pipeline;
+  }
+
+  if (r->gpu_culling_supported) {
+    VkComputePipelineCreateInfo compute_info;
+
+    compute_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    compute_info.pNext = NULL;
+    compute_info.flags = 0;
+    compute_info.stage.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    compute_info.stage.pNext = NULL;
+    compute_info.stage.flags = 0;
+    compute_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    compute_info.stage.module = r->depth_pyramid_compute_shader;
+    compute_info.stage.pName = "main";
+    compute_info.stage.pSpecializationInfo = NULL;
+    compute_info.layout = r->depth_pyramid_pipeline_layout;
+    compute_info.basePipelineHandle = VK_NULL_HANDLE;
+    compute_info.basePipelineIndex = -1;
+
+    vk_result = vkCreateComputePipelines(device, r->pipeline_cache, 1,
+                                         &compute_info, NULL,
+                                         &r->depth_pyramid_pipeline);
+    if (vk_result)
+      goto error_destroy_cull_pipeline;
+  }
+
+  vertex_bindings[0].stride = sizeof(struct owl_skybox_vertex);
 
   vertex_attributes[0].binding = 0;
   vertex_attributes[0].location = 0;
@@ -1846,19 +3030,37 @@ static int owl_renderer_init_graphics_pipelines(struct owl_renderer *r) {
 
   info.layout = r->common_pipeline_layout;
 
-  vk_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, NULL,
-                                        &r->skybox_pipeline);
+  vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                        NULL, &r->skybox_pipeline);
 
   if (vk_result)
-    goto error_destroy_model_pipeline;
+    goto error_destroy_depth_pyramid_pipeline;
 
   owl_renderer_deinit_shaders(r);
 
   return OWL_OK;
 
+error_destroy_depth_pyramid_pipeline:
+  vkDestroyPipeline(device, r->depth_pyramid_pipeline, NULL);
+
+error_destroy_cull_pipeline:
+  vkDestroyPipeline(device, r->cull_pipeline, NULL);
+
+error_destroy_model_indirect_pipeline:
+  vkDestroyPipeline(device, r->model_indirect_pipeline, NULL);
+
+error_destroy_model_instanced_pipeline:
+  vkDestroyPipeline(device, r->model_instanced_pipeline, NULL);
+
+error_destroy_model_bindless_pipeline:
+  vkDestroyPipeline(device, r->model_bindless_pipeline, NULL);
+
 error_destroy_model_pipeline:
   vkDestroyPipeline(device, r->model_pipeline, NULL);
 
+error_destroy_text_sdf_pipeline:
+  vkDestroyPipeline(device, r->text_sdf_pipeline, NULL);
+
 error_destroy_text_pipeline:
   vkDestroyPipeline(device, r->text_pipeline, NULL);
 
@@ -1877,2830 +3079,4671 @@ error_denit_shaders:
 static void owl_renderer_deinit_graphics_pipelines(struct owl_renderer *r) {
   VkDevice const device = r->device;
   vkDestroyPipeline(device, r->skybox_pipeline, NULL);
+  vkDestroyPipeline(device, r->depth_pyramid_pipeline, NULL);
+  vkDestroyPipeline(device, r->cull_pipeline, NULL);
+  vkDestroyPipeline(device, r->model_indirect_pipeline, NULL);
+  vkDestroyPipeline(device, r->model_instanced_pipeline, NULL);
+  vkDestroyPipeline(device, r->model_bindless_pipeline, NULL);
   vkDestroyPipeline(device, r->model_pipeline, NULL);
+  vkDestroyPipeline(device, r->text_sdf_pipeline, NULL);
   vkDestroyPipeline(device, r->text_pipeline, NULL);
   vkDestroyPipeline(device, r->wires_pipeline, NULL);
   vkDestroyPipeline(device, r->basic_pipeline, NULL);
 }
 
-static int owl_renderer_init_upload_buffer(struct owl_renderer *r) {
-  r->upload_buffer_in_use = 0;
-  return OWL_OK;
-}
-
-static void owl_renderer_deinit_upload_buffer(struct owl_renderer *r) {
-  VkDevice const device = r->device;
-
-  if (r->upload_buffer_in_use) { /* someone forgot to call free */
-    vkFreeMemory(device, r->upload_buffer_memory, NULL);
-    vkDestroyBuffer(device, r->upload_buffer, NULL);
-  }
-}
-
-static int owl_renderer_init_garbage(struct owl_renderer *r) {
-  uint32_t i;
-
-  r->garbage = 0;
-
-  for (i = 0; i < OWL_NUM_GARBAGE_FRAMES; ++i) {
-    r->num_garbage_buffers[i] = 0;
-    r->num_garbage_memories[i] = 0;
-    r->num_garbage_descriptor_sets[i] = 0;
-  }
-
-  return OWL_OK;
-}
-
-static void owl_renderer_collect_garbage(struct owl_renderer *r) {
-  uint32_t i;
-  uint32_t const garbage_frames = OWL_NUM_GARBAGE_FRAMES;
-  /* use the _oldest_ garbage frame to collect */
-  uint32_t const collect = (r->garbage + 2) % garbage_frames;
+static int owl_renderer_init_staging(struct owl_renderer *r, uint64_t size,
+                                     VkBuffer *buffer, VkDeviceMemory *memory,
+                                     void **data) {
+  VkResult vk_result;
   VkDevice const device = r->device;
 
-  /* update the garbage index */
-  r->garbage = (r->garbage + 1) % garbage_frames;
-
-  if (r->num_garbage_descriptor_sets[collect]) {
-    vkFreeDescriptorSets(device, r->descriptor_pool,
-                         r->num_garbage_descriptor_sets[collect],
-                         r->garbage_descriptor_sets[collect]);
-  }
-
-  r->num_garbage_descriptor_sets[collect] = 0;
-
-  for (i = 0; i < r->num_garbage_memories[collect]; ++i) {
-    VkDeviceMemory memory = r->garbage_memories[collect][i];
-    vkFreeMemory(device, memory, NULL);
-  }
-
-  r->num_garbage_memories[collect] = 0;
-
-  for (i = 0; i < r->num_garbage_buffers[collect]; ++i) {
-    VkBuffer buffer = r->garbage_buffers[collect][i];
-    vkDestroyBuffer(device, buffer, NULL);
-  }
-
-  r->num_garbage_buffers[collect] = 0;
-}
-
-static void owl_renderer_deinit_garbage(struct owl_renderer *r) {
-  r->garbage = 0;
-  for (; r->garbage < OWL_NUM_GARBAGE_FRAMES; ++r->garbage)
-    owl_renderer_collect_garbage(r);
-}
-
-static int owl_renderer_garbage_push_vertex(struct owl_renderer *r) {
-  uint32_t i;
-  uint32_t const capacity = OWL_ARRAY_SIZE(r->garbage_buffers[0]);
-  uint32_t const garbage = r->garbage;
-  uint32_t const num_buffers = r->num_garbage_buffers[garbage];
-  uint32_t const num_memories = r->num_garbage_memories[garbage];
-
-  if (capacity <= num_buffers + r->num_frames)
-    return OWL_ERROR_NO_SPACE;
-
-  if (capacity <= num_memories + 1)
-    return OWL_ERROR_NO_SPACE;
-
-  for (i = 0; i < r->num_frames; ++i) {
-    VkBuffer buffer = r->vertex_buffers[i];
-    r->garbage_buffers[garbage][num_buffers + i] = buffer;
-  }
-
-  r->num_garbage_buffers[garbage] += r->num_frames;
-
-  {
-    VkDeviceMemory memory = r->vertex_buffer_memory;
-    r->garbage_memories[garbage][num_memories] = memory;
-  }
-
-  r->num_garbage_memories[garbage] += 1;
-
-  return OWL_OK;
-}
-
-static int owl_renderer_garbage_push_index(struct owl_renderer *r) {
-  uint32_t i;
-  uint32_t const capacity = OWL_ARRAY_SIZE(r->garbage_buffers[0]);
-  uint32_t const garbage = r->garbage;
-  uint32_t const num_buffers = r->num_garbage_buffers[garbage];
-  uint32_t const num_memories = r->num_garbage_memories[garbage];
-
-  if (capacity <= num_buffers + r->num_frames)
-    return OWL_ERROR_NO_SPACE;
-
-  if (capacity <= num_memories + 1)
-    return OWL_ERROR_NO_SPACE;
-
-  for (i = 0; i < r->num_frames; ++i) {
-    VkBuffer buffer = r->index_buffers[i];
-    r->garbage_buffers[garbage][num_buffers + i] = buffer;
-  }
-
-  r->num_garbage_buffers[garbage] += r->num_frames;
-
-  {
-    VkDeviceMemory memory = r->index_buffer_memory;
-    r->garbage_memories[garbage][num_memories] = memory;
-  }
-
-  r->num_garbage_memories[garbage] += 1;
-
-  return OWL_OK;
-}
-
-static int owl_renderer_garbage_push_uniform(struct owl_renderer *r) {
-  uint32_t i;
-  uint32_t const capacity = OWL_ARRAY_SIZE(r->garbage_buffers[0]);
-  uint32_t const garbage = r->garbage;
-  uint32_t const num_buffers = r->num_garbage_buffers[garbage];
-  uint32_t const num_memories = r->num_garbage_memories[garbage];
-  uint32_t num_descriptor_sets = r->num_garbage_descriptor_sets[garbage];
-
-  if (capacity <= num_buffers + r->num_frames)
-    return OWL_ERROR_NO_SPACE;
-
-  if (capacity <= num_memories + 1)
-    return OWL_ERROR_NO_SPACE;
-
-  if (capacity <= num_descriptor_sets + r->num_frames * 3)
-    return OWL_ERROR_NO_SPACE;
-
-  for (i = 0; i < r->num_frames; ++i) {
-    VkBuffer buffer = r->uniform_buffers[i];
-    r->garbage_buffers[garbage][num_buffers + i] = buffer;
-  }
-  r->num_garbage_buffers[garbage] += r->num_frames;
-
   {
-    VkDeviceMemory memory = r->uniform_buffer_memory;
-    r->garbage_memories[garbage][num_memories] = memory;
-  }
-  r->num_garbage_memories[garbage] += 1;
-
-  for (i = 0; i < r->num_frames; ++i) {
-    uint32_t const count = num_descriptor_sets;
-    VkDescriptorSet descriptor_set;
-
-    descriptor_set = r->uniform_pvm_descriptor_sets[i];
-    r->garbage_descriptor_sets[garbage][count + i] = descriptor_set;
-  }
-  num_descriptor_sets += r->num_frames;
-
-  for (i = 0; i < OWL_NUM_IN_FLIGHT_FRAMES; ++i) {
-    uint32_t const count = num_descriptor_sets;
-    VkDescriptorSet descriptor_set;
-
-    descriptor_set = r->uniform_model_descriptor_sets[i];
-    r->garbage_descriptor_sets[garbage][count + i] = descriptor_set;
-  }
-  num_descriptor_sets += r->num_frames;
-  r->num_garbage_descriptor_sets[garbage] = num_descriptor_sets;
-
-  return OWL_OK;
-}
-
-static int owl_renderer_init_vertex_buffer(struct owl_renderer *r,
-                                           uint64_t size) {
-  int32_t i;
-
-  VkDevice const device = r->device;
-
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
     VkBufferCreateInfo info;
-    VkResult vk_result = VK_SUCCESS;
 
     info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     info.pNext = NULL;
     info.flags = 0;
     info.size = size;
-    info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     info.queueFamilyIndexCount = 0;
     info.pQueueFamilyIndices = NULL;
 
-    vk_result = vkCreateBuffer(device, &info, NULL, &r->vertex_buffers[i]);
+    vk_result = vkCreateBuffer(device, &info, NULL, buffer);
     if (vk_result)
-      goto error_destroy_buffers;
+      goto error;
   }
 
   {
-    uint32_t j;
-    VkDeviceSize aligned_size;
     VkMemoryPropertyFlagBits properties;
-    VkMemoryAllocateInfo info;
     VkMemoryRequirements requirements;
-    VkResult vk_result = VK_SUCCESS;
+    VkMemoryAllocateInfo info;
 
     properties = 0;
     properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
     properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    vkGetBufferMemoryRequirements(device, r->vertex_buffers[0], &requirements);
-
-    r->vertex_buffer_alignment = requirements.alignment;
-    aligned_size = OWL_ALIGN_UP_2(size, requirements.alignment);
-    r->vertex_buffer_aligned_size = aligned_size;
+    vkGetBufferMemoryRequirements(device, *buffer, &requirements);
 
     info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     info.pNext = NULL;
-    info.allocationSize = aligned_size * r->num_frames;
+    info.allocationSize = requirements.size;
     info.memoryTypeIndex = owl_renderer_find_memory_type(
         r, requirements.memoryTypeBits, properties);
 
-    vk_result = vkAllocateMemory(device, &info, NULL, &r->vertex_buffer_memory);
+    vk_result = vkAllocateMemory(device, &info, NULL, memory);
     if (vk_result)
-      goto error_destroy_buffers;
+      goto error_destroy_buffer;
 
-    for (j = 0; j < r->num_frames; ++j) {
-      VkDeviceMemory memory = r->vertex_buffer_memory;
-      VkBuffer buffer = r->vertex_buffers[j];
-      vk_result = vkBindBufferMemory(device, buffer, memory, aligned_size * j);
-      if (vk_result)
-        goto error_free_memory;
-    }
+    vk_result = vkBindBufferMemory(device, *buffer, *memory, 0);
+    if (vk_result)
+      goto error_free_memory;
 
-    vk_result = vkMapMemory(device, r->vertex_buffer_memory, 0, size, 0,
-                            &r->vertex_buffer_data);
+    vk_result = vkMapMemory(device, *memory, 0, size, 0, data);
     if (vk_result)
       goto error_free_memory;
   }
 
-  r->vertex_buffer_last_offset = 0;
-  r->vertex_buffer_offset = 0;
-  r->vertex_buffer_size = size;
-
   return OWL_OK;
 
 error_free_memory:
-  vkFreeMemory(device, r->vertex_buffer_memory, NULL);
+  vkFreeMemory(device, *memory, NULL);
 
-  i = r->num_frames;
+error_destroy_buffer:
+  vkDestroyBuffer(device, *buffer, NULL);
 
-error_destroy_buffers:
-  for (i = i - 1; i >= 0; --i)
-    vkDestroyBuffer(device, r->vertex_buffers[i], NULL);
+error:
+  return OWL_ERROR_NO_UPLOAD_MEMORY;
+}
 
-  return OWL_ERROR_FATAL;
+static int owl_renderer_init_upload_buffer(struct owl_renderer *r) {
+  int ret;
+  void *data;
+
+  ret = owl_renderer_init_staging(r, OWL_UPLOAD_BUFFER_SIZE, &r->upload_buffer,
+                                  &r->upload_buffer_memory, &data);
+  if (ret)
+    return ret;
+
+  r->upload_buffer_data = data;
+  r->upload_buffer_size = OWL_UPLOAD_BUFFER_SIZE;
+  r->upload_buffer_head = 0;
+  r->first_upload = 0;
+  r->num_uploads = 0;
+
+  return OWL_OK;
 }
 
-static void owl_renderer_deinit_vertex_buffer(struct owl_renderer *r) {
+static void owl_renderer_deinit_upload_buffer(struct owl_renderer *r) {
   uint32_t i;
   VkDevice const device = r->device;
 
-  vkFreeMemory(device, r->vertex_buffer_memory, NULL);
+  for (i = 0; i < r->num_uploads; ++i) {
+    uint32_t const id = (r->first_upload + i) % OWL_MAX_UPLOADS;
+    struct owl_renderer_upload *upload = &r->uploads[id];
 
-  for (i = 0; i < r->num_frames; ++i)
-    vkDestroyBuffer(device, r->vertex_buffers[i], NULL);
+    /* someone forgot to call free */
+    if (!upload->released && upload->buffer) {
+      vkFreeMemory(device, upload->memory, NULL);
+      vkDestroyBuffer(device, upload->buffer, NULL);
+    }
+  }
+
+  vkFreeMemory(device, r->upload_buffer_memory, NULL);
+  vkDestroyBuffer(device, r->upload_buffer, NULL);
 }
 
-static int owl_renderer_init_index_buffer(struct owl_renderer *r,
-                                          uint64_t size) {
+static int owl_renderer_init_async_uploads(struct owl_renderer *r) {
   int32_t i;
   VkDevice const device = r->device;
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    VkBufferCreateInfo info;
+  r->async_upload = NULL;
+  r->async_command_buffer = VK_NULL_HANDLE;
+  r->async_upload_ticket = 0;
+  r->async_upload_done_ticket = 0;
+
+  {
+    VkCommandPoolCreateInfo info;
     VkResult vk_result = VK_SUCCESS;
 
-    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     info.pNext = NULL;
     info.flags = 0;
-    info.size = size;
-    info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    info.queueFamilyIndexCount = 0;
-    info.pQueueFamilyIndices = NULL;
+    info.flags |= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    info.flags |= VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    info.queueFamilyIndex = r->transfer_family;
 
-    vk_result = vkCreateBuffer(device, &info, NULL, &r->index_buffers[i]);
+    vk_result =
+        vkCreateCommandPool(device, &info, NULL, &r->async_command_pool);
     if (vk_result)
-      goto error_destroy_buffers;
+      goto error;
   }
 
-  {
-    uint32_t j;
-    VkDeviceSize aligned_size;
-    VkMemoryPropertyFlagBits properties;
-    VkMemoryAllocateInfo info;
-    VkMemoryRequirements requirements;
+  for (i = 0; i < OWL_MAX_ASYNC_UPLOADS; ++i) {
+    VkCommandBufferAllocateInfo info;
     VkResult vk_result = VK_SUCCESS;
+    struct owl_renderer_async_upload *upload = &r->async_uploads[i];
 
-    properties = 0;
-    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-    vkGetBufferMemoryRequirements(device, r->index_buffers[0], &requirements);
-
-    r->index_buffer_alignment = requirements.alignment;
-    aligned_size = OWL_ALIGN_UP_2(size, requirements.alignment);
-    r->index_buffer_aligned_size = aligned_size;
+    upload->state = OWL_RENDERER_ASYNC_UPLOAD_STATE_FREE;
+    upload->ticket = 0;
+    upload->staging_data = NULL;
+    upload->num_buffer_barriers = 0;
+    upload->num_image_barriers = 0;
 
-    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     info.pNext = NULL;
-    info.allocationSize = aligned_size * r->num_frames;
-    info.memoryTypeIndex = owl_renderer_find_memory_type(
-        r, requirements.memoryTypeBits, properties);
+    info.commandPool = r->async_command_pool;
+    info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    info.commandBufferCount = 1;
 
-    vk_result = vkAllocateMemory(device, &info, NULL, &r->index_buffer_memory);
+    vk_result =
+        vkAllocateCommandBuffers(device, &info, &upload->command_buffer);
     if (vk_result)
-      goto error_destroy_buffers;
+      goto error_free_command_buffers;
+  }
 
-    for (j = 0; j < r->num_frames; ++j) {
-      VkDeviceMemory memory = r->index_buffer_memory;
-      VkBuffer buffer = r->index_buffers[j];
-      vk_result = vkBindBufferMemory(device, buffer, memory, aligned_size * j);
-      if (vk_result)
-        goto error_free_memory;
-    }
+  for (i = 0; i < OWL_MAX_ASYNC_UPLOADS; ++i) {
+    VkFenceCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
 
-    vk_result = vkMapMemory(device, r->index_buffer_memory, 0, size, 0,
-                            &r->index_buffer_data);
+    vk_result = vkCreateFence(device, &info, NULL, &r->async_uploads[i].fence);
     if (vk_result)
-      goto error_free_memory;
+      goto error_destroy_fences;
   }
 
-  r->index_buffer_last_offset = 0;
-  r->index_buffer_offset = 0;
-  r->index_buffer_size = size;
-
   return OWL_OK;
 
-error_free_memory:
-  vkFreeMemory(device, r->index_buffer_memory, NULL);
+error_destroy_fences:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyFence(device, r->async_uploads[i].fence, NULL);
 
-  i = r->num_frames;
+  i = OWL_MAX_ASYNC_UPLOADS;
 
-error_destroy_buffers:
+error_free_command_buffers:
   for (i = i - 1; i >= 0; --i)
-    vkDestroyBuffer(device, r->index_buffers[i], NULL);
+    vkFreeCommandBuffers(device, r->async_command_pool, 1,
+                         &r->async_uploads[i].command_buffer);
+
+  vkDestroyCommandPool(device, r->async_command_pool, NULL);
 
+error:
   return OWL_ERROR_FATAL;
 }
 
-static void owl_renderer_deinit_index_buffer(struct owl_renderer *r) {
-  uint32_t i;
+static void owl_renderer_deinit_async_uploads(struct owl_renderer *r) {
+  int32_t i;
   VkDevice const device = r->device;
 
-  vkFreeMemory(device, r->index_buffer_memory, NULL);
+  for (i = 0; i < OWL_MAX_ASYNC_UPLOADS; ++i) {
+    struct owl_renderer_async_upload *upload = &r->async_uploads[i];
 
-  for (i = 0; i < r->num_frames; ++i)
-    vkDestroyBuffer(device, r->index_buffers[i], NULL);
+    /* never acquired, the device is idle so the staging memory can go */
+    if (upload->staging_data) {
+      owl_renderer_upload_free(r, upload->staging_data);
+      upload->staging_data = NULL;
+    }
+
+    vkDestroyFence(device, upload->fence, NULL);
+    vkFreeCommandBuffers(device, r->async_command_pool, 1,
+                         &upload->command_buffer);
+  }
+
+  vkDestroyCommandPool(device, r->async_command_pool, NULL);
 }
 
-static int owl_renderer_init_uniform_buffer(struct owl_renderer *r,
-                                            uint64_t size) {
+/* the graphics stages that read what the uploads write */
+#define OWL_RENDERER_ASYNC_UPLOAD_DST_STAGES                                   \
+  (VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |  \
+   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+
+static struct owl_renderer_async_upload *
+owl_renderer_find_async_upload(struct owl_renderer *r, uint64_t ticket) {
   int32_t i;
-  VkDevice const device = r->device;
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    VkBufferCreateInfo info;
-    VkResult vk_result = VK_SUCCESS;
+  for (i = 0; i < OWL_MAX_ASYNC_UPLOADS; ++i) {
+    struct owl_renderer_async_upload *upload = &r->async_uploads[i];
 
-    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.size = size;
-    info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    info.queueFamilyIndexCount = 0;
-    info.pQueueFamilyIndices = NULL;
+    if (OWL_RENDERER_ASYNC_UPLOAD_STATE_SUBMITTED != upload->state)
+      continue;
 
-    vk_result = vkCreateBuffer(device, &info, NULL, &r->uniform_buffers[i]);
-    if (vk_result)
-      goto error_destroy_buffers;
+    if (ticket == upload->ticket)
+      return upload;
   }
 
-  {
-    uint32_t j;
-    VkDeviceSize aligned_size;
-    VkMemoryPropertyFlagBits properties;
-    VkMemoryAllocateInfo info;
-    VkMemoryRequirements requirements;
-    VkResult vk_result = VK_SUCCESS;
-
-    properties = 0;
-    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  return NULL;
+}
 
-    vkGetBufferMemoryRequirements(device, r->uniform_buffers[0], &requirements);
+/*
+ * the transfer fence was observed signaled by the host, so anything
+ * submitted to the graphics queue afterwards already comes after the copies.
+ * only the acquire half of the ownership transfer is left to record.
+ */
+static int
+owl_renderer_acquire_async_upload(struct owl_renderer *r,
+                                  struct owl_renderer_async_upload *upload,
+                                  VkCommandBuffer command_buffer) {
+  VkResult vk_result;
+  VkDevice const device = r->device;
 
-    r->uniform_buffer_alignment = requirements.alignment;
-    aligned_size = OWL_ALIGN_UP_2(size, requirements.alignment);
-    r->uniform_buffer_aligned_size = aligned_size;
+  if (upload->num_buffer_barriers || upload->num_image_barriers)
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         OWL_RENDERER_ASYNC_UPLOAD_DST_STAGES, 0, 0, NULL,
+                         upload->num_buffer_barriers, upload->buffer_barriers,
+                         upload->num_image_barriers, upload->image_barriers);
 
-    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.allocationSize = aligned_size * r->num_frames;
-    info.memoryTypeIndex = owl_renderer_find_memory_type(
-        r, requirements.memoryTypeBits, properties);
+  if (upload->staging_data) {
+    owl_renderer_upload_free(r, upload->staging_data);
+    upload->staging_data = NULL;
+  }
 
-    vk_result =
-        vkAllocateMemory(device, &info, NULL, &r->uniform_buffer_memory);
-    if (vk_result)
-      goto error_destroy_buffers;
+  upload->state = OWL_RENDERER_ASYNC_UPLOAD_STATE_FREE;
+  r->async_upload_done_ticket = upload->ticket;
 
-    for (j = 0; j < r->num_frames; ++j) {
-      VkDeviceMemory memory = r->uniform_buffer_memory;
-      VkBuffer buffer = r->uniform_buffers[j];
-      vk_result = vkBindBufferMemory(device, buffer, memory, aligned_size * j);
-      if (vk_result)
-        goto error_free_memory;
-    }
+  vk_result = vkResetFences(device, 1, &upload->fence);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
 
-    vk_result = vkMapMemory(device, r->uniform_buffer_memory, 0, size, 0,
-                            &r->uniform_buffer_data);
-    if (vk_result)
-      goto error_free_memory;
-  }
+  return OWL_OK;
+}
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    {
-      VkDescriptorSetLayout layouts[2];
-      VkDescriptorSet descriptor_sets[2];
-      VkDescriptorSetAllocateInfo info;
-      VkResult vk_result = VK_SUCCESS;
+/* waits for the oldest upload that still holds staging memory and gives the
+ * memory back, the acquire barriers are left for the next frame */
+static int owl_renderer_reclaim_async_staging(struct owl_renderer *r) {
+  uint64_t ticket;
 
-      layouts[0] = r->common_uniform_descriptor_set_layout;
-      layouts[1] = r->model_uniform_descriptor_set_layout;
+  for (ticket = r->async_upload_done_ticket + 1;
+       ticket <= r->async_upload_ticket; ++ticket) {
+    VkResult vk_result;
+    uint64_t const timeout = (uint64_t)-1;
+    struct owl_renderer_async_upload *upload;
 
-      info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-      info.pNext = NULL;
-      info.descriptorPool = r->descriptor_pool;
-      info.descriptorSetCount = OWL_ARRAY_SIZE(layouts);
-      info.pSetLayouts = layouts;
+    upload = owl_renderer_find_async_upload(r, ticket);
+    if (!upload || !upload->staging_data)
+      continue;
 
-      vk_result = vkAllocateDescriptorSets(device, &info, descriptor_sets);
-      if (vk_result)
-        goto error_free_descriptor_sets;
+    vk_result = vkWaitForFences(r->device, 1, &upload->fence, VK_TRUE, timeout);
+    if (vk_result)
+      return 0;
 
-      r->uniform_pvm_descriptor_sets[i] = descriptor_sets[0];
-      r->uniform_model_descriptor_sets[i] = descriptor_sets[1];
-    }
+    owl_renderer_upload_free(r, upload->staging_data);
+    upload->staging_data = NULL;
 
-    {
-      VkDescriptorBufferInfo descriptors[2];
-      VkWriteDescriptorSet writes[2];
-
-      descriptors[0].buffer = r->uniform_buffers[i];
-      descriptors[0].offset = 0;
-      descriptors[0].range = sizeof(struct owl_common_uniform);
-
-      writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-      writes[0].pNext = NULL;
-      writes[0].dstSet = r->uniform_pvm_descriptor_sets[i];
-      writes[0].dstBinding = 0;
-      writes[0].dstArrayElement = 0;
-      writes[0].descriptorCount = 1;
-      writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-      writes[0].pImageInfo = NULL;
-      writes[0].pBufferInfo = &descriptors[0];
-      writes[0].pTexelBufferView = NULL;
-
-      descriptors[1].buffer = r->uniform_buffers[i];
-      descriptors[1].offset = 0;
-      descriptors[1].range = sizeof(struct owl_model_uniform);
-
-      writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-      writes[1].pNext = NULL;
-      writes[1].dstSet = r->uniform_model_descriptor_sets[i];
-      writes[1].dstBinding = 0;
-      writes[1].dstArrayElement = 0;
-      writes[1].descriptorCount = 1;
-      writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-      writes[1].pImageInfo = NULL;
-      writes[1].pBufferInfo = &descriptors[1];
-      writes[1].pTexelBufferView = NULL;
-
-      vkUpdateDescriptorSets(device, OWL_ARRAY_SIZE(writes), writes, 0, NULL);
-    }
+    return 1;
   }
 
-  r->uniform_buffer_last_offset = 0;
-  r->uniform_buffer_offset = 0;
-  r->uniform_buffer_size = size;
+  return 0;
+}
+
+static int owl_renderer_poll_async_uploads(struct owl_renderer *r,
+                                           VkCommandBuffer command_buffer) {
+  int ret = OWL_OK;
 
-  return OWL_OK;
+  while (!ret) {
+    uint64_t const ticket = r->async_upload_done_ticket + 1;
+    struct owl_renderer_async_upload *upload;
 
-error_free_descriptor_sets:
-  for (i = i - 1; i >= 0; --i) {
-    VkDescriptorSet descriptor_sets[3];
+    upload = owl_renderer_find_async_upload(r, ticket);
+    if (!upload)
+      break;
 
-    descriptor_sets[0] = r->uniform_pvm_descriptor_sets[i];
-    descriptor_sets[1] = r->uniform_model_descriptor_sets[i];
+    /* the transfer queue finishes in submission order */
+    if (VK_SUCCESS != vkGetFenceStatus(r->device, upload->fence))
+      break;
 
-    vkFreeDescriptorSets(device, r->descriptor_pool,
-                         OWL_ARRAY_SIZE(descriptor_sets), descriptor_sets);
+    ret = owl_renderer_acquire_async_upload(r, upload, command_buffer);
   }
 
-  i = r->num_frames;
+  return ret;
+}
 
-error_free_memory:
-  vkFreeMemory(device, r->uniform_buffer_memory, NULL);
+static int owl_renderer_init_garbage(struct owl_renderer *r) {
+  uint32_t i;
 
-  i = r->num_frames;
+  r->garbage = 0;
+  /* a frame's garbage is safe to free once the same frame slot comes back */
+  r->num_garbage_frames = r->num_frames + 1;
 
-error_destroy_buffers:
-  for (i = i - 1; i >= 0; --i)
-    vkDestroyBuffer(device, r->uniform_buffers[i], NULL);
+  for (i = 0; i < r->num_garbage_frames; ++i) {
+    r->num_garbage_buffers[i] = 0;
+    r->num_garbage_memories[i] = 0;
+    r->num_garbage_images[i] = 0;
+    r->num_garbage_image_views[i] = 0;
+    r->num_garbage_framebuffers[i] = 0;
+    r->num_garbage_swapchains[i] = 0;
+    r->num_garbage_bindless_textures[i] = 0;
+  }
 
-  return OWL_ERROR_FATAL;
+  return OWL_OK;
 }
 
-static void owl_renderer_deinit_uniform_buffer(struct owl_renderer *r) {
+static void owl_renderer_collect_garbage(struct owl_renderer *r) {
   uint32_t i;
+  uint32_t const garbage_frames = r->num_garbage_frames;
+  /* collect the garbage pushed num_frames frames ago, its fence was just
+   * waited on. with num_frames + 1 garbage frames that is always garbage + 2 */
+  uint32_t const collect = (r->garbage + 2) % garbage_frames;
   VkDevice const device = r->device;
 
-  for (i = 0; i < r->num_frames; ++i) {
-    VkDescriptorSet descriptor_sets[2];
-
-    descriptor_sets[0] = r->uniform_pvm_descriptor_sets[i];
-    descriptor_sets[1] = r->uniform_model_descriptor_sets[i];
+  /* update the garbage index */
+  r->garbage = (r->garbage + 1) % garbage_frames;
 
-    vkFreeDescriptorSets(device, r->descriptor_pool,
-                         OWL_ARRAY_SIZE(descriptor_sets), descriptor_sets);
+  for (i = 0; i < r->num_garbage_framebuffers[collect]; ++i) {
+    VkFramebuffer framebuffer = r->garbage_framebuffers[collect][i];
+    vkDestroyFramebuffer(device, framebuffer, NULL);
   }
 
-  vkFreeMemory(device, r->uniform_buffer_memory, NULL);
-
-  for (i = 0; i < r->num_frames; ++i)
-    vkDestroyBuffer(device, r->uniform_buffers[i], NULL);
-}
+  r->num_garbage_framebuffers[collect] = 0;
 
-static int owl_renderer_init_frames(struct owl_renderer *r) {
-  int32_t i;
-  VkDevice const device = r->device;
+  for (i = 0; i < r->num_garbage_image_views[collect]; ++i) {
+    VkImageView image_view = r->garbage_image_views[collect][i];
+    vkDestroyImageView(device, image_view, NULL);
+  }
 
-  r->frame = 0;
+  r->num_garbage_image_views[collect] = 0;
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    VkCommandPoolCreateInfo info;
-    VkResult vk_result = VK_SUCCESS;
+  for (i = 0; i < r->num_garbage_images[collect]; ++i) {
+    VkImage image = r->garbage_images[collect][i];
+    vkDestroyImage(device, image, NULL);
+  }
 
-    info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.queueFamilyIndex = r->graphics_family;
+  r->num_garbage_images[collect] = 0;
 
-    vk_result =
-        vkCreateCommandPool(device, &info, NULL, &r->submit_command_pools[i]);
-    if (vk_result)
-      goto error_destroy_submit_command_pools;
+  for (i = 0; i < r->num_garbage_swapchains[collect]; ++i) {
+    VkSwapchainKHR swapchain = r->garbage_swapchains[collect][i];
+    vkDestroySwapchainKHR(device, swapchain, NULL);
   }
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    VkCommandBufferAllocateInfo info;
-    VkResult vk_result = VK_SUCCESS;
-
-    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.commandPool = r->submit_command_pools[i];
-    info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    info.commandBufferCount = 1;
+  r->num_garbage_swapchains[collect] = 0;
 
-    vk_result =
-        vkAllocateCommandBuffers(device, &info, &r->submit_command_buffers[i]);
-    if (vk_result)
-      goto error_free_submit_command_buffers;
+  for (i = 0; i < r->num_garbage_memories[collect]; ++i) {
+    VkDeviceMemory memory = r->garbage_memories[collect][i];
+    vkFreeMemory(device, memory, NULL);
   }
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    VkFenceCreateInfo info;
-    VkResult vk_result = VK_SUCCESS;
+  r->num_garbage_memories[collect] = 0;
 
-    info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+  for (i = 0; i < r->num_garbage_buffers[collect]; ++i) {
+    VkBuffer buffer = r->garbage_buffers[collect][i];
+    vkDestroyBuffer(device, buffer, NULL);
+  }
 
-    vk_result = vkCreateFence(device, &info, NULL, &r->in_flight_fences[i]);
-    if (vk_result)
-      goto error_destroy_in_flight_fences;
+  r->num_garbage_buffers[collect] = 0;
+
+  for (i = 0; i < r->num_garbage_bindless_textures[collect]; ++i) {
+    uint32_t const index = r->garbage_bindless_textures[collect][i];
+    r->free_bindless_textures[r->num_free_bindless_textures++] = index;
   }
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    VkSemaphoreCreateInfo info;
-    VkResult vk_result = VK_SUCCESS;
+  r->num_garbage_bindless_textures[collect] = 0;
+}
 
-    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
+static void owl_renderer_deinit_garbage(struct owl_renderer *r) {
+  uint32_t i;
 
-    vk_result =
-        vkCreateSemaphore(device, &info, NULL, &r->acquire_semaphores[i]);
-    if (vk_result)
-      goto error_destroy_acquire_semaphores;
-  }
+  /* collect_garbage advances the garbage index itself */
+  for (i = 0; i < r->num_garbage_frames; ++i)
+    owl_renderer_collect_garbage(r);
 
-  for (i = 0; i < (int32_t)r->num_frames; ++i) {
-    VkSemaphoreCreateInfo info;
-    VkResult vk_result = VK_SUCCESS;
+  r->garbage = 0;
+}
 
-    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
+static int owl_renderer_garbage_push_targets(struct owl_renderer *r) {
+  uint32_t i;
+  uint32_t const capacity = OWL_ARRAY_SIZE(r->garbage_buffers[0]);
+  uint32_t const garbage = r->garbage;
+  uint32_t const num_images = r->num_garbage_images[garbage];
+  uint32_t const num_image_views = r->num_garbage_image_views[garbage];
+  uint32_t const num_framebuffers = r->num_garbage_framebuffers[garbage];
+  uint32_t const num_swapchains = r->num_garbage_swapchains[garbage];
+  uint32_t const num_memories = r->num_garbage_memories[garbage];
+  uint32_t const num_swapchain_images = r->num_swapchain_images;
 
-    vk_result =
-        vkCreateSemaphore(device, &info, NULL, &r->render_done_semaphores[i]);
-    if (vk_result)
-      goto error_destroy_render_done_semaphores;
-  }
+  if (capacity < num_images + 2)
+    return OWL_ERROR_NO_SPACE;
 
-  return OWL_OK;
+  if (capacity < num_image_views + num_swapchain_images + 2)
+    return OWL_ERROR_NO_SPACE;
 
-error_destroy_render_done_semaphores:
-  for (i = i - 1; i > 0; --i) {
-    VkSemaphore semaphore = r->render_done_semaphores[i];
-    vkDestroySemaphore(device, semaphore, NULL);
-  }
+  if (capacity < num_framebuffers + num_swapchain_images)
+    return OWL_ERROR_NO_SPACE;
 
-  i = r->num_frames;
+  if (capacity < num_swapchains + 1)
+    return OWL_ERROR_NO_SPACE;
 
-error_destroy_acquire_semaphores:
-  for (i = i - 1; i > 0; --i) {
-    VkSemaphore semaphore = r->acquire_semaphores[i];
-    vkDestroySemaphore(device, semaphore, NULL);
+  if (capacity < num_memories + 2)
+    return OWL_ERROR_NO_SPACE;
+
+  for (i = 0; i < num_swapchain_images; ++i) {
+    VkFramebuffer framebuffer = r->swapchain_framebuffers[i];
+    VkImageView image_view = r->swapchain_image_views[i];
+    r->garbage_framebuffers[garbage][num_framebuffers + i] = framebuffer;
+    r->garbage_image_views[garbage][num_image_views + i] = image_view;
   }
 
-  i = r->num_frames;
+  r->num_garbage_framebuffers[garbage] += num_swapchain_images;
+  r->num_garbage_image_views[garbage] += num_swapchain_images;
 
-error_destroy_in_flight_fences:
-  for (i = i - 1; i > 0; --i) {
-    VkFence fence = r->in_flight_fences[i];
-    vkDestroyFence(device, fence, NULL);
-  }
+  /* the swapchain handle stays in r->swapchain to be used as oldSwapchain */
+  r->garbage_swapchains[garbage][num_swapchains] = r->swapchain;
+  r->num_garbage_swapchains[garbage] += 1;
 
-  i = r->num_frames;
+  i = r->num_garbage_image_views[garbage];
+  r->garbage_image_views[garbage][i + 0] = r->color_image_view;
+  r->garbage_image_views[garbage][i + 1] = r->depth_image_view;
+  r->num_garbage_image_views[garbage] += 2;
 
-error_free_submit_command_buffers:
-  for (i = i - 1; i > 0; --i) {
-    VkCommandPool command_pool = r->submit_command_pools[i];
-    VkCommandBuffer command_buffer = r->submit_command_buffers[i];
-    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
-  }
+  r->garbage_images[garbage][num_images + 0] = r->color_image;
+  r->garbage_images[garbage][num_images + 1] = r->depth_image;
+  r->num_garbage_images[garbage] += 2;
 
-error_destroy_submit_command_pools:
-  for (i = i - 1; i > 0; --i) {
-    VkCommandPool command_pool = r->submit_command_pools[i];
-    vkDestroyCommandPool(device, command_pool, NULL);
-  }
+  r->garbage_memories[garbage][num_memories + 0] = r->color_memory;
+  r->garbage_memories[garbage][num_memories + 1] = r->depth_memory;
+  r->num_garbage_memories[garbage] += 2;
 
-  return OWL_ERROR_FATAL;
+  return OWL_OK;
 }
 
-static void owl_renderer_deinit_frames(struct owl_renderer *r) {
+static int owl_renderer_init_quad_batch(struct owl_renderer *r) {
+  int ret;
   uint32_t i;
-
+  uint16_t *indices;
   VkDevice const device = r->device;
 
-  for (i = 0; i < r->num_frames; ++i) {
-    VkSemaphore semaphore = r->render_done_semaphores[i];
-    vkDestroySemaphore(device, semaphore, NULL);
-  }
+  {
+    VkBufferCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-  i = r->num_frames;
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.size = OWL_MAX_BATCH_QUADS * 6 * sizeof(*indices);
+    info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
 
-  for (i = 0; i < r->num_frames; ++i) {
-    VkSemaphore semaphore = r->acquire_semaphores[i];
-    vkDestroySemaphore(device, semaphore, NULL);
+    vk_result = vkCreateBuffer(device, &info, NULL, &r->quad_index_buffer);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error;
+    }
   }
 
-  i = r->num_frames;
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
 
-  for (i = 0; i < r->num_frames; ++i) {
-    VkFence fence = r->in_flight_fences[i];
-    vkDestroyFence(device, fence, NULL);
-  }
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-  i = r->num_frames;
+    vkGetBufferMemoryRequirements(device, r->quad_index_buffer, &requirements);
 
-  for (i = 0; i < r->num_frames; ++i) {
-    VkCommandPool command_pool = r->submit_command_pools[i];
-    VkCommandBuffer command_buffer = r->submit_command_buffers[i];
-    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+    ret = owl_memory_allocate(r, &requirements, properties,
+                              &r->quad_index_memory);
+    if (ret)
+      goto error_destroy_quad_index_buffer;
+
+    ret = owl_memory_bind_buffer(r, r->quad_index_buffer,
+                                 &r->quad_index_memory);
+    if (ret)
+      goto error_free_quad_index_memory;
   }
 
-  for (i = 0; i < r->num_frames; ++i) {
-    VkCommandPool command_pool = r->submit_command_pools[i];
-    vkDestroyCommandPool(device, command_pool, NULL);
+  /* written once, every batch draws its quads from the start of the buffer */
+  indices = r->quad_index_memory.data;
+
+  for (i = 0; i < OWL_MAX_BATCH_QUADS; ++i) {
+    uint16_t const first = (uint16_t)(i * 4);
+
+    indices[i * 6 + 0] = first + 2;
+    indices[i * 6 + 1] = first + 3;
+    indices[i * 6 + 2] = first + 1;
+    indices[i * 6 + 3] = first + 1;
+    indices[i * 6 + 4] = first + 0;
+    indices[i * 6 + 5] = first + 2;
   }
-}
 
-static int owl_renderer_init_samplers(struct owl_renderer *r) {
-  VkSamplerCreateInfo info;
-  VkResult vk_result = VK_SUCCESS;
-  VkDevice const device = r->device;
+  r->quad_batch.num_quads = 0;
 
-  info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-  info.pNext = NULL;
-  info.flags = 0;
-  info.magFilter = VK_FILTER_LINEAR;
-  info.minFilter = VK_FILTER_LINEAR;
-  info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-#if 0
-  info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-#else
-  info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-#endif
-  info.mipLodBias = 0.0F;
-  info.anisotropyEnable = VK_TRUE;
-  info.maxAnisotropy = 16.0F;
-  info.compareEnable = VK_FALSE;
-  info.compareOp = VK_COMPARE_OP_ALWAYS;
-  info.minLod = 0.0F;
-  info.maxLod = VK_LOD_CLAMP_NONE;
-  info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-  info.unnormalizedCoordinates = VK_FALSE;
+  return OWL_OK;
 
-  vk_result = vkCreateSampler(device, &info, NULL, &r->linear_sampler);
-  if (vk_result)
-    return OWL_ERROR_FATAL;
+error_free_quad_index_memory:
+  owl_memory_free(r, &r->quad_index_memory);
 
-  return OWL_OK;
+error_destroy_quad_index_buffer:
+  vkDestroyBuffer(device, r->quad_index_buffer, NULL);
+
+error:
+  return ret;
 }
 
-static void owl_renderer_deinit_samplers(struct owl_renderer *r) {
-  VkDevice const device = r->device;
-  vkDestroySampler(device, r->linear_sampler, NULL);
+static void owl_renderer_deinit_quad_batch(struct owl_renderer *r) {
+  vkDestroyBuffer(r->device, r->quad_index_buffer, NULL);
+  owl_memory_free(r, &r->quad_index_memory);
 }
 
-/* TODO(samuel): cleanup */
+static int owl_renderer_init_frame_page(struct owl_renderer *r, uint64_t size,
+                                        struct owl_renderer_frame_page *page) {
+  int ret;
+  VkDevice const device = r->device;
 
-#define OWL_IRRADIANCE_MAP 0
-#define OWL_PREFILTERED_MAP 1
-#define OWL_NUM_ENVIRONMENT_MAPS 2
+  {
+    VkBufferCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-struct owl_renderer_irradiance_push_constant {
-  owl_m4 mvp;
-  float delta_phi;
-  float delta_theta;
-};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.size = size;
+    info.usage = 0;
+    info.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    info.usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
 
-struct owl_renderer_prefiltered_push_constant {
-  owl_m4 mvp;
-  float roughness;
-  uint32_t samples;
-};
+    vk_result = vkCreateBuffer(device, &info, NULL, &page->buffer);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error;
+    }
+  }
 
-/* TODO(samuel): cleanup function */
-static int owl_renderer_init_filter_maps(struct owl_renderer *r) {
-  int32_t i;
-  VkImage *images[OWL_NUM_ENVIRONMENT_MAPS];
-  VkDeviceMemory *memories[OWL_NUM_ENVIRONMENT_MAPS];
-  VkImageView *image_views[OWL_NUM_ENVIRONMENT_MAPS];
-  VkFormat formats[OWL_NUM_ENVIRONMENT_MAPS];
-  uint32_t dimensions[OWL_NUM_ENVIRONMENT_MAPS];
-  VkDeviceSize push_constant_ranges[OWL_NUM_ENVIRONMENT_MAPS];
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
 
-  static uint32_t const vertex_shader_source[] = {
-#include "owl_environment.vert.spv.u32"
-  };
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-  static uint32_t const irradiance_fragment_shader_source[] = {
-#include "owl_irradiance.frag.spv.u32"
-  };
+    vkGetBufferMemoryRequirements(device, page->buffer, &requirements);
 
-  static uint32_t const prefilter_fragment_shader_source[] = {
-#include "owl_prefilter.frag.spv.u32"
-  };
+    ret = owl_memory_allocate(r, &requirements, properties, &page->memory);
+    if (ret)
+      goto error_destroy_buffer;
 
-  VkRenderPass offscreen_pass = VK_NULL_HANDLE;
-  VkImage offscreen_image = VK_NULL_HANDLE;
-  VkDeviceMemory offscreen_memory = VK_NULL_HANDLE;
-  VkImageView offscreen_image_view = VK_NULL_HANDLE;
-  VkFramebuffer offscreen_framebuffer = VK_NULL_HANDLE;
-  VkShaderModule offscreen_vertex_shader = VK_NULL_HANDLE;
-  VkShaderModule offscreen_fragment_shader = VK_NULL_HANDLE;
-  VkPipelineLayout offscreen_pipeline_layout = VK_NULL_HANDLE;
-  VkPipeline offscreen_pipeline = VK_NULL_HANDLE;
+    ret = owl_memory_bind_buffer(r, page->buffer, &page->memory);
+    if (ret)
+      goto error_free_memory;
+  }
 
-  int ret = OWL_OK;
-  VkDevice const device = r->device;
+  /* the descriptor sets are allocated from the frame's transient pool the
+   * first time the page holds uniforms */
+  page->common_descriptor_set = VK_NULL_HANDLE;
+  page->model_descriptor_set = VK_NULL_HANDLE;
 
-  formats[OWL_IRRADIANCE_MAP] = VK_FORMAT_R32G32B32A32_SFLOAT;
-  formats[OWL_PREFILTERED_MAP] = VK_FORMAT_R16G16B16A16_SFLOAT;
+  page->size = size;
 
-  dimensions[OWL_IRRADIANCE_MAP] = 64;
-  dimensions[OWL_PREFILTERED_MAP] = 512;
+  return OWL_OK;
 
-  images[OWL_IRRADIANCE_MAP] = &r->irradiance_map_image;
-  images[OWL_PREFILTERED_MAP] = &r->prefiltered_map_image;
+error_free_memory:
+  owl_memory_free(r, &page->memory);
 
-  memories[OWL_IRRADIANCE_MAP] = &r->irradiance_map_memory;
-  memories[OWL_PREFILTERED_MAP] = &r->prefiltered_map_memory;
+error_destroy_buffer:
+  vkDestroyBuffer(device, page->buffer, NULL);
 
-  image_views[OWL_IRRADIANCE_MAP] = &r->irradiance_map_image_view;
-  image_views[OWL_PREFILTERED_MAP] = &r->prefiltered_map_image_view;
+error:
+  return ret;
+}
 
-  push_constant_ranges[OWL_IRRADIANCE_MAP] =
-      sizeof(struct owl_renderer_irradiance_push_constant);
-  push_constant_ranges[OWL_PREFILTERED_MAP] =
-      sizeof(struct owl_renderer_prefiltered_push_constant);
+static void
+owl_renderer_deinit_frame_page(struct owl_renderer *r,
+                               struct owl_renderer_frame_page *page) {
+  vkDestroyBuffer(r->device, page->buffer, NULL);
+  owl_memory_free(r, &page->memory);
+}
 
-  r->prefiltered_map_image = VK_NULL_HANDLE;
-  r->prefiltered_map_memory = VK_NULL_HANDLE;
-  r->prefiltered_map_image_view = VK_NULL_HANDLE;
+static int owl_renderer_init_frame_page_descriptor_sets(
+    struct owl_renderer *r, struct owl_renderer_frame_page *page) {
+  int ret;
+  VkDevice const device = r->device;
 
-  r->irradiance_map_image = VK_NULL_HANDLE;
-  r->irradiance_map_memory = VK_NULL_HANDLE;
-  r->irradiance_map_image_view = VK_NULL_HANDLE;
+  {
+    VkDescriptorSetLayout layouts[2];
+    VkDescriptorSet descriptor_sets[2];
 
-  for (i = 0; i < OWL_NUM_ENVIRONMENT_MAPS; ++i) {
-    uint32_t j;
-    VkViewport viewport;
-    VkRect2D scissor;
-    owl_m4 matrices[6];
+    layouts[0] = r->common_uniform_descriptor_set_layout;
+    layouts[1] = r->model_uniform_descriptor_set_layout;
 
-    uint32_t mips;
-    VkFormat const format = formats[i];
-    uint32_t const dimension = dimensions[i];
+    ret = owl_renderer_frame_allocate_descriptor_sets(
+        r, OWL_ARRAY_SIZE(layouts), layouts, descriptor_sets);
+    if (ret)
+      return ret;
 
-    mips = owl_texture_calculate_mipmaps(dimension, dimension);
+    page->common_descriptor_set = descriptor_sets[0];
+    page->model_descriptor_set = descriptor_sets[1];
+  }
 
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = dimension;
-    viewport.height = dimension;
-    viewport.minDepth = 0.0F;
-    viewport.maxDepth = 1.0F;
+  {
+    VkDescriptorBufferInfo descriptors[2];
+    VkWriteDescriptorSet writes[2];
 
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent.width = dimension;
-    scissor.extent.height = dimension;
+    descriptors[0].buffer = page->buffer;
+    descriptors[0].offset = 0;
+    descriptors[0].range = sizeof(struct owl_common_uniform);
 
-    {
-      VkImageCreateInfo info;
-      VkResult vk_result;
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].pNext = NULL;
+    writes[0].dstSet = page->common_descriptor_set;
+    writes[0].dstBinding = 0;
+    writes[0].dstArrayElement = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    writes[0].pImageInfo = NULL;
+    writes[0].pBufferInfo = &descriptors[0];
+    writes[0].pTexelBufferView = NULL;
 
-      info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-      info.imageType = VK_IMAGE_TYPE_2D;
-      info.format = formats[i];
-      info.extent.width = dimension;
-      info.extent.height = dimension;
-      info.extent.depth = 1;
-      info.mipLevels = mips;
-      info.arrayLayers = 6;
-      info.samples = VK_SAMPLE_COUNT_1_BIT;
-      info.tiling = VK_IMAGE_TILING_OPTIMAL;
-      info.usage = 0;
-      info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
-      info.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-      info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      info.queueFamilyIndexCount = 0;
-      info.pQueueFamilyIndices = NULL;
-      info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    descriptors[1].buffer = page->buffer;
+    descriptors[1].offset = 0;
+    descriptors[1].range = sizeof(struct owl_model_uniform);
 
-      vk_result = vkCreateImage(device, &info, NULL, images[i]);
-      if (vk_result)
-        goto error;
-    }
+    writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].pNext = NULL;
+    writes[1].dstSet = page->model_descriptor_set;
+    writes[1].dstBinding = 0;
+    writes[1].dstArrayElement = 0;
+    writes[1].descriptorCount = 1;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    writes[1].pImageInfo = NULL;
+    writes[1].pBufferInfo = &descriptors[1];
+    writes[1].pTexelBufferView = NULL;
 
-    {
-      VkMemoryPropertyFlagBits properties;
-      VkMemoryRequirements requirements;
-      VkMemoryAllocateInfo info;
-      VkResult vk_result;
+    vkUpdateDescriptorSets(device, OWL_ARRAY_SIZE(writes), writes, 0, NULL);
+  }
 
-      properties = 0;
-      properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  return OWL_OK;
+}
 
-      vkGetImageMemoryRequirements(device, *images[i], &requirements);
+static int owl_renderer_init_frame_allocator(struct owl_renderer *r) {
+  int ret;
+  int32_t i;
 
-      info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-      info.pNext = NULL;
-      info.allocationSize = requirements.size;
-      info.memoryTypeIndex = owl_renderer_find_memory_type(
-          r, requirements.memoryTypeBits, properties);
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    struct owl_renderer_frame_page *page = &r->frame_pages[i][0];
 
-      vk_result = vkAllocateMemory(device, &info, NULL, memories[i]);
-      if (vk_result)
-        goto error;
+    ret = owl_renderer_init_frame_page(r, r->frame_page_size, page);
+    if (ret)
+      goto error_deinit_frame_pages;
 
-      vk_result = vkBindImageMemory(device, *images[i], *memories[i], 0);
-      if (vk_result)
-        goto error;
-    }
+    r->num_frame_pages[i] = 1;
+  }
 
-    {
-      VkImageViewCreateInfo info;
-      VkResult vk_result;
+  {
+    VkPhysicalDeviceProperties properties;
+    VkMemoryRequirements requirements;
+    VkBuffer buffer = r->frame_pages[0][0].buffer;
 
-      info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.image = *images[i];
-      info.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-      info.format = format;
-      info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      info.subresourceRange.baseMipLevel = 0;
-      info.subresourceRange.levelCount = mips;
-      info.subresourceRange.baseArrayLayer = 0;
-      info.subresourceRange.layerCount = 6;
+    vkGetPhysicalDeviceProperties(r->physical_device, &properties);
+    vkGetBufferMemoryRequirements(r->device, buffer, &requirements);
 
-      vk_result = vkCreateImageView(device, &info, NULL, image_views[i]);
-      if (vk_result)
-        goto error;
-    }
+    r->frame_vertex_alignment = requirements.alignment;
+    r->frame_index_alignment = requirements.alignment;
+    r->frame_uniform_alignment =
+        OWL_MAX(requirements.alignment,
+                properties.limits.minUniformBufferOffsetAlignment);
+  }
 
-    {
-      VkAttachmentReference color_reference;
-      VkAttachmentDescription attachment;
-      VkSubpassDescription subpass;
-      VkSubpassDependency dependency;
-      VkRenderPassCreateInfo info;
-      VkResult vk_result;
+  r->frame_page = 0;
+  r->frame_page_offset = 0;
+  r->frame_last_offset = 0;
 
-      color_reference.attachment = 0;
-      color_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  /* the pages are new, the sets in the frame pools reference the old ones */
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i)
+    vkResetDescriptorPool(r->device, r->frame_descriptor_pools[i], 0);
 
-      attachment.flags = 0;
-      attachment.format = format;
-      attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-      attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-      attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-      attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-      attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-      attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  return OWL_OK;
 
-      subpass.flags = 0;
-      subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-      subpass.inputAttachmentCount = 0;
-      subpass.pInputAttachments = NULL;
-      subpass.colorAttachmentCount = 1;
-      subpass.pColorAttachments = &color_reference;
-      subpass.pResolveAttachments = NULL;
-      subpass.pDepthStencilAttachment = NULL;
-      subpass.preserveAttachmentCount = 0;
-      subpass.pPreserveAttachments = NULL;
+error_deinit_frame_pages:
+  for (i = i - 1; i >= 0; --i) {
+    owl_renderer_deinit_frame_page(r, &r->frame_pages[i][0]);
+    r->num_frame_pages[i] = 0;
+  }
 
-      dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-      dependency.dstSubpass = 0;
-      dependency.srcStageMask = 0;
-      dependency.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-      dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-      dependency.dstStageMask = 0;
-      dependency.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-      dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-      dependency.srcAccessMask = 0;
-      dependency.dstAccessMask = 0;
-      dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-      dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-      dependency.dependencyFlags = 0;
+  return ret;
+}
 
-      info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.attachmentCount = 1;
-      info.pAttachments = &attachment;
-      info.subpassCount = 1;
-      info.pSubpasses = &subpass;
-      info.dependencyCount = 1;
-      info.pDependencies = &dependency;
+static void owl_renderer_deinit_frame_allocator(struct owl_renderer *r) {
+  uint32_t i;
+  uint32_t j;
 
-      vk_result = vkCreateRenderPass(device, &info, NULL, &offscreen_pass);
-      if (vk_result)
-        goto error;
-    }
+  for (i = 0; i < r->num_frames; ++i) {
+    for (j = 0; j < r->num_frame_pages[i]; ++j)
+      owl_renderer_deinit_frame_page(r, &r->frame_pages[i][j]);
 
-    {
-      VkImageCreateInfo info;
-      VkResult vk_result;
+    r->num_frame_pages[i] = 0;
+  }
+}
 
-      info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-      info.imageType = VK_IMAGE_TYPE_2D;
-      info.format = formats[i];
-      info.extent.width = dimension;
-      info.extent.height = dimension;
-      info.extent.depth = 1;
-      info.mipLevels = 1;
-      info.arrayLayers = 6;
-      info.samples = VK_SAMPLE_COUNT_1_BIT;
-      info.tiling = VK_IMAGE_TILING_OPTIMAL;
-      info.usage = 0;
-      info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-      info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-      info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      info.queueFamilyIndexCount = 0;
-      info.pQueueFamilyIndices = NULL;
-      info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+/* folds the pages a frame spilled into back into a single one big enough for
+ * the busiest frame seen, only safe once the frame's fence was waited on */
+static int owl_renderer_fit_frame_pages(struct owl_renderer *r) {
+  int ret;
+  uint32_t i;
+  struct owl_renderer_frame_page page;
+  uint32_t const frame = r->frame;
+  struct owl_renderer_frame_page *pages = r->frame_pages[frame];
 
-      vk_result = vkCreateImage(device, &info, NULL, &offscreen_image);
-      if (vk_result)
-        goto error;
-    }
+  if (1 == r->num_frame_pages[frame] && r->frame_page_size <= pages[0].size)
+    return OWL_OK;
 
-    {
-      VkMemoryPropertyFlagBits properties;
-      VkMemoryRequirements requirements;
-      VkMemoryAllocateInfo info;
-      VkResult vk_result;
+  /* the new page is created first, the old chain stays usable on failure */
+  ret = owl_renderer_init_frame_page(r, r->frame_page_size, &page);
+  if (ret)
+    return ret;
 
-      properties = 0;
-      properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  for (i = 0; i < r->num_frame_pages[frame]; ++i)
+    owl_renderer_deinit_frame_page(r, &pages[i]);
 
-      vkGetImageMemoryRequirements(device, offscreen_image, &requirements);
+  pages[0] = page;
+  r->num_frame_pages[frame] = 1;
 
-      info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-      info.pNext = NULL;
-      info.allocationSize = requirements.size;
-      info.memoryTypeIndex = owl_renderer_find_memory_type(
-          r, requirements.memoryTypeBits, properties);
+  return OWL_OK;
+}
 
-      vk_result = vkAllocateMemory(device, &info, NULL, &offscreen_memory);
-      if (vk_result)
-        goto error;
+/* every set allocated in the frame is released in one go, the frame's fence
+ * was waited on */
+static int owl_renderer_reset_frame_descriptor_pool(struct owl_renderer *r) {
+  uint32_t i;
+  VkResult vk_result;
+  uint32_t const frame = r->frame;
+  VkDescriptorPool pool = r->frame_descriptor_pools[frame];
 
-      vk_result =
-          vkBindImageMemory(device, offscreen_image, offscreen_memory, 0);
-      if (vk_result)
-        goto error;
-    }
+  vk_result = vkResetDescriptorPool(r->device, pool, 0);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
 
-    {
-      VkImageViewCreateInfo info;
-      VkResult vk_result;
+  for (i = 0; i < r->num_frame_pages[frame]; ++i) {
+    r->frame_pages[frame][i].common_descriptor_set = VK_NULL_HANDLE;
+    r->frame_pages[frame][i].model_descriptor_set = VK_NULL_HANDLE;
+  }
 
-      info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.image = offscreen_image;
-      info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-      info.format = format;
-      info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-      info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      info.subresourceRange.baseMipLevel = 0;
-      info.subresourceRange.levelCount = 1;
-      info.subresourceRange.baseArrayLayer = 0;
-      info.subresourceRange.layerCount = 1;
+  return OWL_OK;
+}
 
-      vk_result = vkCreateImageView(device, &info, NULL, &offscreen_image_view);
-      if (vk_result)
-        goto error;
-    }
+static int owl_renderer_init_frames(struct owl_renderer *r) {
+  int32_t i;
+  VkDevice const device = r->device;
 
-    {
-      VkFramebufferCreateInfo info;
-      VkResult vk_result;
+  r->frame = 0;
+  r->num_frame_threads = 0;
+  r->num_culled_models = 0;
 
-      info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.renderPass = offscreen_pass;
-      info.attachmentCount = 1;
-      info.pAttachments = &offscreen_image_view;
-      info.width = dimension;
-      info.height = dimension;
-      info.layers = 1;
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkCommandPoolCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-      vk_result =
-          vkCreateFramebuffer(device, &info, NULL, &offscreen_framebuffer);
-      if (vk_result)
-        goto error;
-    }
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.queueFamilyIndex = r->graphics_family;
 
-    /* TODO(samuel): why does he change the layout manualy instead of
-leaving
-* it to the render pass?
-https://github.com/SaschaWillems/Vulkan-glTF-PBR/blob/master/src/main.cpp#L1288
-*/
-#if 0
-    ret = owl_renderer_begin_im_command_buffer(r);
-    if (ret)
-      goto error;
+    vk_result =
+        vkCreateCommandPool(device, &info, NULL, &r->submit_command_pools[i]);
+    if (vk_result)
+      goto error_destroy_submit_command_pools;
+  }
 
-    {
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkCommandBufferAllocateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-    }
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.commandPool = r->submit_command_pools[i];
+    info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    info.commandBufferCount = 1;
 
-    ret = owl_renderer_end_im_command_buffer(r);
-    if (ret)
-      goto error;
-#endif
+    vk_result =
+        vkAllocateCommandBuffers(device, &info, &r->submit_command_buffers[i]);
+    if (vk_result)
+      goto error_free_submit_command_buffers;
+  }
 
-    {
-      VkPushConstantRange range;
-      VkPipelineLayoutCreateInfo info;
-      VkResult vk_result;
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkCommandBufferAllocateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-      range.stageFlags = 0;
-      range.stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
-      range.stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
-      range.offset = 0;
-      range.size = push_constant_ranges[i];
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.commandPool = r->submit_command_pools[i];
+    info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    info.commandBufferCount = 1;
 
-      info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.setLayoutCount = 1;
-      info.pSetLayouts = &r->common_texture_descriptor_set_layout;
-      info.pushConstantRangeCount = 1;
-      info.pPushConstantRanges = &range;
+    vk_result =
+        vkAllocateCommandBuffers(device, &info, &r->inline_command_buffers[i]);
+    if (vk_result)
+      goto error_free_inline_command_buffers;
+  }
 
-      vk_result = vkCreatePipelineLayout(device, &info, NULL,
-                                         &offscreen_pipeline_layout);
-      if (vk_result)
-        goto error;
-    }
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkCommandBufferAllocateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-    {
-      VkShaderModuleCreateInfo info;
-      VkResult vk_result;
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.commandPool = r->submit_command_pools[i];
+    info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    info.commandBufferCount = 1;
 
-      info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.codeSize = sizeof(vertex_shader_source);
-      info.pCode = vertex_shader_source;
+    vk_result =
+        vkAllocateCommandBuffers(device, &info, &r->cull_command_buffers[i]);
+    if (vk_result)
+      goto error_free_cull_command_buffers;
+  }
 
-      vk_result =
-          vkCreateShaderModule(device, &info, NULL, &offscreen_vertex_shader);
-      if (vk_result)
-        goto error;
-    }
+  r->cull_recording = 0;
 
-    {
-      VkShaderModuleCreateInfo info;
-      VkResult vk_result;
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkFenceCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
 
-      info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      if (OWL_IRRADIANCE_MAP == i) {
-        info.codeSize = sizeof(irradiance_fragment_shader_source);
-        info.pCode = irradiance_fragment_shader_source;
-      } else if (OWL_PREFILTERED_MAP == i) {
-        info.codeSize = sizeof(prefilter_fragment_shader_source);
-        info.pCode = prefilter_fragment_shader_source;
-      } else {
-        OWL_ASSERT(0);
-        goto error;
-      }
+    info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    vk_result = vkCreateFence(device, &info, NULL, &r->in_flight_fences[i]);
+    if (vk_result)
+      goto error_destroy_in_flight_fences;
+  }
+
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkSemaphoreCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+
+    vk_result =
+        vkCreateSemaphore(device, &info, NULL, &r->acquire_semaphores[i]);
+    if (vk_result)
+      goto error_destroy_acquire_semaphores;
+  }
+
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkSemaphoreCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+
+    vk_result =
+        vkCreateSemaphore(device, &info, NULL, &r->render_done_semaphores[i]);
+    if (vk_result)
+      goto error_destroy_render_done_semaphores;
+  }
+
+  return OWL_OK;
+
+error_destroy_render_done_semaphores:
+  for (i = i - 1; i > 0; --i) {
+    VkSemaphore semaphore = r->render_done_semaphores[i];
+    vkDestroySemaphore(device, semaphore, NULL);
+  }
+
+  i = r->num_frames;
+
+error_destroy_acquire_semaphores:
+  for (i = i - 1; i > 0; --i) {
+    VkSemaphore semaphore = r->acquire_semaphores[i];
+    vkDestroySemaphore(device, semaphore, NULL);
+  }
+
+  i = r->num_frames;
+
+error_destroy_in_flight_fences:
+  for (i = i - 1; i > 0; --i) {
+    VkFence fence = r->in_flight_fences[i];
+    vkDestroyFence(device, fence, NULL);
+  }
+
+  i = r->num_frames;
+
+error_free_cull_command_buffers:
+  for (i = i - 1; i >= 0; --i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    VkCommandBuffer command_buffer = r->cull_command_buffers[i];
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+  }
+
+  i = r->num_frames;
+
+error_free_inline_command_buffers:
+  for (i = i - 1; i >= 0; --i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    VkCommandBuffer command_buffer = r->inline_command_buffers[i];
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+  }
+
+  i = r->num_frames;
+
+error_free_submit_command_buffers:
+  for (i = i - 1; i > 0; --i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    VkCommandBuffer command_buffer = r->submit_command_buffers[i];
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+  }
+
+error_destroy_submit_command_pools:
+  for (i = i - 1; i > 0; --i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    vkDestroyCommandPool(device, command_pool, NULL);
+  }
+
+  return OWL_ERROR_FATAL;
+}
+
+static void owl_renderer_deinit_frames(struct owl_renderer *r) {
+  uint32_t i;
+
+  VkDevice const device = r->device;
+
+  for (i = 0; i < r->num_frames; ++i) {
+    VkSemaphore semaphore = r->render_done_semaphores[i];
+    vkDestroySemaphore(device, semaphore, NULL);
+  }
+
+  i = r->num_frames;
+
+  for (i = 0; i < r->num_frames; ++i) {
+    VkSemaphore semaphore = r->acquire_semaphores[i];
+    vkDestroySemaphore(device, semaphore, NULL);
+  }
+
+  i = r->num_frames;
+
+  for (i = 0; i < r->num_frames; ++i) {
+    VkFence fence = r->in_flight_fences[i];
+    vkDestroyFence(device, fence, NULL);
+  }
+
+  i = r->num_frames;
+
+  for (i = 0; i < r->num_frames; ++i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    VkCommandBuffer command_buffer = r->cull_command_buffers[i];
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+  }
+
+  for (i = 0; i < r->num_frames; ++i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    VkCommandBuffer command_buffer = r->inline_command_buffers[i];
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+  }
+
+  for (i = 0; i < r->num_frames; ++i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    VkCommandBuffer command_buffer = r->submit_command_buffers[i];
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+  }
+
+  for (i = 0; i < r->num_frames; ++i) {
+    VkCommandPool command_pool = r->submit_command_pools[i];
+    vkDestroyCommandPool(device, command_pool, NULL);
+  }
+}
+
+static int owl_renderer_init_timestamps(struct owl_renderer *r) {
+  int32_t i;
+  uint32_t num_families;
+  VkQueueFamilyProperties *families;
+  VkPhysicalDeviceProperties properties;
+  VkQueryPoolCreateInfo info;
+  VkResult vk_result = VK_SUCCESS;
+  VkDevice const device = r->device;
+  VkPhysicalDevice const physical_device = r->physical_device;
+
+  OWL_MEMSET(&r->stats, 0, sizeof(r->stats));
+
+  vkGetPhysicalDeviceProperties(physical_device, &properties);
+  r->timestamp_period = properties.limits.timestampPeriod;
+
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &num_families,
+                                           NULL);
+
+  families = OWL_MALLOC(num_families * sizeof(*families));
+  if (!families)
+    return OWL_ERROR_NO_MEMORY;
+
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &num_families,
+                                           families);
+
+  r->timestamps_supported = 0 != families[r->graphics_family].timestampValidBits;
+
+  OWL_FREE(families);
+
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    r->frame_timestamps[i].query_pool = VK_NULL_HANDLE;
+    r->frame_timestamps[i].num_scopes = 0;
+  }
+
+  r->im_timestamps.query_pool = VK_NULL_HANDLE;
+  r->im_timestamps.num_scopes = 0;
+
+  if (!r->timestamps_supported) {
+    OWL_DEBUG_LOG("timestamps are not supported, profiling is disabled\n");
+    return OWL_OK;
+  }
+
+  info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  info.pNext = NULL;
+  info.flags = 0;
+  info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  info.queryCount = OWL_MAX_TIMESTAMP_SCOPES * 2;
+  info.pipelineStatistics = 0;
+
+  for (i = 0; i < (int32_t)r->num_frames; ++i) {
+    VkQueryPool *query_pool = &r->frame_timestamps[i].query_pool;
+
+    vk_result = vkCreateQueryPool(device, &info, NULL, query_pool);
+    if (vk_result)
+      goto error_destroy_frame_query_pools;
+  }
+
+  vk_result =
+      vkCreateQueryPool(device, &info, NULL, &r->im_timestamps.query_pool);
+  if (vk_result)
+    goto error_destroy_frame_query_pools;
+
+  return OWL_OK;
+
+error_destroy_frame_query_pools:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyQueryPool(device, r->frame_timestamps[i].query_pool, NULL);
+
+  return OWL_ERROR_FATAL;
+}
+
+static void owl_renderer_deinit_timestamps(struct owl_renderer *r) {
+  uint32_t i;
+  VkDevice const device = r->device;
+
+  if (!r->timestamps_supported)
+    return;
+
+  vkDestroyQueryPool(device, r->im_timestamps.query_pool, NULL);
+
+  for (i = 0; i < r->num_frames; ++i)
+    vkDestroyQueryPool(device, r->frame_timestamps[i].query_pool, NULL);
+}
+
+static void
+owl_renderer_reset_timestamps(struct owl_renderer *r,
+                              struct owl_renderer_timestamps *timestamps,
+                              VkCommandBuffer command_buffer) {
+  uint32_t i;
+
+  if (!r->timestamps_supported)
+    return;
+
+  vkCmdResetQueryPool(command_buffer, timestamps->query_pool, 0,
+                      OWL_MAX_TIMESTAMP_SCOPES * 2);
+
+  for (i = 0; i < OWL_RENDERER_NUM_SCOPES; ++i)
+    timestamps->open_scopes[i] = (uint32_t)-1;
+
+  timestamps->num_scopes = 0;
+}
+
+/* only called once the command buffer that wrote the timestamps is known to
+ * be done, so the results are read without waiting. every query comes with
+ * its availability, a scope that was never ended is skipped on its own */
+static void
+owl_renderer_resolve_timestamps(struct owl_renderer *r,
+                                struct owl_renderer_timestamps *timestamps,
+                                float *ms) {
+  uint32_t i;
+  uint64_t results[OWL_MAX_TIMESTAMP_SCOPES * 2][2];
+  VkQueryResultFlags flags;
+  VkResult vk_result = VK_SUCCESS;
+  uint32_t const num_queries = timestamps->num_scopes * 2;
+
+  if (!r->timestamps_supported || !timestamps->num_scopes)
+    return;
+
+  flags = 0;
+  flags |= VK_QUERY_RESULT_64_BIT;
+  flags |= VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+
+  /* not ready only means some query was never written */
+  vk_result = vkGetQueryPoolResults(
+      r->device, timestamps->query_pool, 0, num_queries,
+      num_queries * sizeof(*results), results, sizeof(*results), flags);
+  if (VK_SUCCESS != vk_result && VK_NOT_READY != vk_result)
+    return;
+
+  for (i = 0; i < timestamps->num_scopes; ++i) {
+    uint64_t const begin = results[i * 2][0];
+    uint64_t const end = results[i * 2 + 1][0];
+    double ns;
+
+    if (!results[i * 2][1] || !results[i * 2 + 1][1])
+      continue;
+
+    ns = (double)(end - begin) * r->timestamp_period;
+
+    ms[timestamps->scopes[i]] += (float)(ns / 1000000.0);
+  }
+
+  timestamps->num_scopes = 0;
+}
+
+static int owl_renderer_init_samplers(struct owl_renderer *r) {
+  VkSamplerCreateInfo info;
+  VkResult vk_result = VK_SUCCESS;
+  VkDevice const device = r->device;
+
+  info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  info.pNext = NULL;
+  info.flags = 0;
+  info.magFilter = VK_FILTER_LINEAR;
+  info.minFilter = VK_FILTER_LINEAR;
+  info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+#if 0
+  info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+#else
+  info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+#endif
+  info.mipLodBias = 0.0F;
+  info.anisotropyEnable = VK_TRUE;
+  info.maxAnisotropy = 16.0F;
+  info.compareEnable = VK_FALSE;
+  info.compareOp = VK_COMPARE_OP_ALWAYS;
+  info.minLod = 0.0F;
+  info.maxLod = VK_LOD_CLAMP_NONE;
+  info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+  info.unnormalizedCoordinates = VK_FALSE;
+
+  vk_result = vkCreateSampler(device, &info, NULL, &r->linear_sampler);
+  if (vk_result)
+    goto error;
+
+  /* texel fetches only, nothing is filtered */
+  info.magFilter = VK_FILTER_NEAREST;
+  info.minFilter = VK_FILTER_NEAREST;
+  info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  info.anisotropyEnable = VK_FALSE;
+  info.maxAnisotropy = 1.0F;
+
+  vk_result = vkCreateSampler(device, &info, NULL, &r->nearest_sampler);
+  if (vk_result)
+    goto error_destroy_linear_sampler;
+
+  return OWL_OK;
+
+error_destroy_linear_sampler:
+  vkDestroySampler(device, r->linear_sampler, NULL);
+
+error:
+  return OWL_ERROR_FATAL;
+}
+
+static void owl_renderer_deinit_samplers(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+  vkDestroySampler(device, r->nearest_sampler, NULL);
+  vkDestroySampler(device, r->linear_sampler, NULL);
+}
+
+static int owl_renderer_init_bindless(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+
+  r->bindless_descriptor_pool = VK_NULL_HANDLE;
+  r->bindless_descriptor_set = VK_NULL_HANDLE;
+  r->num_bindless_textures = 0;
+  r->num_free_bindless_textures = 0;
+
+  if (!r->bindless_supported)
+    return OWL_OK;
+
+  {
+    VkDescriptorPoolSize sizes[2];
+    VkDescriptorPoolCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    sizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+    sizes[0].descriptorCount = 1;
+
+    sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    sizes[1].descriptorCount = OWL_MAX_BINDLESS_TEXTURES;
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    info.maxSets = 1;
+    info.poolSizeCount = OWL_ARRAY_SIZE(sizes);
+    info.pPoolSizes = sizes;
+
+    vk_result = vkCreateDescriptorPool(device, &info, NULL,
+                                       &r->bindless_descriptor_pool);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkDescriptorSetAllocateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.descriptorPool = r->bindless_descriptor_pool;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &r->model_bindless_descriptor_set_layout;
+
+    vk_result =
+        vkAllocateDescriptorSets(device, &info, &r->bindless_descriptor_set);
+    if (vk_result)
+      goto error_destroy_bindless_descriptor_pool;
+  }
+
+  {
+    VkDescriptorImageInfo descriptor;
+    VkWriteDescriptorSet write;
+
+    descriptor.sampler = r->linear_sampler;
+    descriptor.imageView = VK_NULL_HANDLE;
+    descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = r->bindless_descriptor_set;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    write.pImageInfo = &descriptor;
+    write.pBufferInfo = NULL;
+    write.pTexelBufferView = NULL;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+  }
+
+  return OWL_OK;
+
+error_destroy_bindless_descriptor_pool:
+  vkDestroyDescriptorPool(device, r->bindless_descriptor_pool, NULL);
+
+error:
+  return OWL_ERROR_FATAL;
+}
+
+static void owl_renderer_deinit_bindless(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+  vkDestroyDescriptorPool(device, r->bindless_descriptor_pool, NULL);
+}
+
+static int owl_renderer_init_depth_pyramid(struct owl_renderer *r) {
+  int ret;
+  int32_t i;
+  VkDevice const device = r->device;
+
+  r->depth_pyramid_image = VK_NULL_HANDLE;
+  r->depth_pyramid_image_view = VK_NULL_HANDLE;
+  r->depth_pyramid_descriptor_pool = VK_NULL_HANDLE;
+  r->cull_pyramid_descriptor_set = VK_NULL_HANDLE;
+  r->depth_pyramid_frame = 0;
+
+  for (i = 0; i < OWL_DEPTH_PYRAMID_LEVELS; ++i)
+    r->depth_pyramid_level_views[i] = VK_NULL_HANDLE;
+
+  if (!r->gpu_culling_supported)
+    return OWL_OK;
+
+  {
+    VkImageCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = VK_FORMAT_R32_SFLOAT;
+    info.extent.width = OWL_DEPTH_PYRAMID_SIZE;
+    info.extent.height = OWL_DEPTH_PYRAMID_SIZE;
+    info.extent.depth = 1;
+    info.mipLevels = OWL_DEPTH_PYRAMID_LEVELS;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = 0;
+    info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    vk_result = vkCreateImage(device, &info, NULL, &r->depth_pyramid_image);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error;
+    }
+  }
+
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
+
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    vkGetImageMemoryRequirements(device, r->depth_pyramid_image,
+                                 &requirements);
+
+    ret = owl_memory_allocate(r, &requirements, properties,
+                              &r->depth_pyramid_memory);
+    if (ret)
+      goto error_destroy_depth_pyramid_image;
+
+    ret = owl_memory_bind_image(r, r->depth_pyramid_image,
+                                &r->depth_pyramid_memory);
+    if (ret)
+      goto error_free_depth_pyramid_memory;
+  }
+
+  {
+    VkImageViewCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.image = r->depth_pyramid_image;
+    info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    info.format = VK_FORMAT_R32_SFLOAT;
+    info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    info.subresourceRange.baseMipLevel = 0;
+    info.subresourceRange.levelCount = OWL_DEPTH_PYRAMID_LEVELS;
+    info.subresourceRange.baseArrayLayer = 0;
+    info.subresourceRange.layerCount = 1;
+
+    vk_result = vkCreateImageView(device, &info, NULL,
+                                  &r->depth_pyramid_image_view);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error_free_depth_pyramid_memory;
+    }
+
+    /* a view per level to write them one at a time */
+    for (i = 0; i < OWL_DEPTH_PYRAMID_LEVELS; ++i) {
+      info.subresourceRange.baseMipLevel = i;
+      info.subresourceRange.levelCount = 1;
+
+      vk_result = vkCreateImageView(device, &info, NULL,
+                                    &r->depth_pyramid_level_views[i]);
+      if (vk_result) {
+        ret = OWL_ERROR_FATAL;
+        goto error_destroy_depth_pyramid_level_views;
+      }
+    }
+  }
+
+  {
+    VkDescriptorImageInfo descriptor;
+    VkWriteDescriptorSet write;
+
+    ret = owl_renderer_allocate_descriptor_sets(
+        r, 1, &r->cull_pyramid_descriptor_set_layout,
+        &r->cull_pyramid_descriptor_set, &r->depth_pyramid_descriptor_pool);
+    if (ret)
+      goto error_destroy_depth_pyramid_level_views;
+
+    descriptor.sampler = r->nearest_sampler;
+    descriptor.imageView = r->depth_pyramid_image_view;
+    descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = r->cull_pyramid_descriptor_set;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &descriptor;
+    write.pBufferInfo = NULL;
+    write.pTexelBufferView = NULL;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+  }
+
+  /* the pyramid stays in the general layout, it's written and read by
+   * compute only */
+  ret = owl_renderer_begin_im_command_buffer(r);
+  if (ret)
+    goto error_free_cull_pyramid_descriptor_set;
+
+  {
+    VkImageMemoryBarrier barrier;
+
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = 0;
+    barrier.dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = r->depth_pyramid_image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = OWL_DEPTH_PYRAMID_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(r->im_command_buffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0,
+                         NULL, 1, &barrier);
+  }
+
+  ret = owl_renderer_end_im_command_buffer(r);
+  if (ret)
+    goto error_free_cull_pyramid_descriptor_set;
+
+  return OWL_OK;
+
+error_free_cull_pyramid_descriptor_set:
+  owl_renderer_free_descriptor_sets(r, r->depth_pyramid_descriptor_pool, 1,
+                                    &r->cull_pyramid_descriptor_set);
+
+  i = OWL_DEPTH_PYRAMID_LEVELS;
+
+error_destroy_depth_pyramid_level_views:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyImageView(device, r->depth_pyramid_level_views[i], NULL);
+
+  vkDestroyImageView(device, r->depth_pyramid_image_view, NULL);
+
+error_free_depth_pyramid_memory:
+  owl_memory_free(r, &r->depth_pyramid_memory);
+
+error_destroy_depth_pyramid_image:
+  vkDestroyImage(device, r->depth_pyramid_image, NULL);
+
+error:
+  return ret;
+}
+
+static void owl_renderer_deinit_depth_pyramid(struct owl_renderer *r) {
+  int32_t i;
+  VkDevice const device = r->device;
+
+  if (!r->gpu_culling_supported)
+    return;
+
+  owl_renderer_free_descriptor_sets(r, r->depth_pyramid_descriptor_pool, 1,
+                                    &r->cull_pyramid_descriptor_set);
+
+  for (i = 0; i < OWL_DEPTH_PYRAMID_LEVELS; ++i)
+    vkDestroyImageView(device, r->depth_pyramid_level_views[i], NULL);
+
+  vkDestroyImageView(device, r->depth_pyramid_image_view, NULL);
+  owl_memory_free(r, &r->depth_pyramid_memory);
+  vkDestroyImage(device, r->depth_pyramid_image, NULL);
+}
+
+/* TODO(samuel): cleanup */
+
+#define OWL_IRRADIANCE_MAP 0
+#define OWL_PREFILTERED_MAP 1
+#define OWL_NUM_ENVIRONMENT_MAPS 2
+
+struct owl_renderer_irradiance_push_constant {
+  owl_m4 mvp;
+  float delta_phi;
+  float delta_theta;
+};
+
+struct owl_renderer_prefiltered_push_constant {
+  owl_m4 mvp;
+  float roughness;
+  uint32_t samples;
+};
+
+/* TODO(samuel): cleanup function */
+static int owl_renderer_init_filter_maps(struct owl_renderer *r) {
+  int32_t i;
+  VkImage *images[OWL_NUM_ENVIRONMENT_MAPS];
+  struct owl_memory_allocation *memories[OWL_NUM_ENVIRONMENT_MAPS];
+  VkImageView *image_views[OWL_NUM_ENVIRONMENT_MAPS];
+  VkFormat formats[OWL_NUM_ENVIRONMENT_MAPS];
+  uint32_t dimensions[OWL_NUM_ENVIRONMENT_MAPS];
+  VkDeviceSize push_constant_ranges[OWL_NUM_ENVIRONMENT_MAPS];
+
+  static uint32_t const vertex_shader_source[] = {
+#include "owl_environment.vert.spv.u32"
+  };
+
+  static uint32_t const irradiance_fragment_shader_source[] = {
+#include "owl_irradiance.frag.spv.u32"
+  };
+
+  static uint32_t const prefilter_fragment_shader_source[] = {
+#include "owl_prefilter.frag.spv.u32"
+  };
+
+  VkRenderPass offscreen_pass = VK_NULL_HANDLE;
+  VkImage offscreen_image = VK_NULL_HANDLE;
+  struct owl_memory_allocation offscreen_memory;
+  VkImageView offscreen_image_view = VK_NULL_HANDLE;
+  VkFramebuffer offscreen_framebuffer = VK_NULL_HANDLE;
+  VkShaderModule offscreen_vertex_shader = VK_NULL_HANDLE;
+  VkShaderModule offscreen_fragment_shader = VK_NULL_HANDLE;
+  VkPipelineLayout offscreen_pipeline_layout = VK_NULL_HANDLE;
+  VkPipeline offscreen_pipeline = VK_NULL_HANDLE;
+
+  int ret = OWL_OK;
+  VkDevice const device = r->device;
+
+  offscreen_memory.memory = VK_NULL_HANDLE;
+
+  formats[OWL_IRRADIANCE_MAP] = VK_FORMAT_R32G32B32A32_SFLOAT;
+  formats[OWL_PREFILTERED_MAP] = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+  dimensions[OWL_IRRADIANCE_MAP] = 64;
+  dimensions[OWL_PREFILTERED_MAP] = 512;
+
+  images[OWL_IRRADIANCE_MAP] = &r->irradiance_map_image;
+  images[OWL_PREFILTERED_MAP] = &r->prefiltered_map_image;
+
+  memories[OWL_IRRADIANCE_MAP] = &r->irradiance_map_memory;
+  memories[OWL_PREFILTERED_MAP] = &r->prefiltered_map_memory;
+
+  image_views[OWL_IRRADIANCE_MAP] = &r->irradiance_map_image_view;
+  image_views[OWL_PREFILTERED_MAP] = &r->prefiltered_map_image_view;
+
+  push_constant_ranges[OWL_IRRADIANCE_MAP] =
+      sizeof(struct owl_renderer_irradiance_push_constant);
+  push_constant_ranges[OWL_PREFILTERED_MAP] =
+      sizeof(struct owl_renderer_prefiltered_push_constant);
+
+  r->prefiltered_map_image = VK_NULL_HANDLE;
+  r->prefiltered_map_memory.memory = VK_NULL_HANDLE;
+  r->prefiltered_map_image_view = VK_NULL_HANDLE;
+
+  r->irradiance_map_image = VK_NULL_HANDLE;
+  r->irradiance_map_memory.memory = VK_NULL_HANDLE;
+  r->irradiance_map_image_view = VK_NULL_HANDLE;
+
+  for (i = 0; i < OWL_NUM_ENVIRONMENT_MAPS; ++i) {
+    uint32_t j;
+    VkViewport viewport;
+    VkRect2D scissor;
+    owl_m4 matrices[6];
+
+    uint32_t mips;
+    VkFormat const format = formats[i];
+    uint32_t const dimension = dimensions[i];
+
+    mips = owl_texture_calculate_mipmaps(dimension, dimension);
+
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = dimension;
+    viewport.height = dimension;
+    viewport.minDepth = 0.0F;
+    viewport.maxDepth = 1.0F;
+
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    scissor.extent.width = dimension;
+    scissor.extent.height = dimension;
+
+    {
+      VkImageCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+      info.imageType = VK_IMAGE_TYPE_2D;
+      info.format = formats[i];
+      info.extent.width = dimension;
+      info.extent.height = dimension;
+      info.extent.depth = 1;
+      info.mipLevels = mips;
+      info.arrayLayers = 6;
+      info.samples = VK_SAMPLE_COUNT_1_BIT;
+      info.tiling = VK_IMAGE_TILING_OPTIMAL;
+      info.usage = 0;
+      info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+      info.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+      info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      info.queueFamilyIndexCount = 0;
+      info.pQueueFamilyIndices = NULL;
+      info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+      vk_result = vkCreateImage(device, &info, NULL, images[i]);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkMemoryPropertyFlagBits properties;
+      VkMemoryRequirements requirements;
+
+      properties = 0;
+      properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+      vkGetImageMemoryRequirements(device, *images[i], &requirements);
+
+      ret = owl_memory_allocate(r, &requirements, properties, memories[i]);
+      if (ret)
+        goto error;
+
+      ret = owl_memory_bind_image(r, *images[i], memories[i]);
+      if (ret)
+        goto error;
+    }
+
+    {
+      VkImageViewCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.image = *images[i];
+      info.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+      info.format = format;
+      info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      info.subresourceRange.baseMipLevel = 0;
+      info.subresourceRange.levelCount = mips;
+      info.subresourceRange.baseArrayLayer = 0;
+      info.subresourceRange.layerCount = 6;
+
+      vk_result = vkCreateImageView(device, &info, NULL, image_views[i]);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkAttachmentReference color_reference;
+      VkAttachmentDescription attachment;
+      VkSubpassDescription subpass;
+      VkSubpassDependency dependency;
+      VkRenderPassCreateInfo info;
+      VkResult vk_result;
+
+      color_reference.attachment = 0;
+      color_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+      attachment.flags = 0;
+      attachment.format = format;
+      attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+      attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+      attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+      attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+      attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+      subpass.flags = 0;
+      subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+      subpass.inputAttachmentCount = 0;
+      subpass.pInputAttachments = NULL;
+      subpass.colorAttachmentCount = 1;
+      subpass.pColorAttachments = &color_reference;
+      subpass.pResolveAttachments = NULL;
+      subpass.pDepthStencilAttachment = NULL;
+      subpass.preserveAttachmentCount = 0;
+      subpass.pPreserveAttachments = NULL;
+
+      dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+      dependency.dstSubpass = 0;
+      dependency.srcStageMask = 0;
+      dependency.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+      dependency.dstStageMask = 0;
+      dependency.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+      dependency.srcAccessMask = 0;
+      dependency.dstAccessMask = 0;
+      dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+      dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      dependency.dependencyFlags = 0;
+
+      info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.attachmentCount = 1;
+      info.pAttachments = &attachment;
+      info.subpassCount = 1;
+      info.pSubpasses = &subpass;
+      info.dependencyCount = 1;
+      info.pDependencies = &dependency;
+
+      vk_result = vkCreateRenderPass(device, &info, NULL, &offscreen_pass);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkImageCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+      info.imageType = VK_IMAGE_TYPE_2D;
+      info.format = formats[i];
+      info.extent.width = dimension;
+      info.extent.height = dimension;
+      info.extent.depth = 1;
+      info.mipLevels = 1;
+      info.arrayLayers = 6;
+      info.samples = VK_SAMPLE_COUNT_1_BIT;
+      info.tiling = VK_IMAGE_TILING_OPTIMAL;
+      info.usage = 0;
+      info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+      info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+      info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      info.queueFamilyIndexCount = 0;
+      info.pQueueFamilyIndices = NULL;
+      info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+      vk_result = vkCreateImage(device, &info, NULL, &offscreen_image);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkMemoryPropertyFlagBits properties;
+      VkMemoryRequirements requirements;
+
+      properties = 0;
+      properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+      vkGetImageMemoryRequirements(device, offscreen_image, &requirements);
+
+      ret = owl_memory_allocate(r, &requirements, properties,
+                                &offscreen_memory);
+      if (ret)
+        goto error;
+
+      ret = owl_memory_bind_image(r, offscreen_image, &offscreen_memory);
+      if (ret)
+        goto error;
+    }
+
+    {
+      VkImageViewCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.image = offscreen_image;
+      info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+      info.format = format;
+      info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+      info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      info.subresourceRange.baseMipLevel = 0;
+      info.subresourceRange.levelCount = 1;
+      info.subresourceRange.baseArrayLayer = 0;
+      info.subresourceRange.layerCount = 1;
+
+      vk_result = vkCreateImageView(device, &info, NULL, &offscreen_image_view);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkFramebufferCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.renderPass = offscreen_pass;
+      info.attachmentCount = 1;
+      info.pAttachments = &offscreen_image_view;
+      info.width = dimension;
+      info.height = dimension;
+      info.layers = 1;
+
+      vk_result =
+          vkCreateFramebuffer(device, &info, NULL, &offscreen_framebuffer);
+      if (vk_result)
+        goto error;
+    }
+
+    /* TODO(samuel): why does he change the layout manualy instead of
+leaving
+* it to the render pass?
+https://github.com/SaschaWillems/Vulkan-glTF-PBR/blob/master/src/main.cpp#L1288
+*/
+#if 0
+    ret = owl_renderer_begin_im_command_buffer(r);
+    if (ret)
+      goto error;
+
+    {
+
+    }
+
+    ret = owl_renderer_end_im_command_buffer(r);
+    if (ret)
+      goto error;
+#endif
+
+    {
+      VkPushConstantRange range;
+      VkPipelineLayoutCreateInfo info;
+      VkResult vk_result;
+
+      range.stageFlags = 0;
+      range.stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+      range.stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+      range.offset = 0;
+      range.size = push_constant_ranges[i];
+
+      info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.setLayoutCount = 1;
+      info.pSetLayouts = &r->common_texture_descriptor_set_layout;
+      info.pushConstantRangeCount = 1;
+      info.pPushConstantRanges = &range;
+
+      vk_result = vkCreatePipelineLayout(device, &info, NULL,
+                                         &offscreen_pipeline_layout);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkShaderModuleCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.codeSize = sizeof(vertex_shader_source);
+      info.pCode = vertex_shader_source;
+
+      vk_result =
+          vkCreateShaderModule(device, &info, NULL, &offscreen_vertex_shader);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkShaderModuleCreateInfo info;
+      VkResult vk_result;
+
+      info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      if (OWL_IRRADIANCE_MAP == i) {
+        info.codeSize = sizeof(irradiance_fragment_shader_source);
+        info.pCode = irradiance_fragment_shader_source;
+      } else if (OWL_PREFILTERED_MAP == i) {
+        info.codeSize = sizeof(prefilter_fragment_shader_source);
+        info.pCode = prefilter_fragment_shader_source;
+      } else {
+        OWL_ASSERT(0);
+        goto error;
+      }
+
+      vk_result =
+          vkCreateShaderModule(device, &info, NULL, &offscreen_fragment_shader);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      VkVertexInputBindingDescription vertex_binding;
+      VkVertexInputAttributeDescription vertex_attribute;
+      VkPipelineVertexInputStateCreateInfo vertex_input;
+      VkPipelineInputAssemblyStateCreateInfo input_assembly;
+      VkPipelineViewportStateCreateInfo viewport_state;
+      VkPipelineRasterizationStateCreateInfo rasterization;
+      VkPipelineMultisampleStateCreateInfo multisample;
+      VkPipelineColorBlendAttachmentState color_attachment;
+      VkPipelineColorBlendStateCreateInfo color;
+      VkPipelineDepthStencilStateCreateInfo depth;
+      VkDynamicState dynamic[2];
+      VkPipelineDynamicStateCreateInfo dynamic_state;
+      VkPipelineShaderStageCreateInfo stages[2];
+      VkGraphicsPipelineCreateInfo info;
+      VkResult vk_result;
+
+      vertex_binding.binding = 0;
+      /* TODO(samuel): remove dependance on the skybox vertex */
+      vertex_binding.stride = sizeof(struct owl_skybox_vertex);
+      vertex_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+      vertex_attribute.location = 0;
+      vertex_attribute.binding = 0;
+      vertex_attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+      vertex_attribute.offset = offsetof(struct owl_skybox_vertex, position);
+
+      vertex_input.sType =
+          VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+      vertex_input.pNext = NULL;
+      vertex_input.flags = 0;
+      vertex_input.vertexBindingDescriptionCount = 1;
+      vertex_input.pVertexBindingDescriptions = &vertex_binding;
+      vertex_input.vertexAttributeDescriptionCount = 1;
+      vertex_input.pVertexAttributeDescriptions = &vertex_attribute;
+
+      input_assembly.sType =
+          VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+      input_assembly.pNext = NULL;
+      input_assembly.flags = 0;
+      input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+      input_assembly.primitiveRestartEnable = VK_FALSE;
+
+      viewport.x = 0;
+      viewport.y = 0;
+      viewport.width = dimension;
+      viewport.height = dimension;
+      viewport.minDepth = 0.0F;
+      viewport.maxDepth = 1.0F;
+
+      scissor.offset.x = 0;
+      scissor.offset.y = 0;
+      scissor.extent.width = dimension;
+      scissor.extent.height = dimension;
+
+      viewport_state.sType =
+          VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+      viewport_state.pNext = NULL;
+      viewport_state.flags = 0;
+      viewport_state.viewportCount = 1;
+      viewport_state.pViewports = &viewport;
+      viewport_state.scissorCount = 1;
+      viewport_state.pScissors = &scissor;
+
+      rasterization.sType =
+          VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+      rasterization.pNext = NULL;
+      rasterization.flags = 0;
+      rasterization.depthClampEnable = VK_FALSE;
+      rasterization.rasterizerDiscardEnable = VK_FALSE;
+      rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+      rasterization.cullMode = VK_CULL_MODE_NONE;
+      rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+      rasterization.depthBiasEnable = VK_FALSE;
+      rasterization.depthBiasConstantFactor = 0.0F;
+      rasterization.depthBiasClamp = 0.0F;
+      rasterization.depthBiasSlopeFactor = 0.0F;
+      rasterization.lineWidth = 1.0F;
+
+      multisample.sType =
+          VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+      multisample.pNext = NULL;
+      multisample.flags = 0;
+      multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+      multisample.sampleShadingEnable = VK_FALSE;
+      multisample.minSampleShading = 0.0F;
+      multisample.pSampleMask = NULL;
+      multisample.alphaToCoverageEnable = VK_FALSE;
+      multisample.alphaToOneEnable = VK_FALSE;
+
+      color_attachment.blendEnable = VK_FALSE;
+      color_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+      color_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+      color_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+      color_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+      color_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+      color_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+      color_attachment.colorWriteMask = 0;
+      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
+      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
+      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
+      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+
+      color.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+      color.pNext = NULL;
+      color.flags = 0;
+      color.logicOpEnable = VK_FALSE;
+      color.logicOp = VK_LOGIC_OP_CLEAR;
+      color.attachmentCount = 1;
+      color.pAttachments = &color_attachment;
+      color.blendConstants[0] = 0.0F;
+      color.blendConstants[1] = 0.0F;
+      color.blendConstants[2] = 0.0F;
+      color.blendConstants[3] = 0.0F;
+
+      depth.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+      depth.pNext = NULL;
+      depth.flags = 0;
+      depth.depthTestEnable = VK_FALSE;
+      depth.depthWriteEnable = VK_FALSE;
+      depth.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+      depth.depthBoundsTestEnable = VK_FALSE;
+      depth.stencilTestEnable = VK_FALSE;
+      depth.front.failOp = VK_STENCIL_OP_KEEP;
+      depth.front.passOp = VK_STENCIL_OP_KEEP;
+      depth.front.depthFailOp = VK_STENCIL_OP_KEEP;
+      depth.front.compareOp = VK_COMPARE_OP_NEVER;
+      depth.front.compareMask = 0;
+      depth.front.writeMask = 0;
+      depth.front.reference = 0;
+      depth.back.failOp = VK_STENCIL_OP_KEEP;
+      depth.back.passOp = VK_STENCIL_OP_KEEP;
+      depth.back.depthFailOp = VK_STENCIL_OP_KEEP;
+      depth.back.compareOp = VK_COMPARE_OP_ALWAYS;
+      depth.back.compareMask = 0;
+      depth.back.writeMask = 0;
+      depth.back.reference = 0;
+      depth.minDepthBounds = 0.0F;
+      depth.maxDepthBounds = 0.0F;
+
+      stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+      stages[0].pNext = NULL;
+      stages[0].flags = 0;
+      stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+      stages[0].module = offscreen_vertex_shader;
+      stages[0].pName = "main";
+      stages[0].pSpecializationInfo = NULL;
+
+      stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+      stages[1].pNext = NULL;
+      stages[1].flags = 0;
+      stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+      stages[1].module = offscreen_fragment_shader;
+      stages[1].pName = "main";
+      stages[1].pSpecializationInfo = NULL;
+
+      dynamic[0] = VK_DYNAMIC_STATE_VIEWPORT;
+      dynamic[1] = VK_DYNAMIC_STATE_SCISSOR;
+
+      dynamic_state.sType =
+          VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+      dynamic_state.pNext = NULL;
+      dynamic_state.flags = 0;
+      dynamic_state.dynamicStateCount = OWL_ARRAY_SIZE(dynamic);
+      dynamic_state.pDynamicStates = dynamic;
+
+      info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+      info.pNext = NULL;
+      info.flags = 0;
+      info.stageCount = OWL_ARRAY_SIZE(stages);
+      info.pStages = stages;
+      info.pVertexInputState = &vertex_input;
+      info.pInputAssemblyState = &input_assembly;
+      info.pTessellationState = NULL;
+      info.pViewportState = &viewport_state;
+      info.pRasterizationState = &rasterization;
+      info.pMultisampleState = &multisample;
+      info.pDepthStencilState = &depth;
+      info.pColorBlendState = &color;
+      info.pDynamicState = &dynamic_state;
+      info.layout = offscreen_pipeline_layout;
+      info.renderPass = offscreen_pass;
+      info.subpass = 0;
+      info.basePipelineHandle = VK_NULL_HANDLE;
+      info.basePipelineIndex = -1;
+
+      vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                            NULL, &offscreen_pipeline);
+      if (vk_result)
+        goto error;
+    }
+
+    {
+      float angle;
+      owl_v3 axis;
+      owl_m4 tmp;
+
+      OWL_M4_IDENTITY(tmp);
+      angle = OWL_DEGREES_AS_RADIANS(90.0F);
+      axis[0] = 0.0F;
+      axis[1] = 1.0F;
+      axis[2] = 0.0F;
+      owl_m4_rotate(tmp, angle, axis, tmp);
+      angle = OWL_DEGREES_AS_RADIANS(180.0F);
+      axis[0] = 1.0F;
+      axis[1] = 0.0F;
+      axis[2] = 0.0F;
+      owl_m4_rotate(tmp, angle, axis, matrices[0]);
+
+      OWL_M4_IDENTITY(tmp);
+      angle = OWL_DEGREES_AS_RADIANS(-90.0F);
+      axis[0] = 0.0F;
+      axis[1] = 1.0F;
+      axis[2] = 0.0F;
+      owl_m4_rotate(tmp, angle, axis, tmp);
+      angle = OWL_DEGREES_AS_RADIANS(180.0F);
+      axis[0] = 1.0F;
+      axis[1] = 0.0F;
+      axis[2] = 0.0F;
+      owl_m4_rotate(tmp, angle, axis, matrices[1]);
+
+      OWL_M4_IDENTITY(tmp);
+      angle = OWL_DEGREES_AS_RADIANS(-90.0F);
+      axis[0] = 1.0F;
+      axis[1] = 0.0F;
+      axis[2] = 0.0F;
+      owl_m4_rotate(tmp, angle, axis, matrices[2]);
+
+      OWL_M4_IDENTITY(tmp);
+      angle = OWL_DEGREES_AS_RADIANS(90.0F);
+      axis[0] = 1.0F;
+      axis[1] = 0.0F;
+      axis[2] = 0.0F;
+      owl_m4_rotate(tmp, angle, axis, matrices[3]);
+
+      OWL_M4_IDENTITY(tmp);
+      angle = OWL_DEGREES_AS_RADIANS(180.0F);
+      axis[0] = 1.0F;
+      axis[1] = 0.0F;
+      axis[2] = 0.0F;
+      owl_m4_rotate(tmp, angle, axis, matrices[4]);
+
+      OWL_M4_IDENTITY(tmp);
+      angle = OWL_DEGREES_AS_RADIANS(180.0F);
+      axis[0] = 0.0F;
+      axis[1] = 0.0F;
+      axis[2] = 1.0F;
+      owl_m4_rotate(tmp, angle, axis, matrices[5]);
+    }
+
+    ret = owl_renderer_begin_im_command_buffer(r);
+    if (ret)
+      goto error;
+
+    {
+      VkImageMemoryBarrier barrier;
+      VkCommandBuffer const command_buffer = r->im_command_buffer;
+
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.pNext = NULL;
+      barrier.srcAccessMask = VK_ACCESS_NONE;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = *images[i];
+      barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      barrier.subresourceRange.baseMipLevel = 0;
+      barrier.subresourceRange.levelCount = mips;
+      barrier.subresourceRange.baseArrayLayer = 0;
+      barrier.subresourceRange.layerCount = 6;
+
+      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0,
+                           NULL, 1, &barrier);
+    }
+
+    ret = owl_renderer_end_im_command_buffer(r);
+    if (ret)
+      goto error;
+
+    for (j = 0; j < mips; ++j) {
+      uint32_t k;
+      for (k = 0; k < 6; ++k) {
+        VkCommandBuffer command_buffer;
+
+        ret = owl_renderer_begin_im_command_buffer(r);
+        if (ret)
+          goto error;
+
+        command_buffer = r->im_command_buffer;
+
+        owl_renderer_begin_scope(r, OWL_RENDERER_SCOPE_FILTER_MAPS);
+
+        {
+          viewport.width = dimension * OWL_POW(0.5, (double)j);
+          viewport.height = viewport.width;
+
+          vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+          vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        }
+
+        {
+          VkClearValue clear_value;
+          VkRenderPassBeginInfo info;
+
+          clear_value.color.float32[0] = 0.0F;
+          clear_value.color.float32[1] = 0.0F;
+          clear_value.color.float32[2] = 0.2F;
+          clear_value.color.float32[3] = 0.0F;
+
+          info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+          info.pNext = NULL;
+          info.renderPass = offscreen_pass;
+          info.framebuffer = offscreen_framebuffer;
+          info.renderArea.offset.x = 0;
+          info.renderArea.offset.y = 0;
+          info.renderArea.extent.width = dimension;
+          info.renderArea.extent.height = dimension;
+          info.clearValueCount = 1;
+          info.pClearValues = &clear_value;
+
+          vkCmdBeginRenderPass(command_buffer, &info,
+                               VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        {
+          vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            offscreen_pipeline);
+        }
+
+        if (OWL_IRRADIANCE_MAP == i) {
+          float fov;
+          float ratio;
+          float near;
+          float far;
+          owl_m4 perspective;
+          struct owl_renderer_irradiance_push_constant push_constant;
+
+          fov = OWL_PI / 2.0F;
+          ratio = 1.0F;
+          near = 0.1F;
+          far = 512.0F;
+          owl_m4_perspective(fov, ratio, near, far, perspective);
+          owl_m4_multiply(perspective, matrices[k], push_constant.mvp);
+
+          push_constant.delta_phi = 2.0F * OWL_PI / 180.0F;
+          push_constant.delta_theta = 0.5F * OWL_PI / 64.0F;
+
+          vkCmdPushConstants(command_buffer, offscreen_pipeline_layout,
+                             VK_SHADER_STAGE_VERTEX_BIT |
+                                 VK_SHADER_STAGE_FRAGMENT_BIT,
+                             0, sizeof(push_constant), &push_constant);
+        } else if (OWL_PREFILTERED_MAP == i) {
+          float fov;
+          float ratio;
+          float near;
+          float far;
+          owl_m4 perspective;
+          struct owl_renderer_prefiltered_push_constant push_constant;
+
+          fov = OWL_PI / 2.0F;
+          ratio = 1.0F;
+          near = 0.1F;
+          far = 512.0F;
+          owl_m4_perspective(fov, ratio, near, far, perspective);
+          owl_m4_multiply(perspective, matrices[k], push_constant.mvp);
+
+          push_constant.roughness = (float)j / (float)(mips - 1);
+          push_constant.samples = 32;
+
+          vkCmdPushConstants(command_buffer, offscreen_pipeline_layout,
+                             VK_SHADER_STAGE_VERTEX_BIT |
+                                 VK_SHADER_STAGE_FRAGMENT_BIT,
+                             0, sizeof(push_constant), &push_constant);
+        }
+
+        {
+          vkCmdBindDescriptorSets(command_buffer,
+                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                  offscreen_pipeline_layout, 0, 1,
+                                  &r->skybox.descriptor_set, 0, NULL);
+        }
+
+        {
+          struct owl_skybox_vertex *mapped_vertices;
+          struct owl_renderer_vertex_allocation vertex_allocation;
+          uint32_t *mapped_indices;
+          struct owl_renderer_index_allocation index_allocation;
+          /*
+           *    4----5
+           *  / |  / |
+           * 0----1  |
+           * |  | |  |
+           * |  6-|--7
+           * | /  | /
+           * 2----3
+           */
+          static struct owl_skybox_vertex const vertices[] = {
+              {-1.0F, -1.0F, -1.0F},                           /* 0 */
+              {1.0F, -1.0F, -1.0F},                            /* 1 */
+              {-1.0F, 1.0F, -1.0F},                            /* 2 */
+              {1.0F, 1.0F, -1.0F},                             /* 3 */
+              {-1.0F, -1.0F, 1.0F},                            /* 4 */
+              {1.0F, -1.0F, 1.0F},                             /* 5 */
+              {-1.0F, 1.0F, 1.0F},                             /* 6 */
+              {1.0F, 1.0F, 1.0F}};                             /* 7 */
+          static uint32_t const indices[] = {2, 3, 1, 1, 0, 2, /* face 0 .....*/
+                                             3, 7, 5, 5, 1, 3, /* face 1 */
+                                             6, 2, 0, 0, 4, 6, /* face 2 */
+                                             7, 6, 4, 4, 5, 7, /* face 3 */
+                                             3, 2, 6, 6, 7, 3, /* face 4 */
+                                             4, 0, 1, 1, 5, 4}; /* face 5 */
+
+          mapped_vertices = owl_renderer_vertex_allocate(r, sizeof(vertices),
+                                                         &vertex_allocation);
+          if (!mapped_vertices)
+            goto error;
+
+          mapped_indices = owl_renderer_index_allocate(r, sizeof(indices),
+                                                       &index_allocation);
+          if (!mapped_indices)
+            goto error;
+
+          OWL_MEMCPY(mapped_vertices, vertices, sizeof(vertices));
+          OWL_MEMCPY(mapped_indices, indices, sizeof(indices));
+
+          vkCmdBindVertexBuffers(command_buffer, 0, 1,
+                                 &vertex_allocation.buffer,
+                                 &vertex_allocation.offset);
+
+          vkCmdBindIndexBuffer(command_buffer, index_allocation.buffer,
+                               index_allocation.offset, VK_INDEX_TYPE_UINT32);
+
+          vkCmdDrawIndexed(command_buffer, OWL_ARRAY_SIZE(indices), 1, 0, 0, 0);
+        }
+
+        {
+          /* */
+          vkCmdEndRenderPass(command_buffer);
+        }
+
+        {
+          VkImageMemoryBarrier barrier;
+
+          barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+          barrier.pNext = NULL;
+          barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+          barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+          barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+          barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+          barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.image = offscreen_image;
+          barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          barrier.subresourceRange.baseMipLevel = 0;
+          barrier.subresourceRange.levelCount = 1;
+          barrier.subresourceRange.baseArrayLayer = 0;
+          barrier.subresourceRange.layerCount = 1;
+
+          vkCmdPipelineBarrier(command_buffer,
+                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL,
+                               0, NULL, 1, &barrier);
+        }
+
+        {
+          /**/
+          VkImageCopy copy;
+
+          copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          copy.srcSubresource.mipLevel = 0;
+          copy.srcSubresource.baseArrayLayer = 0;
+          copy.srcSubresource.layerCount = 1;
+          copy.srcOffset.x = 0;
+          copy.srcOffset.y = 0;
+          copy.srcOffset.z = 0;
+          copy.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          copy.dstSubresource.mipLevel = j;
+          copy.dstSubresource.baseArrayLayer = k;
+          copy.dstSubresource.layerCount = 1;
+          copy.dstOffset.x = 0;
+          copy.dstOffset.y = 0;
+          copy.dstOffset.z = 0;
+          copy.extent.width = viewport.width;
+          copy.extent.height = viewport.height;
+          copy.extent.depth = 1;
+
+          vkCmdCopyImage(command_buffer, offscreen_image,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, *images[i],
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+        }
+
+        {
+          VkImageMemoryBarrier barrier;
+
+          barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+          barrier.pNext = NULL;
+          barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+          barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+          barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+          barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+          barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+          barrier.image = offscreen_image;
+          barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          barrier.subresourceRange.baseMipLevel = 0;
+          barrier.subresourceRange.levelCount = 1;
+          barrier.subresourceRange.baseArrayLayer = 0;
+          barrier.subresourceRange.layerCount = 1;
+
+          vkCmdPipelineBarrier(command_buffer,
+                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL,
+                               0, NULL, 1, &barrier);
+        }
+
+        owl_renderer_end_scope(r, OWL_RENDERER_SCOPE_FILTER_MAPS);
+
+        ret = owl_renderer_end_im_command_buffer(r);
+        if (ret)
+          goto error;
+
+        owl_renderer_frame_clear_offset(r);
+      }
+    }
+
+    ret = owl_renderer_begin_im_command_buffer(r);
+    if (ret)
+      goto error;
+
+    {
+      VkImageMemoryBarrier barrier;
+      VkCommandBuffer const command_buffer = r->im_command_buffer;
+
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.pNext = NULL;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+/* TODO(samuel): verify
+https://github.com/SaschaWillems/Vulkan-glTF-PBR/blob/master/src/main.cpp#L1619
+*/
+#if 1
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+#else
+      barrier.dstAccessMask = 0;
+      barrier.dstAccessMask |= VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask |= VK_ACCESS_HOST_WRITE_BIT;
+#endif
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = *images[i];
+      barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      barrier.subresourceRange.baseMipLevel = 0;
+      barrier.subresourceRange.levelCount = mips;
+      barrier.subresourceRange.baseArrayLayer = 0;
+      barrier.subresourceRange.layerCount = 6;
+
+      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0,
+                           NULL, 1, &barrier);
+    }
+    ret = owl_renderer_end_im_command_buffer(r);
+    if (ret)
+      goto error;
+
+    if (OWL_PREFILTERED_MAP == i)
+      r->prefiltered_map_mipmaps = mips;
+
+    vkDestroyPipeline(device, offscreen_pipeline, NULL);
+    offscreen_pipeline = VK_NULL_HANDLE;
+
+    vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
+    offscreen_pipeline_layout = VK_NULL_HANDLE;
+
+    vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
+    offscreen_fragment_shader = VK_NULL_HANDLE;
+
+    vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
+    offscreen_vertex_shader = VK_NULL_HANDLE;
+
+    vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
+    offscreen_framebuffer = VK_NULL_HANDLE;
+
+    vkDestroyImageView(device, offscreen_image_view, NULL);
+    offscreen_image_view = VK_NULL_HANDLE;
+
+    owl_memory_free(r, &offscreen_memory);
+
+    vkDestroyImage(device, offscreen_image, NULL);
+    offscreen_image = VK_NULL_HANDLE;
+
+    vkDestroyRenderPass(device, offscreen_pass, NULL);
+    offscreen_pass = VK_NULL_HANDLE;
+  }
+
+  return OWL_OK;
+
+error:
+  owl_renderer_frame_clear_offset(r);
+
+  if (offscreen_pipeline)
+    vkDestroyPipeline(device, offscreen_pipeline, NULL);
+
+  if (offscreen_pipeline_layout)
+    vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
+
+  if (offscreen_fragment_shader)
+    vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
+
+  if (offscreen_vertex_shader)
+    vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
+
+  if (offscreen_framebuffer)
+    vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
+
+  if (offscreen_image_view)
+    vkDestroyImageView(device, offscreen_image_view, NULL);
+
+  owl_memory_free(r, &offscreen_memory);
+
+  if (offscreen_image)
+    vkDestroyImage(device, offscreen_image, NULL);
+
+  if (offscreen_pass)
+    vkDestroyRenderPass(device, offscreen_pass, NULL);
+
+  if (r->prefiltered_map_image_view)
+    vkDestroyImageView(device, r->prefiltered_map_image_view, NULL);
+
+  owl_memory_free(r, &r->prefiltered_map_memory);
+
+  if (r->prefiltered_map_image)
+    vkDestroyImage(device, r->prefiltered_map_image, NULL);
+
+  if (r->irradiance_map_image_view)
+    vkDestroyImageView(device, r->irradiance_map_image_view, NULL);
+
+  owl_memory_free(r, &r->irradiance_map_memory);
+
+  if (r->irradiance_map_image)
+    vkDestroyImage(device, r->irradiance_map_image, NULL);
+
+  return OWL_ERROR_FATAL;
+}
+
+static void owl_renderer_deinit_filter_maps(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+
+  vkDestroyImageView(device, r->prefiltered_map_image_view, NULL);
+  owl_memory_free(r, &r->prefiltered_map_memory);
+  vkDestroyImage(device, r->prefiltered_map_image, NULL);
+  vkDestroyImageView(device, r->irradiance_map_image_view, NULL);
+  owl_memory_free(r, &r->irradiance_map_memory);
+  vkDestroyImage(device, r->irradiance_map_image, NULL);
+}
+
+/* TODO(samuel): cleanup function */
+static int owl_renderer_init_brdflut(struct owl_renderer *r) {
+  int ret = OWL_OK;
+  VkFormat const format = VK_FORMAT_R16G16_SFLOAT;
+  uint32_t const dimension = 512;
+
+  static uint32_t const vertex_shader_source[] = {
+#include "owl_brdflut.vert.spv.u32"
+  };
+
+  static uint32_t const fragment_shader_source[] = {
+#include "owl_brdflut.frag.spv.u32"
+  };
+
+  VkRenderPass offscreen_pass = VK_NULL_HANDLE;
+  VkFramebuffer offscreen_framebuffer = VK_NULL_HANDLE;
+  VkShaderModule offscreen_vertex_shader = VK_NULL_HANDLE;
+  VkShaderModule offscreen_fragment_shader = VK_NULL_HANDLE;
+  VkPipelineLayout offscreen_pipeline_layout = VK_NULL_HANDLE;
+  VkPipeline offscreen_pipeline = VK_NULL_HANDLE;
+  VkDevice const device = r->device;
+
+  r->brdflut_map_memory.memory = VK_NULL_HANDLE;
+
+  {
+    VkImageCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = format;
+    info.extent.width = dimension;
+    info.extent.height = dimension;
+    info.extent.depth = 1;
+    info.mipLevels = 1;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = 0;
+    info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    vk_result = vkCreateImage(device, &info, NULL, &r->brdflut_map_image);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
+
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    vkGetImageMemoryRequirements(device, r->brdflut_map_image, &requirements);
+
+    ret = owl_memory_allocate(r, &requirements, properties,
+                              &r->brdflut_map_memory);
+    if (ret)
+      goto error;
+
+    ret = owl_memory_bind_image(r, r->brdflut_map_image,
+                                &r->brdflut_map_memory);
+    if (ret)
+      goto error;
+  }
+
+  {
+    VkImageViewCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.image = r->brdflut_map_image;
+    info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    info.format = format;
+    info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    info.subresourceRange.baseMipLevel = 0;
+    info.subresourceRange.levelCount = 1;
+    info.subresourceRange.baseArrayLayer = 0;
+    info.subresourceRange.layerCount = 1;
+
+    vk_result =
+        vkCreateImageView(device, &info, NULL, &r->brdflut_map_image_view);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkAttachmentReference color_reference;
+    VkAttachmentDescription attachment;
+    VkSubpassDescription subpass;
+    VkSubpassDependency dependency;
+    VkRenderPassCreateInfo info;
+    VkResult vk_result;
+
+    color_reference.attachment = 0;
+    color_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    attachment.flags = 0;
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    subpass.flags = 0;
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.inputAttachmentCount = 0;
+    subpass.pInputAttachments = NULL;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &color_reference;
+    subpass.pResolveAttachments = NULL;
+    subpass.pDepthStencilAttachment = NULL;
+    subpass.preserveAttachmentCount = 0;
+    subpass.pPreserveAttachments = NULL;
+
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = 0;
+    dependency.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.dstStageMask = 0;
+    dependency.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask = 0;
+    dependency.dstAccessMask = 0;
+    dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dependencyFlags = 0;
+
+    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.attachmentCount = 1;
+    info.pAttachments = &attachment;
+    info.subpassCount = 1;
+    info.pSubpasses = &subpass;
+    info.dependencyCount = 1;
+    info.pDependencies = &dependency;
+
+    vk_result = vkCreateRenderPass(device, &info, NULL, &offscreen_pass);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkFramebufferCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.renderPass = offscreen_pass;
+    info.attachmentCount = 1;
+    info.pAttachments = &r->brdflut_map_image_view;
+    info.width = dimension;
+    info.height = dimension;
+    info.layers = 1;
+
+    vk_result =
+        vkCreateFramebuffer(device, &info, NULL, &offscreen_framebuffer);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkPipelineLayoutCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.setLayoutCount = 0;
+    info.pSetLayouts = NULL;
+    info.pushConstantRangeCount = 0;
+    info.pPushConstantRanges = NULL;
+
+    vk_result =
+        vkCreatePipelineLayout(device, &info, NULL, &offscreen_pipeline_layout);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(vertex_shader_source);
+    info.pCode = vertex_shader_source;
+
+    vk_result =
+        vkCreateShaderModule(device, &info, NULL, &offscreen_vertex_shader);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkShaderModuleCreateInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.codeSize = sizeof(fragment_shader_source);
+    info.pCode = fragment_shader_source;
+
+    vk_result =
+        vkCreateShaderModule(device, &info, NULL, &offscreen_fragment_shader);
+    if (vk_result)
+      goto error;
+  }
+
+  {
+    VkPipelineVertexInputStateCreateInfo vertex_input;
+    VkPipelineInputAssemblyStateCreateInfo input_assembly;
+    VkViewport viewport;
+    VkRect2D scissor;
+    VkPipelineViewportStateCreateInfo viewport_state;
+    VkPipelineRasterizationStateCreateInfo rasterization;
+    VkPipelineMultisampleStateCreateInfo multisample;
+    VkPipelineColorBlendAttachmentState color_attachment;
+    VkPipelineColorBlendStateCreateInfo color;
+    VkPipelineDepthStencilStateCreateInfo depth;
+    VkPipelineShaderStageCreateInfo stages[2];
+    VkGraphicsPipelineCreateInfo info;
+    VkResult vk_result;
+
+    vertex_input.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input.pNext = NULL;
+    vertex_input.flags = 0;
+    vertex_input.vertexBindingDescriptionCount = 0;
+    vertex_input.pVertexBindingDescriptions = NULL;
+    vertex_input.vertexAttributeDescriptionCount = 0;
+    vertex_input.pVertexAttributeDescriptions = NULL;
+
+    input_assembly.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.pNext = NULL;
+    input_assembly.flags = 0;
+    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    input_assembly.primitiveRestartEnable = VK_FALSE;
+
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = dimension;
+    viewport.height = dimension;
+    viewport.minDepth = 0.0F;
+    viewport.maxDepth = 1.0F;
+
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    scissor.extent.width = dimension;
+    scissor.extent.height = dimension;
+
+    viewport_state.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state.pNext = NULL;
+    viewport_state.flags = 0;
+    viewport_state.viewportCount = 1;
+    viewport_state.pViewports = &viewport;
+    viewport_state.scissorCount = 1;
+    viewport_state.pScissors = &scissor;
+
+    rasterization.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.pNext = NULL;
+    rasterization.flags = 0;
+    rasterization.depthClampEnable = VK_FALSE;
+    rasterization.rasterizerDiscardEnable = VK_FALSE;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.depthBiasEnable = VK_FALSE;
+    rasterization.depthBiasConstantFactor = 0.0F;
+    rasterization.depthBiasClamp = 0.0F;
+    rasterization.depthBiasSlopeFactor = 0.0F;
+    rasterization.lineWidth = 1.0F;
+
+    multisample.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.pNext = NULL;
+    multisample.flags = 0;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisample.sampleShadingEnable = VK_FALSE;
+    multisample.minSampleShading = 0.0F;
+    multisample.pSampleMask = NULL;
+    multisample.alphaToCoverageEnable = VK_FALSE;
+    multisample.alphaToOneEnable = VK_FALSE;
+
+    color_attachment.blendEnable = VK_FALSE;
+    color_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    color_attachment.colorWriteMask = 0;
+    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
+    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
+    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
+    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+
+    color.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color.pNext = NULL;
+    color.flags = 0;
+    color.logicOpEnable = VK_FALSE;
+    color.logicOp = VK_LOGIC_OP_CLEAR;
+    color.attachmentCount = 1;
+    color.pAttachments = &color_attachment;
+    color.blendConstants[0] = 0.0F;
+    color.blendConstants[1] = 0.0F;
+    color.blendConstants[2] = 0.0F;
+    color.blendConstants[3] = 0.0F;
+
+    depth.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depth.pNext = NULL;
+    depth.flags = 0;
+    depth.depthTestEnable = VK_FALSE;
+    depth.depthWriteEnable = VK_FALSE;
+    depth.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    depth.depthBoundsTestEnable = VK_FALSE;
+    depth.stencilTestEnable = VK_FALSE;
+    depth.front.failOp = VK_STENCIL_OP_KEEP;
+    depth.front.passOp = VK_STENCIL_OP_KEEP;
+    depth.front.depthFailOp = VK_STENCIL_OP_KEEP;
+    depth.front.compareOp = VK_COMPARE_OP_NEVER;
+    depth.front.compareMask = 0;
+    depth.front.writeMask = 0;
+    depth.front.reference = 0;
+    depth.back.failOp = VK_STENCIL_OP_KEEP;
+    depth.back.passOp = VK_STENCIL_OP_KEEP;
+    depth.back.depthFailOp = VK_STENCIL_OP_KEEP;
+    depth.back.compareOp = VK_COMPARE_OP_ALWAYS;
+    depth.back.compareMask = 0;
+    depth.back.writeMask = 0;
+    depth.back.reference = 0;
+    depth.minDepthBounds = 0.0F;
+    depth.maxDepthBounds = 0.0F;
+
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].pNext = NULL;
+    stages[0].flags = 0;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = offscreen_vertex_shader;
+    stages[0].pName = "main";
+    stages[0].pSpecializationInfo = NULL;
+
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].pNext = NULL;
+    stages[1].flags = 0;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = offscreen_fragment_shader;
+    stages[1].pName = "main";
+    stages[1].pSpecializationInfo = NULL;
+
+    info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.stageCount = OWL_ARRAY_SIZE(stages);
+    info.pStages = stages;
+    info.pVertexInputState = &vertex_input;
+    info.pInputAssemblyState = &input_assembly;
+    info.pTessellationState = NULL;
+    info.pViewportState = &viewport_state;
+    info.pRasterizationState = &rasterization;
+    info.pMultisampleState = &multisample;
+    info.pDepthStencilState = &depth;
+    info.pColorBlendState = &color;
+    info.pDynamicState = NULL;
+    info.layout = offscreen_pipeline_layout;
+    info.renderPass = offscreen_pass;
+    info.subpass = 0;
+    info.basePipelineHandle = VK_NULL_HANDLE;
+    info.basePipelineIndex = -1;
+
+    vk_result = vkCreateGraphicsPipelines(device, r->pipeline_cache, 1, &info,
+                                          NULL, &offscreen_pipeline);
+    if (vk_result)
+      goto error;
+  }
+
+  ret = owl_renderer_begin_im_command_buffer(r);
+  if (ret)
+    goto error;
+
+  {
+    VkClearValue clear_value;
+    VkRenderPassBeginInfo info;
+    VkCommandBuffer const command_buffer = r->im_command_buffer;
+
+    clear_value.color.float32[0] = 0.0F;
+    clear_value.color.float32[1] = 0.0F;
+    clear_value.color.float32[2] = 0.0F;
+    clear_value.color.float32[3] = 1.0F;
+
+    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    info.pNext = NULL;
+    info.renderPass = offscreen_pass;
+    info.framebuffer = offscreen_framebuffer;
+    info.renderArea.offset.x = 0;
+    info.renderArea.offset.y = 0;
+    info.renderArea.extent.width = dimension;
+    info.renderArea.extent.height = dimension;
+    info.clearValueCount = 1;
+    info.pClearValues = &clear_value;
+
+    vkCmdBeginRenderPass(command_buffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+  }
+
+  {
+    VkCommandBuffer const command_buffer = r->im_command_buffer;
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      offscreen_pipeline);
+    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+  }
+
+  {
+    VkCommandBuffer const command_buffer = r->im_command_buffer;
+    vkCmdEndRenderPass(command_buffer);
+  }
+
+  ret = owl_renderer_end_im_command_buffer(r);
+  if (ret)
+    goto error;
+
+  ret = owl_renderer_begin_im_command_buffer(r);
+  if (ret)
+    goto error;
+
+  {
+    VkImageMemoryBarrier barrier;
+    VkCommandBuffer const command_buffer = r->im_command_buffer;
+
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = r->brdflut_map_image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0,
+                         NULL, 1, &barrier);
+  }
+
+  ret = owl_renderer_end_im_command_buffer(r);
+  if (ret)
+    goto error;
+
+  vkDestroyPipeline(device, offscreen_pipeline, NULL);
+  vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
+  vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
+  vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
+  vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
+  vkDestroyRenderPass(device, offscreen_pass, NULL);
+
+  return OWL_OK;
+
+error:
+  if (offscreen_pipeline)
+    vkDestroyPipeline(device, offscreen_pipeline, NULL);
+
+  if (offscreen_pipeline_layout)
+    vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
+
+  if (offscreen_fragment_shader)
+    vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
 
-      vk_result =
-          vkCreateShaderModule(device, &info, NULL, &offscreen_fragment_shader);
-      if (vk_result)
-        goto error;
-    }
+  if (offscreen_vertex_shader)
+    vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
 
-    {
-      VkVertexInputBindingDescription vertex_binding;
-      VkVertexInputAttributeDescription vertex_attribute;
-      VkPipelineVertexInputStateCreateInfo vertex_input;
-      VkPipelineInputAssemblyStateCreateInfo input_assembly;
-      VkPipelineViewportStateCreateInfo viewport_state;
-      VkPipelineRasterizationStateCreateInfo rasterization;
-      VkPipelineMultisampleStateCreateInfo multisample;
-      VkPipelineColorBlendAttachmentState color_attachment;
-      VkPipelineColorBlendStateCreateInfo color;
-      VkPipelineDepthStencilStateCreateInfo depth;
-      VkDynamicState dynamic[2];
-      VkPipelineDynamicStateCreateInfo dynamic_state;
-      VkPipelineShaderStageCreateInfo stages[2];
-      VkGraphicsPipelineCreateInfo info;
-      VkResult vk_result;
+  if (offscreen_framebuffer)
+    vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
 
-      vertex_binding.binding = 0;
-      /* TODO(samuel): remove dependance on the skybox vertex */
-      vertex_binding.stride = sizeof(struct owl_skybox_vertex);
-      vertex_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  if (offscreen_pass)
+    vkDestroyRenderPass(device, offscreen_pass, NULL);
 
-      vertex_attribute.location = 0;
-      vertex_attribute.binding = 0;
-      vertex_attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-      vertex_attribute.offset = offsetof(struct owl_skybox_vertex, position);
+  if (r->brdflut_map_image_view)
+    vkDestroyImageView(device, r->brdflut_map_image_view, NULL);
 
-      vertex_input.sType =
-          VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-      vertex_input.pNext = NULL;
-      vertex_input.flags = 0;
-      vertex_input.vertexBindingDescriptionCount = 1;
-      vertex_input.pVertexBindingDescriptions = &vertex_binding;
-      vertex_input.vertexAttributeDescriptionCount = 1;
-      vertex_input.pVertexAttributeDescriptions = &vertex_attribute;
+  owl_memory_free(r, &r->brdflut_map_memory);
 
-      input_assembly.sType =
-          VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-      input_assembly.pNext = NULL;
-      input_assembly.flags = 0;
-      input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-      input_assembly.primitiveRestartEnable = VK_FALSE;
+  if (r->brdflut_map_image)
+    vkDestroyImage(device, r->brdflut_map_image, NULL);
 
-      viewport.x = 0;
-      viewport.y = 0;
-      viewport.width = dimension;
-      viewport.height = dimension;
-      viewport.minDepth = 0.0F;
-      viewport.maxDepth = 1.0F;
+  return OWL_ERROR_FATAL;
+}
 
-      scissor.offset.x = 0;
-      scissor.offset.y = 0;
-      scissor.extent.width = dimension;
-      scissor.extent.height = dimension;
+static void owl_renderer_deinit_brdflut(struct owl_renderer *r) {
+  VkDevice const device = r->device;
+  vkDestroyImageView(device, r->brdflut_map_image_view, NULL);
+  owl_memory_free(r, &r->brdflut_map_memory);
+  vkDestroyImage(device, r->brdflut_map_image, NULL);
+}
 
-      viewport_state.sType =
-          VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-      viewport_state.pNext = NULL;
-      viewport_state.flags = 0;
-      viewport_state.viewportCount = 1;
-      viewport_state.pViewports = &viewport;
-      viewport_state.scissorCount = 1;
-      viewport_state.pScissors = &scissor;
+static int owl_renderer_init_common(struct owl_renderer *r, uint32_t width,
+                                    uint32_t height, uint32_t num_frames,
+                                    char const *pipeline_cache_path) {
+  owl_v3 up;
+  int ret;
+  float ratio;
+  float const fov = OWL_DEGREES_AS_RADIANS(45.0F);
+  float const near = 0.01;
+  float const far = 512.0F;
 
-      rasterization.sType =
-          VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-      rasterization.pNext = NULL;
-      rasterization.flags = 0;
-      rasterization.depthClampEnable = VK_FALSE;
-      rasterization.rasterizerDiscardEnable = VK_FALSE;
-      rasterization.polygonMode = VK_POLYGON_MODE_FILL;
-      rasterization.cullMode = VK_CULL_MODE_NONE;
-      rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-      rasterization.depthBiasEnable = VK_FALSE;
-      rasterization.depthBiasConstantFactor = 0.0F;
-      rasterization.depthBiasClamp = 0.0F;
-      rasterization.depthBiasSlopeFactor = 0.0F;
-      rasterization.lineWidth = 1.0F;
+  r->im_command_buffer = VK_NULL_HANDLE;
+  r->skybox_loaded = 0;
+  r->font_loaded = 0;
+  r->font_generation = 0;
+  r->swapchain = VK_NULL_HANDLE;
+  r->num_frames = num_frames;
+  r->frame_state_lost = 0;
 
-      multisample.sType =
-          VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-      multisample.pNext = NULL;
-      multisample.flags = 0;
-      multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-      multisample.sampleShadingEnable = VK_FALSE;
-      multisample.minSampleShading = 0.0F;
-      multisample.pSampleMask = NULL;
-      multisample.alphaToCoverageEnable = VK_FALSE;
-      multisample.alphaToOneEnable = VK_FALSE;
+  if (pipeline_cache_path) {
+    if (OWL_MAX_PIPELINE_CACHE_PATH_LENGTH <= OWL_STRLEN(pipeline_cache_path))
+      return OWL_ERROR_INVALID_VALUE;
 
-      color_attachment.blendEnable = VK_FALSE;
-      color_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-      color_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-      color_attachment.colorBlendOp = VK_BLEND_OP_ADD;
-      color_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-      color_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-      color_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-      color_attachment.colorWriteMask = 0;
-      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
-      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
-      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
-      color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+    OWL_STRNCPY(r->pipeline_cache_path, pipeline_cache_path,
+                OWL_MAX_PIPELINE_CACHE_PATH_LENGTH);
+  } else {
+    r->pipeline_cache_path[0] = '\0';
+  }
+  r->frame_count = 0;
+  r->num_threads = 0;
 
-      color.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-      color.pNext = NULL;
-      color.flags = 0;
-      color.logicOpEnable = VK_FALSE;
-      color.logicOp = VK_LOGIC_OP_CLEAR;
-      color.attachmentCount = 1;
-      color.pAttachments = &color_attachment;
-      color.blendConstants[0] = 0.0F;
-      color.blendConstants[1] = 0.0F;
-      color.blendConstants[2] = 0.0F;
-      color.blendConstants[3] = 0.0F;
+  r->clear_values[0].color.float32[0] = 0.0F;
+  r->clear_values[0].color.float32[1] = 0.0F;
+  r->clear_values[0].color.float32[2] = 0.0F;
+  r->clear_values[0].color.float32[3] = 1.0F;
+  r->clear_values[1].depthStencil.depth = 1.0F;
+  r->clear_values[1].depthStencil.stencil = 0.0F;
 
-      depth.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-      depth.pNext = NULL;
-      depth.flags = 0;
-      depth.depthTestEnable = VK_FALSE;
-      depth.depthWriteEnable = VK_FALSE;
-      depth.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-      depth.depthBoundsTestEnable = VK_FALSE;
-      depth.stencilTestEnable = VK_FALSE;
-      depth.front.failOp = VK_STENCIL_OP_KEEP;
-      depth.front.passOp = VK_STENCIL_OP_KEEP;
-      depth.front.depthFailOp = VK_STENCIL_OP_KEEP;
-      depth.front.compareOp = VK_COMPARE_OP_NEVER;
-      depth.front.compareMask = 0;
-      depth.front.writeMask = 0;
-      depth.front.reference = 0;
-      depth.back.failOp = VK_STENCIL_OP_KEEP;
-      depth.back.passOp = VK_STENCIL_OP_KEEP;
-      depth.back.depthFailOp = VK_STENCIL_OP_KEEP;
-      depth.back.compareOp = VK_COMPARE_OP_ALWAYS;
-      depth.back.compareMask = 0;
-      depth.back.writeMask = 0;
-      depth.back.reference = 0;
-      depth.minDepthBounds = 0.0F;
-      depth.maxDepthBounds = 0.0F;
+  r->width = width;
+  r->height = height;
 
-      stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-      stages[0].pNext = NULL;
-      stages[0].flags = 0;
-      stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-      stages[0].module = offscreen_vertex_shader;
-      stages[0].pName = "main";
-      stages[0].pSpecializationInfo = NULL;
+  ratio = (float)width / (float)height;
 
-      stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-      stages[1].pNext = NULL;
-      stages[1].flags = 0;
-      stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-      stages[1].module = offscreen_fragment_shader;
-      stages[1].pName = "main";
-      stages[1].pSpecializationInfo = NULL;
+  OWL_V3_SET(r->camera_eye, 0.0F, -0.5F, 3.0F);
+  OWL_V4_SET(r->camera_direction, 0.0F, 0.0F, 1.0F, 1.0F);
+  OWL_V3_SET(up, 0.0F, 1.0F, 0.0F);
+
+  owl_m4_perspective(fov, ratio, near, far, r->projection);
+  owl_m4_look(r->camera_eye, r->camera_direction, up, r->view);
+
+  ret = owl_renderer_init_instance(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize instance!\n");
+    goto error;
+  }
+
+  ret = owl_renderer_init_surface(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize surface!\n");
+    goto error_deinit_instance;
+  }
+
+  ret = owl_renderer_select_physical_device(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Couldn't find physical device\n");
+    goto error_deinit_surface;
+  }
+
+  ret = owl_renderer_clamp_dimensions(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Couldn't clamp dimensions\n");
+    goto error_deinit_surface;
+  }
+
+  ret = owl_renderer_init_device(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize device!\n");
+    goto error_deinit_surface;
+  }
+
+  ret = owl_memory_init(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize memory!\n");
+    goto error_deinit_device;
+  }
+
+  ret = owl_renderer_init_pipeline_cache(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize pipeline cache!\n");
+    goto error_deinit_memory;
+  }
+
+  ret = owl_renderer_init_attachments(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize attachments\n");
+    goto error_deinit_pipeline_cache;
+  }
+
+  ret = owl_renderer_init_render_passes(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize render passes!\n");
+    goto error_deinit_attachments;
+  }
+
+  ret = owl_renderer_init_swapchain(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize swapchain!\n");
+    goto error_deinit_render_passes;
+  }
+
+  ret = owl_renderer_init_pools(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize pools!\n");
+    goto error_deinit_swapchain;
+  }
+
+  ret = owl_renderer_init_layouts(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize layouts!\n");
+    goto error_deinit_pools;
+  }
 
-      dynamic[0] = VK_DYNAMIC_STATE_VIEWPORT;
-      dynamic[1] = VK_DYNAMIC_STATE_SCISSOR;
+  ret = owl_renderer_init_graphics_pipelines(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize graphics pipelines!\n");
+    goto error_deinit_layouts;
+  }
 
-      dynamic_state.sType =
-          VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-      dynamic_state.pNext = NULL;
-      dynamic_state.flags = 0;
-      dynamic_state.dynamicStateCount = OWL_ARRAY_SIZE(dynamic);
-      dynamic_state.pDynamicStates = dynamic;
+  ret = owl_renderer_init_upload_buffer(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize upload heap!\n");
+    goto error_deinit_graphics_pipelines;
+  }
 
-      info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-      info.pNext = NULL;
-      info.flags = 0;
-      info.stageCount = OWL_ARRAY_SIZE(stages);
-      info.pStages = stages;
-      info.pVertexInputState = &vertex_input;
-      info.pInputAssemblyState = &input_assembly;
-      info.pTessellationState = NULL;
-      info.pViewportState = &viewport_state;
-      info.pRasterizationState = &rasterization;
-      info.pMultisampleState = &multisample;
-      info.pDepthStencilState = &depth;
-      info.pColorBlendState = &color;
-      info.pDynamicState = &dynamic_state;
-      info.layout = offscreen_pipeline_layout;
-      info.renderPass = offscreen_pass;
-      info.subpass = 0;
-      info.basePipelineHandle = VK_NULL_HANDLE;
-      info.basePipelineIndex = -1;
+  ret = owl_renderer_init_async_uploads(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize async uploads!\n");
+    goto error_deinit_upload_buffer;
+  }
 
-      vk_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info,
-                                            NULL, &offscreen_pipeline);
-      if (vk_result)
-        goto error;
-    }
+  ret = owl_renderer_init_samplers(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize samplers!\n");
+    goto error_deinit_async_uploads;
+  }
 
-    {
-      float angle;
-      owl_v3 axis;
-      owl_m4 tmp;
+  ret = owl_renderer_init_bindless(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize bindless!\n");
+    goto error_deinit_samplers;
+  }
 
-      OWL_M4_IDENTITY(tmp);
-      angle = OWL_DEGREES_AS_RADIANS(90.0F);
-      axis[0] = 0.0F;
-      axis[1] = 1.0F;
-      axis[2] = 0.0F;
-      owl_m4_rotate(tmp, angle, axis, tmp);
-      angle = OWL_DEGREES_AS_RADIANS(180.0F);
-      axis[0] = 1.0F;
-      axis[1] = 0.0F;
-      axis[2] = 0.0F;
-      owl_m4_rotate(tmp, angle, axis, matrices[0]);
+  ret = owl_renderer_init_frames(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize frames!\n");
+    goto error_deinit_bindless;
+  }
 
-      OWL_M4_IDENTITY(tmp);
-      angle = OWL_DEGREES_AS_RADIANS(-90.0F);
-      axis[0] = 0.0F;
-      axis[1] = 1.0F;
-      axis[2] = 0.0F;
-      owl_m4_rotate(tmp, angle, axis, tmp);
-      angle = OWL_DEGREES_AS_RADIANS(180.0F);
-      axis[0] = 1.0F;
-      axis[1] = 0.0F;
-      axis[2] = 0.0F;
-      owl_m4_rotate(tmp, angle, axis, matrices[1]);
+  ret = owl_renderer_init_timestamps(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize timestamps!\n");
+    goto error_deinit_frames;
+  }
 
-      OWL_M4_IDENTITY(tmp);
-      angle = OWL_DEGREES_AS_RADIANS(-90.0F);
-      axis[0] = 1.0F;
-      axis[1] = 0.0F;
-      axis[2] = 0.0F;
-      owl_m4_rotate(tmp, angle, axis, matrices[2]);
+  ret = owl_renderer_init_garbage(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize garbage!\n");
+    goto error_deinit_timestamps;
+  }
 
-      OWL_M4_IDENTITY(tmp);
-      angle = OWL_DEGREES_AS_RADIANS(90.0F);
-      axis[0] = 1.0F;
-      axis[1] = 0.0F;
-      axis[2] = 0.0F;
-      owl_m4_rotate(tmp, angle, axis, matrices[3]);
+  r->frame_page_size = OWL_FRAME_PAGE_SIZE;
 
-      OWL_M4_IDENTITY(tmp);
-      angle = OWL_DEGREES_AS_RADIANS(180.0F);
-      axis[0] = 1.0F;
-      axis[1] = 0.0F;
-      axis[2] = 0.0F;
-      owl_m4_rotate(tmp, angle, axis, matrices[4]);
+  ret = owl_renderer_init_frame_allocator(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize frame allocator!\n");
+    goto error_deinit_garbage;
+  }
 
-      OWL_M4_IDENTITY(tmp);
-      angle = OWL_DEGREES_AS_RADIANS(180.0F);
-      axis[0] = 0.0F;
-      axis[1] = 0.0F;
-      axis[2] = 1.0F;
-      owl_m4_rotate(tmp, angle, axis, matrices[5]);
-    }
+  ret = owl_renderer_init_quad_batch(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize quad batch!\n");
+    goto error_deinit_frame_allocator;
+  }
 
-    ret = owl_renderer_begin_im_command_buffer(r);
-    if (ret)
-      goto error;
+  ret = owl_renderer_init_depth_pyramid(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize depth pyramid!\n");
+    goto error_deinit_quad_batch;
+  }
 
-    {
-      VkImageMemoryBarrier barrier;
-      VkCommandBuffer const command_buffer = r->im_command_buffer;
+  return OWL_OK;
 
-      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-      barrier.pNext = NULL;
-      barrier.srcAccessMask = VK_ACCESS_NONE;
-      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-      barrier.image = *images[i];
-      barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      barrier.subresourceRange.baseMipLevel = 0;
-      barrier.subresourceRange.levelCount = mips;
-      barrier.subresourceRange.baseArrayLayer = 0;
-      barrier.subresourceRange.layerCount = 6;
+error_deinit_quad_batch:
+  owl_renderer_deinit_quad_batch(r);
 
-      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0,
-                           NULL, 1, &barrier);
-    }
+error_deinit_frame_allocator:
+  owl_renderer_deinit_frame_allocator(r);
 
-    ret = owl_renderer_end_im_command_buffer(r);
-    if (ret)
-      goto error;
+error_deinit_garbage:
+  owl_renderer_deinit_garbage(r);
 
-    for (j = 0; j < mips; ++j) {
-      uint32_t k;
-      for (k = 0; k < 6; ++k) {
-        VkCommandBuffer command_buffer;
+error_deinit_timestamps:
+  owl_renderer_deinit_timestamps(r);
 
-        ret = owl_renderer_begin_im_command_buffer(r);
-        if (ret)
-          goto error;
+error_deinit_frames:
+  owl_renderer_deinit_frames(r);
 
-        command_buffer = r->im_command_buffer;
+error_deinit_bindless:
+  owl_renderer_deinit_bindless(r);
 
-        {
-          viewport.width = dimension * OWL_POW(0.5, (double)j);
-          viewport.height = viewport.width;
+error_deinit_samplers:
+  owl_renderer_deinit_samplers(r);
 
-          vkCmdSetViewport(command_buffer, 0, 1, &viewport);
-          vkCmdSetScissor(command_buffer, 0, 1, &scissor);
-        }
+error_deinit_async_uploads:
+  owl_renderer_deinit_async_uploads(r);
 
-        {
-          VkClearValue clear_value;
-          VkRenderPassBeginInfo info;
+error_deinit_upload_buffer:
+  owl_renderer_deinit_upload_buffer(r);
 
-          clear_value.color.float32[0] = 0.0F;
-          clear_value.color.float32[1] = 0.0F;
-          clear_value.color.float32[2] = 0.2F;
-          clear_value.color.float32[3] = 0.0F;
+error_deinit_graphics_pipelines:
+  owl_renderer_deinit_graphics_pipelines(r);
 
-          info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-          info.pNext = NULL;
-          info.renderPass = offscreen_pass;
-          info.framebuffer = offscreen_framebuffer;
-          info.renderArea.offset.x = 0;
-          info.renderArea.offset.y = 0;
-          info.renderArea.extent.width = dimension;
-          info.renderArea.extent.height = dimension;
-          info.clearValueCount = 1;
-          info.pClearValues = &clear_value;
+error_deinit_layouts:
+  owl_renderer_deinit_layouts(r);
 
-          vkCmdBeginRenderPass(command_buffer, &info,
-                               VK_SUBPASS_CONTENTS_INLINE);
-        }
+error_deinit_pools:
+  owl_renderer_deinit_pools(r);
 
-        {
-          vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            offscreen_pipeline);
-        }
+error_deinit_swapchain:
+  owl_renderer_deinit_swapchain(r);
 
-        if (OWL_IRRADIANCE_MAP == i) {
-          float fov;
-          float ratio;
-          float near;
-          float far;
-          owl_m4 perspective;
-          struct owl_renderer_irradiance_push_constant push_constant;
+error_deinit_render_passes:
+  owl_renderer_deinit_render_passes(r);
 
-          fov = OWL_PI / 2.0F;
-          ratio = 1.0F;
-          near = 0.1F;
-          far = 512.0F;
-          owl_m4_perspective(fov, ratio, near, far, perspective);
-          owl_m4_multiply(perspective, matrices[k], push_constant.mvp);
+error_deinit_attachments:
+  owl_renderer_deinit_attachments(r);
 
-          push_constant.delta_phi = 2.0F * OWL_PI / 180.0F;
-          push_constant.delta_theta = 0.5F * OWL_PI / 64.0F;
+error_deinit_pipeline_cache:
+  owl_renderer_deinit_pipeline_cache(r);
 
-          vkCmdPushConstants(command_buffer, offscreen_pipeline_layout,
-                             VK_SHADER_STAGE_VERTEX_BIT |
-                                 VK_SHADER_STAGE_FRAGMENT_BIT,
-                             0, sizeof(push_constant), &push_constant);
-        } else if (OWL_PREFILTERED_MAP == i) {
-          float fov;
-          float ratio;
-          float near;
-          float far;
-          owl_m4 perspective;
-          struct owl_renderer_prefiltered_push_constant push_constant;
+error_deinit_memory:
+  owl_memory_deinit(r);
 
-          fov = OWL_PI / 2.0F;
-          ratio = 1.0F;
-          near = 0.1F;
-          far = 512.0F;
-          owl_m4_perspective(fov, ratio, near, far, perspective);
-          owl_m4_multiply(perspective, matrices[k], push_constant.mvp);
+error_deinit_device:
+  owl_renderer_deinit_device(r);
 
-          push_constant.roughness = (float)j / (float)(mips - 1);
-          push_constant.samples = 32;
+error_deinit_surface:
+  owl_renderer_deinit_surface(r);
 
-          vkCmdPushConstants(command_buffer, offscreen_pipeline_layout,
-                             VK_SHADER_STAGE_VERTEX_BIT |
-                                 VK_SHADER_STAGE_FRAGMENT_BIT,
-                             0, sizeof(push_constant), &push_constant);
-        }
+error_deinit_instance:
+  owl_renderer_deinit_instance(r);
+
+error:
+  return ret;
+}
 
-        {
-          vkCmdBindDescriptorSets(command_buffer,
-                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                  offscreen_pipeline_layout, 0, 1,
-                                  &r->skybox.descriptor_set, 0, NULL);
-        }
+OWLAPI int owl_renderer_init(struct owl_renderer *r, struct owl_plataform *p,
+                             uint32_t num_frames,
+                             char const *pipeline_cache_path) {
+  uint32_t width;
+  uint32_t height;
 
-        {
-          struct owl_skybox_vertex *mapped_vertices;
-          struct owl_renderer_vertex_allocation vertex_allocation;
-          uint32_t *mapped_indices;
-          struct owl_renderer_index_allocation index_allocation;
-          /*
-           *    4----5
-           *  / |  / |
-           * 0----1  |
-           * |  | |  |
-           * |  6-|--7
-           * | /  | /
-           * 2----3
-           */
-          static struct owl_skybox_vertex const vertices[] = {
-              {-1.0F, -1.0F, -1.0F},                           /* 0 */
-              {1.0F, -1.0F, -1.0F},                            /* 1 */
-              {-1.0F, 1.0F, -1.0F},                            /* 2 */
-              {1.0F, 1.0F, -1.0F},                             /* 3 */
-              {-1.0F, -1.0F, 1.0F},                            /* 4 */
-              {1.0F, -1.0F, 1.0F},                             /* 5 */
-              {-1.0F, 1.0F, 1.0F},                             /* 6 */
-              {1.0F, 1.0F, 1.0F}};                             /* 7 */
-          static uint32_t const indices[] = {2, 3, 1, 1, 0, 2, /* face 0 .....*/
-                                             3, 7, 5, 5, 1, 3, /* face 1 */
-                                             6, 2, 0, 0, 4, 6, /* face 2 */
-                                             7, 6, 4, 4, 5, 7, /* face 3 */
-                                             3, 2, 6, 6, 7, 3, /* face 4 */
-                                             4, 0, 1, 1, 5, 4}; /* face 5 */
+  if (!num_frames || OWL_MAX_IN_FLIGHT_FRAMES < num_frames)
+    return OWL_ERROR_INVALID_VALUE;
 
-          mapped_vertices = owl_renderer_vertex_allocate(r, sizeof(vertices),
-                                                         &vertex_allocation);
-          if (!mapped_vertices)
-            goto error;
+  r->plataform = p;
+  r->headless = 0;
 
-          mapped_indices = owl_renderer_index_allocate(r, sizeof(indices),
-                                                       &index_allocation);
-          if (!mapped_indices)
-            goto error;
+  owl_plataform_get_framebuffer_dimensions(p, &width, &height);
 
-          OWL_MEMCPY(mapped_vertices, vertices, sizeof(vertices));
-          OWL_MEMCPY(mapped_indices, indices, sizeof(indices));
+  return owl_renderer_init_common(r, width, height, num_frames,
+                                  pipeline_cache_path);
+}
 
-          vkCmdBindVertexBuffers(command_buffer, 0, 1,
-                                 &vertex_allocation.buffer,
-                                 &vertex_allocation.offset);
+OWLAPI int owl_renderer_init_headless(struct owl_renderer *r, uint32_t width,
+                                      uint32_t height, uint32_t num_frames,
+                                      char const *pipeline_cache_path) {
+  if (!num_frames || OWL_MAX_IN_FLIGHT_FRAMES < num_frames)
+    return OWL_ERROR_INVALID_VALUE;
 
-          vkCmdBindIndexBuffer(command_buffer, index_allocation.buffer,
-                               index_allocation.offset, VK_INDEX_TYPE_UINT32);
+  r->plataform = NULL;
+  r->headless = 1;
 
-          vkCmdDrawIndexed(command_buffer, OWL_ARRAY_SIZE(indices), 1, 0, 0, 0);
-        }
+  return owl_renderer_init_common(r, width, height, num_frames,
+                                  pipeline_cache_path);
+}
 
-        {
-          /* */
-          vkCmdEndRenderPass(command_buffer);
-        }
+OWLAPI void owl_renderer_deinit(struct owl_renderer *r) {
+  vkDeviceWaitIdle(r->device);
 
-        {
-          VkImageMemoryBarrier barrier;
+  if (r->font_loaded)
+    owl_renderer_unload_font(r);
 
-          barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-          barrier.pNext = NULL;
-          barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-          barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-          barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-          barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-          barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-          barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-          barrier.image = offscreen_image;
-          barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-          barrier.subresourceRange.baseMipLevel = 0;
-          barrier.subresourceRange.levelCount = 1;
-          barrier.subresourceRange.baseArrayLayer = 0;
-          barrier.subresourceRange.layerCount = 1;
+  if (r->skybox_loaded)
+    owl_renderer_unload_skybox(r);
 
-          vkCmdPipelineBarrier(command_buffer,
-                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL,
-                               0, NULL, 1, &barrier);
-        }
+  owl_renderer_deinit_depth_pyramid(r);
+  owl_renderer_deinit_quad_batch(r);
 
-        {
-          /**/
-          VkImageCopy copy;
+  if (!r->frame_state_lost) {
+    owl_renderer_deinit_frame_allocator(r);
+    owl_renderer_deinit_garbage(r);
+    owl_renderer_deinit_timestamps(r);
+    owl_renderer_deinit_frames(r);
+  }
 
-          copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-          copy.srcSubresource.mipLevel = 0;
-          copy.srcSubresource.baseArrayLayer = 0;
-          copy.srcSubresource.layerCount = 1;
-          copy.srcOffset.x = 0;
-          copy.srcOffset.y = 0;
-          copy.srcOffset.z = 0;
-          copy.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-          copy.dstSubresource.mipLevel = j;
-          copy.dstSubresource.baseArrayLayer = k;
-          copy.dstSubresource.layerCount = 1;
-          copy.dstOffset.x = 0;
-          copy.dstOffset.y = 0;
-          copy.dstOffset.z = 0;
-          copy.extent.width = viewport.width;
-          copy.extent.height = viewport.height;
-          copy.extent.depth = 1;
+  owl_renderer_deinit_bindless(r);
+  owl_renderer_deinit_samplers(r);
+  owl_renderer_deinit_async_uploads(r);
+  owl_renderer_deinit_upload_buffer(r);
+  owl_renderer_deinit_graphics_pipelines(r);
+  owl_renderer_deinit_layouts(r);
+  owl_renderer_deinit_pools(r);
 
-          vkCmdCopyImage(command_buffer, offscreen_image,
-                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, *images[i],
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
-        }
+  if (!r->frame_state_lost)
+    owl_renderer_deinit_swapchain(r);
 
-        {
-          VkImageMemoryBarrier barrier;
+  owl_renderer_deinit_render_passes(r);
+  owl_renderer_deinit_attachments(r);
+  owl_renderer_deinit_pipeline_cache(r);
+  owl_memory_deinit(r);
+  owl_renderer_deinit_device(r);
+  owl_renderer_deinit_surface(r);
+  owl_renderer_deinit_instance(r);
+}
 
-          barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-          barrier.pNext = NULL;
-          barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-          barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-          barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-          barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-          barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-          barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-          barrier.image = offscreen_image;
-          barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-          barrier.subresourceRange.baseMipLevel = 0;
-          barrier.subresourceRange.levelCount = 1;
-          barrier.subresourceRange.baseArrayLayer = 0;
-          barrier.subresourceRange.layerCount = 1;
+OWLAPI int owl_renderer_update_dimensions(struct owl_renderer *r) {
+  uint32_t width;
+  uint32_t height;
+  float ratio;
+  float const fov = OWL_DEGREES_AS_RADIANS(45.0F);
+  float const near = 0.01;
+  float const far = 10.0F;
+  VkResult vk_result;
+  int ret;
 
-          vkCmdPipelineBarrier(command_buffer,
-                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL,
-                               0, NULL, 1, &barrier);
-        }
+  if (r->frame_state_lost)
+    return OWL_ERROR_FATAL;
 
-        ret = owl_renderer_end_im_command_buffer(r);
-        if (ret)
-          goto error;
+  if (!r->headless) {
+    owl_plataform_get_framebuffer_dimensions(r->plataform, &width, &height);
+    r->width = width;
+    r->height = height;
+  }
 
-        owl_renderer_vertex_clear_offset(r);
-        owl_renderer_index_clear_offset(r);
-      }
-    }
+  ratio = (float)r->width / (float)r->height;
+  owl_m4_perspective(fov, ratio, near, far, r->projection);
 
-    ret = owl_renderer_begin_im_command_buffer(r);
-    if (ret)
+  if (r->headless) {
+    /* the readback buffer is mapped, just wait for it */
+    vk_result = vkDeviceWaitIdle(r->device);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
       goto error;
+    }
 
-    {
-      VkImageMemoryBarrier barrier;
-      VkCommandBuffer const command_buffer = r->im_command_buffer;
+    owl_renderer_deinit_swapchain(r);
+    owl_renderer_deinit_attachments(r);
+  } else {
+    /* frames in flight still reference the current targets, retire them to
+     * the garbage instead of waiting for the device */
+    ret = owl_renderer_garbage_push_targets(r);
+    if (OWL_ERROR_NO_SPACE == ret) {
+      vk_result = vkDeviceWaitIdle(r->device);
+      if (vk_result) {
+        ret = OWL_ERROR_FATAL;
+        goto error;
+      }
 
-      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-      barrier.pNext = NULL;
-      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-/* TODO(samuel): verify
-https://github.com/SaschaWillems/Vulkan-glTF-PBR/blob/master/src/main.cpp#L1619
-*/
-#if 1
-      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-#else
-      barrier.dstAccessMask = 0;
-      barrier.dstAccessMask |= VK_ACCESS_TRANSFER_WRITE_BIT;
-      barrier.dstAccessMask |= VK_ACCESS_HOST_WRITE_BIT;
-#endif
-      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-      barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-      barrier.image = *images[i];
-      barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-      barrier.subresourceRange.baseMipLevel = 0;
-      barrier.subresourceRange.levelCount = mips;
-      barrier.subresourceRange.baseArrayLayer = 0;
-      barrier.subresourceRange.layerCount = 6;
+      /* nothing is in flight, every garbage frame can go */
+      owl_renderer_deinit_garbage(r);
 
-      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0,
-                           NULL, 1, &barrier);
+      ret = owl_renderer_garbage_push_targets(r);
     }
-    ret = owl_renderer_end_im_command_buffer(r);
+
     if (ret)
       goto error;
+  }
 
-    if (OWL_PREFILTERED_MAP == i)
-      r->prefiltered_map_mipmaps = mips;
+  ret = owl_renderer_clamp_dimensions(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to clamp dimensions!\n");
+    goto error;
+  }
 
-    vkDestroyPipeline(device, offscreen_pipeline, NULL);
-    offscreen_pipeline = VK_NULL_HANDLE;
+  ret = owl_renderer_init_attachments(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to resize attachments!\n");
+    goto error;
+  }
 
-    vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
-    offscreen_pipeline_layout = VK_NULL_HANDLE;
+  ret = owl_renderer_init_swapchain(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to resize swapchain!\n");
+    goto error_deinit_attachments;
+  }
 
-    vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
-    offscreen_fragment_shader = VK_NULL_HANDLE;
+  return OWL_OK;
 
-    vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
-    offscreen_vertex_shader = VK_NULL_HANDLE;
+error_deinit_attachments:
+  owl_renderer_deinit_attachments(r);
 
-    vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
-    offscreen_framebuffer = VK_NULL_HANDLE;
+error:
+  return ret;
+}
+
+OWLAPI void owl_renderer_set_viewport(struct owl_renderer *r,
+                                      VkCommandBuffer command_buffer) {
+  VkViewport viewport;
+  VkRect2D scissor;
+
+  viewport.x = 0.0F;
+  viewport.y = 0.0F;
+  viewport.width = r->width;
+  viewport.height = r->height;
+  viewport.minDepth = 0.0F;
+  viewport.maxDepth = 1.0F;
+
+  scissor.offset.x = 0;
+  scissor.offset.y = 0;
+  scissor.extent.width = r->width;
+  scissor.extent.height = r->height;
+
+  vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+  vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+
+/* everything that has one copy per frame, the frame pages keep the size they
+ * grew to */
+static int owl_renderer_init_frame_state(struct owl_renderer *r) {
+  int ret;
+
+  ret = owl_renderer_init_swapchain(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize swapchain!\n");
+    goto error;
+  }
 
-    vkDestroyImageView(device, offscreen_image_view, NULL);
-    offscreen_image_view = VK_NULL_HANDLE;
+  ret = owl_renderer_init_frames(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize frames!\n");
+    goto error_deinit_swapchain;
+  }
 
-    vkFreeMemory(device, offscreen_memory, NULL);
-    offscreen_memory = VK_NULL_HANDLE;
+  ret = owl_renderer_init_timestamps(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize timestamps!\n");
+    goto error_deinit_frames;
+  }
 
-    vkDestroyImage(device, offscreen_image, NULL);
-    offscreen_image = VK_NULL_HANDLE;
+  ret = owl_renderer_init_garbage(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize garbage!\n");
+    goto error_deinit_timestamps;
+  }
 
-    vkDestroyRenderPass(device, offscreen_pass, NULL);
-    offscreen_pass = VK_NULL_HANDLE;
+  ret = owl_renderer_init_frame_allocator(r);
+  if (ret) {
+    OWL_DEBUG_LOG("Failed to initialize frame allocator!\n");
+    goto error_deinit_garbage;
   }
 
   return OWL_OK;
 
-error:
-  owl_renderer_vertex_clear_offset(r);
-  owl_renderer_index_clear_offset(r);
-
-  if (offscreen_pipeline)
-    vkDestroyPipeline(device, offscreen_pipeline, NULL);
+error_deinit_garbage:
+  owl_renderer_deinit_garbage(r);
 
-  if (offscreen_pipeline_layout)
-    vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
+error_deinit_timestamps:
+  owl_renderer_deinit_timestamps(r);
 
-  if (offscreen_fragment_shader)
-    vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
+error_deinit_frames:
+  owl_renderer_deinit_frames(r);
 
-  if (offscreen_vertex_shader)
-    vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
+error_deinit_swapchain:
+  owl_renderer_deinit_swapchain(r);
 
-  if (offscreen_framebuffer)
-    vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
+error:
+  return ret;
+}
 
-  if (offscreen_image_view)
-    vkDestroyImageView(device, offscreen_image_view, NULL);
+static void owl_renderer_deinit_frame_state(struct owl_renderer *r) {
+  owl_renderer_deinit_frame_allocator(r);
+  owl_renderer_deinit_garbage(r);
+  owl_renderer_deinit_timestamps(r);
+  owl_renderer_deinit_frames(r);
+  owl_renderer_deinit_swapchain(r);
+}
 
-  if (offscreen_memory)
-    vkFreeMemory(device, offscreen_memory, NULL);
+OWLAPI int owl_renderer_set_num_frames(struct owl_renderer *r,
+                                       uint32_t num_frames) {
+  int ret;
+  VkResult vk_result;
+  uint32_t const old_num_frames = r->num_frames;
 
-  if (offscreen_image)
-    vkDestroyImage(device, offscreen_image, NULL);
+  if (!num_frames || OWL_MAX_IN_FLIGHT_FRAMES < num_frames)
+    return OWL_ERROR_INVALID_VALUE;
 
-  if (offscreen_pass)
-    vkDestroyRenderPass(device, offscreen_pass, NULL);
+  /* a failed call left nothing to tear down, build it again either way */
+  if (!r->frame_state_lost) {
+    if (num_frames == r->num_frames)
+      return OWL_OK;
 
-  if (r->prefiltered_map_image_view)
-    vkDestroyImageView(device, r->prefiltered_map_image_view, NULL);
+    vk_result = vkDeviceWaitIdle(r->device);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
 
-  if (r->prefiltered_map_memory)
-    vkFreeMemory(device, r->prefiltered_map_memory, NULL);
+    owl_renderer_deinit_frame_state(r);
+  }
 
-  if (r->prefiltered_map_image)
-    vkDestroyImage(device, r->prefiltered_map_image, NULL);
+  r->num_frames = num_frames;
 
-  if (r->irradiance_map_image_view)
-    vkDestroyImageView(device, r->irradiance_map_image_view, NULL);
+  ret = owl_renderer_init_frame_state(r);
+  if (!ret) {
+    r->frame_state_lost = 0;
+    return OWL_OK;
+  }
 
-  if (r->irradiance_map_memory)
-    vkFreeMemory(device, r->irradiance_map_memory, NULL);
+  OWL_DEBUG_LOG("Failed to change the number of frames!\n");
 
-  if (r->irradiance_map_image)
-    vkDestroyImage(device, r->irradiance_map_image, NULL);
+  /* the old count worked before, try to keep rendering with it */
+  r->num_frames = old_num_frames;
+  r->frame_state_lost = OWL_OK != owl_renderer_init_frame_state(r);
 
-  return OWL_ERROR_FATAL;
+  return ret;
 }
 
-static void owl_renderer_deinit_filter_maps(struct owl_renderer *r) {
-  VkDevice const device = r->device;
+/* allocations never move, when the current page is full the frame continues
+ * in the next one of the chain */
+static uint8_t *
+owl_renderer_frame_allocate(struct owl_renderer *r, uint64_t size,
+                            uint64_t alignment,
+                            struct owl_renderer_frame_page **page,
+                            uint64_t *offset) {
+  uint32_t const frame = r->frame;
+  struct owl_renderer_frame_page *current;
+  uint64_t start = OWL_ALIGN_UP_2(r->frame_page_offset, alignment);
 
-  vkDestroyImageView(device, r->prefiltered_map_image_view, NULL);
-  vkFreeMemory(device, r->prefiltered_map_memory, NULL);
-  vkDestroyImage(device, r->prefiltered_map_image, NULL);
-  vkDestroyImageView(device, r->irradiance_map_image_view, NULL);
-  vkFreeMemory(device, r->irradiance_map_memory, NULL);
-  vkDestroyImage(device, r->irradiance_map_image, NULL);
-}
+  current = &r->frame_pages[frame][r->frame_page];
 
-/* TODO(samuel): cleanup function */
-static int owl_renderer_init_brdflut(struct owl_renderer *r) {
-  int ret = OWL_OK;
-  VkFormat const format = VK_FORMAT_R16G16_SFLOAT;
-  uint32_t const dimension = 512;
+  while (current->size < start + size) {
+    uint32_t const next = r->frame_page + 1;
+    struct owl_renderer_frame_page *pages = r->frame_pages[frame];
 
-  static uint32_t const vertex_shader_source[] = {
-#include "owl_brdflut.vert.spv.u32"
-  };
+    if (OWL_MAX_FRAME_PAGES <= next)
+      return NULL;
 
-  static uint32_t const fragment_shader_source[] = {
-#include "owl_brdflut.frag.spv.u32"
-  };
+    if (r->num_frame_pages[frame] == next) {
+      int ret;
+      /* a request bigger than a page gets a page of its own */
+      uint64_t const page_size = OWL_MAX(r->frame_page_size, size);
 
-  VkRenderPass offscreen_pass = VK_NULL_HANDLE;
-  VkFramebuffer offscreen_framebuffer = VK_NULL_HANDLE;
-  VkShaderModule offscreen_vertex_shader = VK_NULL_HANDLE;
-  VkShaderModule offscreen_fragment_shader = VK_NULL_HANDLE;
-  VkPipelineLayout offscreen_pipeline_layout = VK_NULL_HANDLE;
-  VkPipeline offscreen_pipeline = VK_NULL_HANDLE;
-  VkDevice const device = r->device;
+      ret = owl_renderer_init_frame_page(r, page_size, &pages[next]);
+      if (ret)
+        return NULL;
 
-  {
-    VkImageCreateInfo info;
-    VkResult vk_result;
+      ++r->num_frame_pages[frame];
+    }
 
-    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.imageType = VK_IMAGE_TYPE_2D;
-    info.format = format;
-    info.extent.width = dimension;
-    info.extent.height = dimension;
-    info.extent.depth = 1;
-    info.mipLevels = 1;
-    info.arrayLayers = 1;
-    info.samples = VK_SAMPLE_COUNT_1_BIT;
-    info.tiling = VK_IMAGE_TILING_OPTIMAL;
-    info.usage = 0;
-    info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
-    info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    info.queueFamilyIndexCount = 0;
-    info.pQueueFamilyIndices = NULL;
-    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    r->frame_page = next;
+    r->frame_page_offset = 0;
 
-    vk_result = vkCreateImage(device, &info, NULL, &r->brdflut_map_image);
-    if (vk_result)
-      goto error;
+    current = &pages[next];
+    start = 0;
   }
 
-  {
-    VkMemoryPropertyFlagBits properties;
-    VkMemoryRequirements requirements;
-    VkMemoryAllocateInfo info;
-    VkResult vk_result;
+  r->frame_page_offset = start + size;
 
-    properties = 0;
-    properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  *page = current;
+  *offset = start;
 
-    vkGetImageMemoryRequirements(device, r->brdflut_map_image, &requirements);
+  return &((uint8_t *)current->memory.data)[start];
+}
 
-    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.allocationSize = requirements.size;
-    info.memoryTypeIndex = owl_renderer_find_memory_type(
-        r, requirements.memoryTypeBits, properties);
+OWLAPI void *
+owl_renderer_vertex_allocate(struct owl_renderer *r, uint64_t size,
+                             struct owl_renderer_vertex_allocation *alloc) {
+  uint8_t *data;
+  uint64_t offset;
+  struct owl_renderer_frame_page *page;
 
-    vk_result = vkAllocateMemory(device, &info, NULL, &r->brdflut_map_memory);
-    if (vk_result)
-      goto error;
+  data = owl_renderer_frame_allocate(r, size, r->frame_vertex_alignment, &page,
+                                     &offset);
+  if (!data)
+    return NULL;
 
-    vk_result = vkBindImageMemory(device, r->brdflut_map_image,
-                                  r->brdflut_map_memory, 0);
-    if (vk_result)
-      goto error;
-  }
+  alloc->offset = offset;
+  alloc->buffer = page->buffer;
 
-  {
-    VkImageViewCreateInfo info;
-    VkResult vk_result;
+  return data;
+}
 
-    info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.image = r->brdflut_map_image;
-    info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    info.format = format;
-    info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-    info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-    info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-    info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-    info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    info.subresourceRange.baseMipLevel = 0;
-    info.subresourceRange.levelCount = 1;
-    info.subresourceRange.baseArrayLayer = 0;
-    info.subresourceRange.layerCount = 1;
+OWLAPI void *
+owl_renderer_index_allocate(struct owl_renderer *r, uint64_t size,
+                            struct owl_renderer_index_allocation *alloc) {
+  uint8_t *data;
+  uint64_t offset;
+  struct owl_renderer_frame_page *page;
 
-    vk_result =
-        vkCreateImageView(device, &info, NULL, &r->brdflut_map_image_view);
-    if (vk_result)
-      goto error;
-  }
+  data = owl_renderer_frame_allocate(r, size, r->frame_index_alignment, &page,
+                                     &offset);
+  if (!data)
+    return NULL;
 
-  {
-    VkAttachmentReference color_reference;
-    VkAttachmentDescription attachment;
-    VkSubpassDescription subpass;
-    VkSubpassDependency dependency;
-    VkRenderPassCreateInfo info;
-    VkResult vk_result;
+  alloc->offset = offset;
+  alloc->buffer = page->buffer;
 
-    color_reference.attachment = 0;
-    color_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  return data;
+}
 
-    attachment.flags = 0;
-    attachment.format = format;
-    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+OWLAPI void *
+owl_renderer_uniform_allocate(struct owl_renderer *r, uint64_t size,
+                              struct owl_renderer_uniform_allocation *alloc) {
+  uint8_t *data;
+  uint64_t offset;
+  struct owl_renderer_frame_page *page;
 
-    subpass.flags = 0;
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.inputAttachmentCount = 0;
-    subpass.pInputAttachments = NULL;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &color_reference;
-    subpass.pResolveAttachments = NULL;
-    subpass.pDepthStencilAttachment = NULL;
-    subpass.preserveAttachmentCount = 0;
-    subpass.pPreserveAttachments = NULL;
+  data = owl_renderer_frame_allocate(r, size, r->frame_uniform_alignment,
+                                     &page, &offset);
+  if (!data)
+    return NULL;
 
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = 0;
-    dependency.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstStageMask = 0;
-    dependency.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstAccessMask = 0;
-    dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-    dependency.dependencyFlags = 0;
+  if (!page->common_descriptor_set) {
+    int ret = owl_renderer_init_frame_page_descriptor_sets(r, page);
+    if (ret)
+      return NULL;
+  }
 
-    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.attachmentCount = 1;
-    info.pAttachments = &attachment;
-    info.subpassCount = 1;
-    info.pSubpasses = &subpass;
-    info.dependencyCount = 1;
-    info.pDependencies = &dependency;
+  alloc->offset = (uint32_t)offset;
+  alloc->buffer = page->buffer;
+  alloc->common_descriptor_set = page->common_descriptor_set;
+  alloc->model_descriptor_set = page->model_descriptor_set;
 
-    vk_result = vkCreateRenderPass(device, &info, NULL, &offscreen_pass);
-    if (vk_result)
-      goto error;
-  }
+  return data;
+}
 
-  {
-    VkFramebufferCreateInfo info;
-    VkResult vk_result;
+OWLAPI void owl_renderer_frame_clear_offset(struct owl_renderer *r) {
+  uint32_t i;
+  uint64_t used = r->frame_page_offset;
+  struct owl_renderer_frame_page *pages = r->frame_pages[r->frame];
 
-    info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.renderPass = offscreen_pass;
-    info.attachmentCount = 1;
-    info.pAttachments = &r->brdflut_map_image_view;
-    info.width = dimension;
-    info.height = dimension;
-    info.layers = 1;
+  for (i = 0; i < r->frame_page; ++i)
+    used += pages[i].size;
 
-    vk_result =
-        vkCreateFramebuffer(device, &info, NULL, &offscreen_framebuffer);
-    if (vk_result)
-      goto error;
-  }
+  r->frame_last_offset = used;
+
+  /* pages come from a buddy allocator, a power of two wastes nothing */
+  while (r->frame_page_size < used)
+    r->frame_page_size *= 2;
 
-  {
-    VkPipelineLayoutCreateInfo info;
-    VkResult vk_result;
+  r->frame_page = 0;
+  r->frame_page_offset = 0;
+}
 
-    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.setLayoutCount = 0;
-    info.pSetLayouts = NULL;
-    info.pushConstantRangeCount = 0;
-    info.pPushConstantRanges = NULL;
+OWLAPI int owl_renderer_allocate_descriptor_sets(
+    struct owl_renderer *r, uint32_t count,
+    VkDescriptorSetLayout const *layouts, VkDescriptorSet *sets,
+    VkDescriptorPool *pool) {
+  int ret;
+  int32_t i;
+  VkDescriptorSetAllocateInfo info;
+  VkResult vk_result = VK_SUCCESS;
 
-    vk_result =
-        vkCreatePipelineLayout(device, &info, NULL, &offscreen_pipeline_layout);
-    if (vk_result)
-      goto error;
+  info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  info.pNext = NULL;
+  info.descriptorSetCount = count;
+  info.pSetLayouts = layouts;
+
+  /* sets freed from older pools leave holes in them, the newest pool is the
+   * most likely to have room so it's tried first */
+  for (i = (int32_t)r->num_descriptor_pools - 1; i >= 0; --i) {
+    info.descriptorPool = r->descriptor_pools[i];
+
+    vk_result = vkAllocateDescriptorSets(r->device, &info, sets);
+    if (!vk_result) {
+      *pool = r->descriptor_pools[i];
+      return OWL_OK;
+    }
   }
 
-  {
-    VkShaderModuleCreateInfo info;
-    VkResult vk_result;
+  if (OWL_MAX_DESCRIPTOR_POOLS <= r->num_descriptor_pools)
+    return OWL_ERROR_NO_SPACE;
 
-    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.codeSize = sizeof(vertex_shader_source);
-    info.pCode = vertex_shader_source;
+  ret = owl_renderer_init_descriptor_pool(
+      r, OWL_DESCRIPTOR_POOL_SIZE,
+      VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+      &r->descriptor_pools[r->num_descriptor_pools]);
+  if (ret)
+    return ret;
 
-    vk_result =
-        vkCreateShaderModule(device, &info, NULL, &offscreen_vertex_shader);
-    if (vk_result)
-      goto error;
-  }
+  info.descriptorPool = r->descriptor_pools[r->num_descriptor_pools++];
 
-  {
-    VkShaderModuleCreateInfo info;
-    VkResult vk_result;
+  vk_result = vkAllocateDescriptorSets(r->device, &info, sets);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
 
-    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.codeSize = sizeof(fragment_shader_source);
-    info.pCode = fragment_shader_source;
+  *pool = info.descriptorPool;
 
-    vk_result =
-        vkCreateShaderModule(device, &info, NULL, &offscreen_fragment_shader);
-    if (vk_result)
-      goto error;
-  }
+  return OWL_OK;
+}
 
-  {
-    VkPipelineVertexInputStateCreateInfo vertex_input;
-    VkPipelineInputAssemblyStateCreateInfo input_assembly;
-    VkViewport viewport;
-    VkRect2D scissor;
-    VkPipelineViewportStateCreateInfo viewport_state;
-    VkPipelineRasterizationStateCreateInfo rasterization;
-    VkPipelineMultisampleStateCreateInfo multisample;
-    VkPipelineColorBlendAttachmentState color_attachment;
-    VkPipelineColorBlendStateCreateInfo color;
-    VkPipelineDepthStencilStateCreateInfo depth;
-    VkPipelineShaderStageCreateInfo stages[2];
-    VkGraphicsPipelineCreateInfo info;
-    VkResult vk_result;
+OWLAPI void owl_renderer_free_descriptor_sets(struct owl_renderer *r,
+                                              VkDescriptorPool pool,
+                                              uint32_t count,
+                                              VkDescriptorSet const *sets) {
+  vkFreeDescriptorSets(r->device, pool, count, sets);
+}
 
-    vertex_input.sType =
-        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input.pNext = NULL;
-    vertex_input.flags = 0;
-    vertex_input.vertexBindingDescriptionCount = 0;
-    vertex_input.pVertexBindingDescriptions = NULL;
-    vertex_input.vertexAttributeDescriptionCount = 0;
-    vertex_input.pVertexAttributeDescriptions = NULL;
+OWLAPI int owl_renderer_frame_allocate_descriptor_sets(
+    struct owl_renderer *r, uint32_t count,
+    VkDescriptorSetLayout const *layouts, VkDescriptorSet *sets) {
+  VkDescriptorSetAllocateInfo info;
+  VkResult vk_result = VK_SUCCESS;
 
-    input_assembly.sType =
-        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    input_assembly.pNext = NULL;
-    input_assembly.flags = 0;
-    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    input_assembly.primitiveRestartEnable = VK_FALSE;
+  info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  info.pNext = NULL;
+  info.descriptorPool = r->frame_descriptor_pools[r->frame];
+  info.descriptorSetCount = count;
+  info.pSetLayouts = layouts;
 
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = dimension;
-    viewport.height = dimension;
-    viewport.minDepth = 0.0F;
-    viewport.maxDepth = 1.0F;
+  vk_result = vkAllocateDescriptorSets(r->device, &info, sets);
+  if (vk_result)
+    return OWL_ERROR_NO_FRAME_MEMORY;
 
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent.width = dimension;
-    scissor.extent.height = dimension;
+  return OWL_OK;
+}
 
-    viewport_state.sType =
-        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewport_state.pNext = NULL;
-    viewport_state.flags = 0;
-    viewport_state.viewportCount = 1;
-    viewport_state.pViewports = &viewport;
-    viewport_state.scissorCount = 1;
-    viewport_state.pScissors = &scissor;
+OWLAPI int owl_renderer_add_bindless_texture(struct owl_renderer *r,
+                                             struct owl_texture *texture) {
+  uint32_t index;
+  VkDescriptorImageInfo descriptor;
+  VkWriteDescriptorSet write;
 
-    rasterization.sType =
-        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterization.pNext = NULL;
-    rasterization.flags = 0;
-    rasterization.depthClampEnable = VK_FALSE;
-    rasterization.rasterizerDiscardEnable = VK_FALSE;
-    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterization.cullMode = VK_CULL_MODE_NONE;
-    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterization.depthBiasEnable = VK_FALSE;
-    rasterization.depthBiasConstantFactor = 0.0F;
-    rasterization.depthBiasClamp = 0.0F;
-    rasterization.depthBiasSlopeFactor = 0.0F;
-    rasterization.lineWidth = 1.0F;
+  if (!r->bindless_supported)
+    return OWL_ERROR_INVALID_VALUE;
 
-    multisample.sType =
-        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisample.pNext = NULL;
-    multisample.flags = 0;
-    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisample.sampleShadingEnable = VK_FALSE;
-    multisample.minSampleShading = 0.0F;
-    multisample.pSampleMask = NULL;
-    multisample.alphaToCoverageEnable = VK_FALSE;
-    multisample.alphaToOneEnable = VK_FALSE;
+  if (r->num_free_bindless_textures)
+    index = r->free_bindless_textures[--r->num_free_bindless_textures];
+  else if (r->num_bindless_textures < OWL_MAX_BINDLESS_TEXTURES)
+    index = r->num_bindless_textures++;
+  else
+    return OWL_ERROR_NO_SPACE;
 
-    color_attachment.blendEnable = VK_FALSE;
-    color_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_attachment.colorBlendOp = VK_BLEND_OP_ADD;
-    color_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    color_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    color_attachment.colorWriteMask = 0;
-    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
-    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
-    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
-    color_attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+  descriptor.sampler = VK_NULL_HANDLE;
+  descriptor.imageView = texture->image_view;
+  descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-    color.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    color.pNext = NULL;
-    color.flags = 0;
-    color.logicOpEnable = VK_FALSE;
-    color.logicOp = VK_LOGIC_OP_CLEAR;
-    color.attachmentCount = 1;
-    color.pAttachments = &color_attachment;
-    color.blendConstants[0] = 0.0F;
-    color.blendConstants[1] = 0.0F;
-    color.blendConstants[2] = 0.0F;
-    color.blendConstants[3] = 0.0F;
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.pNext = NULL;
+  write.dstSet = r->bindless_descriptor_set;
+  write.dstBinding = 1;
+  write.dstArrayElement = index;
+  write.descriptorCount = 1;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  write.pImageInfo = &descriptor;
+  write.pBufferInfo = NULL;
+  write.pTexelBufferView = NULL;
 
-    depth.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depth.pNext = NULL;
-    depth.flags = 0;
-    depth.depthTestEnable = VK_FALSE;
-    depth.depthWriteEnable = VK_FALSE;
-    depth.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-    depth.depthBoundsTestEnable = VK_FALSE;
-    depth.stencilTestEnable = VK_FALSE;
-    depth.front.failOp = VK_STENCIL_OP_KEEP;
-    depth.front.passOp = VK_STENCIL_OP_KEEP;
-    depth.front.depthFailOp = VK_STENCIL_OP_KEEP;
-    depth.front.compareOp = VK_COMPARE_OP_NEVER;
-    depth.front.compareMask = 0;
-    depth.front.writeMask = 0;
-    depth.front.reference = 0;
-    depth.back.failOp = VK_STENCIL_OP_KEEP;
-    depth.back.passOp = VK_STENCIL_OP_KEEP;
-    depth.back.depthFailOp = VK_STENCIL_OP_KEEP;
-    depth.back.compareOp = VK_COMPARE_OP_ALWAYS;
-    depth.back.compareMask = 0;
-    depth.back.writeMask = 0;
-    depth.back.reference = 0;
-    depth.minDepthBounds = 0.0F;
-    depth.maxDepthBounds = 0.0F;
+  vkUpdateDescriptorSets(r->device, 1, &write, 0, NULL);
 
-    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stages[0].pNext = NULL;
-    stages[0].flags = 0;
-    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    stages[0].module = offscreen_vertex_shader;
-    stages[0].pName = "main";
-    stages[0].pSpecializationInfo = NULL;
+  texture->bindless_index = index;
 
-    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stages[1].pNext = NULL;
-    stages[1].flags = 0;
-    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    stages[1].module = offscreen_fragment_shader;
-    stages[1].pName = "main";
-    stages[1].pSpecializationInfo = NULL;
+  return OWL_OK;
+}
 
-    info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    info.pNext = NULL;
-    info.flags = 0;
-    info.stageCount = OWL_ARRAY_SIZE(stages);
-    info.pStages = stages;
-    info.pVertexInputState = &vertex_input;
-    info.pInputAssemblyState = &input_assembly;
-    info.pTessellationState = NULL;
-    info.pViewportState = &viewport_state;
-    info.pRasterizationState = &rasterization;
-    info.pMultisampleState = &multisample;
-    info.pDepthStencilState = &depth;
-    info.pColorBlendState = &color;
-    info.pDynamicState = NULL;
-    info.layout = offscreen_pipeline_layout;
-    info.renderPass = offscreen_pass;
-    info.subpass = 0;
-    info.basePipelineHandle = VK_NULL_HANDLE;
-    info.basePipelineIndex = -1;
+OWLAPI void owl_renderer_remove_bindless_texture(struct owl_renderer *r,
+                                                 struct owl_texture *texture) {
+  uint32_t const garbage = r->garbage;
+  uint32_t const count = r->num_garbage_bindless_textures[garbage];
 
-    vk_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info,
-                                          NULL, &offscreen_pipeline);
-    if (vk_result)
-      goto error;
-  }
+  OWL_ASSERT(OWL_BINDLESS_NONE != texture->bindless_index);
 
-  ret = owl_renderer_begin_im_command_buffer(r);
-  if (ret)
-    goto error;
+  /* the slot isn't rewritten, frames in flight may still sample it */
+  r->garbage_bindless_textures[garbage][count] = texture->bindless_index;
+  r->num_garbage_bindless_textures[garbage] = count + 1;
 
-  {
-    VkClearValue clear_value;
-    VkRenderPassBeginInfo info;
-    VkCommandBuffer const command_buffer = r->im_command_buffer;
+  texture->bindless_index = OWL_BINDLESS_NONE;
+}
 
-    clear_value.color.float32[0] = 0.0F;
-    clear_value.color.float32[1] = 0.0F;
-    clear_value.color.float32[2] = 0.0F;
-    clear_value.color.float32[3] = 1.0F;
+#define OWL_RENDERER_IS_SWAPCHAIN_OUT_OF_DATE(vk_result)                       \
+  (VK_ERROR_OUT_OF_DATE_KHR == (vk_result) ||                                  \
+   VK_SUBOPTIMAL_KHR == (vk_result) ||                                         \
+   VK_ERROR_SURFACE_LOST_KHR == (vk_result))
 
-    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    info.pNext = NULL;
-    info.renderPass = offscreen_pass;
-    info.framebuffer = offscreen_framebuffer;
-    info.renderArea.offset.x = 0;
-    info.renderArea.offset.y = 0;
-    info.renderArea.extent.width = dimension;
-    info.renderArea.extent.height = dimension;
-    info.clearValueCount = 1;
-    info.pClearValues = &clear_value;
+OWLAPI int owl_renderer_begin_frame(struct owl_renderer *r) {
+  VkResult vk_result = VK_SUCCESS;
+  int ret = OWL_OK;
+
+  uint64_t const timeout = (uint64_t)-1;
+  uint32_t const num_clear_values = OWL_ARRAY_SIZE(r->clear_values);
+  uint32_t const frame = r->frame;
+  VkClearValue const *clear_values = r->clear_values;
+  VkCommandBuffer command_buffer = r->submit_command_buffers[frame];
+  VkSemaphore acquire_semaphore = r->acquire_semaphores[frame];
+  VkDevice const device = r->device;
+
+  if (r->frame_state_lost)
+    return OWL_ERROR_FATAL;
 
-    vkCmdBeginRenderPass(command_buffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+  if (!r->headless) {
+    vk_result =
+        vkAcquireNextImageKHR(device, r->swapchain, timeout, acquire_semaphore,
+                              VK_NULL_HANDLE, &r->swapchain_image);
+    /* a suboptimal acquire already signaled the semaphore, the swapchain gets
+     * recreated when presenting instead */
+    if (VK_SUBOPTIMAL_KHR != vk_result &&
+        OWL_RENDERER_IS_SWAPCHAIN_OUT_OF_DATE(vk_result)) {
+      ret = owl_renderer_update_dimensions(r);
+      if (ret)
+        return ret;
+
+      vk_result = vkAcquireNextImageKHR(device, r->swapchain, timeout,
+                                        acquire_semaphore, VK_NULL_HANDLE,
+                                        &r->swapchain_image);
+      if (vk_result)
+        return OWL_ERROR_FATAL;
+    }
   }
 
   {
-    VkCommandBuffer const command_buffer = r->im_command_buffer;
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                      offscreen_pipeline);
-    vkCmdDraw(command_buffer, 3, 1, 0, 0);
-  }
+    VkFence in_flight_fence = r->in_flight_fences[frame];
+    VkCommandPool command_pool = r->submit_command_pools[frame];
 
-  {
-    VkCommandBuffer const command_buffer = r->im_command_buffer;
-    vkCmdEndRenderPass(command_buffer);
-  }
+    vk_result = vkWaitForFences(device, 1, &in_flight_fence, VK_TRUE, timeout);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
 
-  ret = owl_renderer_end_im_command_buffer(r);
-  if (ret)
-    goto error;
+    vk_result = vkResetFences(device, 1, &in_flight_fence);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
 
-  ret = owl_renderer_begin_im_command_buffer(r);
-  if (ret)
-    goto error;
+    vk_result = vkResetCommandPool(device, command_pool, 0);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
+  }
 
   {
-    VkImageMemoryBarrier barrier;
-    VkCommandBuffer const command_buffer = r->im_command_buffer;
-
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.pNext = NULL;
-    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = r->brdflut_map_image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+    struct owl_renderer_timestamps *timestamps = &r->frame_timestamps[frame];
 
-    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, NULL, 0,
-                         NULL, 1, &barrier);
+    if (timestamps->num_scopes) {
+      OWL_MEMSET(r->stats.frame_ms, 0, sizeof(r->stats.frame_ms));
+      owl_renderer_resolve_timestamps(r, timestamps, r->stats.frame_ms);
+    }
   }
 
-  ret = owl_renderer_end_im_command_buffer(r);
+  owl_renderer_collect_garbage(r);
+
+  ret = owl_renderer_fit_frame_pages(r);
   if (ret)
-    goto error;
+    return ret;
 
-  vkDestroyPipeline(device, offscreen_pipeline, NULL);
-  vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
-  vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
-  vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
-  vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
-  vkDestroyRenderPass(device, offscreen_pass, NULL);
+  ret = owl_renderer_reset_frame_descriptor_pool(r);
+  if (ret)
+    return ret;
 
-  return OWL_OK;
+  /* quads left over from a frame that failed to end */
+  r->quad_batch.num_quads = 0;
 
-error:
-  if (offscreen_pipeline)
-    vkDestroyPipeline(device, offscreen_pipeline, NULL);
+  ++r->frame_count;
 
-  if (offscreen_pipeline_layout)
-    vkDestroyPipelineLayout(device, offscreen_pipeline_layout, NULL);
+  {
+    VkCommandBufferBeginInfo info;
 
-  if (offscreen_fragment_shader)
-    vkDestroyShaderModule(device, offscreen_fragment_shader, NULL);
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    info.pNext = NULL;
+    info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    info.pInheritanceInfo = NULL;
 
-  if (offscreen_vertex_shader)
-    vkDestroyShaderModule(device, offscreen_vertex_shader, NULL);
+    vk_result = vkBeginCommandBuffer(command_buffer, &info);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
+  }
 
-  if (offscreen_framebuffer)
-    vkDestroyFramebuffer(device, offscreen_framebuffer, NULL);
+  r->frame_command_buffer = command_buffer;
+  r->num_frame_threads = 0;
+  r->cull_recording = 0;
+  r->num_culled_models = 0;
 
-  if (offscreen_pass)
-    vkDestroyRenderPass(device, offscreen_pass, NULL);
+  /* uploads that finished become visible to this frame */
+  ret = owl_renderer_poll_async_uploads(r, command_buffer);
+  if (ret)
+    return ret;
 
-  if (r->brdflut_map_image_view)
-    vkDestroyImageView(device, r->brdflut_map_image_view, NULL);
+  owl_renderer_reset_timestamps(r, &r->frame_timestamps[frame], command_buffer);
+  owl_renderer_begin_scope(r, OWL_RENDERER_SCOPE_MAIN_PASS);
 
-  if (r->brdflut_map_memory)
-    vkFreeMemory(device, r->brdflut_map_memory, NULL);
+  {
+    VkRenderPassBeginInfo info;
+    VkFramebuffer framebuffer;
 
-  if (r->brdflut_map_image)
-    vkDestroyImage(device, r->brdflut_map_image, NULL);
+    if (r->headless)
+      framebuffer = r->offscreen_framebuffer;
+    else
+      framebuffer = r->swapchain_framebuffers[r->swapchain_image];
 
-  return OWL_ERROR_FATAL;
-}
+    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    info.pNext = NULL;
+    info.renderPass = r->main_render_pass;
+    info.framebuffer = framebuffer;
+    info.renderArea.offset.x = 0;
+    info.renderArea.offset.y = 0;
+    info.renderArea.extent.width = r->width;
+    info.renderArea.extent.height = r->height;
+    info.clearValueCount = num_clear_values;
+    info.pClearValues = clear_values;
 
-static void owl_renderer_deinit_brdflut(struct owl_renderer *r) {
-  VkDevice const device = r->device;
-  vkDestroyImageView(device, r->brdflut_map_image_view, NULL);
-  vkFreeMemory(device, r->brdflut_map_memory, NULL);
-  vkDestroyImage(device, r->brdflut_map_image, NULL);
-}
+    /* with recording threads around every command inside the main pass has
+     * to come from a secondary command buffer */
+    if (r->num_threads) {
+      vkCmdBeginRenderPass(command_buffer, &info,
+                           VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    } else {
+      vkCmdBeginRenderPass(command_buffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+      owl_renderer_set_viewport(r, command_buffer);
+    }
+  }
 
-OWLAPI int owl_renderer_init(struct owl_renderer *r, struct owl_plataform *p) {
-  uint32_t width;
-  uint32_t height;
-  owl_v3 up;
-  int ret;
-  float ratio;
-  float const fov = OWL_DEGREES_AS_RADIANS(45.0F);
-  float const near = 0.01;
-  float const far = 512.0F;
+  if (r->num_threads) {
+    VkCommandBufferInheritanceInfo inheritance;
+    VkCommandBufferBeginInfo info;
+    VkCommandBuffer inline_command_buffer = r->inline_command_buffers[frame];
 
-  r->plataform = p;
-  r->im_command_buffer = VK_NULL_HANDLE;
-  r->skybox_loaded = 0;
-  r->font_loaded = 0;
-  r->num_frames = OWL_NUM_IN_FLIGHT_FRAMES;
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.pNext = NULL;
+    inheritance.renderPass = r->main_render_pass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = VK_NULL_HANDLE;
+    inheritance.occlusionQueryEnable = VK_FALSE;
+    inheritance.queryFlags = 0;
+    inheritance.pipelineStatistics = 0;
 
-  r->clear_values[0].color.float32[0] = 0.0F;
-  r->clear_values[0].color.float32[1] = 0.0F;
-  r->clear_values[0].color.float32[2] = 0.0F;
-  r->clear_values[0].color.float32[3] = 1.0F;
-  r->clear_values[1].depthStencil.depth = 1.0F;
-  r->clear_values[1].depthStencil.stencil = 0.0F;
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    info.pInheritanceInfo = &inheritance;
 
-  owl_plataform_get_framebuffer_dimensions(p, &width, &height);
-  r->width = width;
-  r->height = height;
+    vk_result = vkBeginCommandBuffer(inline_command_buffer, &info);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
 
-  ratio = (float)width / (float)height;
+    /* secondary command buffers don't inherit dynamic state */
+    owl_renderer_set_viewport(r, inline_command_buffer);
 
-  OWL_V3_SET(r->camera_eye, 0.0F, -0.5F, 3.0F);
-  OWL_V4_SET(r->camera_direction, 0.0F, 0.0F, 1.0F, 1.0F);
-  OWL_V3_SET(up, 0.0F, 1.0F, 0.0F);
+    r->frame_command_buffer = inline_command_buffer;
+  }
 
-  owl_m4_perspective(fov, ratio, near, far, r->projection);
-  owl_m4_look(r->camera_eye, r->camera_direction, up, r->view);
+  return OWL_OK;
+}
 
-  ret = owl_renderer_init_instance(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize instance!\n");
-    goto error;
-  }
+/* reduces the frame's depth into the pyramid the next frame culls against,
+ * recorded after the main pass */
+static int owl_renderer_build_depth_pyramid(struct owl_renderer *r) {
+  int ret;
+  int32_t i;
+  owl_m4 flip;
+  VkDescriptorSet descriptor_sets[OWL_DEPTH_PYRAMID_LEVELS];
+  VkDescriptorSetLayout layouts[OWL_DEPTH_PYRAMID_LEVELS];
+  struct owl_renderer_depth_pyramid_push_constant push_constant;
+  VkCommandBuffer command_buffer = r->frame_command_buffer;
+
+  /* the depth view changes with the dimensions, the sets are rewritten every
+   * frame */
+  for (i = 0; i < OWL_DEPTH_PYRAMID_LEVELS; ++i)
+    layouts[i] = r->depth_pyramid_descriptor_set_layout;
+
+  ret = owl_renderer_frame_allocate_descriptor_sets(
+      r, OWL_DEPTH_PYRAMID_LEVELS, layouts, descriptor_sets);
+  if (ret)
+    return ret;
 
-  ret = owl_renderer_init_surface(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize surface!\n");
-    goto error_deinit_instance;
-  }
+  for (i = 0; i < OWL_DEPTH_PYRAMID_LEVELS; ++i) {
+    VkDescriptorImageInfo images[3];
+    VkWriteDescriptorSet writes[3];
 
-  ret = owl_renderer_select_physical_device(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Couldn't find physical device\n");
-    goto error_deinit_surface;
-  }
+    images[0].sampler = r->nearest_sampler;
+    images[0].imageView = r->depth_image_view;
+    images[0].imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
-  ret = owl_renderer_clamp_dimensions(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Couldn't clamp dimensions\n");
-    goto error_deinit_surface;
-  }
+    /* level 0 doesn't read it, any level will do */
+    images[1].sampler = r->nearest_sampler;
+    images[1].imageView = r->depth_pyramid_level_views[i ? i - 1 : 0];
+    images[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-  ret = owl_renderer_init_device(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize device!\n");
-    goto error_deinit_surface;
-  }
+    images[2].sampler = VK_NULL_HANDLE;
+    images[2].imageView = r->depth_pyramid_level_views[i];
+    images[2].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-  ret = owl_renderer_init_attachments(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize attachments\n");
-    goto error_deinit_device;
-  }
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].pNext = NULL;
+    writes[0].dstSet = descriptor_sets[i];
+    writes[0].dstBinding = 0;
+    writes[0].dstArrayElement = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo = &images[0];
+    writes[0].pBufferInfo = NULL;
+    writes[0].pTexelBufferView = NULL;
 
-  ret = owl_renderer_init_render_passes(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize render passes!\n");
-    goto error_deinit_attachments;
-  }
+    writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].pNext = NULL;
+    writes[1].dstSet = descriptor_sets[i];
+    writes[1].dstBinding = 1;
+    writes[1].dstArrayElement = 0;
+    writes[1].descriptorCount = 1;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[1].pImageInfo = &images[1];
+    writes[1].pBufferInfo = NULL;
+    writes[1].pTexelBufferView = NULL;
 
-  ret = owl_renderer_init_swapchain(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize swapchain!\n");
-    goto error_deinit_render_passes;
-  }
+    writes[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[2].pNext = NULL;
+    writes[2].dstSet = descriptor_sets[i];
+    writes[2].dstBinding = 2;
+    writes[2].dstArrayElement = 0;
+    writes[2].descriptorCount = 1;
+    writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[2].pImageInfo = &images[2];
+    writes[2].pBufferInfo = NULL;
+    writes[2].pTexelBufferView = NULL;
 
-  ret = owl_renderer_init_pools(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize pools!\n");
-    goto error_deinit_swapchain;
+    vkUpdateDescriptorSets(r->device, OWL_ARRAY_SIZE(writes), writes, 0, NULL);
   }
 
-  ret = owl_renderer_init_layouts(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize layouts!\n");
-    goto error_deinit_pools;
-  }
+  owl_renderer_begin_scope(r, OWL_RENDERER_SCOPE_DEPTH_PYRAMID);
 
-  ret = owl_renderer_init_graphics_pipelines(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize graphics pipelines!\n");
-    goto error_deinit_layouts;
-  }
+  {
+    VkMemoryBarrier memory_barrier;
+    VkImageMemoryBarrier image_barrier;
+    VkPipelineStageFlagBits src_stages;
+
+    /* the previous frame's culling is done reading the pyramid */
+    memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memory_barrier.pNext = NULL;
+    memory_barrier.srcAccessMask = 0;
+    memory_barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+    image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    image_barrier.pNext = NULL;
+    image_barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    image_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    image_barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    image_barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.image = r->depth_image;
+    image_barrier.subresourceRange.aspectMask = 0;
+    image_barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_DEPTH_BIT;
+    image_barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    image_barrier.subresourceRange.baseMipLevel = 0;
+    image_barrier.subresourceRange.levelCount = 1;
+    image_barrier.subresourceRange.baseArrayLayer = 0;
+    image_barrier.subresourceRange.layerCount = 1;
+
+    src_stages = 0;
+    src_stages |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    src_stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, src_stages,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &memory_barrier, 0, NULL, 1, &image_barrier);
+  }
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    r->depth_pyramid_pipeline);
+
+  push_constant.samples = (uint32_t)r->msaa;
+
+  for (i = 0; i < OWL_DEPTH_PYRAMID_LEVELS; ++i) {
+    /* owl_depth_pyramid.comp runs 8x8 texels per group */
+    uint32_t const size = OWL_MAX(OWL_DEPTH_PYRAMID_SIZE >> i, 1);
+    uint32_t const num_groups = (size + 7) / 8;
+
+    if (i) {
+      VkMemoryBarrier barrier;
+
+      barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      barrier.pNext = NULL;
+      barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-  ret = owl_renderer_init_upload_buffer(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize upload heap!\n");
-    goto error_deinit_graphics_pipelines;
-  }
+      vkCmdPipelineBarrier(command_buffer,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                           &barrier, 0, NULL, 0, NULL);
+    }
 
-  ret = owl_renderer_init_samplers(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize samplers!\n");
-    goto error_deinit_upload_buffer;
-  }
+    push_constant.level = i;
 
-  ret = owl_renderer_init_frames(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize frames!\n");
-    goto error_deinit_samplers;
-  }
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            r->depth_pyramid_pipeline_layout, 0, 1,
+                            &descriptor_sets[i], 0, NULL);
 
-  ret = owl_renderer_init_garbage(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to initialize garbage!\n");
-    goto error_deinit_frames;
-  }
+    vkCmdPushConstants(command_buffer, r->depth_pyramid_pipeline_layout,
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constant),
+                       &push_constant);
 
-  ret = owl_renderer_init_vertex_buffer(r, OWL_DEFAULT_BUFFER_SIZE);
-  if (ret) {
-    OWL_DEBUG_LOG("Filed to initilize vertex buffer!\n");
-    goto error_deinit_garbage;
+    vkCmdDispatch(command_buffer, num_groups, num_groups, 1);
   }
 
-  ret = owl_renderer_init_index_buffer(r, OWL_DEFAULT_BUFFER_SIZE);
-  if (ret) {
-    OWL_DEBUG_LOG("Filed to initilize index buffer!\n");
-    goto error_deinit_vertex_buffer;
-  }
+  {
+    VkMemoryBarrier barrier;
+    VkPipelineStageFlagBits dst_stages;
 
-  ret = owl_renderer_init_uniform_buffer(r, OWL_DEFAULT_BUFFER_SIZE);
-  if (ret) {
-    OWL_DEBUG_LOG("Filed to initilize uniform buffer!\n");
-    goto error_deinit_index_buffer;
+    /* the next frame's culling reads the pyramid, its main pass starts
+     * writing the depth again once the reads are done. the render pass
+     * discards the old layout */
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    dst_stages = 0;
+    dst_stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dst_stages |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         dst_stages, 0, 1, &barrier, 0, NULL, 0, NULL);
   }
 
-  return OWL_OK;
+  owl_renderer_end_scope(r, OWL_RENDERER_SCOPE_DEPTH_PYRAMID);
 
-error_deinit_index_buffer:
-  owl_renderer_deinit_index_buffer(r);
+  /* same world to clip space as the models, y flipped before the view */
+  OWL_M4_IDENTITY(flip);
+  flip[1][1] = -1.0F;
 
-error_deinit_vertex_buffer:
-  owl_renderer_deinit_vertex_buffer(r);
+  owl_m4_multiply(r->projection, r->view, r->depth_pyramid_clip);
+  owl_m4_multiply(r->depth_pyramid_clip, flip, r->depth_pyramid_clip);
 
-error_deinit_garbage:
-  owl_renderer_deinit_garbage(r);
+  r->depth_pyramid_frame = r->frame_count;
 
-error_deinit_frames:
-  owl_renderer_deinit_frames(r);
+  return OWL_OK;
+}
 
-error_deinit_samplers:
-  owl_renderer_deinit_samplers(r);
+OWLAPI int owl_renderer_end_frame(struct owl_renderer *r) {
+  uint32_t const frame = r->frame;
+  VkCommandBuffer command_buffer = r->submit_command_buffers[frame];
+  VkFence in_flight_fence = r->in_flight_fences[frame];
+  VkSemaphore acquire_semaphore = r->acquire_semaphores[frame];
+  VkSemaphore render_done_semaphore = r->render_done_semaphores[frame];
 
-error_deinit_upload_buffer:
-  owl_renderer_deinit_upload_buffer(r);
+  int ret;
+  VkResult vk_result;
 
-error_deinit_graphics_pipelines:
-  owl_renderer_deinit_graphics_pipelines(r);
+  ret = owl_draw_flush(r);
+  if (ret)
+    return ret;
 
-error_deinit_layouts:
-  owl_renderer_deinit_layouts(r);
+  if (r->frame_command_buffer != command_buffer) {
+    uint32_t i;
+    VkCommandBuffer secondaries[OWL_MAX_RECORDING_THREADS + 1];
 
-error_deinit_pools:
-  owl_renderer_deinit_pools(r);
+    vk_result = vkEndCommandBuffer(r->frame_command_buffer);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
 
-error_deinit_swapchain:
-  owl_renderer_deinit_swapchain(r);
+    /* the main thread's commands go first, then every thread in the order
+     * they began */
+    secondaries[0] = r->frame_command_buffer;
+    for (i = 0; i < r->num_frame_threads; ++i) {
+      struct owl_thread *t = r->frame_threads[i];
 
-error_deinit_render_passes:
-  owl_renderer_deinit_render_passes(r);
+      secondaries[i + 1] = t->command_buffer;
 
-error_deinit_attachments:
-  owl_renderer_deinit_attachments(r);
+      if (r->font_loaded)
+        owl_font_touch_glyphs(r, &r->font, t->touched_glyphs);
+    }
 
-error_deinit_device:
-  owl_renderer_deinit_device(r);
+    vkCmdExecuteCommands(command_buffer, r->num_frame_threads + 1,
+                         secondaries);
 
-error_deinit_surface:
-  owl_renderer_deinit_surface(r);
+    r->frame_command_buffer = command_buffer;
+    r->num_frame_threads = 0;
+  }
 
-error_deinit_instance:
-  owl_renderer_deinit_instance(r);
+  vkCmdEndRenderPass(command_buffer);
+  owl_renderer_end_scope(r, OWL_RENDERER_SCOPE_MAIN_PASS);
 
-error:
-  return ret;
-}
+  /* only the frames that culled a model need the pyramid */
+  if (r->cull_recording) {
+    ret = owl_renderer_build_depth_pyramid(r);
+    if (ret)
+      return ret;
+  }
 
-OWLAPI void owl_renderer_deinit(struct owl_renderer *r) {
-  vkDeviceWaitIdle(r->device);
+  vk_result = vkEndCommandBuffer(command_buffer);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
 
-  if (r->font_loaded)
-    owl_renderer_unload_font(r);
+  /* a scope left open loses its time, every begin needs its end */
+  if (r->timestamps_supported) {
+    uint32_t i;
+    struct owl_renderer_timestamps const *timestamps =
+        &r->frame_timestamps[frame];
+    OWL_UNUSED(timestamps);
 
-  if (r->skybox_loaded)
-    owl_renderer_unload_skybox(r);
+    for (i = 0; i < OWL_RENDERER_NUM_SCOPES; ++i)
+      OWL_ASSERT((uint32_t)-1 == timestamps->open_scopes[i]);
+  }
 
-  owl_renderer_deinit_uniform_buffer(r);
-  owl_renderer_deinit_index_buffer(r);
-  owl_renderer_deinit_vertex_buffer(r);
-  owl_renderer_deinit_garbage(r);
-  owl_renderer_deinit_frames(r);
-  owl_renderer_deinit_samplers(r);
-  owl_renderer_deinit_upload_buffer(r);
-  owl_renderer_deinit_graphics_pipelines(r);
-  owl_renderer_deinit_layouts(r);
-  owl_renderer_deinit_pools(r);
-  owl_renderer_deinit_swapchain(r);
-  owl_renderer_deinit_render_passes(r);
-  owl_renderer_deinit_attachments(r);
-  owl_renderer_deinit_device(r);
-  owl_renderer_deinit_surface(r);
-  owl_renderer_deinit_instance(r);
-}
+  if (r->cull_recording) {
+    VkMemoryBarrier barrier;
+    VkCommandBuffer cull_command_buffer = r->cull_command_buffers[frame];
 
-OWLAPI int owl_renderer_update_dimensions(struct owl_renderer *r) {
-  uint32_t width;
-  uint32_t height;
-  float ratio;
-  float const fov = OWL_DEGREES_AS_RADIANS(45.0F);
-  float const near = 0.01;
-  float const far = 10.0F;
-  VkResult vk_result;
-  int ret;
+    /* the indirect draws of the frame read what the dispatches wrote */
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
 
-  vk_result = vkDeviceWaitIdle(r->device);
-  if (vk_result) {
-    ret = OWL_ERROR_FATAL;
-    goto error;
+    vkCmdPipelineBarrier(cull_command_buffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0,
+                         NULL, 0, NULL);
+
+    vk_result = vkEndCommandBuffer(cull_command_buffer);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
   }
 
-  owl_plataform_get_framebuffer_dimensions(r->plataform, &width, &height);
-  r->width = width;
-  r->height = height;
+  {
+    VkSubmitInfo info;
+    VkPipelineStageFlagBits stage;
+    uint32_t num_command_buffers = 0;
+    VkCommandBuffer command_buffers[2];
 
-  ratio = (float)width / (float)height;
-  owl_m4_perspective(fov, ratio, near, far, r->projection);
+    /* the culling goes first, in submission order */
+    if (r->cull_recording)
+      command_buffers[num_command_buffers++] = r->cull_command_buffers[frame];
 
-  owl_renderer_deinit_graphics_pipelines(r);
-  owl_renderer_deinit_swapchain(r);
-  owl_renderer_deinit_attachments(r);
+    command_buffers[num_command_buffers++] = command_buffer;
 
-  ret = owl_renderer_clamp_dimensions(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to clamp dimensions!\n");
-    goto error;
-  }
+    stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    info.pNext = NULL;
+    if (r->headless) {
+      info.waitSemaphoreCount = 0;
+      info.pWaitSemaphores = NULL;
+      info.signalSemaphoreCount = 0;
+      info.pSignalSemaphores = NULL;
+      info.pWaitDstStageMask = NULL;
+    } else {
+      info.waitSemaphoreCount = 1;
+      info.pWaitSemaphores = &acquire_semaphore;
+      info.signalSemaphoreCount = 1;
+      info.pSignalSemaphores = &render_done_semaphore;
+      info.pWaitDstStageMask = &stage;
+    }
+    info.commandBufferCount = num_command_buffers;
+    info.pCommandBuffers = command_buffers;
 
-  ret = owl_renderer_init_attachments(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to resize attachments!\n");
-    goto error;
-  }
+    vk_result = vkQueueSubmit(r->graphics_queue, 1, &info, in_flight_fence);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
 
-  ret = owl_renderer_init_swapchain(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to resize swapchain!\n");
-    goto error_deinit_attachments;
+    r->cull_recording = 0;
+
+    /* the main pass left it in the transfer source layout */
+    if (r->headless)
+      r->offscreen_rendered = 1;
   }
 
-  ret = owl_renderer_init_graphics_pipelines(r);
-  if (ret) {
-    OWL_DEBUG_LOG("Failed to resize pipelines!\n");
-    goto error_deinit_swapchain;
+  if (!r->headless) {
+    VkPresentInfoKHR info;
+
+    info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    info.pNext = NULL;
+    info.waitSemaphoreCount = 1;
+    info.pWaitSemaphores = &render_done_semaphore;
+    info.swapchainCount = 1;
+    info.pSwapchains = &r->swapchain;
+    info.pImageIndices = &r->swapchain_image;
+    info.pResults = NULL;
+
+    vk_result = vkQueuePresentKHR(r->present_queue, &info);
+    if (OWL_RENDERER_IS_SWAPCHAIN_OUT_OF_DATE(vk_result)) {
+      ret = owl_renderer_update_dimensions(r);
+      if (ret)
+        return ret;
+    }
   }
 
+  owl_renderer_frame_clear_offset(r);
+  r->frame = (r->frame + 1) % r->num_frames;
+
   return OWL_OK;
+}
 
-error_deinit_swapchain:
-  owl_renderer_deinit_swapchain(r);
+OWLAPI int owl_renderer_read_frame(struct owl_renderer *r, void *pixels) {
+  int ret;
+  VkCommandBuffer command_buffer;
 
-error_deinit_attachments:
-  owl_renderer_deinit_attachments(r);
+  if (!r->headless || r->frame_state_lost || !r->offscreen_rendered)
+    return OWL_ERROR_INVALID_VALUE;
 
-error:
-  return ret;
-}
+  ret = owl_renderer_begin_im_command_buffer(r);
+  if (ret)
+    return ret;
 
-OWLAPI void *
-owl_renderer_vertex_allocate(struct owl_renderer *r, uint64_t size,
-                             struct owl_renderer_vertex_allocation *alloc) {
-  uint8_t *data = r->vertex_buffer_data;
-  uint32_t const frame = r->frame;
-  uint64_t const alignment = r->vertex_buffer_alignment;
-  uint64_t required = size + r->vertex_buffer_offset;
-  uint64_t aligned_size = r->vertex_buffer_aligned_size;
+  command_buffer = r->im_command_buffer;
 
-  if (r->vertex_buffer_size < required) {
-    int ret;
+  {
+    VkImageMemoryBarrier barrier;
 
-    ret = owl_renderer_garbage_push_vertex(r);
-    if (ret)
-      return NULL;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = r->offscreen_image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
 
-    /* FIXME(samuel): ensure vertex buffer is valid after failure */
-    ret = owl_renderer_init_vertex_buffer(r, required);
-    if (ret)
-      return NULL;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL,
+                         1, &barrier);
+  }
 
-    data = r->vertex_buffer_data;
-    required = size + r->vertex_buffer_offset;
-    aligned_size = r->vertex_buffer_aligned_size;
+  {
+    VkBufferImageCopy copy;
+
+    copy.bufferOffset = 0;
+    copy.bufferRowLength = 0;
+    copy.bufferImageHeight = 0;
+    copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.imageSubresource.mipLevel = 0;
+    copy.imageSubresource.baseArrayLayer = 0;
+    copy.imageSubresource.layerCount = 1;
+    copy.imageOffset.x = 0;
+    copy.imageOffset.y = 0;
+    copy.imageOffset.z = 0;
+    copy.imageExtent.width = r->width;
+    copy.imageExtent.height = r->height;
+    copy.imageExtent.depth = 1;
+
+    vkCmdCopyImageToBuffer(command_buffer, r->offscreen_image,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           r->offscreen_readback_buffer, 1, &copy);
   }
 
-  alloc->offset = r->vertex_buffer_offset;
-  alloc->buffer = r->vertex_buffers[frame];
+  {
+    VkBufferMemoryBarrier barrier;
 
-  r->vertex_buffer_offset = OWL_ALIGN_UP_2(required, alignment);
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = r->offscreen_readback_buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
 
-  return &data[frame * aligned_size + alloc->offset];
-}
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &barrier,
+                         0, NULL);
+  }
 
-OWLAPI void owl_renderer_vertex_clear_offset(struct owl_renderer *r) {
-  r->vertex_buffer_last_offset = r->vertex_buffer_offset;
-  r->vertex_buffer_offset = 0;
-}
+  ret = owl_renderer_end_im_command_buffer(r);
+  if (ret)
+    return ret;
 
-OWLAPI void *
-owl_renderer_index_allocate(struct owl_renderer *r, uint64_t size,
-                            struct owl_renderer_index_allocation *alloc) {
-  uint8_t *data = r->index_buffer_data;
-  uint32_t const frame = r->frame;
-  uint64_t const alignment = r->index_buffer_alignment;
-  uint64_t required = size + r->index_buffer_offset;
-  uint64_t aligned_size = r->index_buffer_aligned_size;
+  OWL_MEMCPY(pixels, r->offscreen_readback_data, r->width * r->height * 4);
 
-  if (r->index_buffer_size < required) {
-    int ret;
+  return OWL_OK;
+}
 
-    ret = owl_renderer_garbage_push_index(r);
-    if (ret)
-      return NULL;
+/* covers the buffer offset rules of every texel size and the optimal copy
+ * offset alignment of common hardware */
+#define OWL_RENDERER_UPLOAD_ALIGNMENT 256
 
-    /* FIXME(samuel): ensure index buffer is valid after failure */
-    ret = owl_renderer_init_index_buffer(r, required * 2);
-    if (ret)
-      return NULL;
+static int owl_renderer_find_upload_offset(struct owl_renderer *r,
+                                           uint64_t size, uint64_t *offset) {
+  uint32_t i;
+  uint64_t tail = 0;
+  int32_t found = 0;
+  uint64_t const head = r->upload_buffer_head;
+  uint64_t const capacity = r->upload_buffer_size;
+
+  /* the oldest allocation that still lives in the ring */
+  for (i = 0; i < r->num_uploads && !found; ++i) {
+    uint32_t const id = (r->first_upload + i) % OWL_MAX_UPLOADS;
+
+    if (!r->uploads[id].buffer) {
+      tail = r->uploads[id].offset;
+      found = 1;
+    }
+  }
 
-    data = r->index_buffer_data;
-    required = size + r->index_buffer_offset;
-    aligned_size = r->index_buffer_aligned_size;
+  if (!found) {
+    *offset = 0;
+    return size <= capacity ? OWL_OK : OWL_ERROR_NO_SPACE;
   }
 
-  alloc->offset = r->index_buffer_offset;
-  alloc->buffer = r->index_buffers[frame];
+  /* the live allocations don't wrap, try the end first and then the start */
+  if (tail < head) {
+    if (head + size <= capacity) {
+      *offset = head;
+      return OWL_OK;
+    }
+
+    if (size <= tail) {
+      *offset = 0;
+      return OWL_OK;
+    }
 
-  r->index_buffer_offset = OWL_ALIGN_UP_2(required, alignment);
+    return OWL_ERROR_NO_SPACE;
+  }
 
-  return &data[frame * aligned_size + alloc->offset];
-}
+  /* head == tail with live allocations means the ring is full */
+  if (head + size <= tail) {
+    *offset = head;
+    return OWL_OK;
+  }
 
-OWLAPI void owl_renderer_index_clear_offset(struct owl_renderer *r) {
-  r->index_buffer_last_offset = r->index_buffer_offset;
-  r->index_buffer_offset = 0;
+  return OWL_ERROR_NO_SPACE;
 }
 
 OWLAPI void *
-owl_renderer_uniform_allocate(struct owl_renderer *r, uint64_t size,
-                              struct owl_renderer_uniform_allocation *alloc) {
-  uint8_t *data = r->uniform_buffer_data;
-  uint32_t const frame = r->frame;
-  uint64_t const alignment = r->uniform_buffer_alignment;
-  uint64_t required = size + r->uniform_buffer_offset;
-  uint64_t aligned_size = r->uniform_buffer_aligned_size;
+owl_renderer_upload_allocate(struct owl_renderer *r, uint64_t size,
+                             struct owl_renderer_upload_allocation *alloc) {
+  int ret;
+  uint32_t id;
+  uint64_t offset;
+  uint64_t aligned_size;
+  struct owl_renderer_upload *upload;
 
-  if (r->uniform_buffer_size < required) {
-    int ret;
+  if (OWL_MAX_UPLOADS <= r->num_uploads)
+    return NULL;
 
-    ret = owl_renderer_garbage_push_uniform(r);
-    if (ret)
-      return NULL;
+  aligned_size = OWL_MAX(size, 1);
+  aligned_size = OWL_ALIGN_UP_2(aligned_size, OWL_RENDERER_UPLOAD_ALIGNMENT);
 
-    /* FIXME(samuel): ensure uniform buffer is valid after failure */
-    ret = owl_renderer_init_uniform_buffer(r, required * 2);
-    if (ret)
-      return NULL;
+  ret = owl_renderer_find_upload_offset(r, aligned_size, &offset);
 
-    data = r->uniform_buffer_data;
-    required = size + r->uniform_buffer_offset;
-    aligned_size = r->uniform_buffer_aligned_size;
-  }
+  /* the ring might be held by uploads the transfer queue is done with */
+  while (ret && aligned_size <= r->upload_buffer_size &&
+         owl_renderer_reclaim_async_staging(r))
+    ret = owl_renderer_find_upload_offset(r, aligned_size, &offset);
 
-  alloc->offset = r->uniform_buffer_offset;
-  alloc->buffer = r->uniform_buffers[frame];
-  alloc->common_descriptor_set = r->uniform_pvm_descriptor_sets[frame];
-  alloc->model_descriptor_set = r->uniform_model_descriptor_sets[frame];
+  id = (r->first_upload + r->num_uploads) % OWL_MAX_UPLOADS;
+  upload = &r->uploads[id];
 
-  r->uniform_buffer_offset = OWL_ALIGN_UP_2(required, alignment);
+  upload->released = 0;
+  upload->size = size;
 
-  return &data[frame * aligned_size + alloc->offset];
-}
+  if (!ret) {
+    upload->offset = offset;
+    upload->data = &r->upload_buffer_data[offset];
+    upload->buffer = VK_NULL_HANDLE;
+    upload->memory = VK_NULL_HANDLE;
 
-OWLAPI void owl_renderer_uniform_clear_offset(struct owl_renderer *r) {
-  r->uniform_buffer_last_offset = r->uniform_buffer_offset;
-  r->uniform_buffer_offset = 0;
-}
+    r->upload_buffer_head = offset + aligned_size;
 
-#define OWL_RENDERER_IS_SWAPCHAIN_OUT_OF_DATE(vk_result)                       \
-  (VK_ERROR_OUT_OF_DATE_KHR == (vk_result) ||                                  \
-   VK_SUBOPTIMAL_KHR == (vk_result) ||                                         \
-   VK_ERROR_SURFACE_LOST_KHR == (vk_result))
+    alloc->offset = offset;
+    alloc->buffer = r->upload_buffer;
+  } else {
+    /* too big for the ring, or the ring is held by immediate uploads */
+    ret = owl_renderer_init_staging(r, size, &upload->buffer, &upload->memory,
+                                    &upload->data);
+    if (ret)
+      return NULL;
 
-OWLAPI int owl_renderer_begin_frame(struct owl_renderer *r) {
-  VkResult vk_result = VK_SUCCESS;
-  int ret = OWL_OK;
+    upload->offset = 0;
 
-  uint64_t const timeout = (uint64_t)-1;
-  uint32_t const num_clear_values = OWL_ARRAY_SIZE(r->clear_values);
-  uint32_t const frame = r->frame;
-  VkClearValue const *clear_values = r->clear_values;
-  VkCommandBuffer command_buffer = r->submit_command_buffers[frame];
-  VkSemaphore acquire_semaphore = r->acquire_semaphores[frame];
+    alloc->offset = 0;
+    alloc->buffer = upload->buffer;
+  }
+
+  ++r->num_uploads;
+
+  return upload->data;
+}
+
+OWLAPI void owl_renderer_upload_free(struct owl_renderer *r, void *data) {
+  uint32_t i;
   VkDevice const device = r->device;
+  struct owl_renderer_upload *upload = NULL;
 
-  vk_result =
-      vkAcquireNextImageKHR(device, r->swapchain, timeout, acquire_semaphore,
-                            VK_NULL_HANDLE, &r->swapchain_image);
-  if (OWL_RENDERER_IS_SWAPCHAIN_OUT_OF_DATE(vk_result)) {
-    ret = owl_renderer_update_dimensions(r);
-    if (ret)
-      return ret;
+  for (i = 0; i < r->num_uploads && !upload; ++i) {
+    uint32_t const id = (r->first_upload + i) % OWL_MAX_UPLOADS;
 
-    vk_result =
-        vkAcquireNextImageKHR(device, r->swapchain, timeout, acquire_semaphore,
-                              VK_NULL_HANDLE, &r->swapchain_image);
-    if (vk_result)
-      return OWL_ERROR_FATAL;
+    if (!r->uploads[id].released && data == r->uploads[id].data)
+      upload = &r->uploads[id];
   }
 
-  {
-    VkFence in_flight_fence = r->in_flight_fences[frame];
-    VkCommandPool command_pool = r->submit_command_pools[frame];
+  OWL_ASSERT(upload);
+  if (!upload)
+    return;
 
-    vk_result = vkWaitForFences(device, 1, &in_flight_fence, VK_TRUE, timeout);
-    if (vk_result)
-      return OWL_ERROR_FATAL;
+  if (upload->buffer) {
+    vkFreeMemory(device, upload->memory, NULL);
+    vkDestroyBuffer(device, upload->buffer, NULL);
+  }
 
-    vk_result = vkResetFences(device, 1, &in_flight_fence);
-    if (vk_result)
-      return OWL_ERROR_FATAL;
+  upload->released = 1;
 
-    vk_result = vkResetCommandPool(device, command_pool, 0);
-    if (vk_result)
-      return OWL_ERROR_FATAL;
+  /* the ring space is only given back in allocation order */
+  while (r->num_uploads && r->uploads[r->first_upload].released) {
+    r->first_upload = (r->first_upload + 1) % OWL_MAX_UPLOADS;
+    --r->num_uploads;
   }
+}
 
-  owl_renderer_collect_garbage(r);
+OWLAPI void *
+owl_renderer_begin_async_upload(struct owl_renderer *r, uint64_t size,
+                                struct owl_renderer_upload_allocation *alloc) {
+  int32_t i;
+  void *data;
+  VkResult vk_result;
+  struct owl_renderer_async_upload *upload = NULL;
+
+  OWL_ASSERT(!r->async_upload);
+
+  for (i = 0; i < OWL_MAX_ASYNC_UPLOADS && !upload; ++i)
+    if (OWL_RENDERER_ASYNC_UPLOAD_STATE_FREE == r->async_uploads[i].state)
+      upload = &r->async_uploads[i];
+
+  /* every slot is in flight and no frame has acquired them yet, waits for
+   * the oldest one and acquires it here */
+  if (!upload) {
+    uint64_t const oldest = r->async_upload_done_ticket + 1;
+
+    if (owl_renderer_wait_async_upload(r, oldest))
+      return NULL;
+
+    for (i = 0; i < OWL_MAX_ASYNC_UPLOADS && !upload; ++i)
+      if (OWL_RENDERER_ASYNC_UPLOAD_STATE_FREE == r->async_uploads[i].state)
+        upload = &r->async_uploads[i];
+
+    if (!upload)
+      return NULL;
+  }
+
+  data = owl_renderer_upload_allocate(r, size, alloc);
+  if (!data)
+    return NULL;
 
   {
     VkCommandBufferBeginInfo info;
@@ -4710,185 +7753,246 @@ OWLAPI int owl_renderer_begin_frame(struct owl_renderer *r) {
     info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     info.pInheritanceInfo = NULL;
 
-    vk_result = vkBeginCommandBuffer(command_buffer, &info);
+    vk_result = vkBeginCommandBuffer(upload->command_buffer, &info);
     if (vk_result)
-      return OWL_ERROR_FATAL;
+      goto error_free_staging;
   }
 
-  {
-    VkRenderPassBeginInfo info;
-    VkFramebuffer framebuffer;
+  upload->state = OWL_RENDERER_ASYNC_UPLOAD_STATE_RECORDING;
+  upload->num_buffer_barriers = 0;
+  upload->num_image_barriers = 0;
+  upload->staging_data = data;
 
-    framebuffer = r->swapchain_framebuffers[r->swapchain_image];
-    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    info.pNext = NULL;
-    info.renderPass = r->main_render_pass;
-    info.framebuffer = framebuffer;
-    info.renderArea.offset.x = 0;
-    info.renderArea.offset.y = 0;
-    info.renderArea.extent.width = r->width;
-    info.renderArea.extent.height = r->height;
-    info.clearValueCount = num_clear_values;
-    info.pClearValues = clear_values;
+  r->async_upload = upload;
+  r->async_command_buffer = upload->command_buffer;
 
-    vkCmdBeginRenderPass(command_buffer, &info, VK_SUBPASS_CONTENTS_INLINE);
-  }
+  return data;
 
-  return OWL_OK;
+error_free_staging:
+  owl_renderer_upload_free(r, data);
+
+  return NULL;
 }
 
-OWLAPI int owl_renderer_end_frame(struct owl_renderer *r) {
-  uint32_t const frame = r->frame;
-  VkCommandBuffer command_buffer = r->submit_command_buffers[frame];
-  VkFence in_flight_fence = r->in_flight_fences[frame];
-  VkSemaphore acquire_semaphore = r->acquire_semaphores[frame];
-  VkSemaphore render_done_semaphore = r->render_done_semaphores[frame];
+OWLAPI int owl_renderer_async_release_buffer(struct owl_renderer *r,
+                                             VkBuffer buffer,
+                                             VkAccessFlags access) {
+  VkBufferMemoryBarrier barrier;
+  struct owl_renderer_async_upload *upload = r->async_upload;
 
-  VkResult vk_result;
+  OWL_ASSERT(upload);
 
-  vkCmdEndRenderPass(command_buffer);
-  vk_result = vkEndCommandBuffer(command_buffer);
-  if (vk_result)
-    return OWL_ERROR_FATAL;
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.pNext = NULL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.buffer = buffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
 
-  {
-    VkSubmitInfo info;
-    VkPipelineStageFlagBits stage;
+  /* same queue, a plain barrier is enough */
+  if (r->transfer_family == r->graphics_family) {
+    barrier.dstAccessMask = access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 
-    stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    info.pNext = NULL;
-    info.waitSemaphoreCount = 1;
-    info.pWaitSemaphores = &acquire_semaphore;
-    info.signalSemaphoreCount = 1;
-    info.pSignalSemaphores = &render_done_semaphore;
-    info.pWaitDstStageMask = &stage;
-    info.commandBufferCount = 1;
-    info.pCommandBuffers = &command_buffer;
+    vkCmdPipelineBarrier(upload->command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         OWL_RENDERER_ASYNC_UPLOAD_DST_STAGES, 0, 0, NULL, 1,
+                         &barrier, 0, NULL);
 
-    vk_result = vkQueueSubmit(r->graphics_queue, 1, &info, in_flight_fence);
-    if (vk_result)
-      return OWL_ERROR_FATAL;
+    return OWL_OK;
   }
 
-  {
-    VkPresentInfoKHR info;
+  if (OWL_MAX_ASYNC_UPLOAD_BARRIERS <= upload->num_buffer_barriers)
+    return OWL_ERROR_NO_SPACE;
 
-    info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    info.pNext = NULL;
-    info.waitSemaphoreCount = 1;
-    info.pWaitSemaphores = &render_done_semaphore;
-    info.swapchainCount = 1;
-    info.pSwapchains = &r->swapchain;
-    info.pImageIndices = &r->swapchain_image;
-    info.pResults = NULL;
+  /* release half, the access masks of the other queue are ignored */
+  barrier.dstAccessMask = 0;
+  barrier.srcQueueFamilyIndex = r->transfer_family;
+  barrier.dstQueueFamilyIndex = r->graphics_family;
 
-    vk_result = vkQueuePresentKHR(r->present_queue, &info);
-    if (OWL_RENDERER_IS_SWAPCHAIN_OUT_OF_DATE(vk_result))
-      return owl_renderer_update_dimensions(r);
+  vkCmdPipelineBarrier(upload->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 1,
+                       &barrier, 0, NULL);
+
+  /* acquire half, recorded on the graphics queue */
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = access;
+
+  upload->buffer_barriers[upload->num_buffer_barriers++] = barrier;
+
+  return OWL_OK;
+}
+
+OWLAPI int owl_renderer_async_release_image(struct owl_renderer *r,
+                                            VkImage image, uint32_t mipmaps,
+                                            uint32_t layers) {
+  VkImageMemoryBarrier barrier;
+  struct owl_renderer_async_upload *upload = r->async_upload;
+
+  OWL_ASSERT(upload);
+
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.pNext = NULL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = mipmaps;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = layers;
+
+  if (r->transfer_family == r->graphics_family) {
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    vkCmdPipelineBarrier(upload->command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         OWL_RENDERER_ASYNC_UPLOAD_DST_STAGES, 0, 0, NULL, 0,
+                         NULL, 1, &barrier);
+
+    return OWL_OK;
   }
 
-  r->frame = (r->frame + 1) % r->num_frames;
-  owl_renderer_vertex_clear_offset(r);
-  owl_renderer_index_clear_offset(r);
-  owl_renderer_uniform_clear_offset(r);
+  if (OWL_MAX_ASYNC_UPLOAD_BARRIERS <= upload->num_image_barriers)
+    return OWL_ERROR_NO_SPACE;
+
+  /* the layout transition has to match on both halves, it happens once */
+  barrier.dstAccessMask = 0;
+  barrier.srcQueueFamilyIndex = r->transfer_family;
+  barrier.dstQueueFamilyIndex = r->graphics_family;
+
+  vkCmdPipelineBarrier(upload->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0,
+                       NULL, 1, &barrier);
+
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+  upload->image_barriers[upload->num_image_barriers++] = barrier;
 
   return OWL_OK;
 }
 
-OWLAPI void *
-owl_renderer_upload_allocate(struct owl_renderer *r, uint64_t size,
-                             struct owl_renderer_upload_allocation *alloc) {
+OWLAPI int owl_renderer_end_async_upload(struct owl_renderer *r,
+                                         uint64_t *ticket) {
   VkResult vk_result;
-  VkDevice const device = r->device;
+  struct owl_renderer_async_upload *upload = r->async_upload;
 
-  if (r->upload_buffer_in_use)
-    goto error;
+  OWL_ASSERT(upload);
 
-  r->upload_buffer_size = size;
+  r->async_upload = NULL;
+  r->async_command_buffer = VK_NULL_HANDLE;
+
+  vk_result = vkEndCommandBuffer(upload->command_buffer);
+  if (vk_result)
+    goto error;
 
   {
-    VkBufferCreateInfo info;
+    VkSubmitInfo info;
 
-    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     info.pNext = NULL;
-    info.flags = 0;
-    info.size = size;
-    info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    info.queueFamilyIndexCount = 0;
-    info.pQueueFamilyIndices = NULL;
+    info.waitSemaphoreCount = 0;
+    info.pWaitSemaphores = NULL;
+    info.pWaitDstStageMask = NULL;
+    info.commandBufferCount = 1;
+    info.pCommandBuffers = &upload->command_buffer;
+    info.signalSemaphoreCount = 0;
+    info.pSignalSemaphores = NULL;
 
-    vk_result = vkCreateBuffer(device, &info, NULL, &r->upload_buffer);
+    vk_result = vkQueueSubmit(r->transfer_queue, 1, &info, upload->fence);
     if (vk_result)
       goto error;
   }
 
-  {
-    VkMemoryPropertyFlagBits properties;
-    VkMemoryRequirements requirements;
-    VkMemoryAllocateInfo info;
+  upload->state = OWL_RENDERER_ASYNC_UPLOAD_STATE_SUBMITTED;
+  upload->ticket = ++r->async_upload_ticket;
 
-    properties = 0;
-    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  if (ticket)
+    *ticket = upload->ticket;
 
-    vkGetBufferMemoryRequirements(device, r->upload_buffer, &requirements);
+  return OWL_OK;
 
-    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.allocationSize = requirements.size;
-    info.memoryTypeIndex = owl_renderer_find_memory_type(
-        r, requirements.memoryTypeBits, properties);
+error:
+  owl_renderer_upload_free(r, upload->staging_data);
+  upload->staging_data = NULL;
+  upload->state = OWL_RENDERER_ASYNC_UPLOAD_STATE_FREE;
 
-    vk_result = vkAllocateMemory(device, &info, NULL, &r->upload_buffer_memory);
-    if (vk_result)
-      goto error_destroy_buffer;
+  return OWL_ERROR_FATAL;
+}
 
-    vk_result = vkBindBufferMemory(device, r->upload_buffer,
-                                   r->upload_buffer_memory, 0);
-    if (vk_result)
-      goto error_free_memory;
+OWLAPI int owl_renderer_is_async_upload_done(struct owl_renderer *r,
+                                             uint64_t ticket) {
+  return ticket <= r->async_upload_done_ticket;
+}
 
-    vk_result = vkMapMemory(device, r->upload_buffer_memory, 0,
-                            r->upload_buffer_size, 0, &r->upload_buffer_data);
-    if (vk_result)
-      goto error_free_memory;
-  }
+OWLAPI int owl_renderer_wait_async_upload(struct owl_renderer *r,
+                                          uint64_t ticket) {
+  int ret;
+  int end_ret;
 
-  alloc->buffer = r->upload_buffer;
+  if (owl_renderer_is_async_upload_done(r, ticket))
+    return OWL_OK;
 
-  return r->upload_buffer_data;
+  ret = owl_renderer_begin_im_command_buffer(r);
+  if (ret)
+    return ret;
 
-error_free_memory:
-  vkFreeMemory(device, r->upload_buffer_memory, NULL);
+  while (!ret && !owl_renderer_is_async_upload_done(r, ticket)) {
+    VkResult vk_result;
+    uint64_t const timeout = (uint64_t)-1;
+    uint64_t const next = r->async_upload_done_ticket + 1;
+    struct owl_renderer_async_upload *upload;
+
+    upload = owl_renderer_find_async_upload(r, next);
+    if (!upload) {
+      ret = OWL_ERROR_NOT_FOUND;
+      break;
+    }
 
-error_destroy_buffer:
-  vkDestroyBuffer(device, r->upload_buffer, NULL);
+    vk_result = vkWaitForFences(r->device, 1, &upload->fence, VK_TRUE, timeout);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      break;
+    }
 
-error:
-  return NULL;
-}
+    ret = owl_renderer_acquire_async_upload(r, upload, r->im_command_buffer);
+  }
 
-OWLAPI void owl_renderer_upload_free(struct owl_renderer *r, void *data) {
-  VkDevice const device = r->device;
+  /* the im command buffer has to end either way */
+  end_ret = owl_renderer_end_im_command_buffer(r);
+  if (!ret)
+    ret = end_ret;
 
-  OWL_UNUSED(data);
-  OWL_ASSERT(r->upload_buffer_data == data);
-  r->upload_buffer_in_use = 0;
-  r->upload_buffer_size = 0;
-  r->upload_buffer_data = NULL;
+  return ret;
+}
 
-  vkFreeMemory(device, r->upload_buffer_memory, NULL);
-  vkDestroyBuffer(device, r->upload_buffer, NULL);
+static int owl_renderer_load_font_common(struct owl_renderer *r,
+                                         uint32_t size, char const *path,
+                                         int32_t sdf) {
+  int ret = owl_font_init(r, path, size, sdf, &r->font);
+  if (!ret) {
+    r->font_loaded = 1;
+    ++r->font_generation;
+  }
+  return ret;
 }
 
 OWLAPI int owl_renderer_load_font(struct owl_renderer *r, uint32_t size,
                                   char const *path) {
-  int ret = owl_font_init(r, path, size, &r->font);
-  if (!ret)
-    r->font_loaded = 1;
-  return ret;
+  return owl_renderer_load_font_common(r, size, path, 0);
+}
+
+OWLAPI int owl_renderer_load_sdf_font(struct owl_renderer *r, uint32_t size,
+                                      char const *path) {
+  if (!r->text_sdf_pipeline)
+    return OWL_ERROR_INVALID_VALUE;
+
+  return owl_renderer_load_font_common(r, size, path, 1);
 }
 
 OWLAPI void owl_renderer_unload_font(struct owl_renderer *r) {
@@ -4915,6 +8019,8 @@ OWLAPI int owl_renderer_load_skybox(struct owl_renderer *r, char const *path) {
   if (ret)
     goto error;
 
+  r->stats.immediate_ms[OWL_RENDERER_SCOPE_FILTER_MAPS] = 0.0F;
+
   ret = owl_renderer_init_filter_maps(r);
   if (ret)
     goto error_deinit_texture;
@@ -4925,23 +8031,11 @@ OWLAPI int owl_renderer_load_skybox(struct owl_renderer *r, char const *path) {
   if (ret)
     goto error_deinit_filter_maps;
 
-  {
-    VkDescriptorSetAllocateInfo info;
-    VkResult vk_result;
-
-    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.descriptorPool = r->descriptor_pool;
-    info.descriptorSetCount = 1;
-    info.pSetLayouts = &r->model_environment_descriptor_set_layout;
-
-    vk_result =
-        vkAllocateDescriptorSets(device, &info, &r->environment_descriptor_set);
-    if (vk_result) {
-      ret = OWL_ERROR_FATAL;
-      goto error_deinit_brdflut;
-    }
-  }
+  ret = owl_renderer_allocate_descriptor_sets(
+      r, 1, &r->model_environment_descriptor_set_layout,
+      &r->environment_descriptor_set, &r->environment_descriptor_pool);
+  if (ret)
+    goto error_deinit_brdflut;
 
   {
     VkDescriptorImageInfo descriptors[3];
@@ -5011,10 +8105,8 @@ error:
 }
 
 OWLAPI void owl_renderer_unload_skybox(struct owl_renderer *r) {
-  VkDevice const device = r->device;
-
-  vkFreeDescriptorSets(device, r->descriptor_pool, 1,
-                       &r->environment_descriptor_set);
+  owl_renderer_free_descriptor_sets(r, r->environment_descriptor_pool, 1,
+                                    &r->environment_descriptor_set);
   owl_renderer_deinit_brdflut(r);
   owl_renderer_deinit_filter_maps(r);
   owl_texture_deinit(r, &r->skybox);
@@ -5040,6 +8132,29 @@ OWLAPI uint32_t owl_renderer_find_memory_type(struct owl_renderer *r,
   return (uint32_t)-1;
 }
 
+OWLAPI VkCommandBuffer
+owl_renderer_cull_command_buffer(struct owl_renderer *r) {
+  VkCommandBuffer command_buffer = r->cull_command_buffers[r->frame];
+
+  if (!r->cull_recording) {
+    VkCommandBufferBeginInfo info;
+    VkResult vk_result;
+
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    info.pNext = NULL;
+    info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    info.pInheritanceInfo = NULL;
+
+    vk_result = vkBeginCommandBuffer(command_buffer, &info);
+    if (vk_result)
+      return VK_NULL_HANDLE;
+
+    r->cull_recording = 1;
+  }
+
+  return command_buffer;
+}
+
 OWLAPI int owl_renderer_begin_im_command_buffer(struct owl_renderer *r) {
   VkResult vk_result = VK_SUCCESS;
   int ret = OWL_OK;
@@ -5080,6 +8195,8 @@ OWLAPI int owl_renderer_begin_im_command_buffer(struct owl_renderer *r) {
     }
   }
 
+  owl_renderer_reset_timestamps(r, &r->im_timestamps, r->im_command_buffer);
+
   goto out;
 
 error_im_command_buffer_deinit:
@@ -5112,22 +8229,94 @@ OWLAPI int owl_renderer_end_im_command_buffer(struct owl_renderer *r) {
   info.signalSemaphoreCount = 0;
   info.pSignalSemaphores = NULL;
 
-  vk_result = vkQueueSubmit(r->graphics_queue, 1, &info, NULL);
+  vk_result = vkQueueSubmit(r->graphics_queue, 1, &info, r->im_fence);
   if (VK_SUCCESS != vk_result) {
     ret = OWL_ERROR_FATAL;
     goto cleanup;
   }
 
-  vk_result = vkQueueWaitIdle(r->graphics_queue);
+  /* only wait for this command buffer, the frames in flight and the
+   * transfer queue keep going */
+  vk_result =
+      vkWaitForFences(r->device, 1, &r->im_fence, VK_TRUE, (uint64_t)-1);
   if (VK_SUCCESS != vk_result) {
     ret = OWL_ERROR_FATAL;
     goto cleanup;
   }
 
-  r->im_command_buffer = VK_NULL_HANDLE;
+  vk_result = vkResetFences(r->device, 1, &r->im_fence);
+  if (VK_SUCCESS != vk_result) {
+    ret = OWL_ERROR_FATAL;
+    goto cleanup;
+  }
+
+  owl_renderer_resolve_timestamps(r, &r->im_timestamps, r->stats.immediate_ms);
 
 cleanup:
   vkFreeCommandBuffers(r->device, r->command_pool, 1, &r->im_command_buffer);
+  r->im_command_buffer = VK_NULL_HANDLE;
 
   return ret;
 }
+
+OWLAPI void owl_renderer_begin_scope(struct owl_renderer *r,
+                                     enum owl_renderer_scope scope) {
+  VkCommandBuffer command_buffer;
+  struct owl_renderer_timestamps *timestamps;
+
+  if (!r->timestamps_supported)
+    return;
+
+  if (r->im_command_buffer) {
+    command_buffer = r->im_command_buffer;
+    timestamps = &r->im_timestamps;
+  } else {
+    command_buffer = r->frame_command_buffer;
+    timestamps = &r->frame_timestamps[r->frame];
+  }
+
+  if (OWL_MAX_TIMESTAMP_SCOPES <= timestamps->num_scopes) {
+    timestamps->open_scopes[scope] = (uint32_t)-1;
+    return;
+  }
+
+  timestamps->open_scopes[scope] = timestamps->num_scopes;
+  timestamps->scopes[timestamps->num_scopes] = scope;
+
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                      timestamps->query_pool, timestamps->num_scopes * 2);
+
+  ++timestamps->num_scopes;
+}
+
+OWLAPI void owl_renderer_end_scope(struct owl_renderer *r,
+                                   enum owl_renderer_scope scope) {
+  uint32_t id;
+  VkCommandBuffer command_buffer;
+  struct owl_renderer_timestamps *timestamps;
+
+  if (!r->timestamps_supported)
+    return;
+
+  if (r->im_command_buffer) {
+    command_buffer = r->im_command_buffer;
+    timestamps = &r->im_timestamps;
+  } else {
+    command_buffer = r->frame_command_buffer;
+    timestamps = &r->frame_timestamps[r->frame];
+  }
+
+  id = timestamps->open_scopes[scope];
+  if ((uint32_t)-1 == id)
+    return;
+
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      timestamps->query_pool, id * 2 + 1);
+
+  timestamps->open_scopes[scope] = (uint32_t)-1;
+}
+
+OWLAPI void owl_renderer_get_stats(struct owl_renderer *r,
+                                   struct owl_renderer_stats *stats) {
+  OWL_MEMCPY(stats, &r->stats, sizeof(*stats));
+}
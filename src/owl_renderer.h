@@ -2,6 +2,7 @@
 #define OWL_RENDERER_H
 
 #include "owl_font.h"
+#include "owl_memory.h"
 #include "owl_texture.h"
 
 #include <vulkan/vulkan.h>
@@ -9,11 +10,107 @@
 OWL_BEGIN_DECLARATIONS
 
 #define OWL_MAX_SWAPCHAIN_IMAGES 8
+#define OWL_MAX_IN_FLIGHT_FRAMES 3
 #define OWL_NUM_IN_FLIGHT_FRAMES 2
-#define OWL_NUM_GARBAGE_FRAMES (OWL_NUM_IN_FLIGHT_FRAMES + 1)
+#define OWL_MAX_GARBAGE_FRAMES (OWL_MAX_IN_FLIGHT_FRAMES + 1)
+#define OWL_MAX_TIMESTAMP_SCOPES 32
+#define OWL_MAX_RECORDING_THREADS 16
+#define OWL_MAX_CULLED_MODELS 64
+#define OWL_MAX_ASYNC_UPLOADS 16
+#define OWL_MAX_UPLOADS 64
+#define OWL_UPLOAD_BUFFER_SIZE (32 * 1024 * 1024)
+#define OWL_MAX_ASYNC_UPLOAD_BARRIERS 8
+#define OWL_MAX_FRAME_PAGES 8
+#define OWL_FRAME_PAGE_SIZE (1 << 18)
+#define OWL_MAX_DESCRIPTOR_POOLS 16
+#define OWL_DESCRIPTOR_POOL_SIZE 256
+#define OWL_FRAME_DESCRIPTOR_POOL_SIZE 64
+#define OWL_MAX_BINDLESS_TEXTURES 1024
+#define OWL_BINDLESS_NONE ((uint32_t)-1)
+#define OWL_MAX_PIPELINE_CACHE_PATH_LENGTH 256
+#if !defined(OWL_PIPELINE_CACHE_PATH)
+#define OWL_PIPELINE_CACHE_PATH "owl_pipeline_cache.bin"
+#endif
+/* 16 bit indices, 4 vertices a quad */
+#define OWL_MAX_BATCH_QUADS 1024
+/* the pyramid doesn't follow the framebuffer, level 0 is always this size */
+#define OWL_DEPTH_PYRAMID_SIZE 512
+#define OWL_DEPTH_PYRAMID_LEVELS 10
+
+enum owl_renderer_scope {
+  OWL_RENDERER_SCOPE_MAIN_PASS,
+  OWL_RENDERER_SCOPE_SKYBOX,
+  OWL_RENDERER_SCOPE_MODEL,
+  OWL_RENDERER_SCOPE_DEPTH_PYRAMID,
+  OWL_RENDERER_SCOPE_FILTER_MAPS,
+  OWL_RENDERER_SCOPE_FLUID_SIMULATION,
+  OWL_RENDERER_NUM_SCOPES
+};
+
+struct owl_renderer_stats {
+  /* gpu milliseconds per scope of the latest frame that finished */
+  float frame_ms[OWL_RENDERER_NUM_SCOPES];
+  /* gpu milliseconds per scope accumulated by immediate command buffers */
+  float immediate_ms[OWL_RENDERER_NUM_SCOPES];
+};
+
+struct owl_renderer_timestamps {
+  VkQueryPool query_pool;
+  uint32_t num_scopes;
+  uint32_t open_scopes[OWL_RENDERER_NUM_SCOPES];
+  enum owl_renderer_scope scopes[OWL_MAX_TIMESTAMP_SCOPES];
+};
+
+struct owl_model;
+struct owl_thread;
+
+enum owl_renderer_async_upload_state {
+  OWL_RENDERER_ASYNC_UPLOAD_STATE_FREE,
+  OWL_RENDERER_ASYNC_UPLOAD_STATE_RECORDING,
+  OWL_RENDERER_ASYNC_UPLOAD_STATE_SUBMITTED
+};
+
+/*
+ * a batch of copies recorded on the transfer queue. the barriers are the
+ * acquire half of the ownership transfer, recorded on the graphics queue once
+ * the fence signals
+ */
+struct owl_renderer_async_upload {
+  enum owl_renderer_async_upload_state state;
+  uint64_t ticket;
+  VkCommandBuffer command_buffer;
+  VkFence fence;
+  /* staging memory from owl_renderer_upload_allocate, NULL once it has been
+   * given back */
+  void *staging_data;
+  uint32_t num_buffer_barriers;
+  VkBufferMemoryBarrier buffer_barriers[OWL_MAX_ASYNC_UPLOAD_BARRIERS];
+  uint32_t num_image_barriers;
+  VkImageMemoryBarrier image_barriers[OWL_MAX_ASYNC_UPLOAD_BARRIERS];
+};
+
+/* quads that share a pipeline and a texture, drawn together on flush */
+struct owl_renderer_quad_batch {
+  VkPipeline pipeline;
+  struct owl_texture const *texture;
+  uint32_t num_quads;
+  struct owl_common_vertex vertices[OWL_MAX_BATCH_QUADS * 4];
+};
 
 struct owl_renderer_upload_allocation {
+  uint64_t offset;
+  VkBuffer buffer;
+};
+
+/* a live upload allocation, buffer is only set for the one-off buffers of
+ * requests that don't fit in the upload ring */
+struct owl_renderer_upload {
+  int32_t released;
+  uint64_t offset;
+  uint64_t size;
+  void *data;
   VkBuffer buffer;
+  VkDeviceMemory memory;
 };
 
 struct owl_renderer_vertex_allocation {
@@ -26,6 +123,19 @@ struct owl_renderer_index_allocation {
   VkBuffer buffer;
 };
 
+/*
+ * a chunk of the per-frame allocator. the vertex, index and uniform data of a
+ * frame is packed in a chain of pages, new pages are appended when one fills
+ * up so the allocations already handed out stay where they are
+ */
+struct owl_renderer_frame_page {
+  uint64_t size;
+  VkBuffer buffer;
+  struct owl_memory_allocation memory;
+  VkDescriptorSet common_descriptor_set;
+  VkDescriptorSet model_descriptor_set;
+};
+
 struct owl_renderer_uniform_allocation {
   uint32_t offset;
   VkBuffer buffer;
@@ -33,9 +143,17 @@ struct owl_renderer_uniform_allocation {
   VkDescriptorSet model_descriptor_set;
 };
 
+struct owl_renderer_depth_pyramid_push_constant {
+  uint32_t level;
+  /* samples of the depth attachment */
+  uint32_t samples;
+};
+
 struct owl_renderer {
   struct owl_plataform *plataform;
 
+  int32_t headless;
+
   owl_v3 camera_eye;
   owl_v3 camera_direction;
   owl_m4 projection;
@@ -57,9 +175,18 @@ struct owl_renderer {
   uint32_t graphics_family;
   uint32_t present_family;
   uint32_t compute_family;
+  /* a transfer only family when the device has one, otherwise graphics */
+  uint32_t transfer_family;
   VkQueue graphics_queue;
   VkQueue present_queue;
   VkQueue compute_queue;
+  VkQueue transfer_queue;
+
+  VkPipelineCache pipeline_cache;
+  /* loaded at init and saved at deinit, empty to start empty every time */
+  char pipeline_cache_path[OWL_MAX_PIPELINE_CACHE_PATH_LENGTH];
+
+  struct owl_memory memory;
 
   VkSampleCountFlagBits msaa;
   VkFormat depth_format;
@@ -77,6 +204,7 @@ struct owl_renderer {
   VkRenderPass main_render_pass;
 
   VkCommandBuffer im_command_buffer;
+  VkFence im_fence;
 
   VkPresentModeKHR present_mode;
 
@@ -87,14 +215,38 @@ struct owl_renderer {
   VkImageView swapchain_image_views[OWL_MAX_SWAPCHAIN_IMAGES];
   VkFramebuffer swapchain_framebuffers[OWL_MAX_SWAPCHAIN_IMAGES];
 
+  VkImage offscreen_image;
+  VkDeviceMemory offscreen_memory;
+  VkImageView offscreen_image_view;
+  VkFramebuffer offscreen_framebuffer;
+  VkBuffer offscreen_readback_buffer;
+  VkDeviceMemory offscreen_readback_memory;
+  void *offscreen_readback_data;
+  /* a frame was submitted into the offscreen image since it was created,
+   * until then it's still in the undefined layout */
+  int32_t offscreen_rendered;
+
   VkCommandPool command_pool;
-  VkDescriptorPool descriptor_pool;
+  /* long lived descriptor sets, a pool is added when the others run out */
+  uint32_t num_descriptor_pools;
+  VkDescriptorPool descriptor_pools[OWL_MAX_DESCRIPTOR_POOLS];
+  /* descriptor sets that live for a single frame, reset all at once */
+  VkDescriptorPool frame_descriptor_pools[OWL_MAX_IN_FLIGHT_FRAMES];
 
   VkShaderModule basic_vertex_shader;
   VkShaderModule basic_fragment_shader;
   VkShaderModule text_fragment_shader;
+  /* VK_NULL_HANDLE when built without the distance field variant */
+  VkShaderModule text_sdf_fragment_shader;
   VkShaderModule model_vertex_shader;
   VkShaderModule model_fragment_shader;
+  VkShaderModule model_bindless_fragment_shader;
+  VkShaderModule model_indirect_vertex_shader;
+  VkShaderModule model_indirect_fragment_shader;
+  /* VK_NULL_HANDLE when built without the instanced variant */
+  VkShaderModule model_instanced_vertex_shader;
+  VkShaderModule cull_compute_shader;
+  VkShaderModule depth_pyramid_compute_shader;
   VkShaderModule skybox_vertex_shader;
   VkShaderModule skybox_fragment_shader;
 
@@ -104,134 +256,323 @@ struct owl_renderer {
   VkDescriptorSetLayout model_storage_descriptor_set_layout;
   VkDescriptorSetLayout model_maps_descriptor_set_layout;
   VkDescriptorSetLayout model_environment_descriptor_set_layout;
+  VkDescriptorSetLayout model_bindless_descriptor_set_layout;
+  VkDescriptorSetLayout model_indirect_descriptor_set_layout;
+  VkDescriptorSetLayout cull_pyramid_descriptor_set_layout;
+  VkDescriptorSetLayout depth_pyramid_descriptor_set_layout;
 
   VkPipelineLayout common_pipeline_layout;
   VkPipelineLayout model_pipeline_layout;
+  VkPipelineLayout model_bindless_pipeline_layout;
+  VkPipelineLayout model_indirect_pipeline_layout;
+  VkPipelineLayout cull_pipeline_layout;
+  VkPipelineLayout depth_pyramid_pipeline_layout;
 
   VkPipeline basic_pipeline;
   VkPipeline wires_pipeline;
   VkPipeline text_pipeline;
+  VkPipeline text_sdf_pipeline;
   VkPipeline model_pipeline;
+  VkPipeline model_bindless_pipeline;
+  /* the model pipeline, or the bindless one, with a matrix per instance */
+  VkPipeline model_instanced_pipeline;
+  VkPipeline model_indirect_pipeline;
+  VkPipeline cull_pipeline;
+  VkPipeline depth_pyramid_pipeline;
   VkPipeline skybox_pipeline;
 
   VkSampler linear_sampler;
+  VkSampler nearest_sampler;
+
+  /* every model texture in a single update after bind array, materials only
+   * push the slots of their maps. the handles are VK_NULL_HANDLE when the
+   * device lacks descriptor indexing */
+  int32_t bindless_supported;
+  VkDescriptorPool bindless_descriptor_pool;
+  VkDescriptorSet bindless_descriptor_set;
+  uint32_t num_bindless_textures;
+  uint32_t num_free_bindless_textures;
+  uint32_t free_bindless_textures[OWL_MAX_BINDLESS_TEXTURES];
+
+  /* models are culled by a compute pass and drawn with a single indirect
+   * draw. needs bindless, the handles are VK_NULL_HANDLE without it */
+  int32_t gpu_culling_supported;
+
+  /* farthest depth of the main pass at every level, built at the end of the
+   * frames that culled a model and tested by the next frame's culling. kept
+   * in the general layout */
+  VkImage depth_pyramid_image;
+  struct owl_memory_allocation depth_pyramid_memory;
+  VkImageView depth_pyramid_image_view;
+  VkImageView depth_pyramid_level_views[OWL_DEPTH_PYRAMID_LEVELS];
+  VkDescriptorPool depth_pyramid_descriptor_pool;
+  VkDescriptorSet cull_pyramid_descriptor_set;
+  /* the world to clip space transform the pyramid was built with */
+  owl_m4 depth_pyramid_clip;
+  /* frame_count of the frame that built it, 0 before the first one */
+  uint64_t depth_pyramid_frame;
 
   int32_t skybox_loaded;
   struct owl_texture skybox;
 
   VkImage irradiance_map_image;
-  VkDeviceMemory irradiance_map_memory;
+  struct owl_memory_allocation irradiance_map_memory;
   VkImageView irradiance_map_image_view;
 
   uint32_t prefiltered_map_mipmaps;
   VkImage prefiltered_map_image;
-  VkDeviceMemory prefiltered_map_memory;
+  struct owl_memory_allocation prefiltered_map_memory;
   VkImageView prefiltered_map_image_view;
 
   VkImage brdflut_map_image;
-  VkDeviceMemory brdflut_map_memory;
+  struct owl_memory_allocation brdflut_map_memory;
   VkImageView brdflut_map_image_view;
 
+  VkDescriptorPool environment_descriptor_pool;
   VkDescriptorSet environment_descriptor_set;
 
   int32_t font_loaded;
+  /* bumped on every font load, retained text laid out with an older font is
+   * laid out again */
+  uint64_t font_generation;
   struct owl_font font;
 
-  int32_t upload_buffer_in_use;
-  void *upload_buffer_data;
+  /* persistently mapped staging ring, allocations are handed out at the
+   * head and reclaimed from the tail in the order they were made */
+  uint8_t *upload_buffer_data;
   VkDeviceSize upload_buffer_size;
+  VkDeviceSize upload_buffer_head;
   VkBuffer upload_buffer;
   VkDeviceMemory upload_buffer_memory;
+  uint32_t first_upload;
+  uint32_t num_uploads;
+  struct owl_renderer_upload uploads[OWL_MAX_UPLOADS];
+
+  VkCommandPool async_command_pool;
+  /* the upload being recorded, NULL outside begin/end_async_upload */
+  struct owl_renderer_async_upload *async_upload;
+  VkCommandBuffer async_command_buffer;
+  /* tickets are handed out in submission order, the transfer queue finishes
+   * them in the same order */
+  uint64_t async_upload_ticket;
+  uint64_t async_upload_done_ticket;
+  struct owl_renderer_async_upload async_uploads[OWL_MAX_ASYNC_UPLOADS];
 
   uint32_t frame;
   uint32_t num_frames;
-
-  VkCommandPool submit_command_pools[OWL_NUM_IN_FLIGHT_FRAMES];
-  VkCommandBuffer submit_command_buffers[OWL_NUM_IN_FLIGHT_FRAMES];
-
-  VkFence in_flight_fences[OWL_NUM_IN_FLIGHT_FRAMES];
-  VkSemaphore acquire_semaphores[OWL_NUM_IN_FLIGHT_FRAMES];
-  VkSemaphore render_done_semaphores[OWL_NUM_IN_FLIGHT_FRAMES];
-
-  VkDeviceSize vertex_buffer_last_offset;
-  VkDeviceSize vertex_buffer_size;
-  VkDeviceSize vertex_buffer_offset;
-  VkDeviceSize vertex_buffer_alignment;
-  VkDeviceSize vertex_buffer_aligned_size;
-  VkDeviceMemory vertex_buffer_memory;
-  void *vertex_buffer_data;
-  VkBuffer vertex_buffers[OWL_NUM_IN_FLIGHT_FRAMES];
-
-  VkDeviceSize index_buffer_last_offset;
-  VkDeviceSize index_buffer_size;
-  VkDeviceSize index_buffer_offset;
-  VkDeviceSize index_buffer_alignment;
-  VkDeviceMemory index_buffer_memory;
-  VkDeviceSize index_buffer_aligned_size;
-  void *index_buffer_data;
-  VkBuffer index_buffers[OWL_NUM_IN_FLIGHT_FRAMES];
-
-  VkDeviceSize uniform_buffer_last_offset;
-  VkDeviceSize uniform_buffer_size;
-  VkDeviceSize uniform_buffer_offset;
-  VkDeviceSize uniform_buffer_alignment;
-  VkDeviceMemory uniform_buffer_memory;
-  VkDeviceSize uniform_buffer_aligned_size;
-  void *uniform_buffer_data;
-  VkBuffer uniform_buffers[OWL_NUM_IN_FLIGHT_FRAMES];
-  VkDescriptorSet uniform_pvm_descriptor_sets[OWL_NUM_IN_FLIGHT_FRAMES];
-  VkDescriptorSet uniform_model_descriptor_sets[OWL_NUM_IN_FLIGHT_FRAMES];
+  /* owl_renderer_set_num_frames couldn't build the per frame state with
+   * either count, only deinit and another set_num_frames work */
+  int32_t frame_state_lost;
+  /* frames begun so far, a resource last used on frame n is no longer in
+   * flight once frame_count reaches n + num_frames */
+  uint64_t frame_count;
+
+  VkCommandPool submit_command_pools[OWL_MAX_IN_FLIGHT_FRAMES];
+  VkCommandBuffer submit_command_buffers[OWL_MAX_IN_FLIGHT_FRAMES];
+  /* secondary buffers the main pass records into while threads record */
+  VkCommandBuffer inline_command_buffers[OWL_MAX_IN_FLIGHT_FRAMES];
+  /* culling dispatches, submitted ahead of the frame's command buffer.
+   * begun by the first gpu culled draw of the frame */
+  VkCommandBuffer cull_command_buffers[OWL_MAX_IN_FLIGHT_FRAMES];
+  int32_t cull_recording;
+  /* the models culled this frame, the indirect commands of a model are
+   * written once a frame */
+  uint32_t num_culled_models;
+  struct owl_model const *culled_models[OWL_MAX_CULLED_MODELS];
+  /* where the current frame's commands go, either the submit or the inline
+   * command buffer */
+  VkCommandBuffer frame_command_buffer;
+
+  uint32_t num_threads;
+  uint32_t num_frame_threads;
+  struct owl_thread *frame_threads[OWL_MAX_RECORDING_THREADS];
+
+  VkFence in_flight_fences[OWL_MAX_IN_FLIGHT_FRAMES];
+  VkSemaphore acquire_semaphores[OWL_MAX_IN_FLIGHT_FRAMES];
+  VkSemaphore render_done_semaphores[OWL_MAX_IN_FLIGHT_FRAMES];
+
+  int32_t timestamps_supported;
+  float timestamp_period;
+  struct owl_renderer_timestamps frame_timestamps[OWL_MAX_IN_FLIGHT_FRAMES];
+  struct owl_renderer_timestamps im_timestamps;
+  struct owl_renderer_stats stats;
+
+  /* size new pages are created with, grows to the busiest frame seen */
+  uint64_t frame_page_size;
+  /* page of the current frame allocations come from */
+  uint32_t frame_page;
+  uint64_t frame_page_offset;
+  /* bytes the previous frame used across all its pages */
+  uint64_t frame_last_offset;
+  uint64_t frame_vertex_alignment;
+  uint64_t frame_index_alignment;
+  uint64_t frame_uniform_alignment;
+  uint32_t num_frame_pages[OWL_MAX_IN_FLIGHT_FRAMES];
+  struct owl_renderer_frame_page frame_pages[OWL_MAX_IN_FLIGHT_FRAMES]
+                                            [OWL_MAX_FRAME_PAGES];
+
+  /* indices for OWL_MAX_BATCH_QUADS quads, shared by every batch */
+  VkBuffer quad_index_buffer;
+  struct owl_memory_allocation quad_index_memory;
+  struct owl_renderer_quad_batch quad_batch;
 
   uint32_t garbage;
-  uint32_t num_garbage_buffers[OWL_NUM_GARBAGE_FRAMES];
-  uint32_t num_garbage_memories[OWL_NUM_GARBAGE_FRAMES];
-  uint32_t num_garbage_descriptor_sets[OWL_NUM_GARBAGE_FRAMES];
+  uint32_t num_garbage_frames;
+  uint32_t num_garbage_buffers[OWL_MAX_GARBAGE_FRAMES];
+  uint32_t num_garbage_memories[OWL_MAX_GARBAGE_FRAMES];
 
-  VkBuffer garbage_buffers[OWL_NUM_GARBAGE_FRAMES][32];
-  VkDeviceMemory garbage_memories[OWL_NUM_GARBAGE_FRAMES][32];
-  VkDescriptorSet garbage_descriptor_sets[OWL_NUM_GARBAGE_FRAMES][32];
+  VkBuffer garbage_buffers[OWL_MAX_GARBAGE_FRAMES][32];
+  VkDeviceMemory garbage_memories[OWL_MAX_GARBAGE_FRAMES][32];
+
+  /* render targets retired by a resize while frames were still in flight */
+  uint32_t num_garbage_images[OWL_MAX_GARBAGE_FRAMES];
+  uint32_t num_garbage_image_views[OWL_MAX_GARBAGE_FRAMES];
+  uint32_t num_garbage_framebuffers[OWL_MAX_GARBAGE_FRAMES];
+  uint32_t num_garbage_swapchains[OWL_MAX_GARBAGE_FRAMES];
+
+  VkImage garbage_images[OWL_MAX_GARBAGE_FRAMES][32];
+  VkImageView garbage_image_views[OWL_MAX_GARBAGE_FRAMES][32];
+  VkFramebuffer garbage_framebuffers[OWL_MAX_GARBAGE_FRAMES][32];
+  VkSwapchainKHR garbage_swapchains[OWL_MAX_GARBAGE_FRAMES][32];
+
+  /* bindless slots still referenced by frames in flight */
+  uint32_t num_garbage_bindless_textures[OWL_MAX_GARBAGE_FRAMES];
+  uint32_t garbage_bindless_textures[OWL_MAX_GARBAGE_FRAMES]
+                                    [OWL_MAX_BINDLESS_TEXTURES];
 
   PFN_vkCreateDebugUtilsMessengerEXT vk_create_debug_utils_messenger_ext;
   PFN_vkDestroyDebugUtilsMessengerEXT vk_destroy_debug_utils_messenger_ext;
 };
 
-OWLAPI int owl_renderer_init(struct owl_renderer *r, struct owl_plataform *p);
+/* num_frames frames in flight like in owl_renderer_set_num_frames,
+ * OWL_NUM_IN_FLIGHT_FRAMES is a good default. the pipeline cache is kept in
+ * pipeline_cache_path, OWL_PIPELINE_CACHE_PATH by default or NULL to not
+ * keep one */
+OWLAPI int owl_renderer_init(struct owl_renderer *r, struct owl_plataform *p,
+                             uint32_t num_frames,
+                             char const *pipeline_cache_path);
+
+/* renders into offscreen targets, no window, surface or swapchain needed */
+OWLAPI int owl_renderer_init_headless(struct owl_renderer *r, uint32_t width,
+                                      uint32_t height, uint32_t num_frames,
+                                      char const *pipeline_cache_path);
 
 OWLAPI void owl_renderer_deinit(struct owl_renderer *r);
 
+/* recreates the size dependent targets, frames in flight keep using the old
+ * ones until they are collected as garbage */
 OWLAPI int owl_renderer_update_dimensions(struct owl_renderer *r);
 
+/* sets the dynamic viewport and scissor to the renderer dimensions */
+OWLAPI void owl_renderer_set_viewport(struct owl_renderer *r,
+                                      VkCommandBuffer command_buffer);
+
+/* picks between 1 and OWL_MAX_IN_FLIGHT_FRAMES frames in flight, 1 for the
+ * lowest latency, 3 for throughput. must be called outside of a frame. on
+ * failure the old count is kept if it can be rebuilt, otherwise frames fail
+ * with OWL_ERROR_FATAL until a later call succeeds */
+OWLAPI int owl_renderer_set_num_frames(struct owl_renderer *r,
+                                       uint32_t num_frames);
+
 OWLAPI int owl_renderer_begin_frame(struct owl_renderer *r);
 
 OWLAPI int owl_renderer_end_frame(struct owl_renderer *r);
 
+/* copies the last finished headless frame as width * height RGBA8 pixels,
+ * OWL_ERROR_INVALID_VALUE if no frame was rendered at the current size */
+OWLAPI int owl_renderer_read_frame(struct owl_renderer *r, void *pixels);
+
 OWLAPI void *
 owl_renderer_vertex_allocate(struct owl_renderer *r, uint64_t size,
                              struct owl_renderer_vertex_allocation *alloc);
 
-OWLAPI void owl_renderer_vertex_clear_offset(struct owl_renderer *r);
-
 OWLAPI void *
 owl_renderer_index_allocate(struct owl_renderer *r, uint64_t size,
                             struct owl_renderer_index_allocation *alloc);
 
-OWLAPI void owl_renderer_index_clear_offset(struct owl_renderer *r);
-
 OWLAPI void *
 owl_renderer_uniform_allocate(struct owl_renderer *r, uint64_t size,
                               struct owl_renderer_uniform_allocation *alloc);
 
-OWLAPI void owl_renderer_uniform_clear_offset(struct owl_renderer *r);
-
+/* rewinds the frame allocator, every allocation of the frame is released */
+OWLAPI void owl_renderer_frame_clear_offset(struct owl_renderer *r);
+
+/* long lived descriptor sets, pool receives the pool they have to be freed
+ * from */
+OWLAPI int owl_renderer_allocate_descriptor_sets(
+    struct owl_renderer *r, uint32_t count,
+    VkDescriptorSetLayout const *layouts, VkDescriptorSet *sets,
+    VkDescriptorPool *pool);
+
+OWLAPI void owl_renderer_free_descriptor_sets(struct owl_renderer *r,
+                                              VkDescriptorPool pool,
+                                              uint32_t count,
+                                              VkDescriptorSet const *sets);
+
+/* descriptor sets valid until the current frame's fence signals, they are
+ * never freed individually */
+OWLAPI int owl_renderer_frame_allocate_descriptor_sets(
+    struct owl_renderer *r, uint32_t count,
+    VkDescriptorSetLayout const *layouts, VkDescriptorSet *sets);
+
+/* writes the texture into a free slot of the bindless array, the slot is
+ * stored in texture->bindless_index */
+OWLAPI int owl_renderer_add_bindless_texture(struct owl_renderer *r,
+                                             struct owl_texture *texture);
+
+/* the slot is reused once the frames in flight are done with it */
+OWLAPI void owl_renderer_remove_bindless_texture(struct owl_renderer *r,
+                                                 struct owl_texture *texture);
+
+/* staging memory for a copy, stays valid until owl_renderer_upload_free.
+ * allocations can be freed in any order */
 OWLAPI void *
 owl_renderer_upload_allocate(struct owl_renderer *r, uint64_t size,
                              struct owl_renderer_upload_allocation *alloc);
 
 OWLAPI void owl_renderer_upload_free(struct owl_renderer *r, void *ptr);
 
+/* starts recording an upload on the transfer queue, copies out of the
+ * returned staging memory go into r->async_command_buffer. blocks on the
+ * oldest upload when every one is in flight, outside of a frame */
+OWLAPI void *
+owl_renderer_begin_async_upload(struct owl_renderer *r, uint64_t size,
+                                struct owl_renderer_upload_allocation *alloc);
+
+/* hands a buffer written by the upload over to the graphics queue, access is
+ * how the graphics queue is going to read it */
+OWLAPI int owl_renderer_async_release_buffer(struct owl_renderer *r,
+                                             VkBuffer buffer,
+                                             VkAccessFlags access);
+
+/* hands an image written by the upload over to the graphics queue, the image
+ * is left in shader read only layout */
+OWLAPI int owl_renderer_async_release_image(struct owl_renderer *r,
+                                            VkImage image, uint32_t mipmaps,
+                                            uint32_t layers);
+
+/* submits without waiting, the ticket can be polled with
+ * owl_renderer_is_async_upload_done */
+OWLAPI int owl_renderer_end_async_upload(struct owl_renderer *r,
+                                         uint64_t *ticket);
+
+/* finished uploads are acquired by owl_renderer_begin_frame, a ticket is done
+ * once the frame that acquired it can use the resources */
+OWLAPI int owl_renderer_is_async_upload_done(struct owl_renderer *r,
+                                             uint64_t ticket);
+
+/* blocks until the ticket is done, outside of a frame */
+OWLAPI int owl_renderer_wait_async_upload(struct owl_renderer *r,
+                                          uint64_t ticket);
+
 OWLAPI int owl_renderer_load_font(struct owl_renderer *r, uint32_t size,
                                   char const *path);
 
+/* loads the font as a signed distance field, text drawn with it stays sharp
+ * at any scale. OWL_ERROR_INVALID_VALUE if built without the sdf shader */
+OWLAPI int owl_renderer_load_sdf_font(struct owl_renderer *r, uint32_t size,
+                                      char const *path);
+
 OWLAPI void owl_renderer_unload_font(struct owl_renderer *r);
 
 OWLAPI int owl_renderer_load_skybox(struct owl_renderer *r, char const *path);
@@ -242,10 +583,25 @@ OWLAPI uint32_t owl_renderer_find_memory_type(struct owl_renderer *r,
                                               uint32_t filter,
                                               uint32_t properties);
 
+/* main thread only, the command buffer the current frame's culling
+ * dispatches are recorded into. VK_NULL_HANDLE if it couldn't begin */
+OWLAPI VkCommandBuffer
+owl_renderer_cull_command_buffer(struct owl_renderer *r);
+
 OWLAPI int owl_renderer_begin_im_command_buffer(struct owl_renderer *r);
 
 OWLAPI int owl_renderer_end_im_command_buffer(struct owl_renderer *r);
 
+/* scopes are recorded into the active immediate or frame command buffer */
+OWLAPI void owl_renderer_begin_scope(struct owl_renderer *r,
+                                     enum owl_renderer_scope scope);
+
+OWLAPI void owl_renderer_end_scope(struct owl_renderer *r,
+                                   enum owl_renderer_scope scope);
+
+OWLAPI void owl_renderer_get_stats(struct owl_renderer *r,
+                                   struct owl_renderer_stats *stats);
+
 OWL_END_DECLARATIONS
 
 #endif
@@ -0,0 +1,155 @@
+#include "owl_text.h"
+
+#include "owl_internal.h"
+
+OWLAPI int owl_text_init(struct owl_renderer *r, struct owl_text *text) {
+  int ret;
+  int32_t i;
+  VkDevice const device = r->device;
+
+  {
+    VkBufferCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.size = OWL_MAX_IN_FLIGHT_FRAMES * sizeof(text->vertices);
+    info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.queueFamilyIndexCount = 0;
+    info.pQueueFamilyIndices = NULL;
+
+    vk_result = vkCreateBuffer(device, &info, NULL, &text->buffer);
+    if (vk_result) {
+      ret = OWL_ERROR_FATAL;
+      goto error;
+    }
+  }
+
+  {
+    VkMemoryPropertyFlagBits properties;
+    VkMemoryRequirements requirements;
+
+    properties = 0;
+    properties |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    properties |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    vkGetBufferMemoryRequirements(device, text->buffer, &requirements);
+
+    ret = owl_memory_allocate(r, &requirements, properties, &text->memory);
+    if (ret)
+      goto error_destroy_buffer;
+
+    ret = owl_memory_bind_buffer(r, text->buffer, &text->memory);
+    if (ret)
+      goto error_free_memory;
+  }
+
+  text->string[0] = '\0';
+  text->width = 0;
+  text->height = 0;
+  text->font_generation = 0;
+  text->num_glyphs = 0;
+  text->version = 1;
+  text->drawn_frame_count = 0;
+
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i)
+    text->frame_versions[i] = 0;
+
+  return OWL_OK;
+
+error_free_memory:
+  owl_memory_free(r, &text->memory);
+
+error_destroy_buffer:
+  vkDestroyBuffer(device, text->buffer, NULL);
+
+error:
+  return ret;
+}
+
+OWLAPI void owl_text_deinit(struct owl_renderer *r, struct owl_text *text) {
+  VkDevice const device = r->device;
+
+  /* frames in flight might still be reading the buffer */
+  vkDeviceWaitIdle(device);
+
+  vkDestroyBuffer(device, text->buffer, NULL);
+  owl_memory_free(r, &text->memory);
+}
+
+OWLAPI int owl_text_update(struct owl_renderer *r, struct owl_text *text,
+                           char const *string, owl_v3 const position,
+                           float scale, owl_v3 const color) {
+  int ret;
+  uint32_t i;
+  char const *it;
+  owl_v2 offset;
+
+  if (!r->font_loaded)
+    return OWL_ERROR_INVALID_VALUE;
+
+  if (OWL_MAX_TEXT_GLYPHS < OWL_STRLEN(string))
+    return OWL_ERROR_NO_SPACE;
+
+  /* evicting glyphs for this string bumps the font generation */
+  ret = owl_font_cache_text(r, &r->font, string);
+  if (ret)
+    return ret;
+
+  if (!OWL_STRNCMP(text->string, string, OWL_MAX_TEXT_GLYPHS) &&
+      !OWL_MEMCMP(text->position, position, sizeof(text->position)) &&
+      text->scale == scale &&
+      !OWL_MEMCMP(text->color, color, sizeof(text->color)) &&
+      text->width == r->width && text->height == r->height &&
+      text->font_generation == r->font_generation)
+    return OWL_OK;
+
+  offset[0] = position[0] * r->width;
+  offset[1] = position[1] * r->height;
+
+  for (i = 0, it = string; '\0' != *it; ++i) {
+    uint32_t j;
+    struct owl_glyph glyph;
+    struct owl_common_vertex *vertices = &text->vertices[i * 4];
+    uint32_t const codepoint = owl_font_next_codepoint(&it);
+
+    ret = owl_font_fill_glyph(r, &r->font, codepoint, scale, offset, &glyph);
+    if (ret) {
+      /* the old layout was partially overwritten, start over next update */
+      text->string[0] = '\0';
+      text->num_glyphs = 0;
+      return ret;
+    }
+
+    text->cells[i] = glyph.cell;
+    text->textures[i] = glyph.texture;
+
+    /* same corners as owl_draw_quad */
+    for (j = 0; j < 4; ++j) {
+      vertices[j].position[0] = glyph.positions[j][0];
+      vertices[j].position[1] = glyph.positions[j][1];
+      vertices[j].position[2] = 0.0F;
+      vertices[j].color[0] = color[0];
+      vertices[j].color[1] = color[1];
+      vertices[j].color[2] = color[2];
+      vertices[j].uv[0] = glyph.uvs[j][0];
+      vertices[j].uv[1] = glyph.uvs[j][1];
+    }
+  }
+
+  OWL_STRNCPY(text->string, string, OWL_MAX_TEXT_GLYPHS);
+  text->string[OWL_MAX_TEXT_GLYPHS] = '\0';
+  OWL_MEMCPY(text->position, position, sizeof(text->position));
+  text->scale = scale;
+  OWL_MEMCPY(text->color, color, sizeof(text->color));
+  text->width = r->width;
+  text->height = r->height;
+  text->font_generation = r->font_generation;
+  text->num_glyphs = i;
+
+  ++text->version;
+
+  return OWL_OK;
+}
@@ -0,0 +1,56 @@
+#ifndef OWL_TEXT_H
+#define OWL_TEXT_H
+
+#include "owl_renderer.h"
+
+OWL_BEGIN_DECLARATIONS
+
+/* in bytes of utf-8, so also the most glyphs a text can have */
+#define OWL_MAX_TEXT_GLYPHS 256
+
+/*
+ * a string laid out once with the renderer font. the glyph quads are kept
+ * in a buffer of their own with a copy per frame in flight, a copy is only
+ * rewritten the first time its frame comes back after the layout changed.
+ * the draw that rewrites it isn't synchronized, a text is drawn at most once
+ * a frame by a single thread.
+ */
+struct owl_text {
+  char string[OWL_MAX_TEXT_GLYPHS + 1];
+  owl_v3 position;
+  float scale;
+  owl_v3 color;
+  /* what the layout was computed against */
+  uint32_t width;
+  uint32_t height;
+  uint64_t font_generation;
+
+  uint32_t num_glyphs;
+  struct owl_common_vertex vertices[OWL_MAX_TEXT_GLYPHS * 4];
+  /* atlas cells, kept so drawing can keep the glyphs from being evicted */
+  int32_t cells[OWL_MAX_TEXT_GLYPHS];
+  /* atlas page of every glyph */
+  struct owl_texture *textures[OWL_MAX_TEXT_GLYPHS];
+
+  /* bumped every time the layout changes */
+  uint64_t version;
+  uint64_t frame_versions[OWL_MAX_IN_FLIGHT_FRAMES];
+  /* frame_count of the last frame that drew it */
+  uint64_t drawn_frame_count;
+  VkBuffer buffer;
+  struct owl_memory_allocation memory;
+};
+
+OWLAPI int owl_text_init(struct owl_renderer *r, struct owl_text *text);
+
+OWLAPI void owl_text_deinit(struct owl_renderer *r, struct owl_text *text);
+
+/* lays the string out again only if anything that affects the layout
+ * changed. position, scale and color are like in owl_draw_scaled_text */
+OWLAPI int owl_text_update(struct owl_renderer *r, struct owl_text *text,
+                           char const *string, owl_v3 const position,
+                           float scale, owl_v3 const color);
+
+OWL_END_DECLARATIONS
+
+#endif
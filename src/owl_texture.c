@@ -79,6 +79,13 @@ OWLAPI void owl_texture_change_layout(struct owl_texture *texture,
 
     src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
     dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  } else if (VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL == texture->layout &&
+             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL == layout) {
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    src_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
   } else if (VK_IMAGE_LAYOUT_UNDEFINED == texture->layout &&
              VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL == layout) {
     barrier.srcAccessMask = VK_ACCESS_NONE_KHR;
@@ -224,9 +231,10 @@ OWLAPI int owl_texture_init(struct owl_renderer *r,
 
   texture->layout = VK_IMAGE_LAYOUT_UNDEFINED;
   texture->image = VK_NULL_HANDLE;
-  texture->memory = VK_NULL_HANDLE;
+  texture->memory.memory = VK_NULL_HANDLE;
   texture->image_view = VK_NULL_HANDLE;
   texture->descriptor_set = VK_NULL_HANDLE;
+  texture->bindless_index = OWL_BINDLESS_NONE;
 
   /* first upload the image(s) data into the upload buffer */
   if (OWL_TEXTURE_SOURCE_DATA == desc->source) {
@@ -442,31 +450,19 @@ OWLAPI int owl_texture_init(struct owl_renderer *r,
   {
     VkMemoryPropertyFlagBits properties;
     VkMemoryRequirements requirements;
-    VkMemoryAllocateInfo info;
 
     properties = 0;
     properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
     vkGetImageMemoryRequirements(r->device, texture->image, &requirements);
 
-    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.allocationSize = requirements.size;
-    info.memoryTypeIndex = owl_renderer_find_memory_type(
-        r, requirements.memoryTypeBits, properties);
-
-    vk_result = vkAllocateMemory(r->device, &info, NULL, &texture->memory);
-    if (vk_result) {
-      ret = OWL_ERROR_NO_MEMORY;
+    ret = owl_memory_allocate(r, &requirements, properties, &texture->memory);
+    if (ret)
       goto error_destroy_image;
-    }
 
-    vk_result =
-        vkBindImageMemory(r->device, texture->image, texture->memory, 0);
-    if (vk_result) {
-      ret = OWL_ERROR_FATAL;
+    ret = owl_memory_bind_image(r, texture->image, &texture->memory);
+    if (ret)
       goto error_free_memory;
-    }
   }
 
   {
@@ -498,22 +494,11 @@ OWLAPI int owl_texture_init(struct owl_renderer *r,
     }
   }
 
-  {
-    VkDescriptorSetAllocateInfo info;
-
-    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    info.pNext = NULL;
-    info.descriptorPool = r->descriptor_pool;
-    info.descriptorSetCount = 1;
-    info.pSetLayouts = &r->common_texture_descriptor_set_layout;
-
-    vk_result =
-        vkAllocateDescriptorSets(r->device, &info, &texture->descriptor_set);
-    if (vk_result) {
-      ret = OWL_ERROR_FATAL;
-      goto error_destroy_image_view;
-    }
-  }
+  ret = owl_renderer_allocate_descriptor_sets(
+      r, 1, &r->common_texture_descriptor_set_layout, &texture->descriptor_set,
+      &texture->descriptor_pool);
+  if (ret)
+    goto error_destroy_image_view;
 
   ret = owl_renderer_begin_im_command_buffer(r);
   if (ret)
@@ -524,7 +509,7 @@ OWLAPI int owl_texture_init(struct owl_renderer *r,
 
   if (OWL_TEXTURE_TYPE_CUBE == desc->type) {
     int32_t i;
-    uint64_t offset = 0;
+    uint64_t offset = upload_allocation.offset;
     uint64_t pixel_size;
     uint64_t size;
     VkBufferImageCopy copies[6];
@@ -557,7 +542,7 @@ OWLAPI int owl_texture_init(struct owl_renderer *r,
   } else {
     VkBufferImageCopy copy;
 
-    copy.bufferOffset = 0;
+    copy.bufferOffset = upload_allocation.offset;
     copy.bufferRowLength = 0;
     copy.bufferImageHeight = 0;
     copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -630,14 +615,14 @@ OWLAPI int owl_texture_init(struct owl_renderer *r,
   return OWL_OK;
 
 error_free_descriptor_set:
-  vkFreeDescriptorSets(r->device, r->descriptor_pool, 1,
-                       &texture->descriptor_set);
+  owl_renderer_free_descriptor_sets(r, texture->descriptor_pool, 1,
+                                    &texture->descriptor_set);
 
 error_destroy_image_view:
   vkDestroyImageView(r->device, texture->image_view, NULL);
 
 error_free_memory:
-  vkFreeMemory(r->device, texture->memory, NULL);
+  owl_memory_free(r, &texture->memory);
 
 error_destroy_image:
   vkDestroyImage(r->device, texture->image, NULL);
@@ -651,9 +636,41 @@ error_free_upload_data:
 
 OWLAPI void owl_texture_deinit(struct owl_renderer *r,
                                struct owl_texture *texture) {
-  vkFreeDescriptorSets(r->device, r->descriptor_pool, 1,
-                       &texture->descriptor_set);
+  if (OWL_BINDLESS_NONE != texture->bindless_index)
+    owl_renderer_remove_bindless_texture(r, texture);
+
+  owl_renderer_free_descriptor_sets(r, texture->descriptor_pool, 1,
+                                    &texture->descriptor_set);
   vkDestroyImageView(r->device, texture->image_view, NULL);
-  vkFreeMemory(r->device, texture->memory, NULL);
+  owl_memory_free(r, &texture->memory);
   vkDestroyImage(r->device, texture->image, NULL);
 }
+
+OWLAPI int owl_texture_update(struct owl_renderer *r,
+                              struct owl_texture *texture, VkBuffer buffer,
+                              uint32_t num_copies,
+                              VkBufferImageCopy const *copies) {
+  int ret;
+
+  ret = owl_renderer_begin_im_command_buffer(r);
+  if (ret)
+    return ret;
+
+  /* the barrier orders the copy after the frames already submitted to the
+   * graphics queue that sample the texture */
+  owl_texture_change_layout(texture, r->im_command_buffer,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+  vkCmdCopyBufferToImage(r->im_command_buffer, buffer, texture->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_copies,
+                         copies);
+
+  owl_texture_generate_mipmaps(texture, r);
+
+  /* generate_mipmaps leaves single level textures as they are */
+  if (VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL == texture->layout)
+    owl_texture_change_layout(texture, r->im_command_buffer,
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+  return owl_renderer_end_im_command_buffer(r);
+}
@@ -2,6 +2,7 @@
 #define OWL_TEXTURE_H
 
 #include "owl_definitions.h"
+#include "owl_memory.h"
 
 #include <vulkan/vulkan.h>
 
@@ -40,10 +41,13 @@ struct owl_texture {
   uint32_t mipmaps;
   uint32_t layers;
   VkImage image;
-  VkDeviceMemory memory;
+  struct owl_memory_allocation memory;
   VkImageView image_view;
   VkImageLayout layout;
+  VkDescriptorPool descriptor_pool;
   VkDescriptorSet descriptor_set;
+  /* slot in the renderer's bindless array, OWL_BINDLESS_NONE if not added */
+  uint32_t bindless_index;
 };
 
 OWLAPI int owl_texture_init(struct owl_renderer *r,
@@ -57,6 +61,13 @@ OWLAPI void owl_texture_change_layout(struct owl_texture *texture,
                                       VkCommandBuffer command_buffer,
                                       VkImageLayout layout);
 
+/* copies the regions of buffer into mip 0 and regenerates the mipmaps, the
+ * texture stays bound to whatever descriptor sets it already is in */
+OWLAPI int owl_texture_update(struct owl_renderer *r,
+                              struct owl_texture *texture, VkBuffer buffer,
+                              uint32_t num_copies,
+                              VkBufferImageCopy const *copies);
+
 uint32_t owl_texture_calculate_mipmaps(uint32_t w, uint32_t h);
 OWL_END_DECLARATIONS
 
@@ -0,0 +1,227 @@
+#include "owl_thread.h"
+
+#include "owl_draw.h"
+#include "owl_internal.h"
+
+OWLAPI int owl_thread_init(struct owl_thread *t, struct owl_renderer *r) {
+  int32_t i;
+  VkDevice const device = r->device;
+
+  t->renderer = r;
+  t->command_buffer = VK_NULL_HANDLE;
+  t->quad_batch.num_quads = 0;
+
+  /* the pools are created for every possible frame so the number of frames
+   * in flight can change without touching the threads */
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i) {
+    VkCommandPoolCreateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    info.queueFamilyIndex = r->graphics_family;
+
+    vk_result = vkCreateCommandPool(device, &info, NULL, &t->command_pools[i]);
+    if (vk_result)
+      goto error_destroy_command_pools;
+  }
+
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i) {
+    VkCommandBufferAllocateInfo info;
+    VkResult vk_result = VK_SUCCESS;
+
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.commandPool = t->command_pools[i];
+    info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    info.commandBufferCount = 1;
+
+    vk_result = vkAllocateCommandBuffers(device, &info, &t->command_buffers[i]);
+    if (vk_result)
+      goto error_free_command_buffers;
+  }
+
+  ++r->num_threads;
+
+  return OWL_OK;
+
+error_free_command_buffers:
+  for (i = i - 1; i >= 0; --i)
+    vkFreeCommandBuffers(device, t->command_pools[i], 1,
+                         &t->command_buffers[i]);
+
+  i = OWL_MAX_IN_FLIGHT_FRAMES;
+
+error_destroy_command_pools:
+  for (i = i - 1; i >= 0; --i)
+    vkDestroyCommandPool(device, t->command_pools[i], NULL);
+
+  return OWL_ERROR_FATAL;
+}
+
+OWLAPI void owl_thread_deinit(struct owl_thread *t, struct owl_renderer *r) {
+  int32_t i;
+  VkDevice const device = r->device;
+
+  vkDeviceWaitIdle(device);
+
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i)
+    vkFreeCommandBuffers(device, t->command_pools[i], 1,
+                         &t->command_buffers[i]);
+
+  for (i = 0; i < OWL_MAX_IN_FLIGHT_FRAMES; ++i)
+    vkDestroyCommandPool(device, t->command_pools[i], NULL);
+
+  --r->num_threads;
+}
+
+OWLAPI int owl_thread_begin(struct owl_thread *t, uint64_t vertex_size,
+                            uint64_t index_size, uint64_t uniform_size) {
+  void *data;
+  VkResult vk_result;
+  struct owl_renderer *r = t->renderer;
+  uint32_t const frame = r->frame;
+  VkDevice const device = r->device;
+
+  /* the thread was created after the frame began, the main pass was started
+   * without secondary command buffers */
+  if (r->frame_command_buffer != r->inline_command_buffers[frame])
+    return OWL_ERROR_INVALID_VALUE;
+
+  if (OWL_MAX_RECORDING_THREADS <= r->num_frame_threads)
+    return OWL_ERROR_NO_SPACE;
+
+  data = owl_renderer_vertex_allocate(r, vertex_size, &t->vertex_slice);
+  if (!data)
+    return OWL_ERROR_NO_FRAME_MEMORY;
+
+  t->vertex_data = data;
+  t->vertex_offset = 0;
+  t->vertex_size = vertex_size;
+  t->vertex_alignment = r->frame_vertex_alignment;
+
+  data = owl_renderer_index_allocate(r, index_size, &t->index_slice);
+  if (!data)
+    return OWL_ERROR_NO_FRAME_MEMORY;
+
+  t->index_data = data;
+  t->index_offset = 0;
+  t->index_size = index_size;
+  t->index_alignment = r->frame_index_alignment;
+
+  data = owl_renderer_uniform_allocate(r, uniform_size, &t->uniform_slice);
+  if (!data)
+    return OWL_ERROR_NO_FRAME_MEMORY;
+
+  t->uniform_data = data;
+  t->uniform_offset = 0;
+  t->uniform_size = uniform_size;
+  t->uniform_alignment = r->frame_uniform_alignment;
+
+  vk_result = vkResetCommandPool(device, t->command_pools[frame], 0);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
+
+  t->command_buffer = t->command_buffers[frame];
+  t->quad_batch.num_quads = 0;
+  OWL_MEMSET(t->touched_glyphs, 0, sizeof(t->touched_glyphs));
+
+  {
+    VkCommandBufferInheritanceInfo inheritance;
+    VkCommandBufferBeginInfo info;
+
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.pNext = NULL;
+    inheritance.renderPass = r->main_render_pass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = VK_NULL_HANDLE;
+    inheritance.occlusionQueryEnable = VK_FALSE;
+    inheritance.queryFlags = 0;
+    inheritance.pipelineStatistics = 0;
+
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    info.pInheritanceInfo = &inheritance;
+
+    vk_result = vkBeginCommandBuffer(t->command_buffer, &info);
+    if (vk_result)
+      return OWL_ERROR_FATAL;
+  }
+
+  owl_renderer_set_viewport(r, t->command_buffer);
+
+  r->frame_threads[r->num_frame_threads++] = t;
+
+  return OWL_OK;
+}
+
+OWLAPI int owl_thread_end(struct owl_thread *t) {
+  int ret;
+  VkResult vk_result;
+
+  ret = owl_draw_thread_flush(t);
+  if (ret)
+    return ret;
+
+  vk_result = vkEndCommandBuffer(t->command_buffer);
+  if (vk_result)
+    return OWL_ERROR_FATAL;
+
+  return OWL_OK;
+}
+
+OWLAPI void *
+owl_thread_vertex_allocate(struct owl_thread *t, uint64_t size,
+                           struct owl_renderer_vertex_allocation *alloc) {
+  uint64_t const offset = t->vertex_offset;
+
+  /* the slice can't grow from a worker thread, the renderer buffer might be
+   * in use by the other threads */
+  if (t->vertex_size < offset + size)
+    return NULL;
+
+  alloc->offset = t->vertex_slice.offset + offset;
+  alloc->buffer = t->vertex_slice.buffer;
+
+  t->vertex_offset = OWL_ALIGN_UP_2(offset + size, t->vertex_alignment);
+
+  return &t->vertex_data[offset];
+}
+
+OWLAPI void *
+owl_thread_index_allocate(struct owl_thread *t, uint64_t size,
+                          struct owl_renderer_index_allocation *alloc) {
+  uint64_t const offset = t->index_offset;
+
+  if (t->index_size < offset + size)
+    return NULL;
+
+  alloc->offset = t->index_slice.offset + offset;
+  alloc->buffer = t->index_slice.buffer;
+
+  t->index_offset = OWL_ALIGN_UP_2(offset + size, t->index_alignment);
+
+  return &t->index_data[offset];
+}
+
+OWLAPI void *
+owl_thread_uniform_allocate(struct owl_thread *t, uint64_t size,
+                            struct owl_renderer_uniform_allocation *alloc) {
+  uint64_t const offset = t->uniform_offset;
+
+  if (t->uniform_size < offset + size)
+    return NULL;
+
+  alloc->offset = t->uniform_slice.offset + (uint32_t)offset;
+  alloc->buffer = t->uniform_slice.buffer;
+  alloc->common_descriptor_set = t->uniform_slice.common_descriptor_set;
+  alloc->model_descriptor_set = t->uniform_slice.model_descriptor_set;
+
+  t->uniform_offset = OWL_ALIGN_UP_2(offset + size, t->uniform_alignment);
+
+  return &t->uniform_data[offset];
+}
@@ -1 +1,73 @@
-/* TODO */
+#ifndef OWL_THREAD_H
+#define OWL_THREAD_H
+
+#include "owl_renderer.h"
+
+OWL_BEGIN_DECLARATIONS
+
+/*
+ * a recording thread, owns a secondary command buffer per frame and a slice
+ * of each of the renderer frame allocators. owl_thread_begin carves the
+ * slices on the main thread, after that the worker thread can record and
+ * allocate on its own without touching any shared renderer state.
+ */
+struct owl_thread {
+  struct owl_renderer *renderer;
+
+  VkCommandPool command_pools[OWL_MAX_IN_FLIGHT_FRAMES];
+  VkCommandBuffer command_buffers[OWL_MAX_IN_FLIGHT_FRAMES];
+  VkCommandBuffer command_buffer;
+
+  uint8_t *vertex_data;
+  uint64_t vertex_offset;
+  uint64_t vertex_size;
+  uint64_t vertex_alignment;
+  struct owl_renderer_vertex_allocation vertex_slice;
+
+  uint8_t *index_data;
+  uint64_t index_offset;
+  uint64_t index_size;
+  uint64_t index_alignment;
+  struct owl_renderer_index_allocation index_slice;
+
+  uint8_t *uniform_data;
+  uint64_t uniform_offset;
+  uint64_t uniform_size;
+  uint64_t uniform_alignment;
+  struct owl_renderer_uniform_allocation uniform_slice;
+
+  struct owl_renderer_quad_batch quad_batch;
+
+  /* bit set of the font cells laid out this frame, the font is read only for
+   * threads so owl_renderer_end_frame marks them used */
+  uint32_t touched_glyphs[OWL_FONT_MAX_GLYPHS / 32];
+};
+
+OWLAPI int owl_thread_init(struct owl_thread *t, struct owl_renderer *r);
+
+OWLAPI void owl_thread_deinit(struct owl_thread *t, struct owl_renderer *r);
+
+/* main thread only, after owl_renderer_begin_frame. reserves the slices and
+ * queues the thread to be executed by owl_renderer_end_frame */
+OWLAPI int owl_thread_begin(struct owl_thread *t, uint64_t vertex_size,
+                            uint64_t index_size, uint64_t uniform_size);
+
+/* worker thread, must return before the main thread calls
+ * owl_renderer_end_frame */
+OWLAPI int owl_thread_end(struct owl_thread *t);
+
+OWLAPI void *
+owl_thread_vertex_allocate(struct owl_thread *t, uint64_t size,
+                           struct owl_renderer_vertex_allocation *alloc);
+
+OWLAPI void *
+owl_thread_index_allocate(struct owl_thread *t, uint64_t size,
+                          struct owl_renderer_index_allocation *alloc);
+
+OWLAPI void *
+owl_thread_uniform_allocate(struct owl_thread *t, uint64_t size,
+                            struct owl_renderer_uniform_allocation *alloc);
+
+OWL_END_DECLARATIONS
+
+#endif